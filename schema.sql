@@ -42,7 +42,9 @@ CREATE TABLE IF NOT EXISTS events (
     event_type TEXT NOT NULL,                -- 'up' або 'down'
     timestamp TEXT NOT NULL,                 -- Час події (ISO 8601)
     building_id INTEGER DEFAULT NULL,        -- ID будинку
-    section_id INTEGER DEFAULT NULL          -- Номер секції (1..3)
+    section_id INTEGER DEFAULT NULL,         -- Номер секції (1..3)
+    refuted_at TEXT DEFAULT NULL,            -- Коли офлайн-журнал сенсора спростував подію (ISO 8601); NULL — дійсна
+    refuted_by TEXT DEFAULT NULL             -- UUID сенсора, чий журнал спростував подію
 );
 
 -- Загальні категорії сервісів
@@ -322,6 +324,13 @@ CREATE TABLE IF NOT EXISTS sensors (
     last_heartbeat TEXT,                     -- Час останнього heartbeat (ISO 8601)
     created_at TEXT NOT NULL,                -- Час реєстрації (ISO 8601)
     is_active INTEGER DEFAULT 1,             -- Активний (1/0)
+    telemetry_json TEXT DEFAULT NULL,        -- Останні службові метрики з heartbeat (JSON: лічильники з'єднань тощо)
+    power_lost_at TEXT DEFAULT NULL,         -- Коли прийшов last-gasp "power_lost" (NULL після наступного heartbeat)
+    hb_seq INTEGER DEFAULT NULL,             -- Останній seq heartbeat (лічильник прошивки з моменту boot)
+    hb_received INTEGER DEFAULT 0,           -- Скільки heartbeat з seq отримано
+    hb_lost INTEGER DEFAULT 0,               -- Скільки heartbeat загублено (пропуски в seq)
+    frame_cursor INTEGER DEFAULT NULL,       -- Позиція останнього прийнятого beat у межах boot (seq*2, +1 для power_lost): захист frame від повтору
+    frame_boot INTEGER DEFAULT NULL,         -- boot_count прошивки в цьому beat (епоха для frame_cursor)
     FOREIGN KEY (building_id) REFERENCES buildings(id)
 );
 
@@ -334,6 +343,16 @@ CREATE TABLE IF NOT EXISTS sensor_public_ids (
 );
 CREATE INDEX IF NOT EXISTS idx_sensor_public_ids_sensor_uuid ON sensor_public_ids (sensor_uuid);
 
+-- Офлайн-журнал сенсорів: beat-и, які не дійшли вчасно (немає зв'язку), догружені пакетом
+CREATE TABLE IF NOT EXISTS sensor_journal_beats (
+    sensor_uuid TEXT NOT NULL,               -- FK на sensors
+    ts TEXT NOT NULL,                        -- Час beat за годинником сервера (ISO 8601)
+    seq INTEGER NOT NULL,                    -- seq beat з прошивки
+    received_at TEXT NOT NULL,               -- Коли журнал доставлено (ISO 8601)
+    FOREIGN KEY (sensor_uuid) REFERENCES sensors(uuid) ON DELETE CASCADE
+);
+CREATE INDEX IF NOT EXISTS idx_sensor_journal_beats_sensor_ts ON sensor_journal_beats (sensor_uuid, ts);
+
 -- Стан електропостачання будинків
 CREATE TABLE IF NOT EXISTS building_power_state (
     building_id INTEGER PRIMARY KEY,         -- FK на buildings
@@ -195,6 +195,34 @@ docker compose exec -T powerbot python - < "${REPO_DIR}/scripts/smoke_buildings_
 echo "Running sensor aliases smoke test in test container..."
 docker compose exec -T powerbot python - < "${REPO_DIR}/scripts/smoke_sensor_aliases.py"
 
+# Smoke: heartbeat keep-alive (several beats over one TCP socket) + connection telemetry.
+echo "Running sensor heartbeat keep-alive smoke test in test container..."
+docker compose exec -T powerbot python - < "${REPO_DIR}/scripts/smoke_sensor_heartbeat_keepalive.py"
+
+# Smoke: last-gasp power_lost event (instant offline + monitor wakeup, boot clears it).
+echo "Running sensor power_lost event smoke test in test container..."
+docker compose exec -T powerbot python - < "${REPO_DIR}/scripts/smoke_sensor_power_lost_event.py"
+
+# Smoke: offline heartbeat journal back-fill (bulk endpoint removes false down/up, idempotent).
+echo "Running sensor journal back-fill smoke test in test container..."
+docker compose exec -T powerbot python - < "${REPO_DIR}/scripts/smoke_sensor_journal_backfill.py"
+
+# Smoke: UDP heartbeat transport (loopback replay of datagrams) + seq loss accounting.
+echo "Running sensor UDP heartbeat smoke test in test container..."
+docker compose exec -T powerbot python - < "${REPO_DIR}/scripts/smoke_sensor_udp_heartbeat.py"
+
+# Smoke: binary HMAC heartbeat frame over HTTP/UDP (JSON registration, forged frames rejected).
+echo "Running sensor heartbeat frame smoke test in test container..."
+docker compose exec -T powerbot python - < "${REPO_DIR}/scripts/smoke_sensor_heartbeat_frame.py"
+
+# Smoke: building aggregator batch endpoint (per-beat results, aged beats, monitor wakeup).
+echo "Running sensor heartbeat batch smoke test in test container..."
+docker compose exec -T powerbot python - < "${REPO_DIR}/scripts/smoke_sensor_heartbeat_batch.py"
+
+# Smoke: several sections from one board ("inputs" bitmask -> per-input sensors, validation).
+echo "Running sensor inputs bitmask smoke test in test container..."
+docker compose exec -T powerbot python - < "${REPO_DIR}/scripts/smoke_sensor_inputs_bitmask.py"
+
 # Automated smoke: place click stats (DB-backed views counters).
 echo "Running place click stats smoke test in test container..."
 docker compose exec -T powerbot python - < "${REPO_DIR}/scripts/smoke_place_click_stats.py"
@@ -624,6 +652,10 @@ python3 "${REPO_DIR}/scripts/smoke_public_sensor_api_policy.py"
 echo "Running sensor UUID canonical mapping policy smoke test..."
 python3 "${REPO_DIR}/scripts/smoke_sensor_uuid_canonical_mapping_policy.py"
 
+# Automated smoke: binary heartbeat frame matches test vectors shared with the firmware tests.
+echo "Running sensor heartbeat frame vectors smoke test..."
+python3 "${REPO_DIR}/scripts/smoke_sensor_heartbeat_frame_vectors.py"
+
 # Automated smoke: verify resident-bot isolation when BUSINESS_MODE=0.
 echo "Running business mode-off isolation smoke test in test container..."
 docker compose exec -T powerbot env BUSINESS_MODE=0 BUSINESS_BOT_API_KEY= python - < "${REPO_DIR}/scripts/smoke_business_mode_off.py"
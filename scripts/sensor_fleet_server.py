@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""
+Heartbeat API для навантажувального прогону fleet-sim (sensors/fleet-sim) без docker.
+
+Піднімає той самий aiohttp-застосунок, що й бот (api_server.create_api_app), на тимчасовій
+SQLite-базі з відомим SENSOR_API_KEY і чекає до Ctrl+C. Telegram не потрібен: сповіщення
+про світло з тестових сенсорів нікуди не йдуть, база видаляється при виході (--keep-db —
+лишити, щоб подивитись, що записав сервер).
+
+Використання (з кореня репозиторію):
+    BOT_TOKEN=1:x python scripts/sensor_fleet_server.py --port 18080 --api-key fleet-key
+    sensors/fleet-sim/.pio/build/native/program --port 18080 --api-key fleet-key --sensors 2000
+
+Проти docker compose fleet-sim іде напряму на порт API контейнера з його SENSOR_API_KEY.
+"""
+
+from __future__ import annotations
+
+import argparse
+import asyncio
+import os
+import shutil
+import sys
+import tempfile
+from pathlib import Path
+
+
+REPO_ROOT: Path | None = None
+for candidate in (Path.cwd(), Path("/app"), Path(__file__).resolve().parent.parent):
+    if (candidate / "src" / "database.py").exists() and (candidate / "src" / "api_server.py").exists():
+        REPO_ROOT = candidate
+        break
+if REPO_ROOT is None:
+    raise RuntimeError("Cannot locate repo root (src/database.py + src/api_server.py).")
+
+sys.path.insert(0, str(REPO_ROOT / "src"))
+
+
+async def serve(args: argparse.Namespace) -> None:
+    tmpdir = Path(tempfile.mkdtemp(prefix="powerbot-fleet-"))
+    os.environ["DB_PATH"] = str(tmpdir / "state.db")
+
+    try:
+        # Import only after DB_PATH override.
+        import database  # noqa: WPS433,E402
+        import api_server  # noqa: WPS433,E402
+        from aiohttp import web  # noqa: WPS433,E402
+
+        await database.init_db()
+
+        api_server.CFG.sensor_api_key = args.api_key
+        api_server.CFG.sensor_heartbeat_interval = args.interval_s
+        runner = web.AppRunner(api_server.create_api_app(), access_log=None)
+        await runner.setup()
+        site = web.TCPSite(runner, args.host, args.port, backlog=args.backlog)
+        await site.start()
+        print(f"🚀 heartbeat API: http://{args.host}:{args.port} (база {os.environ['DB_PATH']})", flush=True)
+        try:
+            await asyncio.Event().wait()
+        finally:
+            await runner.cleanup()
+    finally:
+        if args.keep_db:
+            print(f"💾 база лишилась: {tmpdir / 'state.db'}")
+        else:
+            shutil.rmtree(tmpdir, ignore_errors=True)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Heartbeat API на тимчасовій базі для fleet-sim")
+    parser.add_argument("--host", default="127.0.0.1", help="адреса прослуховування")
+    parser.add_argument("--port", type=int, default=18080, help="порт HTTP API")
+    parser.add_argument("--api-key", default="fleet-key", help="SENSOR_API_KEY (той самий, що --api-key fleet-sim)")
+    parser.add_argument(
+        "--interval-s",
+        type=int,
+        default=0,
+        help="SENSOR_HEARTBEAT_INTERVAL_SEC: період, який сервер роздає сенсорам (0 — не роздає)",
+    )
+    parser.add_argument("--backlog", type=int, default=4096, help="listen backlog: шторм — це тисячі SYN разом")
+    parser.add_argument("--keep-db", action="store_true", help="не видаляти базу після зупинки")
+    args = parser.parse_args()
+    try:
+        asyncio.run(serve(args))
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+"""
+Порівняння часу beat прошивки між двома збірками.
+
+Прошивка після кожного beat пише "⏱ beat: <мкс> мкс (...)" — від старту beat до обробки
+результату, разом з усім логуванням на шляху, — і рядок фаз "⏱ dns=… connect=… write=…
+ttfb=… response=… мкс". Знімаємо два логи Serial з однаковим інтервалом і мережею і
+порівнюємо розподіли. За замовчуванням — відкладене логування проти -DPB_LOG_DIRECT=1
+(синхронний Serial, як раніше); --labels підписує інші пари, наприклад Waveshare з
+arduino-libraries/Ethernet проти esp_eth (PB_W5500_DRIVER).
+
+Використання:
+    python sensor_log_bench.py direct.log deferred.log
+    python sensor_log_bench.py direct.log deferred.log --skip 1   # без першого beat (DNS/connect)
+    python sensor_log_bench.py ethernet.log esp_eth.log --labels ethernet,esp_eth
+
+Бінарний лог (PB_LOG_BINARY=1) спершу пропустити через sensor_log_decode.py.
+"""
+import argparse
+import re
+import sys
+from pathlib import Path
+
+_BEAT_RE = re.compile(r"⏱ beat: (\d+) мкс")
+_PHASE_RE = re.compile(r"⏱ dns=(\d+) connect=(\d+) write=(\d+) ttfb=(\d+) response=(\d+) мкс")
+_PHASES = ("dns", "connect", "write", "ttfb", "response")
+
+
+def load_beats(path: Path, skip: int) -> list[int]:
+    text = path.read_text(encoding="utf-8", errors="replace")
+    return [int(v) for v in _BEAT_RE.findall(text)][skip:]
+
+
+def load_phases(path: Path, skip: int) -> dict[str, list[int]]:
+    text = path.read_text(encoding="utf-8", errors="replace")
+    rows = [[int(v) for v in m] for m in _PHASE_RE.findall(text)][skip:]
+    return {name: [row[i] for row in rows] for i, name in enumerate(_PHASES)}
+
+
+def percentile(values: list[int], pct: int) -> int:
+    """Nearest-rank, як оцінка на прошивці (але точна, без кошиків)."""
+    ordered = sorted(values)
+    rank = max(1, -(-len(ordered) * pct // 100))
+    return ordered[rank - 1]
+
+
+def summary(values: list[int]) -> dict[str, int]:
+    return {
+        "beats": len(values),
+        "p50": percentile(values, 50),
+        "p95": percentile(values, 95),
+        "max": max(values),
+    }
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Порівняти '⏱ beat' двох логів сенсора")
+    parser.add_argument("baseline", type=Path, help="лог базової збірки (за замовчуванням PB_LOG_DIRECT=1)")
+    parser.add_argument("candidate", type=Path, help="лог нової збірки (за замовчуванням ring-буфер)")
+    parser.add_argument("--skip", type=int, default=0, help="пропустити перші N beat-ів кожного логу")
+    parser.add_argument("--labels", default="direct,deferred", help="підписи двох логів через кому")
+    args = parser.parse_args()
+    labels = args.labels.split(",")
+    if len(labels) != 2 or not all(labels):
+        parser.error("--labels: рівно два підписи через кому")
+
+    runs = []
+    phases = []
+    for path in (args.baseline, args.candidate):
+        beats = load_beats(path, args.skip)
+        if not beats:
+            print(f"❌ {path}: немає рядків '⏱ beat'", file=sys.stderr)
+            return 1
+        runs.append(summary(beats))
+        phases.append(load_phases(path, args.skip))
+
+    base, cand = runs
+    print(f"{'':10}{labels[0]:>12}{labels[1]:>12}{'різниця':>12}")
+    for key in ("beats", "p50", "p95", "max"):
+        delta = cand[key] - base[key]
+        change = f"{delta:+d}" if key == "beats" else f"{delta:+d} мкс"
+        print(f"{key:10}{base[key]:>12}{cand[key]:>12}{change:>12}")
+    if base["p50"]:
+        print(f"p50: x{base['p50'] / max(cand['p50'], 1):.1f} швидше")
+
+    # Фази — p50 по beat-ах, де фаза була (dns / connect = 0 на keep-alive beat-ах не рахуємо).
+    rows = []
+    for name in _PHASES:
+        a = [v for v in phases[0][name] if v]
+        b = [v for v in phases[1][name] if v]
+        if a and b:
+            rows.append((name, percentile(a, 50), percentile(b, 50)))
+    if rows:
+        print()
+        print(f"{'p50 фаз':10}{labels[0]:>12}{labels[1]:>12}{'різниця':>12}")
+        for name, a, b in rows:
+            print(f"{name:10}{a:>12}{b:>12}{f'{b - a:+d} мкс':>12}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""
+Декодер бінарного логу прошивки сенсора (PB_LOG_BINARY=1, include/pb_log.h).
+
+Прошивка пише в Serial кожен запис як 0x1E + [len u8][level u8][id u16 LE] + аргументи
+('u'/'d' + 4 байти LE, 's' + довжина u8 + байти). Текст форматів береться з
+include/pb_log_formats.h (номер = порядок рядка X(...)), тож таблиця має бути з тієї ж
+прошивки, що й дамп. Байти поза записами (boot-лог, паніки) виводяться як є.
+
+Використання:
+    python sensor_log_decode.py capture.bin
+    pio device monitor --raw | python sensor_log_decode.py -
+    python sensor_log_decode.py capture.bin --formats path/to/pb_log_formats.h
+"""
+import argparse
+import re
+import sys
+from pathlib import Path
+
+SCRIPT_DIR = Path(__file__).parent
+PROJECT_ROOT = SCRIPT_DIR.parent
+DEFAULT_FORMATS = PROJECT_ROOT / "sensors" / "lib" / "powerbot_core" / "include" / "pb_log_formats.h"
+
+SYNC = 0x1E
+HEADER = 4
+LEVELS = ("D", "I", "W", "E")
+
+_ENTRY_RE = re.compile(r"X\(\s*(\w+)\s*,((?:\s*\"(?:[^\"\\]|\\.)*\"\s*\\?)+)\)")
+_LITERAL_RE = re.compile(r"\"((?:[^\"\\]|\\.)*)\"")
+_SPEC_RE = re.compile(r"%(%|(0?)(\d*)[lh]*([sciduxX]))")
+
+
+def _unescape(literal: str) -> str:
+    """C-літерал -> рядок (лише екранування, які трапляються в таблиці)."""
+    return re.sub(
+        r"\\(.)",
+        lambda m: {"n": "\n", "t": "\t", "\\": "\\", '"': '"', "'": "'"}.get(m.group(1), m.group(1)),
+        literal,
+    )
+
+
+def load_formats(path: Path) -> list[tuple[str, str]]:
+    """[(Id, формат)] у порядку таблиці PB_LOG_FORMATS; сусідні літерали склеюються, як у C."""
+    text = path.read_text(encoding="utf-8")
+    body = text[text.index("#define PB_LOG_FORMATS"):]
+    return [
+        (m.group(1), "".join(_unescape(lit) for lit in _LITERAL_RE.findall(m.group(2))))
+        for m in _ENTRY_RE.finditer(body)
+    ]
+
+
+def _args(rec: bytes) -> list:
+    out: list = []
+    at = HEADER
+    while at < len(rec):
+        tag = rec[at]
+        if tag == ord("s") and at + 2 <= len(rec):
+            n = rec[at + 1]
+            out.append(rec[at + 2:at + 2 + n].decode("utf-8", "replace"))
+            at += 2 + n
+        elif tag in (ord("u"), ord("d")) and at + 5 <= len(rec):
+            v = int.from_bytes(rec[at + 1:at + 5], "little", signed=tag == ord("d"))
+            out.append(v)
+            at += 5
+        else:
+            break
+    return out
+
+
+def render(rec: bytes, formats: list[tuple[str, str]]) -> str:
+    """Те саме, що pbLogRender() у прошивці: відсутні аргументи -> "?"."""
+    if len(rec) < HEADER:
+        return ""
+    level, ident = rec[1], rec[2] | (rec[3] << 8)
+    if ident >= len(formats):
+        return f"[?] невідомий формат #{ident}: {rec.hex()}"
+    args = iter(_args(rec))
+
+    def one(m: re.Match) -> str:
+        if m.group(1) == "%":
+            return "%"
+        zero, width, conv = m.group(2), m.group(3), m.group(4)
+        v = next(args, "?")
+        if isinstance(v, int):
+            if conv in "di":
+                s = str(v)
+            elif conv == "c":
+                s = chr(v & 0xFF)
+            elif conv in "xX":
+                s = format(v & 0xFFFFFFFF, conv)
+            else:
+                s = str(v & 0xFFFFFFFF)
+        else:
+            s = str(v)
+        if width:
+            s = s.rjust(int(width), "0" if zero and conv != "s" and v != "?" else " ")
+        return s
+
+    text = _SPEC_RE.sub(one, formats[ident][1])
+    tag = LEVELS[level] if level < len(LEVELS) else "?"
+    return f"[{tag}] {text}"
+
+
+def decode(data: bytes, formats: list[tuple[str, str]]):
+    """Рядки виводу: декодовані записи і сирий текст між ними."""
+    raw = bytearray()
+    at = 0
+    while at < len(data):
+        b = data[at]
+        if b == SYNC and at + 1 < len(data) and data[at + 1] >= HEADER and at + 1 + data[at + 1] <= len(data):
+            if raw:
+                yield raw.decode("utf-8", "replace")
+                raw.clear()
+            n = data[at + 1]
+            yield render(bytes(data[at + 1:at + 1 + n]), formats) + "\n"
+            at += 1 + n
+            continue
+        raw.append(b)
+        at += 1
+    if raw:
+        yield raw.decode("utf-8", "replace")
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Декодер бінарного логу сенсора (PB_LOG_BINARY=1)")
+    parser.add_argument("capture", help="файл з дампом Serial або '-' для stdin")
+    parser.add_argument("--formats", type=Path, default=DEFAULT_FORMATS, help="pb_log_formats.h прошивки")
+    args = parser.parse_args()
+
+    formats = load_formats(args.formats)
+    if not formats:
+        print(f"❌ У {args.formats} не знайдено PB_LOG_FORMATS", file=sys.stderr)
+        return 1
+    data = sys.stdin.buffer.read() if args.capture == "-" else Path(args.capture).read_bytes()
+    for chunk in decode(data, formats):
+        sys.stdout.write(chunk)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -6,6 +6,7 @@ Policy:
 - Every `CREATE TABLE IF NOT EXISTS ...` in runtime must exist in schema.sql.
 - Every `CREATE TABLE IF NOT EXISTS ...` in schema.sql must exist in runtime.
 - Same for `CREATE [UNIQUE] INDEX IF NOT EXISTS ...`.
+- Columns of each table (CREATE TABLE + runtime `ALTER TABLE ... ADD COLUMN` migrations) match.
 """
 
 from __future__ import annotations
@@ -16,6 +17,10 @@ from pathlib import Path
 
 TABLE_RE = re.compile(r"CREATE TABLE IF NOT EXISTS\s+([a-zA-Z0-9_]+)", re.IGNORECASE)
 INDEX_RE = re.compile(r"CREATE (?:UNIQUE\s+)?INDEX IF NOT EXISTS\s+([a-zA-Z0-9_]+)", re.IGNORECASE)
+TABLE_HEAD_RE = re.compile(r"CREATE TABLE IF NOT EXISTS\s+([a-zA-Z0-9_]+)\s*\(", re.IGNORECASE)
+ADD_COLUMN_RE = re.compile(r"ALTER TABLE\s+([a-zA-Z0-9_]+)\s+ADD COLUMN\s+([a-zA-Z0-9_]+)", re.IGNORECASE)
+COLUMN_NAME_RE = re.compile(r"([a-zA-Z_][a-zA-Z0-9_]*)\s")
+CONSTRAINT_WORDS = {"CONSTRAINT", "PRIMARY", "FOREIGN", "UNIQUE", "CHECK"}
 
 
 def _read(path: Path) -> str:
@@ -28,6 +33,42 @@ def _extract_set(pattern: re.Pattern[str], text: str) -> set[str]:
     return {name.strip() for name in pattern.findall(text)}
 
 
+def _split_top_level(body: str) -> list[str]:
+    parts: list[str] = []
+    depth = 0
+    start = 0
+    for i, ch in enumerate(body):
+        if ch == "(":
+            depth += 1
+        elif ch == ")":
+            depth -= 1
+        elif ch == "," and depth == 0:
+            parts.append(body[start:i])
+            start = i + 1
+    parts.append(body[start:])
+    return parts
+
+
+def _extract_columns(text: str) -> dict[str, set[str]]:
+    """table -> columns from CREATE TABLE bodies (comments and constraints skipped) + ADD COLUMN migrations."""
+    columns: dict[str, set[str]] = {}
+    for match in TABLE_HEAD_RE.finditer(text):
+        depth = 1
+        end = match.end()
+        while end < len(text) and depth > 0:
+            depth += {"(": 1, ")": -1}.get(text[end], 0)
+            end += 1
+        body = "\n".join(line.split("--", 1)[0] for line in text[match.end():end - 1].splitlines())
+        table_columns = columns.setdefault(match.group(1), set())
+        for part in _split_top_level(body):
+            name = COLUMN_NAME_RE.match(part.strip() + " ")
+            if name and name.group(1).upper() not in CONSTRAINT_WORDS:
+                table_columns.add(name.group(1))
+    for table, column in ADD_COLUMN_RE.findall(text):
+        columns.setdefault(table, set()).add(column)
+    return columns
+
+
 def main() -> None:
     root = Path(__file__).resolve().parents[1]
     schema_text = _read(root / "schema.sql")
@@ -54,6 +95,16 @@ def main() -> None:
     if only_schema_indexes:
         errors.append(f"indexes only in schema: {only_schema_indexes}")
 
+    schema_columns = _extract_columns(schema_text)
+    runtime_columns = _extract_columns(runtime_text)
+    for table in sorted(schema_tables & runtime_tables):
+        only_runtime_columns = sorted(runtime_columns.get(table, set()) - schema_columns.get(table, set()))
+        only_schema_columns = sorted(schema_columns.get(table, set()) - runtime_columns.get(table, set()))
+        if only_runtime_columns:
+            errors.append(f"{table}: columns only in runtime: {only_runtime_columns}")
+        if only_schema_columns:
+            errors.append(f"{table}: columns only in schema: {only_schema_columns}")
+
     if errors:
         raise SystemExit("ERROR: schema/runtime parity violation(s):\n- " + "\n- ".join(errors))
 
@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""
+Smoke test: batched heartbeats from a building aggregator (firmware PB_ROLE=AGGREGATOR).
+
+Checks:
+- POST /api/v1/heartbeat/batch stores every valid beat in ONE upsert_sensor_heartbeats() call.
+- Per-beat statuses come back in request order: sensor known only by frame uuid_hash -> 200,
+  unknown uuid_hash -> 404, invalid section -> 400; the rest of the batch is still stored.
+- New sensors in a batch are registered like on a single JSON heartbeat (boot resets seq).
+- age_ms back-dates the beat (capped by SENSOR_TIMEOUT), but never behind a newer stored beat.
+- power_lost inside a batch marks the sensor offline.
+- A delayed (aged) batch never moves last_heartbeat backwards and keeps a power_lost newer than the beat.
+- Invalid api_key -> 401, too many beats -> 413; accepted batch carries X-PB-Interval-Ms.
+
+Run (inside container):
+  docker compose exec -T powerbot python - < scripts/smoke_sensor_heartbeat_batch.py
+"""
+
+from __future__ import annotations
+
+import asyncio
+import os
+import shutil
+import sys
+import tempfile
+from datetime import datetime, timedelta
+from pathlib import Path
+
+
+REPO_ROOT: Path | None = None
+for candidate in (Path.cwd(), Path("/app")):
+    if (candidate / "src" / "database.py").exists() and (candidate / "src" / "api_server.py").exists():
+        REPO_ROOT = candidate
+        break
+if REPO_ROOT is None:
+    raise RuntimeError("Cannot locate repo root (src/database.py + src/api_server.py).")
+
+sys.path.insert(0, str(REPO_ROOT / "src"))
+
+SMOKE_API_KEY = "smoke-batch-key"
+AGGREGATOR_UUID = "smoke-batch-agg"
+PEER_UUID = "smoke-batch-peer"
+NEW_UUID = "smoke-batch-new"
+
+
+def _assert(cond: bool, msg: str) -> None:
+    if not cond:
+        raise AssertionError(msg)
+
+
+async def main() -> None:
+    tmpdir = Path(tempfile.mkdtemp(prefix="powerbot-smoke-batch-"))
+    old_db_path = os.environ.get("DB_PATH")
+    os.environ["DB_PATH"] = str(tmpdir / "state.db")
+
+    try:
+        # Import only after DB_PATH override.
+        import database  # noqa: WPS433,E402
+        import api_server  # noqa: WPS433,E402
+        from aiohttp import ClientSession, web  # noqa: WPS433,E402
+        from sensor_frame import sensor_uuid_hash  # noqa: WPS433,E402
+
+        await database.init_db()
+
+        old_key = api_server.CFG.sensor_api_key
+        old_interval = api_server.CFG.sensor_heartbeat_interval
+        old_upsert = api_server.upsert_sensor_heartbeats
+        api_server.CFG.sensor_api_key = SMOKE_API_KEY
+        api_server.CFG.sensor_heartbeat_interval = 20
+        upsert_calls: list[int] = []
+
+        async def _counting_upsert(beats: list[dict]) -> list[dict | None]:
+            upsert_calls.append(len(beats))
+            return await old_upsert(beats)
+
+        api_server.upsert_sensor_heartbeats = _counting_upsert
+        runner = web.AppRunner(api_server.create_api_app())
+        await runner.setup()
+        site = web.TCPSite(runner, "127.0.0.1", 0)
+        await site.start()
+        port = site._server.sockets[0].getsockname()[1]  # noqa: SLF001
+        url = f"http://127.0.0.1:{port}/api/v1/heartbeat/batch"
+
+        try:
+            async with ClientSession() as session:
+                # Peer registered earlier by its own JSON heartbeat (through the aggregator or directly).
+                status, _ = await api_server.process_sensor_heartbeat(
+                    {"api_key": SMOKE_API_KEY, "building_id": 1, "section_id": 2, "sensor_uuid": PEER_UUID, "seq": 5}
+                )
+                _assert(status == 200, f"peer registration failed: {status}")
+
+                batch = {
+                    "api_key": SMOKE_API_KEY,
+                    "building_id": 1,
+                    "sensor_uuid": AGGREGATOR_UUID,
+                    "beats": [
+                        {"sensor_uuid": AGGREGATOR_UUID, "section_id": 1, "event": "boot", "seq": 1, "heap_free": 1000},
+                        {"uuid_hash": sensor_uuid_hash(PEER_UUID).hex(), "section_id": 2, "seq": 6, "age_ms": 30000},
+                        {"uuid_hash": "00" * 8, "section_id": 3, "seq": 1},
+                        {"sensor_uuid": NEW_UUID, "section_id": 99, "seq": 1},
+                        {"sensor_uuid": NEW_UUID, "section_id": 3, "event": "boot", "seq": 1, "age_ms": 10**9},
+                    ],
+                }
+                async with session.post(url, json=batch) as resp:
+                    _assert(resp.status == 200, f"batch: unexpected status {resp.status}")
+                    _assert(resp.headers.get("X-PB-Interval-Ms") == "20000", "batch: X-PB-Interval-Ms missing")
+                    body = await resp.json()
+                _assert(body.get("results") == [200, 200, 404, 400, 200], f"batch: unexpected results {body!r}")
+                _assert(body.get("stored") == 3, f"batch: unexpected stored {body!r}")
+                _assert(upsert_calls == [3], f"batch must be stored in one transaction, got {upsert_calls}")
+
+                now = datetime.now()
+                timeout = timedelta(seconds=int(api_server.CFG.sensor_timeout))
+                sensors = {s["uuid"]: s for s in await database.get_all_active_sensors()}
+                for uuid in (AGGREGATOR_UUID, PEER_UUID, NEW_UUID):
+                    _assert(uuid in sensors, f"{uuid} not stored")
+                agg = sensors[AGGREGATOR_UUID]
+                _assert(agg["section_id"] == 1, f"aggregator section: {agg!r}")
+                _assert(agg.get("telemetry") == {"heap_free": 1000}, f"aggregator telemetry: {agg.get('telemetry')!r}")
+                _assert(now - agg["last_heartbeat"] < timedelta(seconds=5), "aggregator beat must be fresh")
+                # The peer's direct beat is newer than its relayed one (age_ms 30 s): last_heartbeat stays.
+                peer_age = now - sensors[PEER_UUID]["last_heartbeat"]
+                _assert(peer_age < timedelta(seconds=5), f"aged beat moved peer last_heartbeat back: {peer_age}")
+                _assert(
+                    sensors[PEER_UUID].get("heartbeat_seq") == {"last": 6, "received": 2, "lost": 0},
+                    f"peer seq: {sensors[PEER_UUID].get('heartbeat_seq')!r}",
+                )
+                new_age = now - sensors[NEW_UUID]["last_heartbeat"]
+                _assert(timeout - timedelta(seconds=5) < new_age <= timeout + timedelta(seconds=5), f"age cap: {new_age}")
+                _assert(sensors[NEW_UUID]["section_id"] == 3, f"new sensor section: {sensors[NEW_UUID]!r}")
+
+                # Last-gasp of a peer relayed by the aggregator.
+                lost = {
+                    "api_key": SMOKE_API_KEY,
+                    "building_id": 1,
+                    "beats": [{"uuid_hash": sensor_uuid_hash(PEER_UUID).hex(), "event": "power_lost", "seq": 6}],
+                }
+                async with session.post(url, json=lost) as resp:
+                    body = await resp.json()
+                    _assert(resp.status == 200 and body.get("results") == [200], f"power_lost batch: {body!r}")
+                peer = await database.get_sensor_by_uuid(PEER_UUID)
+                _assert(peer and peer.get("power_lost_at") is not None, "power_lost in batch not stored")
+                _assert(upsert_calls == [3], "power_lost-only batch must not upsert heartbeats")
+
+                # A batch delayed past the last-gasp: the peer beat is older than power_lost_at, and the
+                # aggregator's own beat is older than the direct one stored above.
+                lost_at = peer["power_lost_at"]
+                agg_heard = (await database.get_sensor_by_uuid(AGGREGATOR_UUID))["last_heartbeat"]
+                delayed = {
+                    "api_key": SMOKE_API_KEY,
+                    "building_id": 1,
+                    "beats": [
+                        {"sensor_uuid": AGGREGATOR_UUID, "section_id": 1, "seq": 2, "age_ms": 60000},
+                        {"uuid_hash": sensor_uuid_hash(PEER_UUID).hex(), "section_id": 2, "seq": 7, "age_ms": 20000},
+                    ],
+                }
+                async with session.post(url, json=delayed) as resp:
+                    body = await resp.json()
+                    _assert(resp.status == 200 and body.get("results") == [200, 200], f"delayed batch: {body!r}")
+                peer = await database.get_sensor_by_uuid(PEER_UUID)
+                _assert(peer.get("power_lost_at") == lost_at, f"aged beat cleared a newer power_lost: {peer!r}")
+                _assert(peer["last_heartbeat"] < lost_at, f"peer last_heartbeat: {peer!r}")
+                agg = await database.get_sensor_by_uuid(AGGREGATOR_UUID)
+                _assert(agg["last_heartbeat"] == agg_heard, f"aged beat moved last_heartbeat back: {agg!r}")
+
+                # A fresh beat after the outage brings the peer back.
+                fresh = dict(delayed, beats=[{"uuid_hash": sensor_uuid_hash(PEER_UUID).hex(), "section_id": 2, "seq": 8}])
+                async with session.post(url, json=fresh) as resp:
+                    _assert(resp.status == 200, f"fresh batch: unexpected status {resp.status}")
+                peer = await database.get_sensor_by_uuid(PEER_UUID)
+                _assert(peer.get("power_lost_at") is None, f"fresh beat must clear power_lost: {peer!r}")
+
+                bad_key = dict(batch, api_key="wrong")
+                async with session.post(url, json=bad_key) as resp:
+                    _assert(resp.status == 401, f"bad api_key: expected 401, got {resp.status}")
+                too_many = dict(batch, beats=[batch["beats"][0]] * (api_server.SENSOR_BATCH_MAX_BEATS + 1))
+                async with session.post(url, json=too_many) as resp:
+                    _assert(resp.status == 413, f"too many beats: expected 413, got {resp.status}")
+                async with session.post(url, data=b"{", headers={"Content-Type": "application/json"}) as resp:
+                    _assert(resp.status == 400, f"bad JSON: expected 400, got {resp.status}")
+        finally:
+            await runner.cleanup()
+            api_server.CFG.sensor_api_key = old_key
+            api_server.CFG.sensor_heartbeat_interval = old_interval
+            api_server.upsert_sensor_heartbeats = old_upsert
+
+        print("OK: sensor heartbeat batch smoke passed.")
+    finally:
+        if old_db_path is None:
+            os.environ.pop("DB_PATH", None)
+        else:
+            os.environ["DB_PATH"] = old_db_path
+        shutil.rmtree(tmpdir, ignore_errors=True)
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -0,0 +1,245 @@
+#!/usr/bin/env python3
+"""
+Smoke test: binary HMAC heartbeat frame (firmware PB_HB_FRAME=1) over HTTP and UDP.
+
+Checks:
+- frame from an unknown sensor -> 404 (firmware falls back to a JSON heartbeat);
+- after JSON registration the frame is accepted: sensor online, seq counted, uptime_s stored;
+- frame with a bad signature -> 401 over HTTP, silence over UDP;
+- UDP frame -> "OK <seq>" ack;
+- power_lost frame -> sensor offline right away;
+- replayed heartbeat / power_lost / boot frame -> 409 over HTTP, "ERR 409" over UDP,
+  last_heartbeat and power_lost_at untouched; frames (and boot) of an earlier boot_count -> 409
+  even with a small uptime / seq;
+- JSON boot with a new boot_count re-anchors: frames of the new boot accepted, old ones 409.
+
+Run (inside container):
+  docker compose exec -T powerbot python - < scripts/smoke_sensor_heartbeat_frame.py
+"""
+
+from __future__ import annotations
+
+import asyncio
+import json
+import os
+import shutil
+import sys
+import tempfile
+from datetime import datetime, timedelta
+from pathlib import Path
+
+
+REPO_ROOT: Path | None = None
+for candidate in (Path.cwd(), Path("/app")):
+    if (candidate / "src" / "database.py").exists() and (candidate / "src" / "api_server.py").exists():
+        REPO_ROOT = candidate
+        break
+if REPO_ROOT is None:
+    raise RuntimeError("Cannot locate repo root (src/database.py + src/api_server.py).")
+
+sys.path.insert(0, str(REPO_ROOT / "src"))
+
+SMOKE_API_KEY = "smoke-frame-key"
+SMOKE_UUID = "smoke-frame-001"
+ACK_TIMEOUT_SEC = 1.0
+NO_ACK_TIMEOUT_SEC = 0.3
+OCTET_STREAM = {"Content-Type": "application/octet-stream"}
+
+
+def _assert(cond: bool, msg: str) -> None:
+    if not cond:
+        raise AssertionError(msg)
+
+
+class _AckCollector(asyncio.DatagramProtocol):
+    def __init__(self) -> None:
+        self.acks: asyncio.Queue[bytes] = asyncio.Queue()
+
+    def datagram_received(self, data: bytes, addr: tuple) -> None:
+        self.acks.put_nowait(data)
+
+
+async def main() -> None:
+    tmpdir = Path(tempfile.mkdtemp(prefix="powerbot-smoke-frame-"))
+    old_db_path = os.environ.get("DB_PATH")
+    os.environ["DB_PATH"] = str(tmpdir / "state.db")
+
+    try:
+        # Import only after DB_PATH override.
+        import database  # noqa: WPS433,E402
+        import api_server  # noqa: WPS433,E402
+        from sensor_frame import SensorFrameKey, encode_sensor_frame  # noqa: WPS433,E402
+        from aiohttp import ClientSession, web  # noqa: WPS433,E402
+
+        await database.init_db()
+
+        key = SensorFrameKey(SMOKE_API_KEY)
+
+        def _frame(
+            seq: int,
+            event: str = "heartbeat",
+            frame_key: SensorFrameKey = key,
+            uptime_s: int | None = None,
+            boot_count: int = 3,
+        ) -> bytes:
+            return encode_sensor_frame(
+                frame_key,
+                event=event,
+                building_id=1,
+                section_id=1,
+                sensor_uuid=SMOKE_UUID,
+                seq=seq,
+                uptime_s=60 * seq if uptime_s is None else uptime_s,
+                boot_count=boot_count,
+            )
+
+        async def _beat_state() -> tuple:
+            sensor = await database.get_sensor_by_uuid(SMOKE_UUID)
+            return sensor["last_heartbeat"], sensor["power_lost_at"]
+
+        old_key = api_server.CFG.sensor_api_key
+        api_server.CFG.sensor_api_key = SMOKE_API_KEY
+        runner = web.AppRunner(api_server.create_api_app())
+        await runner.setup()
+        site = web.TCPSite(runner, "127.0.0.1", 0)
+        await site.start()
+        port = site._server.sockets[0].getsockname()[1]  # noqa: SLF001
+        url = f"http://127.0.0.1:{port}/api/v1/heartbeat"
+        timeout = timedelta(seconds=api_server.CFG.sensor_timeout)
+
+        listener = await api_server.start_sensor_udp_listener(host="127.0.0.1", port=0)
+        _assert(listener is not None, "UDP listener did not start")
+        loop = asyncio.get_running_loop()
+        client, collector = await loop.create_datagram_endpoint(
+            _AckCollector, remote_addr=("127.0.0.1", listener.get_extra_info("sockname")[1])
+        )
+
+        try:
+            async with ClientSession() as session:
+                # 1) Unknown sensor: frame can't register it.
+                async with session.post(url, data=_frame(1), headers=OCTET_STREAM) as resp:
+                    _assert(resp.status == 404, f"unknown frame: expected 404, got {resp.status}")
+                _assert(await database.get_sensor_by_uuid(SMOKE_UUID) is None, "frame must not register sensors")
+
+                # 2) JSON registration (boot), then frames.
+                boot = {
+                    "api_key": SMOKE_API_KEY,
+                    "building_id": 1,
+                    "section_id": 1,
+                    "sensor_uuid": SMOKE_UUID,
+                    "event": "boot",
+                    "seq": 1,
+                    "boot_count": 3,
+                }
+                async with session.post(url, data=json.dumps(boot), headers={"Content-Type": "application/json"}) as resp:
+                    _assert(resp.status == 200, f"JSON boot: unexpected status {resp.status}")
+                async with session.post(url, data=_frame(2), headers=OCTET_STREAM) as resp:
+                    _assert(resp.status == 200, f"frame: unexpected status {resp.status}")
+                    body = await resp.json()
+                _assert(body.get("sensor_uuid") == SMOKE_UUID, f"frame: bad body {body!r}")
+
+                # 3) Bad signature.
+                async with session.post(
+                    url, data=_frame(3, frame_key=SensorFrameKey("wrong")), headers=OCTET_STREAM
+                ) as resp:
+                    _assert(resp.status == 401, f"bad frame: expected 401, got {resp.status}")
+
+            # 4) UDP: frame acked with its seq; forged frame ignored.
+            client.sendto(_frame(4))
+            ack = await asyncio.wait_for(collector.acks.get(), ACK_TIMEOUT_SEC)
+            _assert(ack == b"OK 4", f"UDP frame: unexpected ack {ack!r}")
+            client.sendto(_frame(5, frame_key=SensorFrameKey("wrong")))
+            try:
+                ack = await asyncio.wait_for(collector.acks.get(), NO_ACK_TIMEOUT_SEC)
+            except asyncio.TimeoutError:
+                pass
+            else:
+                raise AssertionError(f"forged UDP frame must not be acked, got {ack!r}")
+
+            sensors = await database.get_all_active_sensors()
+            sensor = next((s for s in sensors if s["uuid"] == SMOKE_UUID), None)
+            _assert(sensor is not None, "smoke sensor missing")
+            _assert(database.sensor_heartbeat_is_fresh(sensor, datetime.now(), timeout), "sensor must be online")
+            # 1 (JSON boot), 2 (HTTP frame), 4 (UDP frame); 3 was forged -> lost.
+            _assert(
+                sensor.get("heartbeat_seq") == {"last": 4, "received": 3, "lost": 1},
+                f"unexpected seq stats: {sensor.get('heartbeat_seq')!r}",
+            )
+            _assert(
+                (sensor.get("telemetry") or {}).get("uptime_s") == 240,
+                f"uptime_s must be stored from frame: {sensor.get('telemetry')!r}",
+            )
+
+            # 5) Last-gasp frame.
+            async with ClientSession() as session:
+                async with session.post(url, data=_frame(4, event="power_lost"), headers=OCTET_STREAM) as resp:
+                    _assert(resp.status == 200, f"power_lost frame: unexpected status {resp.status}")
+            sensor = await database.get_sensor_by_uuid(SMOKE_UUID)
+            _assert(
+                not database.sensor_heartbeat_is_fresh(sensor, datetime.now(), timeout),
+                "sensor must be offline after power_lost frame",
+            )
+
+            # 6) Replays: a captured frame must not bring the sensor back or take it down.
+            async with ClientSession() as session:
+                before = await _beat_state()
+                async with session.post(url, data=_frame(4), headers=OCTET_STREAM) as resp:
+                    _assert(resp.status == 409, f"replayed heartbeat: expected 409, got {resp.status}")
+                _assert(await _beat_state() == before, "replayed heartbeat must not touch the sensor")
+
+                async with session.post(url, data=_frame(6), headers=OCTET_STREAM) as resp:
+                    _assert(resp.status == 200, f"fresh frame after power_lost: unexpected status {resp.status}")
+                sensor = await database.get_sensor_by_uuid(SMOKE_UUID)
+                _assert(database.sensor_heartbeat_is_fresh(sensor, datetime.now(), timeout), "sensor must be back online")
+
+                before = await _beat_state()
+                async with session.post(url, data=_frame(4, event="power_lost"), headers=OCTET_STREAM) as resp:
+                    _assert(resp.status == 409, f"replayed power_lost: expected 409, got {resp.status}")
+                async with session.post(url, data=_frame(6, event="boot"), headers=OCTET_STREAM) as resp:
+                    _assert(resp.status == 409, f"replayed boot: expected 409, got {resp.status}")
+                # Captured frames of an earlier boot: small uptime / seq must not reopen that epoch.
+                async with session.post(
+                    url, data=_frame(1, event="boot", uptime_s=3, boot_count=2), headers=OCTET_STREAM
+                ) as resp:
+                    _assert(resp.status == 409, f"old-boot boot frame: expected 409, got {resp.status}")
+                async with session.post(url, data=_frame(100, boot_count=2), headers=OCTET_STREAM) as resp:
+                    _assert(resp.status == 409, f"old-boot frame: expected 409, got {resp.status}")
+                _assert(await _beat_state() == before, "replayed power_lost/boot must not touch the sensor")
+
+            client.sendto(_frame(6))
+            ack = await asyncio.wait_for(collector.acks.get(), ACK_TIMEOUT_SEC)
+            _assert(ack == b"ERR 409 6", f"replayed UDP frame: unexpected ack {ack!r}")
+            _assert(await _beat_state() == before, "replayed UDP frame must not touch the sensor")
+
+            # 7) Real reboot: JSON boot re-anchors the stream, frames from the new epoch are accepted.
+            async with ClientSession() as session:
+                reboot = dict(boot, uptime_s=5, boot_count=4)
+                async with session.post(url, data=json.dumps(reboot), headers={"Content-Type": "application/json"}) as resp:
+                    _assert(resp.status == 200, f"JSON reboot: unexpected status {resp.status}")
+                async with session.post(url, data=_frame(2, uptime_s=65, boot_count=4), headers=OCTET_STREAM) as resp:
+                    _assert(resp.status == 200, f"frame after reboot: unexpected status {resp.status}")
+                async with session.post(url, data=_frame(7), headers=OCTET_STREAM) as resp:
+                    _assert(resp.status == 409, f"old-epoch frame after reboot: expected 409, got {resp.status}")
+            sensors = await database.get_all_active_sensors()
+            sensor = next(s for s in sensors if s["uuid"] == SMOKE_UUID)
+            _assert(
+                (sensor.get("telemetry") or {}).get("boot_count") == 4,
+                f"boot_count must be stored from frame: {sensor.get('telemetry')!r}",
+            )
+        finally:
+            client.close()
+            await api_server.stop_sensor_udp_listener(listener)
+            await runner.cleanup()
+            api_server.CFG.sensor_api_key = old_key
+
+        print("OK: sensor heartbeat frame smoke passed.")
+    finally:
+        if old_db_path is None:
+            os.environ.pop("DB_PATH", None)
+        else:
+            os.environ["DB_PATH"] = old_db_path
+        shutil.rmtree(tmpdir, ignore_errors=True)
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""
+Static smoke-check: binary heartbeat frame (firmware PB_HB_FRAME=1) matches the shared test vectors.
+
+The same vectors file is checked by the firmware host test
+(sensors/lib/powerbot_core/test/test_hb_frame), so encoder and decoder can't drift apart.
+
+Checks:
+- src/sensor_frame.py encodes every vector byte-for-byte;
+- decode returns the same fields (uuid resolved via sensor_uuid_hash);
+- any flipped byte, wrong key or wrong length -> rejected.
+
+Run:
+  python3 scripts/smoke_sensor_heartbeat_frame_vectors.py
+"""
+
+from __future__ import annotations
+
+import sys
+from pathlib import Path
+
+
+def _resolve_repo_root() -> Path:
+    candidates = []
+    try:
+        candidates.append(Path(__file__).resolve().parents[1])
+    except Exception:
+        pass
+    candidates.append(Path.cwd())
+    for path in candidates:
+        if (path / "src/sensor_frame.py").exists():
+            return path
+    return candidates[0]
+
+
+REPO_ROOT = _resolve_repo_root()
+VECTORS_PATH = REPO_ROOT / "sensors/lib/powerbot_core/test/heartbeat_frame_vectors.txt"
+
+sys.path.insert(0, str(REPO_ROOT / "src"))
+
+from sensor_frame import (  # noqa: E402
+    SENSOR_FRAME_SIZE,
+    SensorFrameKey,
+    decode_sensor_frame,
+    encode_sensor_frame,
+    sensor_uuid_hash,
+)
+
+
+def _assert(cond: bool, msg: str) -> None:
+    if not cond:
+        raise AssertionError(msg)
+
+
+def main() -> None:
+    _assert(SENSOR_FRAME_SIZE == 36, f"frame size changed: {SENSOR_FRAME_SIZE}")
+    _assert(VECTORS_PATH.exists(), f"missing vectors file: {VECTORS_PATH}")
+
+    checked = 0
+    for lineno, line in enumerate(VECTORS_PATH.read_text(encoding="utf-8").splitlines(), start=1):
+        if not line.strip() or line.startswith("#"):
+            continue
+        key, building, section, uuid, event, seq, uptime, boot_count, frame_hex = line.split()
+        where = f"{VECTORS_PATH.name}:{lineno}"
+        frame_key = SensorFrameKey(key)
+        expected = bytes.fromhex(frame_hex)
+
+        encoded = encode_sensor_frame(
+            frame_key,
+            event=event,
+            building_id=int(building),
+            section_id=int(section),
+            sensor_uuid=uuid,
+            seq=int(seq),
+            uptime_s=int(uptime),
+            boot_count=int(boot_count),
+        )
+        _assert(encoded == expected, f"{where}: encode mismatch {encoded.hex()} != {frame_hex}")
+
+        frame = decode_sensor_frame(expected, frame_key)
+        _assert(frame is not None, f"{where}: valid frame rejected")
+        _assert(
+            (frame.event, frame.building_id, frame.section_id, frame.uuid_hash, frame.seq, frame.uptime_s,
+             frame.boot_count)
+            == (event, int(building), int(section), sensor_uuid_hash(uuid), int(seq), int(uptime), int(boot_count)),
+            f"{where}: decoded fields mismatch: {frame!r}",
+        )
+
+        for idx in range(len(expected)):
+            tampered = bytearray(expected)
+            tampered[idx] ^= 0x01
+            _assert(decode_sensor_frame(bytes(tampered), frame_key) is None, f"{where}: byte {idx} flip accepted")
+        _assert(decode_sensor_frame(expected, SensorFrameKey(key + "x")) is None, f"{where}: wrong key accepted")
+        _assert(decode_sensor_frame(expected[:-1], frame_key) is None, f"{where}: short frame accepted")
+        _assert(decode_sensor_frame(expected + b"\x00", frame_key) is None, f"{where}: long frame accepted")
+        checked += 1
+
+    _assert(checked > 0, "no vectors checked")
+    print(f"OK: sensor heartbeat frame vectors smoke passed ({checked} vectors).")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+"""
+Smoke test: heartbeat keep-alive contract (firmware PB_HTTP_KEEPALIVE=1).
+
+Checks:
+- Several heartbeats written back-to-back on ONE raw TCP socket (exactly like the
+  firmware does: HTTP/1.1 + Content-Length + `Connection: keep-alive`) all succeed.
+- Server never answers with `Connection: close` for a keep-alive heartbeat.
+- Firmware connection counters (`conn_new` / `conn_reused`) are stored as sensor
+  telemetry and exposed via GET /api/v1/sensors.
+- Per-phase latency summary (`hb_lat`) is stored with it; malformed phases are dropped.
+- Beat interval deviation summary (`hb_int`) is stored with it.
+- DNS refresh summary (`hb_dns`) is stored with it.
+- Mains quality summary (`mains_v` / `mains_hz`) is stored with it; malformed arrays are dropped.
+- SENSOR_HEARTBEAT_INTERVAL_SEC -> `X-PB-Interval-Ms` header on beat responses (absent when 0).
+
+Run (inside container):
+  docker compose exec -T powerbot python - < scripts/smoke_sensor_heartbeat_keepalive.py
+"""
+
+from __future__ import annotations
+
+import asyncio
+import json
+import os
+import shutil
+import sys
+import tempfile
+from pathlib import Path
+
+
+REPO_ROOT: Path | None = None
+for candidate in (Path.cwd(), Path("/app")):
+    if (candidate / "src" / "database.py").exists() and (candidate / "src" / "api_server.py").exists():
+        REPO_ROOT = candidate
+        break
+if REPO_ROOT is None:
+    raise RuntimeError("Cannot locate repo root (src/database.py + src/api_server.py).")
+
+sys.path.insert(0, str(REPO_ROOT / "src"))
+
+SMOKE_API_KEY = "smoke-keepalive-key"
+SMOKE_UUID = "smoke-keepalive-001"
+
+
+def _assert(cond: bool, msg: str) -> None:
+    if not cond:
+        raise AssertionError(msg)
+
+
+async def _read_http_response(reader: asyncio.StreamReader) -> tuple[int, dict[str, str], bytes]:
+    status_line = (await reader.readline()).decode("latin-1").strip()
+    parts = status_line.split(" ", 2)
+    _assert(len(parts) >= 2 and parts[1].isdigit(), f"bad status line: {status_line!r}")
+    headers: dict[str, str] = {}
+    while True:
+        line = (await reader.readline()).decode("latin-1").strip()
+        if not line:
+            break
+        name, _, value = line.partition(":")
+        headers[name.strip().lower()] = value.strip()
+    length = int(headers.get("content-length", "0"))
+    body = await reader.readexactly(length) if length else b""
+    return int(parts[1]), headers, body
+
+
+async def main() -> None:
+    tmpdir = Path(tempfile.mkdtemp(prefix="powerbot-smoke-keepalive-"))
+    old_db_path = os.environ.get("DB_PATH")
+    os.environ["DB_PATH"] = str(tmpdir / "state.db")
+
+    try:
+        # Import only after DB_PATH override.
+        import database  # noqa: WPS433,E402
+        import api_server  # noqa: WPS433,E402
+        from aiohttp import ClientSession, web  # noqa: WPS433,E402
+
+        await database.init_db()
+
+        old_key = api_server.CFG.sensor_api_key
+        old_interval = api_server.CFG.sensor_heartbeat_interval
+        api_server.CFG.sensor_api_key = SMOKE_API_KEY
+        api_server.CFG.sensor_heartbeat_interval = 0
+        runner = web.AppRunner(api_server.create_api_app())
+        await runner.setup()
+        site = web.TCPSite(runner, "127.0.0.1", 0)
+        await site.start()
+        port = site._server.sockets[0].getsockname()[1]  # noqa: SLF001
+
+        try:
+            reader, writer = await asyncio.open_connection("127.0.0.1", port)
+            for beat in range(1, 4):
+                if beat == 3:
+                    api_server.CFG.sensor_heartbeat_interval = 30
+                payload = json.dumps(
+                    {
+                        "api_key": SMOKE_API_KEY,
+                        "building_id": 1,
+                        "section_id": 1,
+                        "sensor_uuid": SMOKE_UUID,
+                        "conn_new": 1,
+                        "conn_reused": beat - 1,
+                        "log_drops": beat * 3,
+                        "hb_lat": {
+                            "dns": [1800, 3000, 3000, 0],
+                            "ttfb": [40000, 250000 * beat, 250000 * beat, beat - 1],
+                            "connect": [1, 2, 3],
+                            "write": [1, -2, 3, 0],
+                            "bogus": [1, 2, 3, 4],
+                        },
+                        "hb_int": [1200, 4000 * beat, 4000 * beat, 0],
+                        "hb_dns": [9000, 9000, 9000 * beat, beat - 1],
+                        "mains_v": [2180 + beat, 2295, 2310, 500 * beat],
+                        "mains_hz": [49980, 50000, 50020, 500 * beat] if beat < 3 else [49980, 50000],
+                    },
+                    separators=(",", ":"),
+                ).encode()
+                request = (
+                    "POST /api/v1/heartbeat HTTP/1.1\r\n"
+                    "Host: smoke\r\n"
+                    "Content-Type: application/json\r\n"
+                    "Connection: keep-alive\r\n"
+                    f"Content-Length: {len(payload)}\r\n"
+                    "\r\n"
+                ).encode() + payload
+                writer.write(request)
+                await writer.drain()
+
+                status, headers, body = await _read_http_response(reader)
+                _assert(status == 200, f"beat {beat}: expected 200, got {status}: {body!r}")
+                _assert(
+                    headers.get("connection", "").lower() != "close",
+                    f"beat {beat}: server closed keep-alive connection",
+                )
+                _assert(json.loads(body).get("status") == "ok", f"beat {beat}: bad body {body!r}")
+                expected_interval = "30000" if beat == 3 else None
+                _assert(
+                    headers.get("x-pb-interval-ms") == expected_interval,
+                    f"beat {beat}: X-PB-Interval-Ms {headers.get('x-pb-interval-ms')!r}, expected {expected_interval!r}",
+                )
+
+            _assert(not reader.at_eof(), "server closed socket after keep-alive heartbeats")
+            writer.close()
+            await writer.wait_closed()
+
+            sensors = await database.get_all_active_sensors()
+            sensor = next((s for s in sensors if s["uuid"] == SMOKE_UUID), None)
+            _assert(sensor is not None, "smoke sensor not registered")
+            _assert(
+                sensor.get("telemetry") == {
+                    "conn_new": 1,
+                    "conn_reused": 2,
+                    "log_drops": 9,
+                    "hb_int": [1200, 12000, 12000, 0],
+                    "hb_dns": [9000, 9000, 27000, 2],
+                    "mains_v": [2183, 2295, 2310, 1500],
+                    "hb_lat": {"dns": [1800, 3000, 3000, 0], "ttfb": [40000, 750000, 750000, 2]},
+                },
+                f"unexpected telemetry: {sensor.get('telemetry')!r}",
+            )
+
+            async with ClientSession() as session:
+                async with session.get(
+                    f"http://127.0.0.1:{port}/api/v1/sensors",
+                    headers={"X-API-Key": SMOKE_API_KEY},
+                ) as resp:
+                    _assert(resp.status == 200, f"/api/v1/sensors: unexpected status {resp.status}")
+                    info = await resp.json()
+            listed = next((s for s in info.get("sensors", []) if s.get("uuid") == SMOKE_UUID), None)
+            _assert(listed is not None, "/api/v1/sensors: smoke sensor missing")
+            _assert(listed.get("telemetry") == sensor.get("telemetry"), "/api/v1/sensors: telemetry not exposed")
+        finally:
+            await runner.cleanup()
+            api_server.CFG.sensor_api_key = old_key
+            api_server.CFG.sensor_heartbeat_interval = old_interval
+
+        print("OK: heartbeat keep-alive smoke passed.")
+    finally:
+        if old_db_path is None:
+            os.environ.pop("DB_PATH", None)
+        else:
+            os.environ["DB_PATH"] = old_db_path
+        shutil.rmtree(tmpdir, ignore_errors=True)
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
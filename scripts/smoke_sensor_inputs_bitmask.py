@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+"""
+Smoke test: one board, several sections (firmware PB_INPUTS > 0, "inputs" bitmask).
+
+Checks:
+- Heartbeat with inputs + input_sections registers a sensor "<uuid>#in<N>" per input,
+  in its own section; bit set -> section UP, bit clear -> section DOWN.
+- The board's own supply (hub row) does not decide its section: section 1 follows in1 only.
+- A flipped input wakes the monitor right away; the same mask again does not.
+- Inputs relayed in an aggregator batch are applied too.
+- Mask wider than input_sections, invalid section or too many inputs -> HTTP 400.
+
+Run (inside container):
+  docker compose exec -T powerbot python - < scripts/smoke_sensor_inputs_bitmask.py
+"""
+
+from __future__ import annotations
+
+import asyncio
+import os
+import shutil
+import sys
+import tempfile
+from pathlib import Path
+
+
+REPO_ROOT: Path | None = None
+for candidate in (Path.cwd(), Path("/app")):
+    if (candidate / "src" / "database.py").exists() and (candidate / "src" / "api_server.py").exists():
+        REPO_ROOT = candidate
+        break
+if REPO_ROOT is None:
+    raise RuntimeError("Cannot locate repo root (src/database.py + src/api_server.py).")
+
+sys.path.insert(0, str(REPO_ROOT / "src"))
+
+SMOKE_API_KEY = "smoke-inputs-key"
+HUB_UUID = "smoke-inputs-hub"
+BUILDING_ID = 1
+
+
+def _assert(cond: bool, msg: str) -> None:
+    if not cond:
+        raise AssertionError(msg)
+
+
+async def main() -> None:
+    tmpdir = Path(tempfile.mkdtemp(prefix="powerbot-smoke-inputs-"))
+    old_db_path = os.environ.get("DB_PATH")
+    os.environ["DB_PATH"] = str(tmpdir / "state.db")
+
+    try:
+        # Import only after DB_PATH override.
+        import database  # noqa: WPS433,E402
+        import api_server  # noqa: WPS433,E402
+        import services  # noqa: WPS433,E402
+        from sensor_events import wait_sensors_recheck  # noqa: WPS433,E402
+        from aiohttp import ClientSession, web  # noqa: WPS433,E402
+
+        await database.init_db()
+
+        old_key = api_server.CFG.sensor_api_key
+        api_server.CFG.sensor_api_key = SMOKE_API_KEY
+        runner = web.AppRunner(api_server.create_api_app())
+        await runner.setup()
+        site = web.TCPSite(runner, "127.0.0.1", 0)
+        await site.start()
+        port = site._server.sockets[0].getsockname()[1]  # noqa: SLF001
+        url = f"http://127.0.0.1:{port}/api/v1/heartbeat"
+
+        def _payload(inputs: object, **extra: object) -> dict:
+            payload = {
+                "api_key": SMOKE_API_KEY,
+                "building_id": BUILDING_ID,
+                "section_id": 1,
+                "sensor_uuid": HUB_UUID,
+                "name": "Щиток",
+                "inputs": inputs,
+                "input_sections": [1, 2, 3],
+            }
+            payload.update(extra)
+            return payload
+
+        async def _states() -> dict[int, bool]:
+            states = await services.check_sensors_timeout()
+            return {sid: states.get((BUILDING_ID, sid)) for sid in (1, 2, 3)}
+
+        try:
+            async with ClientSession() as session:
+                # 1) in1 + in3 live, in2 dark.
+                async with session.post(url, json=_payload(0b101, event="boot")) as resp:
+                    _assert(resp.status == 200, f"boot: unexpected status {resp.status}")
+                await wait_sensors_recheck(0)
+                states = await _states()
+                _assert(states == {1: True, 2: False, 3: True}, f"mask 0b101: unexpected states {states!r}")
+                for n, section_id in ((1, 1), (2, 2), (3, 3)):
+                    child = await database.get_sensor_by_uuid(f"{HUB_UUID}#in{n}")
+                    _assert(child is not None and child["section_id"] == section_id, f"in{n} not registered: {child!r}")
+                hub = {s["uuid"]: s for s in await database.get_all_active_sensors()}[HUB_UUID]
+                _assert(hub.get("telemetry") == {"inputs": 0b101}, f"hub telemetry: {hub.get('telemetry')!r}")
+
+                # Same mask: nothing changed, monitor stays asleep.
+                async with session.post(url, json=_payload(0b101)) as resp:
+                    _assert(resp.status == 200, f"steady: unexpected status {resp.status}")
+                _assert(not await wait_sensors_recheck(0.05), "steady inputs must not wake monitor")
+
+                # 2) in1 drops while the board itself (on UPS) keeps beating: section 1 DOWN.
+                async with session.post(url, json=_payload(0b100)) as resp:
+                    _assert(resp.status == 200, f"edge: unexpected status {resp.status}")
+                _assert(await wait_sensors_recheck(1.0), "input edge must wake sensors monitor")
+                states = await _states()
+                _assert(states == {1: False, 2: False, 3: True}, f"mask 0b100: unexpected states {states!r}")
+
+                # 3) Same board behind an aggregator.
+                batch = {
+                    "api_key": SMOKE_API_KEY,
+                    "building_id": BUILDING_ID,
+                    "beats": [
+                        {"sensor_uuid": HUB_UUID, "section_id": 1, "inputs": 0b011, "input_sections": [1, 2, 3]},
+                    ],
+                }
+                async with session.post(f"{url}/batch", json=batch) as resp:
+                    body = await resp.json()
+                    _assert(resp.status == 200 and body.get("results") == [200], f"batch: {body!r}")
+                _assert(await wait_sensors_recheck(1.0), "batched input edge must wake sensors monitor")
+                states = await _states()
+                _assert(states == {1: True, 2: True, 3: False}, f"batch mask 0b011: unexpected states {states!r}")
+
+                # 4) Validation.
+                for bad in (
+                    _payload(0b1000),
+                    _payload(-1),
+                    _payload(True),
+                    _payload(1, input_sections=[1, 9]),
+                    _payload(1, input_sections=[]),
+                    _payload(1, input_sections=[1] * (api_server.SENSOR_INPUTS_MAX + 1)),
+                    _payload(1, input_sections=None),
+                ):
+                    async with session.post(url, json=bad) as resp:
+                        _assert(resp.status == 400, f"bad inputs {bad!r}: expected 400, got {resp.status}")
+        finally:
+            await runner.cleanup()
+            api_server.CFG.sensor_api_key = old_key
+
+        print("OK: sensor inputs bitmask smoke passed.")
+    finally:
+        if old_db_path is None:
+            os.environ.pop("DB_PATH", None)
+        else:
+            os.environ["DB_PATH"] = old_db_path
+        shutil.rmtree(tmpdir, ignore_errors=True)
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
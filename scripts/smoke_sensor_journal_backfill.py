@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+"""
+Smoke test: offline heartbeat journal back-fill (POST /api/v1/heartbeat/bulk, firmware PB_JOURNAL_BEATS).
+
+Checks:
+- Journal covering an outage -> beats stored, the down/up pair inside the alive span flagged as refuted
+  (kept in the table, hidden from history readers), events outside the span untouched.
+- Re-posting the same journal (retry after a lost response) -> nothing stored twice, nothing refuted again.
+- seq 0 (power_lost marker) splits the journal: a down/up pair in the gap is a real outage and stays.
+- Unknown sensor -> HTTP 404; bad api_key -> 401; malformed beats -> 400.
+
+Run (inside container):
+  docker compose exec -T powerbot python - < scripts/smoke_sensor_journal_backfill.py
+"""
+
+from __future__ import annotations
+
+import asyncio
+import os
+import shutil
+import sys
+import tempfile
+from datetime import datetime, timedelta
+from pathlib import Path
+
+
+REPO_ROOT: Path | None = None
+for candidate in (Path.cwd(), Path("/app")):
+    if (candidate / "src" / "database.py").exists() and (candidate / "src" / "api_server.py").exists():
+        REPO_ROOT = candidate
+        break
+if REPO_ROOT is None:
+    raise RuntimeError("Cannot locate repo root (src/database.py + src/api_server.py).")
+
+sys.path.insert(0, str(REPO_ROOT / "src"))
+
+SMOKE_API_KEY = "smoke-journal-key"
+SMOKE_UUID = "smoke-journal-001"
+SMOKE_SECTION = (1, 1)
+PERIOD_MS = 10_000
+
+
+def _assert(cond: bool, msg: str) -> None:
+    if not cond:
+        raise AssertionError(msg)
+
+
+async def main() -> None:
+    tmpdir = Path(tempfile.mkdtemp(prefix="powerbot-smoke-journal-"))
+    old_db_path = os.environ.get("DB_PATH")
+    os.environ["DB_PATH"] = str(tmpdir / "state.db")
+
+    try:
+        # Import only after DB_PATH override.
+        import database  # noqa: WPS433,E402
+        import api_server  # noqa: WPS433,E402
+        from aiohttp import ClientSession, web  # noqa: WPS433,E402
+
+        await database.init_db()
+
+        old_key = api_server.CFG.sensor_api_key
+        api_server.CFG.sensor_api_key = SMOKE_API_KEY
+        runner = web.AppRunner(api_server.create_api_app())
+        await runner.setup()
+        site = web.TCPSite(runner, "127.0.0.1", 0)
+        await site.start()
+        port = site._server.sockets[0].getsockname()[1]  # noqa: SLF001
+        base = f"http://127.0.0.1:{port}/api/v1/heartbeat"
+
+        def _payload(**extra: object) -> dict:
+            payload = {
+                "api_key": SMOKE_API_KEY,
+                "building_id": SMOKE_SECTION[0],
+                "section_id": SMOKE_SECTION[1],
+                "sensor_uuid": SMOKE_UUID,
+            }
+            payload.update(extra)
+            return payload
+
+        async def _put_events(*events: tuple[str, int]) -> None:
+            """(event_type, age_s) -> events table with back-dated timestamps (monitor's view)."""
+            now = datetime.now()
+            async with database.open_db() as db:
+                await db.execute("DELETE FROM events")
+                await db.executemany(
+                    "INSERT INTO events (event_type, timestamp, building_id, section_id) VALUES (?, ?, ?, ?)",
+                    [
+                        (kind, (now - timedelta(seconds=age)).isoformat(), SMOKE_SECTION[0], SMOKE_SECTION[1])
+                        for kind, age in events
+                    ],
+                )
+                await db.commit()
+
+        async def _events() -> list[str]:
+            rows = await database.get_all_events(SMOKE_SECTION[0], SMOKE_SECTION[1])
+            return [kind for kind, _ in rows]
+
+        async def _refuted() -> list[tuple[str, str]]:
+            async with database.open_db() as db:
+                async with db.execute(
+                    "SELECT event_type, refuted_by FROM events WHERE refuted_at IS NOT NULL ORDER BY timestamp, id"
+                ) as cur:
+                    return [(row[0], row[1]) for row in await cur.fetchall()]
+
+        async def _journal_rows() -> int:
+            async with database.open_db() as db:
+                async with db.execute(
+                    "SELECT COUNT(*) FROM sensor_journal_beats WHERE sensor_uuid=?", (SMOKE_UUID,)
+                ) as cur:
+                    return int((await cur.fetchone())[0])
+
+        try:
+            async with ClientSession() as session:
+                # Journal before registration -> 404 (nothing to attach it to).
+                async with session.post(f"{base}/bulk", json=_payload(beats=[[1, 10]])) as resp:
+                    _assert(resp.status == 404, f"unregistered journal: expected 404, got {resp.status}")
+
+                async with session.post(base, json=_payload()) as resp:
+                    _assert(resp.status == 200, f"heartbeat: unexpected status {resp.status}")
+
+                # 1) Link outage: beats every period from 290s to 20s ago; monitor saw down at 200s
+                #    and up at 30s. An older real outage (3000s..2900s ago) is outside the journal.
+                await _put_events(("down", 3000), ("up", 2900), ("down", 200), ("up", 30))
+                beats = [[10 + i, 290 - 10 * i] for i in range(28)]
+                async with session.post(
+                    f"{base}/bulk", json=_payload(period_ms=PERIOD_MS, stride=1, beats=beats)
+                ) as resp:
+                    _assert(resp.status == 200, f"bulk: unexpected status {resp.status}")
+                    body = await resp.json()
+                _assert(body.get("stored") == len(beats), f"bulk: all beats must be stored, got {body!r}")
+                _assert(body.get("events_refuted") == 2, f"bulk: false down/up must be refuted, got {body!r}")
+                _assert(await _events() == ["down", "up"], f"real outage must stay, got {await _events()!r}")
+                _assert(
+                    await _refuted() == [("down", SMOKE_UUID), ("up", SMOKE_UUID)],
+                    f"refuted events must be kept and flagged, got {await _refuted()!r}",
+                )
+                all_events = await database.get_all_events(SMOKE_SECTION[0], SMOKE_SECTION[1], include_refuted=True)
+                _assert(len(all_events) == 4, f"include_refuted must return every event, got {all_events!r}")
+                last = await database.get_last_event(building_id=SMOKE_SECTION[0], section_id=SMOKE_SECTION[1])
+                _assert(
+                    last is not None and last[0] == "up" and last[1] < datetime.now() - timedelta(seconds=2000),
+                    f"last event must skip refuted rows, got {last!r}",
+                )
+
+                # 2) Retry of the same journal -> idempotent.
+                async with session.post(
+                    f"{base}/bulk", json=_payload(period_ms=PERIOD_MS, stride=1, beats=beats)
+                ) as resp:
+                    _assert(resp.status == 200, f"bulk retry: unexpected status {resp.status}")
+                    body = await resp.json()
+                _assert(body.get("stored") == 0, f"bulk retry: duplicates stored, got {body!r}")
+                _assert(body.get("events_refuted") == 0, f"bulk retry: nothing to refute, got {body!r}")
+                _assert(len(await _refuted()) == 2, f"bulk retry: refuted set changed, got {await _refuted()!r}")
+                _assert(await _journal_rows() == len(beats), "bulk retry: journal rows duplicated")
+
+                # 3) power_lost marker at 205s splits the journal: the down/up in the gap is real.
+                await _put_events(("down", 200), ("up", 30))
+                marked = (
+                    [[100 + i, 290 - 10 * i] for i in range(9)]
+                    + [[0, 205]]
+                    + [[200 + i, 190 - 10 * i] for i in range(18)]
+                )
+                async with session.post(
+                    f"{base}/bulk", json=_payload(period_ms=PERIOD_MS, stride=1, beats=marked)
+                ) as resp:
+                    _assert(resp.status == 200, f"bulk with marker: unexpected status {resp.status}")
+                    body = await resp.json()
+                _assert(body.get("stored") == len(marked) - 1, f"marker must not be stored, got {body!r}")
+                _assert(body.get("events_refuted") == 0, f"real outage must stay, got {body!r}")
+                _assert(await _events() == ["down", "up"], f"events changed: {await _events()!r}")
+
+                # 4) Errors.
+                async with session.post(
+                    f"{base}/bulk", json=_payload(sensor_uuid="smoke-journal-unknown", beats=[[1, 10]])
+                ) as resp:
+                    _assert(resp.status == 404, f"unknown sensor: expected 404, got {resp.status}")
+                async with session.post(f"{base}/bulk", json=_payload(api_key="nope", beats=[])) as resp:
+                    _assert(resp.status == 401, f"bad key: expected 401, got {resp.status}")
+                for bad in ([[1]], [[1, -5]], [[True, 3]], "beats", [[1, 2.5]]):
+                    async with session.post(f"{base}/bulk", json=_payload(beats=bad)) as resp:
+                        _assert(resp.status == 400, f"bad beats {bad!r}: expected 400, got {resp.status}")
+                async with session.post(f"{base}/bulk", json=_payload(stride=0, beats=[])) as resp:
+                    _assert(resp.status == 400, f"stride=0: expected 400, got {resp.status}")
+        finally:
+            await runner.cleanup()
+            api_server.CFG.sensor_api_key = old_key
+
+        print("OK: sensor journal back-fill smoke passed.")
+    finally:
+        if old_db_path is None:
+            os.environ.pop("DB_PATH", None)
+        else:
+            os.environ["DB_PATH"] = old_db_path
+        shutil.rmtree(tmpdir, ignore_errors=True)
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
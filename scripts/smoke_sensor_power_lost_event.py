@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+"""
+Smoke test: last-gasp `power_lost` heartbeat event (firmware PB_POWER_SENSE_MODE != 0).
+
+Checks:
+- Regular heartbeat -> sensor online, section UP.
+- `event=power_lost` -> sensor offline immediately (no 150s timeout), section DOWN,
+  sensors monitor is woken up right away (wait_sensors_recheck returns early).
+- `power_lost` for an unknown sensor is accepted but does not register it.
+- Next `event=boot` heartbeat clears `power_lost_at` -> sensor online again.
+- Unknown `event` -> HTTP 400.
+
+Run (inside container):
+  docker compose exec -T powerbot python - < scripts/smoke_sensor_power_lost_event.py
+"""
+
+from __future__ import annotations
+
+import asyncio
+import os
+import shutil
+import sys
+import tempfile
+from datetime import datetime, timedelta
+from pathlib import Path
+
+
+REPO_ROOT: Path | None = None
+for candidate in (Path.cwd(), Path("/app")):
+    if (candidate / "src" / "database.py").exists() and (candidate / "src" / "api_server.py").exists():
+        REPO_ROOT = candidate
+        break
+if REPO_ROOT is None:
+    raise RuntimeError("Cannot locate repo root (src/database.py + src/api_server.py).")
+
+sys.path.insert(0, str(REPO_ROOT / "src"))
+
+SMOKE_API_KEY = "smoke-power-lost-key"
+SMOKE_UUID = "smoke-power-lost-001"
+SMOKE_SECTION = (1, 1)
+
+
+def _assert(cond: bool, msg: str) -> None:
+    if not cond:
+        raise AssertionError(msg)
+
+
+async def main() -> None:
+    tmpdir = Path(tempfile.mkdtemp(prefix="powerbot-smoke-power-lost-"))
+    old_db_path = os.environ.get("DB_PATH")
+    os.environ["DB_PATH"] = str(tmpdir / "state.db")
+
+    try:
+        # Import only after DB_PATH override.
+        import database  # noqa: WPS433,E402
+        import api_server  # noqa: WPS433,E402
+        import services  # noqa: WPS433,E402
+        from sensor_events import wait_sensors_recheck  # noqa: WPS433,E402
+        from aiohttp import ClientSession, web  # noqa: WPS433,E402
+
+        await database.init_db()
+
+        old_key = api_server.CFG.sensor_api_key
+        api_server.CFG.sensor_api_key = SMOKE_API_KEY
+        runner = web.AppRunner(api_server.create_api_app())
+        await runner.setup()
+        site = web.TCPSite(runner, "127.0.0.1", 0)
+        await site.start()
+        port = site._server.sockets[0].getsockname()[1]  # noqa: SLF001
+        url = f"http://127.0.0.1:{port}/api/v1/heartbeat"
+        timeout = timedelta(seconds=api_server.CFG.sensor_timeout)
+
+        def _payload(**extra: object) -> dict:
+            payload = {
+                "api_key": SMOKE_API_KEY,
+                "building_id": SMOKE_SECTION[0],
+                "section_id": SMOKE_SECTION[1],
+                "sensor_uuid": SMOKE_UUID,
+            }
+            payload.update(extra)
+            return payload
+
+        async def _sensor_online() -> bool:
+            sensor = await database.get_sensor_by_uuid(SMOKE_UUID)
+            _assert(sensor is not None, "smoke sensor not registered")
+            return database.sensor_heartbeat_is_fresh(sensor, datetime.now(), timeout)
+
+        try:
+            async with ClientSession() as session:
+                # 1) Regular heartbeat -> online.
+                async with session.post(url, json=_payload()) as resp:
+                    _assert(resp.status == 200, f"heartbeat: unexpected status {resp.status}")
+                # First beat of a new sensor wakes the monitor too; drain it.
+                await wait_sensors_recheck(0)
+                _assert(await _sensor_online(), "sensor must be online after heartbeat")
+                states = await services.check_sensors_timeout()
+                _assert(states.get(SMOKE_SECTION) is True, f"section must be UP, got {states!r}")
+
+                # Steady heartbeat of an online sensor must not wake the monitor.
+                async with session.post(url, json=_payload(event="heartbeat")) as resp:
+                    _assert(resp.status == 200, f"heartbeat #2: unexpected status {resp.status}")
+                _assert(not await wait_sensors_recheck(0.05), "steady heartbeat must not wake monitor")
+
+                # 2) Last-gasp -> offline right away, monitor woken.
+                async with session.post(url, json=_payload(event="power_lost")) as resp:
+                    _assert(resp.status == 200, f"power_lost: unexpected status {resp.status}")
+                    body = await resp.json()
+                _assert(body.get("event") == "power_lost", f"power_lost: bad body {body!r}")
+                _assert(await wait_sensors_recheck(1.0), "power_lost must wake sensors monitor")
+                _assert(not await _sensor_online(), "sensor must be offline right after power_lost")
+                sensor = await database.get_sensor_by_uuid(SMOKE_UUID)
+                _assert(sensor.get("power_lost_at") is not None, "power_lost_at must be set")
+                states = await services.check_sensors_timeout()
+                _assert(states.get(SMOKE_SECTION) is False, f"section must be DOWN, got {states!r}")
+
+                # Unknown sensor: accepted (no retries from a dying board), not registered.
+                async with session.post(
+                    url, json=_payload(sensor_uuid="smoke-power-lost-unknown", event="power_lost")
+                ) as resp:
+                    _assert(resp.status == 200, f"unknown power_lost: unexpected status {resp.status}")
+                _assert(
+                    await database.get_sensor_by_uuid("smoke-power-lost-unknown") is None,
+                    "power_lost must not register unknown sensors",
+                )
+
+                # 3) Boot after power restore -> online again, flag cleared, monitor woken.
+                async with session.post(url, json=_payload(event="boot")) as resp:
+                    _assert(resp.status == 200, f"boot: unexpected status {resp.status}")
+                _assert(await wait_sensors_recheck(1.0), "boot must wake sensors monitor")
+                _assert(await _sensor_online(), "sensor must be online after boot heartbeat")
+                sensor = await database.get_sensor_by_uuid(SMOKE_UUID)
+                _assert(sensor.get("power_lost_at") is None, "boot heartbeat must clear power_lost_at")
+                states = await services.check_sensors_timeout()
+                _assert(states.get(SMOKE_SECTION) is True, f"section must be UP again, got {states!r}")
+
+                # 4) Unknown event -> 400.
+                async with session.post(url, json=_payload(event="reboot-please")) as resp:
+                    _assert(resp.status == 400, f"bad event: expected 400, got {resp.status}")
+        finally:
+            await runner.cleanup()
+            api_server.CFG.sensor_api_key = old_key
+
+        print("OK: sensor power_lost event smoke passed.")
+    finally:
+        if old_db_path is None:
+            os.environ.pop("DB_PATH", None)
+        else:
+            os.environ["DB_PATH"] = old_db_path
+        shutil.rmtree(tmpdir, ignore_errors=True)
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
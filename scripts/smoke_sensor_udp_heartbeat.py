@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+"""
+Smoke test: UDP heartbeat transport (firmware PB_TRANSPORT=PB_TRANSPORT_UDP) + seq loss accounting.
+
+Loopback harness: starts the UDP listener on 127.0.0.1, replays a scripted list of
+datagrams (as a sensor would send them, incl. gaps, duplicates, garbage and a reboot)
+and checks every ack plus the resulting per-sensor loss counters.
+
+Checks:
+- valid datagram -> "OK <seq>" ack; sensor registered/online like via HTTP;
+- gap in seq -> counted as lost; duplicate / late seq -> ignored;
+- bad api_key / garbage -> no reply at all (listener is not a reflector);
+- valid key but bad building -> "ERR 404 <seq>";
+- boot with seq=1 -> new baseline (no false losses after firmware reboot);
+- HTTP heartbeat with seq feeds the same counters; invalid seq -> 400.
+
+Run (inside container):
+  docker compose exec -T powerbot python - < scripts/smoke_sensor_udp_heartbeat.py
+"""
+
+from __future__ import annotations
+
+import asyncio
+import json
+import os
+import shutil
+import sys
+import tempfile
+from datetime import datetime, timedelta
+from pathlib import Path
+
+
+REPO_ROOT: Path | None = None
+for candidate in (Path.cwd(), Path("/app")):
+    if (candidate / "src" / "database.py").exists() and (candidate / "src" / "api_server.py").exists():
+        REPO_ROOT = candidate
+        break
+if REPO_ROOT is None:
+    raise RuntimeError("Cannot locate repo root (src/database.py + src/api_server.py).")
+
+sys.path.insert(0, str(REPO_ROOT / "src"))
+
+SMOKE_API_KEY = "smoke-udp-key"
+SMOKE_UUID = "smoke-udp-001"
+ACK_TIMEOUT_SEC = 1.0
+NO_ACK_TIMEOUT_SEC = 0.3
+
+
+def _assert(cond: bool, msg: str) -> None:
+    if not cond:
+        raise AssertionError(msg)
+
+
+def _beat(seq: int, **extra: object) -> bytes:
+    payload = {
+        "api_key": SMOKE_API_KEY,
+        "building_id": 1,
+        "section_id": 1,
+        "sensor_uuid": SMOKE_UUID,
+        "seq": seq,
+    }
+    payload.update(extra)
+    return json.dumps(payload, separators=(",", ":")).encode()
+
+
+# (datagram, expected ack or None = no reply)
+REPLAY: list[tuple[bytes, bytes | None]] = [
+    (_beat(1, event="boot"), b"OK 1"),
+    (_beat(2), b"OK 2"),
+    (_beat(3), b"OK 3"),
+    (_beat(5), b"OK 5"),                       # seq 4 lost on the wire
+    (_beat(3), b"OK 3"),                       # late duplicate: acked, not counted
+    (_beat(6), b"OK 6"),
+    (_beat(7, api_key="wrong"), None),         # unauthenticated: silent drop
+    (b"\x00\xffgarbage", None),
+    (b"[1, 2, 3]", None),
+    (_beat(8, building_id=999), b"ERR 404 8"),  # authenticated, but invalid
+    (_beat(1, event="boot"), b"OK 1"),         # firmware rebooted: new baseline
+    (_beat(2), b"OK 2"),
+]
+
+
+class _AckCollector(asyncio.DatagramProtocol):
+    def __init__(self) -> None:
+        self.acks: asyncio.Queue[bytes] = asyncio.Queue()
+
+    def datagram_received(self, data: bytes, addr: tuple) -> None:
+        self.acks.put_nowait(data)
+
+
+async def main() -> None:
+    tmpdir = Path(tempfile.mkdtemp(prefix="powerbot-smoke-udp-"))
+    old_db_path = os.environ.get("DB_PATH")
+    os.environ["DB_PATH"] = str(tmpdir / "state.db")
+
+    try:
+        # Import only after DB_PATH override.
+        import database  # noqa: WPS433,E402
+        import api_server  # noqa: WPS433,E402
+        from aiohttp import ClientSession, web  # noqa: WPS433,E402
+
+        await database.init_db()
+
+        # Pure seq accounting.
+        adv = database.advance_heartbeat_seq
+        _assert(adv(None, 0, 0, 7) == (7, 1, 0), "first seq is a baseline")
+        _assert(adv(7, 1, 0, 10) == (10, 2, 2), "gap must count lost beats")
+        _assert(adv(10, 2, 2, 9) == (10, 2, 2), "late seq must be ignored")
+        _assert(adv(10, 2, 2, 10) == (10, 2, 2), "duplicate seq must be ignored")
+        _assert(adv(1000, 5, 0, 1) == (1, 6, 0), "far-back seq = firmware restart")
+        _assert(adv(10, 2, 2, 3, restart=True) == (3, 3, 2), "boot must reset baseline")
+
+        old_key = api_server.CFG.sensor_api_key
+        api_server.CFG.sensor_api_key = SMOKE_API_KEY
+        listener = await api_server.start_sensor_udp_listener(host="127.0.0.1", port=0)
+        _assert(listener is not None, "UDP listener did not start")
+        udp_port = listener.get_extra_info("sockname")[1]
+
+        loop = asyncio.get_running_loop()
+        client, collector = await loop.create_datagram_endpoint(
+            _AckCollector, remote_addr=("127.0.0.1", udp_port)
+        )
+
+        runner = web.AppRunner(api_server.create_api_app())
+        await runner.setup()
+        site = web.TCPSite(runner, "127.0.0.1", 0)
+        await site.start()
+        http_port = site._server.sockets[0].getsockname()[1]  # noqa: SLF001
+
+        try:
+            for idx, (datagram, expected) in enumerate(REPLAY):
+                client.sendto(datagram)
+                if expected is None:
+                    try:
+                        ack = await asyncio.wait_for(collector.acks.get(), NO_ACK_TIMEOUT_SEC)
+                    except asyncio.TimeoutError:
+                        continue
+                    raise AssertionError(f"replay #{idx}: expected no reply, got {ack!r}")
+                try:
+                    ack = await asyncio.wait_for(collector.acks.get(), ACK_TIMEOUT_SEC)
+                except asyncio.TimeoutError:
+                    raise AssertionError(f"replay #{idx}: no ack (expected {expected!r})") from None
+                _assert(ack == expected, f"replay #{idx}: expected {expected!r}, got {ack!r}")
+
+            sensors = await database.get_all_active_sensors()
+            sensor = next((s for s in sensors if s["uuid"] == SMOKE_UUID), None)
+            _assert(sensor is not None, "UDP heartbeat did not register the sensor")
+            _assert(
+                database.sensor_heartbeat_is_fresh(
+                    sensor, datetime.now(), timedelta(seconds=api_server.CFG.sensor_timeout)
+                ),
+                "sensor must be online after UDP heartbeats",
+            )
+            # 1,2,3,5,6 (+4 lost), then reboot: 1,2.
+            _assert(
+                sensor.get("heartbeat_seq") == {"last": 2, "received": 7, "lost": 1},
+                f"unexpected seq stats: {sensor.get('heartbeat_seq')!r}",
+            )
+
+            # HTTP transport feeds the same counters.
+            async with ClientSession() as session:
+                url = f"http://127.0.0.1:{http_port}/api/v1/heartbeat"
+                async with session.post(url, data=_beat(4), headers={"Content-Type": "application/json"}) as resp:
+                    _assert(resp.status == 200, f"HTTP seq beat: unexpected status {resp.status}")
+                async with session.post(url, data=_beat(-1), headers={"Content-Type": "application/json"}) as resp:
+                    _assert(resp.status == 400, f"HTTP bad seq: expected 400, got {resp.status}")
+                async with session.get(
+                    f"http://127.0.0.1:{http_port}/api/v1/sensors",
+                    headers={"X-API-Key": SMOKE_API_KEY},
+                ) as resp:
+                    info = await resp.json()
+            listed = next((s for s in info.get("sensors", []) if s.get("uuid") == SMOKE_UUID), None)
+            _assert(listed is not None, "/api/v1/sensors: smoke sensor missing")
+            _assert(
+                listed.get("heartbeat_seq") == {"last": 4, "received": 8, "lost": 2},
+                f"/api/v1/sensors: unexpected seq stats {listed.get('heartbeat_seq')!r}",
+            )
+        finally:
+            client.close()
+            await api_server.stop_sensor_udp_listener(listener)
+            await runner.cleanup()
+            api_server.CFG.sensor_api_key = old_key
+
+        print("OK: sensor UDP heartbeat smoke passed.")
+    finally:
+        if old_db_path is None:
+            os.environ.pop("DB_PATH", None)
+        else:
+            os.environ["DB_PATH"] = old_db_path
+        shutil.rmtree(tmpdir, ignore_errors=True)
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
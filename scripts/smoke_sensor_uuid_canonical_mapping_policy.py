@@ -83,7 +83,7 @@ def main() -> None:
     for snippet in (
         "canonical_building_id = CFG.sensor_uuid_building_map.get(sensor_uuid_key)",
         "canonical mapping applied",
-        "upsert_sensor_heartbeat(sensor_uuid, building_id, section_id, sensor_name, comment)",
+        "upsert_sensor_heartbeat(sensor_uuid, building_id, section_id, sensor_name, comment, telemetry=telemetry,",
     ):
         if snippet not in api:
             violations.append(f"{API_FILE}: missing snippet `{snippet}`")
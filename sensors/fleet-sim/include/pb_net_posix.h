@@ -0,0 +1,127 @@
+/*
+ * PowerBot: адаптер мережі для хоста — non-blocking TCP на сокетах POSIX.
+ *
+ * PbPosixNet — Net для PbHbMachine з тим самим контрактом, що й PbLwipNet (pb_net_lwip.h):
+ * кожна операція лише "питає" стан сокета і повертається. Connect перевіряється через poll(),
+ * а не select(): у fleet-sim тисячі сокетів, номери fd вище FD_SETSIZE.
+ *
+ * Адреса сервера — IPv4-літерал у host (fleet-sim резолвить ім'я один раз при старті).
+ */
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "pb_dns_cache.h"
+#include "pb_hb_fsm.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0   // macOS: SIGPIPE ігнорує сам fleet-sim
+#endif
+
+class PbPosixNet {
+public:
+    PbPosixNet() = default;
+    PbPosixNet(const PbPosixNet &) = delete;
+    PbPosixNet &operator=(const PbPosixNet &) = delete;
+    ~PbPosixNet() { close(); }
+
+    int fd() const { return fd_; }
+
+    bool isOpen() {
+        if (fd_ < 0) {
+            return false;
+        }
+        uint8_t b;
+        const ssize_t n = ::recv(fd_, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (n == 0) {
+            return false;   // сервер закрив сокет (FIN)
+        }
+        return n > 0 || errno == EWOULDBLOCK || errno == EAGAIN;
+    }
+
+    int startResolve(const char *host) { return pbParseIpv4(host, addr_) ? PB_NET_OK : PB_NET_FAIL; }
+    int pollResolve() { return PB_NET_OK; }
+
+    int startConnect(uint16_t port) {
+        close();
+        fd_ = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (fd_ < 0) {
+            return PB_NET_FAIL;
+        }
+        ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL, 0) | O_NONBLOCK);
+        // Як lwIP на сенсорі з маленьким запитом: без Nagle, запит іде одним сегментом одразу.
+        const int one = 1;
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        struct sockaddr_in sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons(port);
+        sa.sin_addr.s_addr = addr_;
+        if (::connect(fd_, reinterpret_cast<struct sockaddr *>(&sa), sizeof(sa)) == 0) {
+            return PB_NET_OK;
+        }
+        if (errno == EINPROGRESS) {
+            return PB_NET_PENDING;
+        }
+        close();
+        return PB_NET_FAIL;
+    }
+
+    int pollConnect() {
+        if (fd_ < 0) {
+            return PB_NET_FAIL;
+        }
+        struct pollfd p = {fd_, POLLOUT, 0};
+        const int r = ::poll(&p, 1, 0);
+        if (r == 0) {
+            return PB_NET_PENDING;
+        }
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (r < 0 || ::getsockopt(fd_, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+            close();
+            return PB_NET_FAIL;
+        }
+        return PB_NET_OK;
+    }
+
+    long write(const uint8_t *data, size_t len) {
+        const ssize_t n = ::send(fd_, data, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n >= 0) {
+            return static_cast<long>(n);
+        }
+        return (errno == EWOULDBLOCK || errno == EAGAIN) ? 0 : -1;
+    }
+
+    long read(uint8_t *buf, size_t cap) {
+        const ssize_t n = ::recv(fd_, buf, cap, MSG_DONTWAIT);
+        if (n > 0) {
+            return static_cast<long>(n);
+        }
+        if (n < 0 && (errno == EWOULDBLOCK || errno == EAGAIN)) {
+            return 0;
+        }
+        return -1;
+    }
+
+    void close() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+private:
+    int fd_ = -1;
+    uint32_t addr_ = 0;
+};
@@ -0,0 +1,589 @@
+/*
+ * PowerBot fleet-sim: тисячі сенсорів з одного процесу проти локального heartbeat API.
+ *
+ * Кожен сенсор — той самий транспорт, що в прошивці: PbHbMachine (pb_hb_fsm.h) з
+ * keep-alive і розбором відповіді pb_http_resp.h, розклад PbBeatSchedule зі зсувом з UUID
+ * (pb_beat_schedule.h), JSON зі слотами pb_hb_body.h для boot / реєстрації і далі 36-байтний
+ * frame з HMAC (pb_hb_frame.h). Мережа — non-blocking сокети POSIX (pb_net_posix.h), усе
+ * в одному потоці на poll().
+ *
+ * Сценарії: втрата beat-ів (--loss), шторм перезавантажень — усі сенсори разом, як після
+ * повернення світла (--reboot-at), і шторм перепідключень — усі keep-alive сокети рвуться
+ * разом (--reconnect-at). Звіт: beat/с, латентність beat (p50/p95/p99/max), частка помилок
+ * за фазою і HTTP-статусом, час, за який після шторму доставили beat усі сенсори.
+ *
+ * Збірка і запуск — README.md поруч.
+ */
+
+#include <math.h>
+#include <netdb.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pb_beat_schedule.h"
+#include "pb_hb_body.h"
+#include "pb_hb_frame.h"
+#include "pb_hb_fsm.h"
+#include "pb_net_posix.h"
+
+// ─── Параметри ───
+
+struct FleetOptions {
+    std::string host = "127.0.0.1";
+    uint16_t port = 8080;
+    std::string apiKey;
+    unsigned sensors = 100;
+    unsigned buildings = 14;   // building_id 1..buildings
+    unsigned sections = 2;     // section_id 1..sections; 2 — є в кожному будинку
+    std::string uuidPrefix = "fleet-sim-";
+    uint32_t intervalMs = 10000;
+    long spreadMs = -1;        // -1 — як у прошивці: PB_HB_PHASE_SPREAD_MS = період
+    uint32_t timeoutMs = 10000;
+    uint32_t durationS = 60;
+    uint32_t reportS = 10;
+    uint32_t bootJitterMs = 0; // розкид старту після шторму (DHCP і т. п.); 0 — всі одночасно
+    double loss = 0;           // частка beat-ів, яких "немає мережі" (слот пропущено)
+    bool keepAlive = true;
+    bool frame = true;
+    std::vector<uint32_t> rebootAtS;
+    std::vector<uint32_t> reconnectAtS;
+    uint32_t seed = 1;
+};
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "Використання: %s --api-key KEY [параметри]\n"
+            "  --host H              сервер (%s)\n"
+            "  --port P              порт HTTP API (8080)\n"
+            "  --sensors N           кількість сенсорів (100)\n"
+            "  --buildings N         building_id 1..N (14)\n"
+            "  --sections N          section_id 1..N (2)\n"
+            "  --uuid-prefix S       префікс sensor_uuid (fleet-sim-)\n"
+            "  --interval-ms MS      період heartbeat (10000)\n"
+            "  --spread-ms MS        зсув beat-ів з UUID, 0 = без зсуву (= період)\n"
+            "  --timeout-ms MS       таймаут connect / IO, як HTTP_TIMEOUT_MS (10000)\n"
+            "  --duration-s S        тривалість прогону (60)\n"
+            "  --report-s S          звіт кожні S секунд, 0 = лише підсумок (10)\n"
+            "  --loss P              частка пропущених beat-ів 0..1 (0)\n"
+            "  --reboot-at S         шторм перезавантажень на секунді S (можна кілька разів)\n"
+            "  --reconnect-at S      розрив усіх keep-alive на секунді S (можна кілька разів)\n"
+            "  --boot-jitter-ms MS   розкид старту після перезавантаження (0)\n"
+            "  --no-keepalive        connect/close на кожен beat (PB_HTTP_KEEPALIVE=0)\n"
+            "  --json-only           без frame (PB_HB_FRAME=0)\n"
+            "  --seed N              seed для --loss / --boot-jitter-ms (1)\n",
+            argv0, "127.0.0.1");
+}
+
+static bool parseOptions(int argc, char **argv, FleetOptions &o) {
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        bool takesValue = true;
+        if (a == "--no-keepalive") {
+            o.keepAlive = false;
+            takesValue = false;
+        } else if (a == "--json-only") {
+            o.frame = false;
+            takesValue = false;
+        } else if (v == nullptr) {
+            fprintf(stderr, "❌ %s: немає значення\n", a.c_str());
+            return false;
+        } else if (a == "--host") {
+            o.host = v;
+        } else if (a == "--port") {
+            o.port = static_cast<uint16_t>(strtoul(v, nullptr, 10));
+        } else if (a == "--api-key") {
+            o.apiKey = v;
+        } else if (a == "--sensors") {
+            o.sensors = static_cast<unsigned>(strtoul(v, nullptr, 10));
+        } else if (a == "--buildings") {
+            o.buildings = static_cast<unsigned>(strtoul(v, nullptr, 10));
+        } else if (a == "--sections") {
+            o.sections = static_cast<unsigned>(strtoul(v, nullptr, 10));
+        } else if (a == "--uuid-prefix") {
+            o.uuidPrefix = v;
+        } else if (a == "--interval-ms") {
+            o.intervalMs = static_cast<uint32_t>(strtoul(v, nullptr, 10));
+        } else if (a == "--spread-ms") {
+            o.spreadMs = strtol(v, nullptr, 10);
+        } else if (a == "--timeout-ms") {
+            o.timeoutMs = static_cast<uint32_t>(strtoul(v, nullptr, 10));
+        } else if (a == "--duration-s") {
+            o.durationS = static_cast<uint32_t>(strtoul(v, nullptr, 10));
+        } else if (a == "--report-s") {
+            o.reportS = static_cast<uint32_t>(strtoul(v, nullptr, 10));
+        } else if (a == "--loss") {
+            o.loss = strtod(v, nullptr);
+        } else if (a == "--reboot-at") {
+            o.rebootAtS.push_back(static_cast<uint32_t>(strtoul(v, nullptr, 10)));
+        } else if (a == "--reconnect-at") {
+            o.reconnectAtS.push_back(static_cast<uint32_t>(strtoul(v, nullptr, 10)));
+        } else if (a == "--boot-jitter-ms") {
+            o.bootJitterMs = static_cast<uint32_t>(strtoul(v, nullptr, 10));
+        } else if (a == "--seed") {
+            o.seed = static_cast<uint32_t>(strtoul(v, nullptr, 10));
+        } else {
+            fprintf(stderr, "❌ невідомий параметр %s\n", a.c_str());
+            return false;
+        }
+        if (takesValue) {
+            i++;
+        }
+    }
+    if (o.apiKey.empty() || !pbJsonLiteralSafe(o.apiKey.c_str()) || !pbJsonLiteralSafe(o.uuidPrefix.c_str())) {
+        fprintf(stderr, "❌ потрібен --api-key без \" і \\ (той самий, що SENSOR_API_KEY сервера)\n");
+        return false;
+    }
+    if (o.sensors == 0 || o.buildings == 0 || o.sections == 0 || o.intervalMs == 0 || o.loss < 0 || o.loss > 1) {
+        fprintf(stderr, "❌ --sensors / --buildings / --sections / --interval-ms > 0, --loss у 0..1\n");
+        return false;
+    }
+    return true;
+}
+
+// ─── Час ───
+
+static uint64_t monoUs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+// ─── Статистика ───
+
+// Nearest-rank по точних значеннях (на сенсорі — log2-гістограма, тут пам'яті досить).
+static uint32_t percentile(std::vector<uint32_t> &v, unsigned pct) {
+    if (v.empty()) {
+        return 0;
+    }
+    const size_t rank = std::max<size_t>(1, (v.size() * pct + 99) / 100);
+    std::nth_element(v.begin(), v.begin() + (rank - 1), v.end());
+    return v[rank - 1];
+}
+
+struct FleetStats {
+    uint64_t started = 0;
+    uint64_t ok = 0;
+    uint64_t failed = 0;
+    uint64_t lost = 0;        // слот пропущено (--loss)
+    uint64_t connNew = 0;
+    uint64_t retried = 0;     // keep-alive виявився закритим, запит повторено на новому сокеті
+    std::vector<uint32_t> beatUs;      // успішні: від старту до відповіді
+    std::vector<uint32_t> connectUs;   // нові з'єднання
+    std::map<std::string, uint64_t> errors;   // "фаза: помилка" або "HTTP 4xx"
+
+    void clear() { *this = FleetStats(); }
+
+    void merge(const FleetStats &o) {
+        started += o.started;
+        ok += o.ok;
+        failed += o.failed;
+        lost += o.lost;
+        connNew += o.connNew;
+        retried += o.retried;
+        beatUs.insert(beatUs.end(), o.beatUs.begin(), o.beatUs.end());
+        connectUs.insert(connectUs.end(), o.connectUs.begin(), o.connectUs.end());
+        for (std::map<std::string, uint64_t>::const_iterator it = o.errors.begin(); it != o.errors.end(); ++it) {
+            errors[it->first] += it->second;
+        }
+    }
+};
+
+static const char *errorName(PbHbError e) {
+    switch (e) {
+        case PbHbError::None:           return "none";
+        case PbHbError::ResolveFailed:  return "resolve";
+        case PbHbError::ResolveTimeout: return "resolve timeout";
+        case PbHbError::ConnectFailed:  return "connect refused";
+        case PbHbError::ConnectTimeout: return "connect timeout";
+        case PbHbError::WriteFailed:    return "write";
+        case PbHbError::WriteTimeout:   return "write timeout";
+        case PbHbError::StatusTimeout:  return "status timeout";
+        case PbHbError::Closed:         return "closed";
+        case PbHbError::BadStatusLine:  return "bad status line";
+        case PbHbError::BadResponse:    return "bad response";
+    }
+    return "?";
+}
+
+static void printStats(const char *title, FleetStats &s, double seconds) {
+    const uint64_t done = s.ok + s.failed;
+    printf("%s: %.0f с, beat %llu (ok %llu, помилки %llu = %.2f%%, пропущено %llu), %.1f beat/с, "
+           "нових з'єднань %llu, повторів %llu\n",
+           title, seconds, static_cast<unsigned long long>(s.started), static_cast<unsigned long long>(s.ok),
+           static_cast<unsigned long long>(s.failed), done ? 100.0 * s.failed / done : 0.0,
+           static_cast<unsigned long long>(s.lost), seconds > 0 ? s.ok / seconds : 0.0,
+           static_cast<unsigned long long>(s.connNew), static_cast<unsigned long long>(s.retried));
+    if (!s.beatUs.empty()) {
+        const uint32_t maxUs = *std::max_element(s.beatUs.begin(), s.beatUs.end());
+        printf("   beat мкс: p50 %u  p95 %u  p99 %u  max %u\n", percentile(s.beatUs, 50), percentile(s.beatUs, 95),
+               percentile(s.beatUs, 99), maxUs);
+    }
+    if (!s.connectUs.empty()) {
+        printf("   connect мкс: p50 %u  p95 %u\n", percentile(s.connectUs, 50), percentile(s.connectUs, 95));
+    }
+    for (std::map<std::string, uint64_t>::const_iterator it = s.errors.begin(); it != s.errors.end(); ++it) {
+        printf("   ❌ %-28s %llu\n", it->first.c_str(), static_cast<unsigned long long>(it->second));
+    }
+    fflush(stdout);
+}
+
+// ─── Сенсор ───
+
+#define FLEET_HB_HEAD(contentType)           \
+    "POST /api/v1/heartbeat HTTP/1.1\r\n"    \
+    "Host: %s\r\n"                           \
+    "Content-Type: " contentType "\r\n"      \
+    "Connection: %s\r\n"                     \
+    "Content-Length: %u\r\n\r\n"
+
+class FleetSensor {
+public:
+    FleetSensor(const FleetOptions &o, const PbHbConfig &cfg, const PbHmacKey &key, unsigned index)
+        : opt_(o), key_(key), hb_(net_, cfg) {
+        char uuid[96];
+        snprintf(uuid, sizeof(uuid), "%s%05u", o.uuidPrefix.c_str(), index + 1);
+        uuid_ = uuid;
+        building_ = static_cast<uint16_t>(1 + index % o.buildings);
+        section_ = static_cast<uint16_t>(1 + (index / o.buildings) % o.sections);
+        pbFrameUuidHash(uuid_.c_str(), uuidHash_);
+
+        // JSON beat прошивки (поля і слоти в тому ж порядку, без heap / hb_* телеметрії).
+        body_ = "{\"api_key\":\"" + o.apiKey + "\",\"building_id\":" + std::to_string(building_) +
+                ",\"section_id\":" + std::to_string(section_) + ",\"sensor_uuid\":\"" + uuid_ +
+                "\",\"comment\":\"fleet-sim\",\"event\":";
+        eventAt_ = body_.size();
+        body_ += PB_SLOT_EVENT ",\"seq\":";
+        seqAt_ = body_.size();
+        body_ += PB_SLOT_U32 ",\"uptime_s\":";
+        uptimeAt_ = body_.size();
+        body_ += PB_SLOT_U32 ",\"boot_count\":";
+        bootCountAt_ = body_.size();
+        body_ += PB_SLOT_U32 ",\"conn_new\":";
+        connNewAt_ = body_.size();
+        body_ += PB_SLOT_U32 ",\"conn_reused\":";
+        connReusedAt_ = body_.size();
+        body_ += PB_SLOT_U32 "}";
+    }
+
+    int fd() const { return net_.fd(); }
+    bool busy() const { return hb_.busy(); }
+    bool wantsWrite() const { return hb_.state() == PbHbState::Connect || hb_.state() == PbHbState::Write; }
+    uint64_t nextUs() const { return schedule_.next(); }
+    bool deliveredSince(uint64_t us) const { return lastOkUs_ >= us; }
+
+    // Старт прошивки: seq з нуля, перший beat — boot і одразу (через jitterUs), далі сітка.
+    void boot(uint64_t nowUs, uint32_t jitterUs) {
+        hb_.abort();
+        net_.close();
+        bootUs_ = nowUs + jitterUs;
+        bootCount_++;   // як NVS-лічильник прошивки
+        seq_ = 0;
+        registered_ = false;
+        const uint32_t spread = opt_.spreadMs < 0 ? opt_.intervalMs : static_cast<uint32_t>(opt_.spreadMs);
+        schedule_.begin(bootUs_, opt_.intervalMs, pbBeatPhaseMs(uuid_.c_str(), spread));
+    }
+
+    // Keep-alive рветься (перезапуск сервера / NAT): наступний beat — нове з'єднання.
+    void dropConnection() {
+        if (!hb_.busy()) {
+            net_.close();
+        }
+    }
+
+    void poll(uint64_t nowUs, std::mt19937 &rng, FleetStats &stats) {
+        const uint32_t ms = static_cast<uint32_t>(nowUs / 1000u);
+        const uint32_t us = static_cast<uint32_t>(nowUs);
+        if (hb_.busy()) {
+            hb_.step(ms, us);
+            if (hb_.finished()) {
+                finish(nowUs, stats);
+            }
+            return;
+        }
+        if (!schedule_.due(nowUs)) {
+            return;
+        }
+        schedule_.started(nowUs);
+        seq_++;
+        if (opt_.loss > 0 && std::uniform_real_distribution<double>(0, 1)(rng) < opt_.loss) {
+            stats.lost++;   // слот без мережі: у прошивці він піде в журнал
+            return;
+        }
+        startedUs_ = nowUs;
+        stats.started++;
+        if (hb_.start(buildRequest(nowUs), ms, us)) {
+            hb_.step(ms, us);
+            if (hb_.finished()) {
+                finish(nowUs, stats);
+            }
+        }
+    }
+
+private:
+    size_t buildRequest(uint64_t nowUs) {
+        char *req = hb_.requestBuffer();
+        const char *conn = opt_.keepAlive ? "keep-alive" : "close";
+        const uint32_t uptimeS = static_cast<uint32_t>((nowUs - std::min(nowUs, bootUs_)) / 1000000u);
+        if (opt_.frame && registered_) {
+            const int head = snprintf(req, hb_.requestCapacity(), FLEET_HB_HEAD("application/octet-stream"),
+                                      opt_.host.c_str(), conn, static_cast<unsigned>(PB_FRAME_SIZE));
+            pbFrameEncode(reinterpret_cast<uint8_t *>(req + head), key_, PbFrameEvent::Heartbeat, building_,
+                          section_, uuidHash_, seq_, uptimeS, bootCount_);
+            return static_cast<size_t>(head) + PB_FRAME_SIZE;
+        }
+        std::string body = body_;
+        pbSlotPutStr(&body[eventAt_], sizeof(PB_SLOT_EVENT) - 1, seq_ == 1 ? "boot" : "heartbeat");
+        pbSlotPutUint(&body[seqAt_], sizeof(PB_SLOT_U32) - 1, seq_);
+        pbSlotPutUint(&body[uptimeAt_], sizeof(PB_SLOT_U32) - 1, uptimeS);
+        pbSlotPutUint(&body[bootCountAt_], sizeof(PB_SLOT_U32) - 1, bootCount_);
+        pbSlotPutUint(&body[connNewAt_], sizeof(PB_SLOT_U32) - 1, hb_.connNew());
+        pbSlotPutUint(&body[connReusedAt_], sizeof(PB_SLOT_U32) - 1, hb_.connReused());
+        const int head = snprintf(req, hb_.requestCapacity(), FLEET_HB_HEAD("application/json"), opt_.host.c_str(),
+                                  conn, static_cast<unsigned>(body.size()));
+        const size_t len = static_cast<size_t>(head) + body.size();
+        if (len > hb_.requestCapacity()) {
+            return 0;
+        }
+        memcpy(req + head, body.data(), body.size());
+        return len;
+    }
+
+    void finish(uint64_t nowUs, FleetStats &stats) {
+        const PbHbTimings &t = hb_.timings();
+        if (t.has(PbHbPhase::Connect)) {
+            stats.connNew++;
+            stats.connectUs.push_back(t.get(PbHbPhase::Connect));
+        }
+        if (hb_.retried()) {
+            stats.retried++;
+        }
+        if (hb_.ok()) {
+            stats.ok++;
+            stats.beatUs.push_back(static_cast<uint32_t>(nowUs - startedUs_));
+            lastOkUs_ = nowUs;
+            registered_ = true;
+        } else {
+            stats.failed++;
+            std::string what;
+            if (hb_.state() == PbHbState::Done) {
+                what = "HTTP " + std::to_string(hb_.httpStatus());
+                // Як прошивка: 4xx на frame (сервер не знає сенсор) — наступний beat знову JSON.
+                registered_ = false;
+            } else {
+                what = std::string(pbHbPhaseName(t.failedAt)) + ": " + errorName(hb_.error());
+            }
+            stats.errors[what]++;
+        }
+        hb_.reset();
+    }
+
+    const FleetOptions &opt_;
+    const PbHmacKey &key_;
+    PbPosixNet net_;
+    PbHbMachine<PbPosixNet> hb_;
+    PbBeatSchedule schedule_;
+
+    std::string uuid_;
+    uint16_t building_ = 1;
+    uint16_t section_ = 1;
+    uint8_t uuidHash_[PB_FRAME_UUID_HASH_SIZE];
+    std::string body_;
+    size_t eventAt_ = 0;
+    size_t seqAt_ = 0;
+    size_t uptimeAt_ = 0;
+    size_t bootCountAt_ = 0;
+    size_t connNewAt_ = 0;
+    size_t connReusedAt_ = 0;
+
+    uint32_t seq_ = 0;
+    uint32_t bootCount_ = 0;
+    bool registered_ = false;
+    uint64_t bootUs_ = 0;
+    uint64_t startedUs_ = 0;
+    uint64_t lastOkUs_ = 0;
+};
+
+// ─── Прогін ───
+
+// Шторм: хто з сенсорів уже доставив beat після нього.
+struct FleetStorm {
+    const char *kind;
+    uint64_t atUs;
+    bool fired;
+    bool recovered;
+};
+
+static bool resolveHost(const std::string &host, std::string &ip) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo *res = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &res) != 0 || res == nullptr) {
+        return false;
+    }
+    char buf[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &reinterpret_cast<struct sockaddr_in *>(res->ai_addr)->sin_addr, buf, sizeof(buf));
+    freeaddrinfo(res);
+    ip = buf;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    FleetOptions opt;
+    if (!parseOptions(argc, argv, opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    std::string ip;
+    if (!resolveHost(opt.host, ip)) {
+        fprintf(stderr, "❌ не вдалося розпізнати %s\n", opt.host.c_str());
+        return 1;
+    }
+    const PbHbConfig cfg = {ip.c_str(), opt.port, opt.timeoutMs, opt.timeoutMs, opt.timeoutMs, opt.keepAlive};
+    const PbHmacKey key(reinterpret_cast<const uint8_t *>(opt.apiKey.data()), opt.apiKey.size());
+
+    std::vector<FleetSensor *> fleet;
+    fleet.reserve(opt.sensors);
+    for (unsigned i = 0; i < opt.sensors; i++) {
+        fleet.push_back(new FleetSensor(opt, cfg, key, i));
+    }
+
+    std::vector<FleetStorm> storms;
+    for (size_t i = 0; i < opt.rebootAtS.size(); i++) {
+        storms.push_back(FleetStorm{"перезавантаження", opt.rebootAtS[i] * 1000000ull, false, false});
+    }
+    for (size_t i = 0; i < opt.reconnectAtS.size(); i++) {
+        storms.push_back(FleetStorm{"перепідключення", opt.reconnectAtS[i] * 1000000ull, false, false});
+    }
+
+    printf("🚀 fleet-sim: %u сенсорів -> %s:%u (%s), період %u мс, %s%s, %u с\n", opt.sensors, opt.host.c_str(),
+           opt.port, ip.c_str(), opt.intervalMs, opt.frame ? "frame" : "JSON",
+           opt.keepAlive ? " + keep-alive" : "", opt.durationS);
+    fflush(stdout);
+
+    std::mt19937 rng(opt.seed);
+    std::uniform_int_distribution<uint32_t> jitter(0, opt.bootJitterMs * 1000u);
+    const uint64_t t0 = monoUs();
+    for (size_t i = 0; i < fleet.size(); i++) {
+        fleet[i]->boot(t0, opt.bootJitterMs ? jitter(rng) : 0);
+    }
+
+    FleetStats total;
+    FleetStats window;
+    uint64_t windowStartUs = t0;
+    const uint64_t endUs = t0 + opt.durationS * 1000000ull;
+    std::vector<struct pollfd> fds;
+    fds.reserve(fleet.size());
+
+    for (uint64_t now = monoUs(); now < endUs; now = monoUs()) {
+        for (size_t s = 0; s < storms.size(); s++) {
+            FleetStorm &st = storms[s];
+            if (st.fired || now < t0 + st.atUs) {
+                continue;
+            }
+            st.fired = true;
+            st.atUs += t0;
+            printf("⚡ шторм: %s усіх %u сенсорів\n", st.kind, opt.sensors);
+            fflush(stdout);
+            const bool reboot = strcmp(st.kind, "перезавантаження") == 0;
+            for (size_t i = 0; i < fleet.size(); i++) {
+                if (reboot) {
+                    fleet[i]->boot(now, opt.bootJitterMs ? jitter(rng) : 0);
+                } else {
+                    fleet[i]->dropConnection();
+                }
+            }
+        }
+
+        uint64_t nextUs = endUs;
+        bool anyBusy = false;
+        fds.clear();
+        for (size_t i = 0; i < fleet.size(); i++) {
+            FleetSensor &s = *fleet[i];
+            // Свій час на кожен сенсор: прохід по тисячах триває мілісекунди, і з одним now
+            // усі фази в ньому мали б однакову тривалість.
+            s.poll(monoUs(), rng, window);
+            if (s.busy()) {
+                anyBusy = true;
+                if (s.fd() >= 0) {
+                    struct pollfd p = {s.fd(), static_cast<short>(s.wantsWrite() ? POLLOUT : POLLIN), 0};
+                    fds.push_back(p);
+                }
+            } else {
+                nextUs = std::min(nextUs, s.nextUs());
+            }
+        }
+
+        for (size_t s = 0; s < storms.size(); s++) {
+            FleetStorm &st = storms[s];
+            if (!st.fired || st.recovered) {
+                continue;
+            }
+            bool all = true;
+            for (size_t i = 0; i < fleet.size() && all; i++) {
+                all = fleet[i]->deliveredSince(st.atUs);
+            }
+            if (all) {
+                st.recovered = true;
+                printf("✅ після шторму (%s) усі сенсори доставили beat за %.3f с\n", st.kind,
+                       (now - st.atUs) / 1e6);
+                fflush(stdout);
+            }
+        }
+
+        if (opt.reportS != 0 && now - windowStartUs >= opt.reportS * 1000000ull) {
+            const double seconds = (now - windowStartUs) / 1e6;
+            FleetStats shown = window;
+            printStats("📊 вікно", shown, seconds);
+            total.merge(window);
+            window.clear();
+            windowStartUs = now;
+        }
+
+        // Сон до події сокета або наступного дедлайну; таймаути машини — з кроком 5 мс.
+        uint64_t waitUs = nextUs > now ? nextUs - now : 0;
+        if (anyBusy) {
+            waitUs = std::min<uint64_t>(waitUs, 5000);
+        }
+        const uint64_t reportUs = windowStartUs + opt.reportS * 1000000ull;
+        if (opt.reportS != 0 && reportUs > now) {
+            waitUs = std::min(waitUs, reportUs - now);
+        }
+        if (waitUs > 0) {
+            ::poll(fds.empty() ? nullptr : &fds[0], fds.size(), static_cast<int>((waitUs + 999) / 1000));
+        }
+    }
+
+    total.merge(window);
+    printf("\n");
+    printStats("🏁 підсумок", total, (monoUs() - t0) / 1e6);
+    if (total.started > total.ok + total.failed) {
+        // Сервер не встигає: ці beat-и ще без відповіді, у латентність і помилки вони не ввійшли.
+        printf("⏳ без відповіді на кінець прогону: %llu\n",
+               static_cast<unsigned long long>(total.started - total.ok - total.failed));
+    }
+    for (size_t s = 0; s < storms.size(); s++) {
+        if (storms[s].fired && !storms[s].recovered) {
+            printf("⚠️ після шторму (%s) не всі сенсори доставили beat до кінця прогону\n", storms[s].kind);
+        }
+    }
+    for (size_t i = 0; i < fleet.size(); i++) {
+        delete fleet[i];
+    }
+    return total.failed == 0 ? 0 : 1;
+}
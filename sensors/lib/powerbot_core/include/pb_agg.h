@@ -0,0 +1,428 @@
+/*
+ * PowerBot: агрегатор будинку (PB_ROLE=PB_ROLE_AGGREGATOR).
+ *
+ * Секції одного будинку часто стоять в одному підвалі на одному комутаторі, а кожна
+ * тримає своє з'єднання до API. Агрегатор — той самий сенсор, зібраний з PB_ROLE_AGGREGATOR:
+ * він слухає LAN (UDP, PB_AGG_UDP_PORT), а сусіди шлють йому звичайні UDP beat-и
+ * (PB_TRANSPORT_UDP, SERVER_HOST = адреса агрегатора): перший — JSON (реєстрація), далі
+ * 36-байтні frame-и з HMAC. Раз на свій слот розкладу агрегатор відправляє на сервер один
+ * пакет (POST /api/v1/heartbeat/batch): свій beat і останній beat кожного сусіда з його віком.
+ *
+ * Ack сусіду — одразу, локально (сервер відповість лише на пакет):
+ *   "OK <seq>"      — beat прийнято в таблицю;
+ *   "ERR 404 <seq>" — сервер не знає сенсор за frame: сусід, як і з сервером, перейде на JSON;
+ *   "ERR 409 <seq>" — frame не новіший за вже прийнятий (повтор): запис сусіда не змінюється;
+ *   "ERR 503 <seq>" — останній пакет не дійшов до сервера або таблиця повна: beat не доставлено;
+ *   "ERR 401/400"   — підпис / api_key або будинок не той.
+ * Статус кожного beat у пакеті сервер повертає в "results" (у порядку beats): 200 — доставлено,
+ * 404 — сенсор невідомий (наступний frame отримає ERR 404), інший 4xx — beat відкидається,
+ * решта — лишається до наступного пакета.
+ *
+ * Таблиця — фіксовані N записів, без heap. Сусід, якого не чути довше за forgetMs, звільняє
+ * запис для нового.
+ *
+ * Header портабельний (без Arduino.h) — перевіряється на хості (test/test_agg).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "pb_beat_journal.h"
+#include "pb_hb_frame.h"
+
+// Найбільша датаграма сусіда (JSON beat; як kDatagramCap PbUdpBeat за замовчуванням).
+static const size_t kPbAggDatagramCap = 832;
+
+// Найдовший SENSOR_UUID сусіда, який агрегатор перешле як є (разом з '\0').
+static const size_t kPbAggUuidCap = 48;
+
+// Найдовший запис сусіда в пакеті:
+// ,{"sensor_uuid":"<47>","section_id":65535,"event":"power_lost","seq":4294967295,
+//   "uptime_s":4294967295,"age_ms":4294967295}
+static const size_t kPbAggRecJsonMax = 176;
+
+// Значення поля "key" у плоскому JSON сусіда (рядок — без лапок). false — поля немає,
+// значення не рядок / не число або рядок з escape (такий uuid ми не пересилаємо).
+inline bool pbAggJsonField(const char *json, size_t len, const char *key, const char **val, size_t *valLen) {
+    const size_t keyLen = strlen(key);
+    for (size_t i = 0; i + keyLen + 3 <= len; i++) {
+        if (json[i] != '"' || memcmp(json + i + 1, key, keyLen) != 0 || json[i + 1 + keyLen] != '"') {
+            continue;
+        }
+        size_t at = i + keyLen + 2;
+        while (at < len && json[at] == ' ') {
+            at++;
+        }
+        if (at == len || json[at] != ':') {
+            continue;
+        }
+        at++;
+        while (at < len && json[at] == ' ') {
+            at++;
+        }
+        if (at < len && json[at] == '"') {
+            const size_t start = ++at;
+            while (at < len && json[at] != '"') {
+                if (json[at] == '\\' || static_cast<unsigned char>(json[at]) < 0x20) {
+                    return false;
+                }
+                at++;
+            }
+            if (at == len) {
+                return false;
+            }
+            *val = json + start;
+            *valLen = at - start;
+            return true;
+        }
+        const size_t start = at;
+        while (at < len && json[at] >= '0' && json[at] <= '9') {
+            at++;
+        }
+        if (at == start) {
+            return false;
+        }
+        *val = json + start;
+        *valLen = at - start;
+        return true;
+    }
+    return false;
+}
+
+inline bool pbAggJsonUint(const char *json, size_t len, const char *key, uint32_t *out) {
+    const char *v;
+    size_t n;
+    if (!pbAggJsonField(json, len, key, &v, &n) || n > 10 || v[0] < '0' || v[0] > '9') {
+        return false;
+    }
+    uint64_t x = 0;
+    for (size_t i = 0; i < n; i++) {
+        x = x * 10u + static_cast<uint32_t>(v[i] - '0');
+    }
+    if (x > UINT32_MAX) {
+        return false;
+    }
+    *out = static_cast<uint32_t>(x);
+    return true;
+}
+
+inline bool pbAggJsonStrIs(const char *json, size_t len, const char *key, const char *expect) {
+    const char *v;
+    size_t n;
+    return pbAggJsonField(json, len, key, &v, &n) && n == strlen(expect) && memcmp(v, expect, n) == 0;
+}
+
+struct PbAggPeer {
+    bool used;
+    bool fresh;      // є beat, якого сервер ще не підтвердив
+    bool needJson;   // сервер не знає сенсор: наступний frame -> ERR 404
+    bool heard;      // є прийнятий beat: (bootCount, seq) — курсор проти повтору frame
+    uint8_t uuidHash[PB_FRAME_UUID_HASH_SIZE];
+    char uuid[kPbAggUuidCap];   // з JSON beat; "" — відомий лише з frame
+    uint16_t sectionId;
+    PbFrameEvent event;
+    uint32_t seq;
+    uint32_t uptimeS;
+    uint32_t bootCount;
+    uint32_t heardMs;
+};
+
+// Frame сусіда новіший за останній прийнятий (підписаний frame можна перехопити й повторити):
+// спершу за boot_count з NVS (назад не йде), у межах boot — за seq; power_lost несе seq
+// останнього beat, тож іде одразу після нього. Те саме правило, що й на сервері.
+inline bool pbAggFrameIsNew(const PbAggPeer &p, const PbFrame &f) {
+    if (!p.heard) {
+        return true;
+    }
+    if (f.bootCount != p.bootCount) {
+        return f.bootCount > p.bootCount;
+    }
+    const uint64_t at = static_cast<uint64_t>(f.seq) * 2u + (f.event == PbFrameEvent::PowerLost ? 1u : 0u);
+    const uint64_t last = static_cast<uint64_t>(p.seq) * 2u + (p.event == PbFrameEvent::PowerLost ? 1u : 0u);
+    return at > last;
+}
+
+template <size_t N>
+class PbAggTable {
+    static_assert(N >= 1 && N <= 32, "агрегатор: 1..32 сусідів");
+
+public:
+    PbAggTable(const PbHmacKey &key, const char *apiKey, uint16_t buildingId, uint32_t forgetMs)
+        : key_(key), apiKey_(apiKey), buildingId_(buildingId), forgetMs_(forgetMs) {
+        memset(peers_, 0, sizeof(peers_));
+    }
+
+    // Датаграма сусіда -> таблиця; ack (без '\0') — у ack. Повертає довжину ack, 0 — не відповідати.
+    size_t accept(const uint8_t *dgram, size_t len, uint32_t nowMs, char *ack, size_t ackCap) {
+        PbFrame f;
+        char uuid[kPbAggUuidCap];
+        uuid[0] = '\0';
+        if (pbFrameDecode(dgram, len, key_, &f)) {
+            if (f.buildingId != buildingId_) {
+                return putAck(ack, ackCap, 400, f.seq);
+            }
+        } else if (len > 0 && dgram[0] == '{') {
+            uint32_t status = 0;
+            if (!parseJson(reinterpret_cast<const char *>(dgram), len, &f, uuid, &status)) {
+                return status != 0 ? putAck(ack, ackCap, static_cast<int>(status), f.seq) : 0;
+            }
+        } else if (len == PB_FRAME_SIZE && dgram[0] == 'P' && dgram[1] == 'B') {
+            return putAck(ack, ackCap, 401, pbFrameGetU32(dgram + 16));   // підпис не той
+        } else {
+            return 0;
+        }
+
+        PbAggPeer *p = find(f.uuidHash, nowMs);
+        if (p == nullptr) {
+            return putAck(ack, ackCap, 503, f.seq);
+        }
+        if (uuid[0] != '\0') {
+            memcpy(p->uuid, uuid, sizeof(uuid));
+            p->needJson = false;
+        } else if (p->needJson) {
+            return putAck(ack, ackCap, 404, f.seq);
+        } else if (!pbAggFrameIsNew(*p, f)) {
+            return putAck(ack, ackCap, 409, f.seq);   // повтор: новіший запис сусіда лишається
+        }
+        p->fresh = true;
+        p->heard = true;
+        p->sectionId = f.sectionId;
+        p->event = f.event;
+        p->seq = f.seq;
+        p->uptimeS = f.uptimeS;
+        p->bootCount = f.bootCount;
+        p->heardMs = nowMs;
+        if (f.event != PbFrameEvent::Heartbeat) {
+            urgent_ = true;
+        }
+        return putAck(ack, ackCap, uplinkOk_ ? 200 : 503, f.seq);
+    }
+
+    // Сусід щойно завантажився або втратив живлення — пакет варто відправити позачергово.
+    bool takeUrgent() {
+        const bool u = urgent_;
+        urgent_ = false;
+        return u;
+    }
+
+    size_t pending() const {
+        size_t n = 0;
+        for (size_t i = 0; i < N; i++) {
+            n += peers_[i].used && peers_[i].fresh ? 1 : 0;
+        }
+        return n;
+    }
+
+    bool uplinkOk() const { return uplinkOk_; }
+
+    // Скільки сусідів у пакеті, що зараз летить (після putBeatsJson()).
+    size_t sent() const { return sentCount_; }
+
+    // Записи сусідів для "beats" пакета, кожен з ',' попереду (перший елемент — власний beat
+    // агрегатора). Запам'ятовує порядок для applyResults(). Повертає довжину (0 — нікого).
+    size_t putBeatsJson(char *out, size_t cap, uint32_t nowMs) {
+        size_t at = 0;
+        sentCount_ = 0;
+        for (size_t i = 0; i < N; i++) {
+            const PbAggPeer &p = peers_[i];
+            if (!p.used || !p.fresh || cap - at < kPbAggRecJsonMax) {
+                continue;
+            }
+            at += putRec(out + at, p, nowMs);
+            sent_[sentCount_].index = static_cast<uint8_t>(i);
+            sent_[sentCount_].seq = p.seq;
+            sent_[sentCount_].heardMs = p.heardMs;
+            sentCount_++;
+        }
+        return at;
+    }
+
+    // Відповідь сервера на пакет (тіло, можливо обрізане). results[0] — власний beat.
+    // Без "results" (інша помилка, обрізане тіло) — beat-и лишаються до наступного пакета.
+    void applyResults(bool httpOk, const char *body) {
+        uplinkOk_ = httpOk;
+        const char *r = httpOk ? strstr(body, "\"results\"") : nullptr;
+        if (r == nullptr) {
+            sentCount_ = 0;
+            return;
+        }
+        r = strchr(r, '[');
+        int own = -1;
+        size_t k = 0;
+        while (r != nullptr && *r != '\0' && *r != ']') {
+            r++;
+            while (*r == ' ') {
+                r++;
+            }
+            int status = 0;
+            const char *digits = r;
+            while (*r >= '0' && *r <= '9') {
+                status = status * 10 + (*r - '0');
+                r++;
+            }
+            if (r == digits || (*r != ',' && *r != ']')) {
+                break;   // обрізано посеред числа — решта без статусу
+            }
+            if (own < 0) {
+                own = status;
+            } else if (k < sentCount_) {
+                applyOne(sent_[k++], status);
+            }
+        }
+        sentCount_ = 0;
+    }
+
+    const PbAggPeer &at(size_t i) const { return peers_[i]; }
+
+private:
+    struct Sent {
+        uint8_t index;
+        uint32_t seq;
+        uint32_t heardMs;
+    };
+
+    static size_t putAck(char *ack, size_t cap, int status, uint32_t seq) {
+        if (cap < 26) {
+            return 0;
+        }
+        size_t at = 0;
+        if (status == 200) {
+            memcpy(ack, "OK ", 3);
+            at = 3;
+        } else {
+            memcpy(ack, "ERR ", 4);
+            at = 4;
+            at += pbJournalPutUint(ack + at, static_cast<uint32_t>(status));
+            ack[at++] = ' ';
+        }
+        at += pbJournalPutUint(ack + at, seq);
+        return at;
+    }
+
+    // JSON beat сусіда (той самий, що сенсор шле серверу). false + status — відповісти помилкою,
+    // false + 0 — не відповідати (не JSON beat).
+    bool parseJson(const char *json, size_t len, PbFrame *f, char *uuid, uint32_t *status) {
+        uint32_t seq = 0;
+        pbAggJsonUint(json, len, "seq", &seq);
+        f->seq = seq;
+        if (!pbAggJsonStrIs(json, len, "api_key", apiKey_)) {
+            *status = 401;
+            return false;
+        }
+        uint32_t building = 0;
+        uint32_t section = 0;
+        const char *u;
+        size_t uLen;
+        if (!pbAggJsonUint(json, len, "building_id", &building) || building != buildingId_ ||
+            !pbAggJsonUint(json, len, "section_id", &section) || section > UINT16_MAX ||
+            !pbAggJsonField(json, len, "sensor_uuid", &u, &uLen) || uLen == 0 || uLen >= kPbAggUuidCap ||
+            u[-1] != '"') {
+            *status = 400;
+            return false;
+        }
+        memcpy(uuid, u, uLen);
+        uuid[uLen] = '\0';
+        pbFrameUuidHash(uuid, f->uuidHash);
+        f->buildingId = static_cast<uint16_t>(building);
+        f->sectionId = static_cast<uint16_t>(section);
+        f->event = pbAggJsonStrIs(json, len, "event", "boot")         ? PbFrameEvent::Boot
+                   : pbAggJsonStrIs(json, len, "event", "power_lost") ? PbFrameEvent::PowerLost
+                                                                      : PbFrameEvent::Heartbeat;
+        f->uptimeS = 0;
+        pbAggJsonUint(json, len, "uptime_s", &f->uptimeS);
+        f->bootCount = 0;
+        pbAggJsonUint(json, len, "boot_count", &f->bootCount);
+        return true;
+    }
+
+    // Запис сусіда; новий — у вільний або найдавніше чутий після forgetMs. nullptr — місця немає.
+    PbAggPeer *find(const uint8_t hash[PB_FRAME_UUID_HASH_SIZE], uint32_t nowMs) {
+        PbAggPeer *spare = nullptr;
+        for (size_t i = 0; i < N; i++) {
+            PbAggPeer &p = peers_[i];
+            if (p.used && memcmp(p.uuidHash, hash, PB_FRAME_UUID_HASH_SIZE) == 0) {
+                return &p;
+            }
+            if (!p.used) {
+                if (spare == nullptr || spare->used) {
+                    spare = &p;
+                }
+            } else if (static_cast<uint32_t>(nowMs - p.heardMs) > forgetMs_ &&
+                       (spare == nullptr || (spare->used && static_cast<int32_t>(p.heardMs - spare->heardMs) < 0))) {
+                spare = &p;
+            }
+        }
+        if (spare == nullptr) {
+            return nullptr;
+        }
+        memset(spare, 0, sizeof(*spare));
+        spare->used = true;
+        memcpy(spare->uuidHash, hash, PB_FRAME_UUID_HASH_SIZE);
+        return spare;
+    }
+
+    static size_t putHex(char *out, const uint8_t *b, size_t n) {
+        static const char kHex[] = "0123456789abcdef";
+        for (size_t i = 0; i < n; i++) {
+            out[2 * i] = kHex[b[i] >> 4];
+            out[2 * i + 1] = kHex[b[i] & 0x0f];
+        }
+        return 2 * n;
+    }
+
+    static size_t putLit(char *out, const char *s) {
+        const size_t n = strlen(s);
+        memcpy(out, s, n);
+        return n;
+    }
+
+    static size_t putRec(char *out, const PbAggPeer &p, uint32_t nowMs) {
+        size_t at = 0;
+        if (p.uuid[0] != '\0') {
+            at += putLit(out + at, ",{\"sensor_uuid\":\"");
+            at += putLit(out + at, p.uuid);
+        } else {
+            at += putLit(out + at, ",{\"uuid_hash\":\"");
+            at += putHex(out + at, p.uuidHash, PB_FRAME_UUID_HASH_SIZE);
+        }
+        at += putLit(out + at, "\",\"section_id\":");
+        at += pbJournalPutUint(out + at, p.sectionId);
+        at += putLit(out + at, ",\"event\":\"");
+        at += putLit(out + at, p.event == PbFrameEvent::Boot        ? "boot"
+                               : p.event == PbFrameEvent::PowerLost ? "power_lost"
+                                                                    : "heartbeat");
+        at += putLit(out + at, "\",\"seq\":");
+        at += pbJournalPutUint(out + at, p.seq);
+        at += putLit(out + at, ",\"uptime_s\":");
+        at += pbJournalPutUint(out + at, p.uptimeS);
+        at += putLit(out + at, ",\"age_ms\":");
+        at += pbJournalPutUint(out + at, nowMs - p.heardMs);
+        out[at++] = '}';
+        return at;
+    }
+
+    void applyOne(const Sent &s, int status) {
+        PbAggPeer &p = peers_[s.index];
+        // Поки пакет летів, сусід міг прислати новіший beat — його не чіпаємо.
+        const bool same = p.used && p.seq == s.seq && p.heardMs == s.heardMs;
+        if (status == 404) {
+            p.needJson = true;
+        }
+        if (same && (status == 200 || (status >= 400 && status < 500))) {
+            p.fresh = false;
+        }
+    }
+
+    PbAggPeer peers_[N];
+    Sent sent_[N];
+    size_t sentCount_ = 0;
+    const PbHmacKey &key_;
+    const char *apiKey_;
+    uint16_t buildingId_;
+    uint32_t forgetMs_;
+    bool uplinkOk_ = true;
+    bool urgent_ = false;
+};
@@ -0,0 +1,155 @@
+/*
+ * PowerBot: журнал недоставлених heartbeat (офлайн-журнал).
+ *
+ * Коли мережа чи сервер лежать, а живлення є, сервер бачить таймаут і пише "світла немає".
+ * Сенсор складає сюди кожен слот розкладу, який не вдалось доставити, — (seq, uptime) — і після
+ * другого поспіль успішного beat відправляє все одним запитом (POST /api/v1/heartbeat/bulk): сервер
+ * відновлює історію і знімає хибне відключення.
+ *
+ * Записи — uptime, а не wall clock: у прошивки немає часу, сервер рахує час як
+ * "зараз - (uptime на момент відправки - uptime запису)". Тому журнал живе в RAM і
+ * зникає з перезавантаженням: після reset uptime починається з нуля, і старі записи вже ні до
+ * чого прив'язати (а reset від втрати живлення і так кінець "живого" відрізка).
+ *
+ * Місткість фіксована (N записів). Коли журнал повний, він проріджується вдвічі (кожен другий
+ * запис) і далі пише кожен stride()-й слот: довге відключення покривається цілком з
+ * грубішим кроком, а не губить свій початок, як звичайний ring. Останній слот тримається
+ * окремо, тож кінець відрізка завжди точний.
+ *
+ * seq = 0 — маркер "пропало живлення" (last-gasp): між записами до і після нього
+ * безперервності немає, і сервер не склеює їх в один відрізок.
+ *
+ * Header портабельний (без Arduino.h) — перевіряється на хості (test/test_beat_journal).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct PbJournalRec {
+    uint32_t seq;       // 0 — маркер втрати живлення
+    uint32_t uptimeS;
+};
+
+// Найдовший запис у JSON: "[4294967295,4294967295],".
+static const size_t kPbJournalRecJsonMax = 24;
+
+template <size_t N>
+class PbBeatJournal {
+    static_assert(N >= 4, "журнал: щонайменше 4 записи");
+
+public:
+    // Недоставлений слот розкладу.
+    void add(uint32_t seq, uint32_t uptimeS) {
+        const PbJournalRec rec = {seq, uptimeS};
+        if (++skip_ < stride_) {
+            tail_ = rec;
+            hasTail_ = true;
+            return;
+        }
+        skip_ = 0;
+        hasTail_ = false;
+        push(rec);
+    }
+
+    // Живлення пропало: закриваємо відрізок (останній слот + маркер).
+    void markPowerLost(uint32_t uptimeS) {
+        if (size() == 0) {
+            return;
+        }
+        if (hasTail_) {
+            hasTail_ = false;
+            push(tail_);
+        }
+        const PbJournalRec marker = {0, uptimeS};
+        push(marker);
+        skip_ = 0;
+    }
+
+    size_t size() const { return n_ + (hasTail_ ? 1 : 0); }
+    bool empty() const { return size() == 0; }
+    // i-й запис від найстаршого; останній — відкладений слот, якщо є.
+    const PbJournalRec &at(size_t i) const { return i < n_ ? recs_[i] : tail_; }
+    // Кожен котрий слот зараз пишеться (1 — кожен).
+    uint32_t stride() const { return stride_; }
+
+    void clear() {
+        n_ = 0;
+        hasTail_ = false;
+        stride_ = 1;
+        skip_ = 0;
+    }
+
+private:
+    void push(const PbJournalRec &rec) {
+        if (n_ == N) {
+            thin();
+        }
+        recs_[n_++] = rec;
+    }
+
+    // Лишає кожен другий запис, а також маркери і запис перед кожним маркером (кінці відрізків).
+    void thin() {
+        size_t kept = 0;
+        for (size_t i = 0; i < n_; i++) {
+            const bool edge = recs_[i].seq == 0 || (i + 1 < n_ && recs_[i + 1].seq == 0);
+            if (i % 2 == 0 || edge) {
+                recs_[kept++] = recs_[i];
+            }
+        }
+        if (kept == n_) {
+            // Самі маркери (патологічно): відкидаємо найстарішу половину.
+            kept = n_ / 2;
+            for (size_t i = 0; i < kept; i++) {
+                recs_[i] = recs_[n_ - kept + i];
+            }
+        }
+        n_ = kept;
+        stride_ *= 2;
+    }
+
+    PbJournalRec recs_[N];
+    size_t n_ = 0;
+    PbJournalRec tail_ = {0, 0};
+    bool hasTail_ = false;
+    uint32_t stride_ = 1;
+    uint32_t skip_ = 0;
+};
+
+inline size_t pbJournalPutUint(char *out, uint32_t v) {
+    char digits[10];
+    size_t n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = digits[n - 1 - i];
+    }
+    return n;
+}
+
+// [[seq,age_s],...] — вік запису відносно nowS (uptime на момент відправки).
+// Повертає довжину або 0, якщо не влазить у cap.
+template <size_t N>
+size_t pbJournalPutJson(char *out, size_t cap, const PbBeatJournal<N> &j, uint32_t nowS) {
+    if (cap < 2 + j.size() * kPbJournalRecJsonMax) {
+        return 0;
+    }
+    size_t at = 0;
+    out[at++] = '[';
+    for (size_t i = 0; i < j.size(); i++) {
+        const PbJournalRec &r = j.at(i);
+        if (i != 0) {
+            out[at++] = ',';
+        }
+        out[at++] = '[';
+        at += pbJournalPutUint(out + at, r.seq);
+        out[at++] = ',';
+        at += pbJournalPutUint(out + at, nowS >= r.uptimeS ? nowS - r.uptimeS : 0);
+        out[at++] = ']';
+    }
+    out[at++] = ']';
+    return at;
+}
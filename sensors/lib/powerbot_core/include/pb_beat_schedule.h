@@ -0,0 +1,128 @@
+/*
+ * PowerBot: розклад heartbeat за абсолютними дедлайнами.
+ *
+ * Раніше наступний beat рахувався від моменту відправки попереднього (lastHeartbeatTime = now),
+ * тож кожен повільний обмін і крок опитування зсували період. Тут дедлайни лежать на сітці
+ * t0 + phase + k * period від старту: затримка одного beat не переходить на наступні.
+ * Пропущені слоти (мережі не було) не наздоганяються — beat іде одразу, далі знову по сітці.
+ *
+ * phase — зсув сенсора в межах періоду з хешу SENSOR_UUID: сенсори, що ввімкнулись разом
+ * після відключення світла, не б'ють у сервер в одну мілісекунду. Перший beat після boot
+ * (сигнал відновлення живлення) іде одразу, без зсуву.
+ *
+ * Відхилення фактичного інтервалу від періоду складається в log2-гістограму (як hb_lat) і їде
+ * в JSON beat ("hb_int"); вікно — до доставленого підсумку.
+ *
+ * Header портабельний (без Arduino.h) — перевіряється на хості (test/test_beat_schedule).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pb_hb_body.h"
+#include "pb_hb_latency.h"
+
+// FNV-1a: стабільний між збірками і платами, на відміну від std::hash.
+inline uint32_t pbFnv1a(const char *s) {
+    uint32_t h = 2166136261u;
+    for (; *s != '\0'; s++) {
+        h ^= static_cast<uint8_t>(*s);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Зсув сенсора в [0, spreadMs); spreadMs = 0 — без зсуву.
+inline uint32_t pbBeatPhaseMs(const char *uuid, uint32_t spreadMs) {
+    return spreadMs == 0 ? 0 : pbFnv1a(uuid) % spreadMs;
+}
+
+class PbBeatSchedule {
+public:
+    // t0 — старт розкладу; перший beat due одразу.
+    void begin(uint64_t nowUs, uint32_t periodMs, uint32_t phaseMs) {
+        periodUs_ = static_cast<uint64_t>(periodMs) * 1000u;
+        phaseUs_ = static_cast<uint64_t>(phaseMs % periodMs) * 1000u;
+        next_ = nowUs;
+        first_ = true;
+        hasLast_ = false;
+        lastUs_ = 0;
+        clearStats();
+    }
+
+    // Новий період (інструкція сервера). Наступний дедлайн не пізніше останнього beat + період:
+    // з 60 с на 10 с сенсор переходить одразу, а не через старий період.
+    void setPeriod(uint32_t periodMs) {
+        periodUs_ = static_cast<uint64_t>(periodMs) * 1000u;
+        phaseUs_ %= periodUs_;
+        if (!first_ && next_ > lastUs_ + periodUs_) {
+            next_ = lastUs_ + periodUs_;
+        }
+        hasLast_ = false;   // інтервал на межі старого і нового періоду — не відхилення
+    }
+
+    bool due(uint64_t nowUs) const { return nowUs >= next_; }
+    uint64_t next() const { return next_; }
+    uint32_t periodUs() const { return static_cast<uint32_t>(periodUs_); }
+
+    // Beat за розкладом стартував у nowUs; дедлайн зсувається на наступний слот сітки.
+    // Повертає інтервал від попереднього beat за розкладом (мкс) або 0: перший beat, перший
+    // після boot-зсуву, або між ними пропущені слоти (тоді вони в skipped()).
+    uint32_t started(uint64_t nowUs) {
+        uint32_t interval = 0;
+        if (first_) {
+            first_ = false;
+            next_ += phaseUs_ != 0 ? phaseUs_ : periodUs_;
+        } else {
+            next_ += periodUs_;
+            if (hasLast_ && next_ > nowUs) {
+                interval = static_cast<uint32_t>(nowUs - lastUs_);
+                deviation_.add(interval > periodUs_ ? interval - static_cast<uint32_t>(periodUs_)
+                                                    : static_cast<uint32_t>(periodUs_) - interval);
+            }
+            hasLast_ = true;
+        }
+        if (next_ <= nowUs) {
+            const uint64_t missed = (nowUs - next_) / periodUs_ + 1;
+            next_ += missed * periodUs_;
+            skipped_ += static_cast<uint32_t>(missed);
+        }
+        lastUs_ = nowUs;
+        return interval;
+    }
+
+    // |інтервал - період|, мкс.
+    const PbLatencyHist &deviation() const { return deviation_; }
+    uint32_t skipped() const { return skipped_; }
+    void clearStats() {
+        deviation_.clear();
+        skipped_ = 0;
+    }
+
+private:
+    uint64_t periodUs_ = 1;
+    uint64_t phaseUs_ = 0;
+    uint64_t next_ = 0;
+    uint64_t lastUs_ = 0;
+    bool first_ = true;
+    bool hasLast_ = false;
+    PbLatencyHist deviation_;
+    uint32_t skipped_ = 0;
+};
+
+// JSON-шаблон: [p50,p95,max відхилення (мкс), пропущені слоти].
+#define PB_HB_INT_JSON "[" PB_SLOT_U32 "," PB_SLOT_U32 "," PB_SLOT_U32 "," PB_SLOT_U32 "]"
+
+inline void pbBeatIntervalsPut(char *arr, size_t len, const PbBeatSchedule &s) {
+    const size_t w = sizeof(PB_SLOT_U32) - 1;
+    if (len < 1 + 4 * (w + 1)) {
+        return;
+    }
+    const PbLatencyHist &h = s.deviation();
+    pbSlotPutUint(arr + 1, w, h.percentile(50));
+    pbSlotPutUint(arr + 1 + (w + 1), w, h.percentile(95));
+    pbSlotPutUint(arr + 1 + 2 * (w + 1), w, h.max());
+    pbSlotPutUint(arr + 1 + 3 * (w + 1), w, s.skipped());
+}
@@ -0,0 +1,373 @@
+/*
+ * PowerBot: кеш DNS для SERVER_HOST з TTL і фоновим оновленням.
+ *
+ * Під час масових відключень upstream DNS часто лягає першим. Раніше кожен beat питав DNS
+ * (lwIP / блокуючий DNSClient на W5500), і мертвий резолвер додавав секунди до beat або
+ * валив його. Тут beat бере адресу з кешу одразу, а net-задача між beat-ами сама оновлює її:
+ *  - коли минув TTL з відповіді (у межах ttlMinS..ttlMaxS);
+ *  - невдале оновлення не чіпає адресу — далі працює остання відома (last-known-good), а
+ *    наступна спроба через retryMinMs, щоразу вдвічі довше до retryMaxMs;
+ *  - адреса з NVS (seed) придатна одразу після boot і оновлюється при першій змозі.
+ * Лише коли адреси немає зовсім, beat чекає на відповідь (kick()).
+ *
+ * TTL lwIP назовні не віддає, тож запит свій: мінімальний A-запит (RFC 1035) по UDP на DNS
+ * з DHCP. Відповідь приймається лише з тим самим id і тим самим ім'ям у питанні.
+ *
+ * Net має надати non-blocking UDP до DNS-сервера (окремий від heartbeat сокет):
+ *   long dnsSend(const uint8_t *data, size_t len); // >0 відправлено, 0 = зайнято, <0 = помилка
+ *   long dnsRecv(uint8_t *buf, size_t cap);        // >0 байт, 0 = поки нічого, <0 = помилка
+ *   void dnsClose();                               // новий сокет (і порт) на кожен запит
+ *
+ * Header портабельний (без Arduino.h) — перевіряється на хості (test/test_dns_cache).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "pb_hb_body.h"
+#include "pb_hb_latency.h"
+
+// RFC 1035: відповідь по UDP — до 512 байт.
+static const size_t kPbDnsMsgMax = 512;
+
+// "a.b.c.d" -> адреса в network byte order (як sin_addr.s_addr); false — не IPv4-літерал.
+inline bool pbParseIpv4(const char *s, uint32_t &addr) {
+    uint8_t b[4];
+    for (int i = 0; i < 4; i++) {
+        if (*s < '0' || *s > '9') {
+            return false;
+        }
+        uint32_t v = 0;
+        for (int d = 0; *s >= '0' && *s <= '9'; d++, s++) {
+            v = v * 10 + static_cast<uint32_t>(*s - '0');
+            if (d == 3 || v > 255) {
+                return false;
+            }
+        }
+        b[i] = static_cast<uint8_t>(v);
+        if (i < 3 && *s++ != '.') {
+            return false;
+        }
+    }
+    if (*s != '\0') {
+        return false;
+    }
+    memcpy(&addr, b, 4);
+    return true;
+}
+
+// A-запит (recursion desired) на host. Повертає довжину або 0 (ім'я некоректне / не влазить).
+inline size_t pbDnsBuildQuery(uint8_t *out, size_t cap, uint16_t id, const char *host) {
+    const size_t hostLen = strlen(host);
+    if (hostLen == 0 || hostLen > 253 || cap < 12 + hostLen + 2 + 4) {
+        return 0;
+    }
+    const uint8_t head[12] = {static_cast<uint8_t>(id >> 8), static_cast<uint8_t>(id), 0x01, 0x00,
+                              0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    memcpy(out, head, sizeof(head));
+    size_t at = sizeof(head);
+    const char *label = host;
+    for (;;) {
+        const char *dot = strchr(label, '.');
+        const size_t n = dot != nullptr ? static_cast<size_t>(dot - label) : strlen(label);
+        if (n == 0 || n > 63) {
+            return 0;
+        }
+        out[at++] = static_cast<uint8_t>(n);
+        memcpy(out + at, label, n);
+        at += n;
+        if (dot == nullptr) {
+            break;
+        }
+        label = dot + 1;
+    }
+    const uint8_t tail[5] = {0x00, 0x00, 0x01, 0x00, 0x01};   // корінь, QTYPE A, QCLASS IN
+    memcpy(out + at, tail, sizeof(tail));
+    return at + sizeof(tail);
+}
+
+enum class PbDnsParse : uint8_t {
+    Ok,
+    Foreign,     // не відповідь на наш запит (інший id / ім'я) — ігноруємо
+    Failed,      // NXDOMAIN / SERVFAIL / без A-запису
+    Malformed,
+};
+
+inline char pbDnsLower(char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; }
+
+// Пропустити ім'я (з компресією); false — виходить за межі повідомлення.
+inline bool pbDnsSkipName(const uint8_t *msg, size_t len, size_t &at) {
+    while (at < len) {
+        const uint8_t n = msg[at];
+        if (n == 0) {
+            at++;
+            return true;
+        }
+        if ((n & 0xC0) == 0xC0) {
+            at += 2;
+            return at <= len;
+        }
+        if ((n & 0xC0) != 0) {
+            return false;
+        }
+        at += 1 + n;
+    }
+    return false;
+}
+
+// Ім'я в питанні (без компресії, як у нашому запиті) == host без урахування регістру.
+inline bool pbDnsQuestionIs(const uint8_t *msg, size_t len, size_t &at, const char *host) {
+    const char *h = host;
+    while (at < len) {
+        const uint8_t n = msg[at++];
+        if (n == 0) {
+            return *h == '\0';
+        }
+        if (n > 63 || at + n > len) {
+            return false;
+        }
+        if (h != host) {
+            if (*h++ != '.') {
+                return false;
+            }
+        }
+        for (uint8_t i = 0; i < n; i++) {
+            if (*h == '\0' || pbDnsLower(*h++) != pbDnsLower(static_cast<char>(msg[at + i]))) {
+                return false;
+            }
+        }
+        at += n;
+    }
+    return false;
+}
+
+inline uint16_t pbDnsU16(const uint8_t *p) { return static_cast<uint16_t>((p[0] << 8) | p[1]); }
+inline uint32_t pbDnsU32(const uint8_t *p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+// Відповідь на pbDnsBuildQuery(id, host): перший A-запис і найменший TTL по ланцюжку
+// (CNAME -> A) — адреса не живе довше за будь-яку ланку.
+inline PbDnsParse pbDnsParseResponse(const uint8_t *msg, size_t len, uint16_t id, const char *host,
+                                     uint32_t &addr, uint32_t &ttlS) {
+    if (len < 12) {
+        return PbDnsParse::Malformed;
+    }
+    if (pbDnsU16(msg) != id || (msg[2] & 0x80) == 0 || pbDnsU16(msg + 4) != 1) {
+        return PbDnsParse::Foreign;
+    }
+    size_t at = 12;
+    if (!pbDnsQuestionIs(msg, len, at, host) || at + 4 > len) {
+        return PbDnsParse::Foreign;
+    }
+    if (pbDnsU16(msg + at) != 1 || pbDnsU16(msg + at + 2) != 1) {
+        return PbDnsParse::Foreign;
+    }
+    at += 4;
+    if ((msg[3] & 0x0F) != 0) {
+        return PbDnsParse::Failed;
+    }
+    uint32_t minTtl = UINT32_MAX;
+    const uint16_t answers = pbDnsU16(msg + 6);
+    for (uint16_t i = 0; i < answers; i++) {
+        if (!pbDnsSkipName(msg, len, at) || at + 10 > len) {
+            return PbDnsParse::Malformed;
+        }
+        const uint16_t type = pbDnsU16(msg + at);
+        const uint16_t cls = pbDnsU16(msg + at + 2);
+        // TTL зі старшим бітом (RFC 2181: > 2^31-1) вважаємо нулем.
+        uint32_t ttl = pbDnsU32(msg + at + 4);
+        ttl = ttl > 0x7FFFFFFFu ? 0 : ttl;
+        const uint16_t rdLen = pbDnsU16(msg + at + 8);
+        at += 10;
+        if (at + rdLen > len) {
+            return PbDnsParse::Malformed;
+        }
+        if (cls == 1 && (type == 1 || type == 5)) {
+            minTtl = ttl < minTtl ? ttl : minTtl;
+        }
+        if (cls == 1 && type == 1 && rdLen == 4) {
+            memcpy(&addr, msg + at, 4);
+            ttlS = minTtl;
+            return PbDnsParse::Ok;
+        }
+        at += rdLen;
+    }
+    return PbDnsParse::Failed;
+}
+
+struct PbDnsConfig {
+    uint32_t ttlMinS;      // TTL з відповіді обрізається до [ttlMinS, ttlMaxS]
+    uint32_t ttlMaxS;
+    uint32_t timeoutMs;    // на одну спробу
+    uint32_t retryMinMs;   // пауза після невдачі; далі вдвічі, до retryMaxMs
+    uint32_t retryMaxMs;
+};
+
+enum class PbDnsEvent : uint8_t {
+    None,
+    Resolved,   // відповідь, адреса та сама
+    Changed,    // нова адреса (зберегти в NVS)
+    Failed,     // лишається остання відома адреса (якщо є)
+};
+
+template <class Net>
+class PbDnsResolver {
+public:
+    PbDnsResolver(Net &net, const char *host, const PbDnsConfig &cfg)
+        : net_(net), host_(host), cfg_(cfg), retryMs_(cfg.retryMinMs) {}
+
+    // Last-known-good з NVS: віддається одразу, але вважається простроченою.
+    void seed(uint32_t addr, uint32_t nowMs) {
+        addr_ = addr;
+        has_ = true;
+        seeded_ = true;
+        dueMs_ = nowMs;
+    }
+
+    bool has() const { return has_; }
+    uint32_t addr() const { return addr_; }
+    bool seeded() const { return seeded_; }   // адреса досі з NVS, DNS ще не відповів
+    bool inFlight() const { return inFlight_; }
+    // TTL минув — адреса віддається далі, оновлення вже в черзі.
+    bool stale(uint32_t nowMs) const { return !has_ || reached(nowMs, expiresMs_) || seeded_; }
+    uint32_t ttlS() const { return ttlS_; }
+    uint32_t retryMs() const { return retryMs_; }
+    uint32_t dueMs() const { return dueMs_; }   // millis() наступного запиту
+    uint32_t lastUs() const { return lastUs_; }   // тривалість останньої спроби
+
+    // Адреса потрібна зараз: її немає — запит одразу (без паузи після невдач); є, але connect
+    // на неї не вдався — одразу, якщо DNS не в паузі після невдачі.
+    void kick(uint32_t nowMs) {
+        if (!inFlight_ && (!has_ || failStreak_ == 0)) {
+            dueMs_ = nowMs;
+        }
+    }
+
+    // Один крок; ніколи не блокує. linkUp = false — нових запитів не починаємо.
+    PbDnsEvent poll(uint32_t nowMs, uint32_t nowUs, bool linkUp) {
+        if (!inFlight_) {
+            if (!linkUp || !reached(nowMs, dueMs_)) {
+                return PbDnsEvent::None;
+            }
+            id_ = static_cast<uint16_t>(nowUs ^ (nowUs >> 16) ^ (++queries_ * 0x9E37u));
+            const size_t len = pbDnsBuildQuery(msg_, sizeof(msg_), id_, host_);
+            const long n = len == 0 ? -1 : net_.dnsSend(msg_, len);
+            if (n == 0) {
+                return PbDnsEvent::None;   // сокет зайнятий — наступного проходу
+            }
+            startMs_ = nowMs;
+            startUs_ = nowUs;
+            if (n < 0) {
+                return failed(nowMs, nowUs);
+            }
+            inFlight_ = true;
+            return PbDnsEvent::None;
+        }
+        for (;;) {
+            const long n = net_.dnsRecv(msg_, sizeof(msg_));
+            if (n < 0) {
+                return failed(nowMs, nowUs);
+            }
+            if (n == 0) {
+                break;
+            }
+            uint32_t addr = 0;
+            uint32_t ttl = 0;
+            const PbDnsParse r = pbDnsParseResponse(msg_, static_cast<size_t>(n), id_, host_, addr, ttl);
+            if (r == PbDnsParse::Ok) {
+                return resolved(nowMs, nowUs, addr, ttl);
+            }
+            if (r != PbDnsParse::Foreign) {
+                return failed(nowMs, nowUs);
+            }
+        }
+        if (static_cast<uint32_t>(nowMs - startMs_) > cfg_.timeoutMs) {
+            return failed(nowMs, nowUs);
+        }
+        return PbDnsEvent::None;
+    }
+
+    // Відповіді (мкс) і невдачі з останнього clearStats() — для "hb_dns".
+    const PbLatencyHist &latency() const { return lat_; }
+    uint32_t fails() const { return fails_; }
+    void clearStats() {
+        lat_.clear();
+        fails_ = 0;
+    }
+
+private:
+    static bool reached(uint32_t nowMs, uint32_t atMs) { return static_cast<int32_t>(nowMs - atMs) >= 0; }
+
+    PbDnsEvent resolved(uint32_t nowMs, uint32_t nowUs, uint32_t addr, uint32_t ttlS) {
+        net_.dnsClose();
+        inFlight_ = false;
+        lastUs_ = nowUs - startUs_;
+        lat_.add(lastUs_);
+        ttlS_ = ttlS < cfg_.ttlMinS ? cfg_.ttlMinS : (ttlS > cfg_.ttlMaxS ? cfg_.ttlMaxS : ttlS);
+        expiresMs_ = nowMs + ttlS_ * 1000u;
+        dueMs_ = expiresMs_;
+        retryMs_ = cfg_.retryMinMs;
+        failStreak_ = 0;
+        const bool changed = !has_ || addr != addr_;
+        addr_ = addr;
+        has_ = true;
+        seeded_ = false;
+        return changed ? PbDnsEvent::Changed : PbDnsEvent::Resolved;
+    }
+
+    PbDnsEvent failed(uint32_t nowMs, uint32_t nowUs) {
+        net_.dnsClose();
+        inFlight_ = false;
+        lastUs_ = nowUs - startUs_;
+        fails_++;
+        failStreak_++;
+        dueMs_ = nowMs + retryMs_;
+        retryMs_ = retryMs_ * 2 < cfg_.retryMaxMs ? retryMs_ * 2 : cfg_.retryMaxMs;
+        return PbDnsEvent::Failed;
+    }
+
+    Net &net_;
+    const char *host_;
+    PbDnsConfig cfg_;
+
+    bool has_ = false;
+    bool seeded_ = false;
+    bool inFlight_ = false;
+    uint32_t addr_ = 0;
+    uint32_t ttlS_ = 0;
+    uint32_t expiresMs_ = 0;
+    uint32_t dueMs_ = 0;
+    uint32_t retryMs_;
+    uint32_t failStreak_ = 0;
+
+    uint16_t id_ = 0;
+    uint32_t queries_ = 0;
+    uint32_t startMs_ = 0;
+    uint32_t startUs_ = 0;
+    uint32_t lastUs_ = 0;
+    uint8_t msg_[kPbDnsMsgMax];
+
+    PbLatencyHist lat_;
+    uint32_t fails_ = 0;
+};
+
+// JSON-шаблон: [p50,p95,max відповіді DNS (мкс), невдалі запити].
+#define PB_HB_DNS_JSON "[" PB_SLOT_U32 "," PB_SLOT_U32 "," PB_SLOT_U32 "," PB_SLOT_U32 "]"
+
+template <class Net>
+inline void pbDnsStatsPut(char *arr, size_t len, const PbDnsResolver<Net> &r) {
+    const size_t w = sizeof(PB_SLOT_U32) - 1;
+    if (len < 1 + 4 * (w + 1)) {
+        return;
+    }
+    const PbLatencyHist &h = r.latency();
+    pbSlotPutUint(arr + 1, w, h.percentile(50));
+    pbSlotPutUint(arr + 1 + (w + 1), w, h.percentile(95));
+    pbSlotPutUint(arr + 1 + 2 * (w + 1), w, h.max());
+    pbSlotPutUint(arr + 1 + 3 * (w + 1), w, r.fails());
+}
@@ -0,0 +1,98 @@
+/*
+ * PowerBot: heartbeat JSON, зібраний на етапі компіляції.
+ *
+ * Усе статичне (API_KEY, BUILDING_ID, SECTION_ID, SENSOR_UUID, SENSOR_COMMENT, HTTP-заголовки)
+ * — це #define з config.h, тож запит склеюється з рядкових літералів в один const-буфер у flash.
+ * Динамічні поля (event, seq, uptime, ...) — слоти фіксованої ширини з пробілів: пробіл —
+ * валідний JSON whitespace, тож число/рядок вписується в слот без зсуву решти буфера
+ * ("seq":        42). На beat — memcpy шаблону + кілька записів у слоти, без heap.
+ *
+ * PbHeapWatch — облік heap між beat-ами (доказ, що beat нічого не алокує і не тече).
+ *
+ * Header портабельний (без Arduino.h) — перевіряється на хості (test/test_hb_body).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define PB_STR_(x) #x
+#define PB_STR(x) PB_STR_(x)
+// Список через кому (PB_INPUT_SECTIONS) — одним літералом.
+#define PB_STRV_(...) #__VA_ARGS__
+#define PB_STRV(...) PB_STRV_(__VA_ARGS__)
+
+// Слоти під динамічні поля (ширина = довжина літерала).
+#define PB_SLOT_U32 "          "      // 10 символів: будь-який uint32_t
+#define PB_SLOT_EVENT "            "  // 12 символів: "power_lost" у лапках
+
+// Літерал можна вставити в JSON-рядок як є (без екранування).
+constexpr bool pbJsonLiteralSafe(const char *s) {
+    return *s == '\0' ||
+           (*s != '"' && *s != '\\' && static_cast<unsigned char>(*s) >= 0x20 && pbJsonLiteralSafe(s + 1));
+}
+
+// Число праворуч у слоті, зліва пробіли. false — не влазить (слот не змінено).
+inline bool pbSlotPutUint(char *slot, size_t width, uint32_t v) {
+    char digits[10];
+    size_t n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    if (n > width) {
+        return false;
+    }
+    memset(slot, ' ', width - n);
+    for (size_t i = 0; i < n; i++) {
+        slot[width - 1 - i] = digits[i];
+    }
+    return true;
+}
+
+// Рядок у лапках зліва в слоті, справа пробіли. s має бути pbJsonLiteralSafe. false — не влазить.
+inline bool pbSlotPutStr(char *slot, size_t width, const char *s) {
+    const size_t n = strlen(s);
+    if (n + 2 > width) {
+        return false;
+    }
+    slot[0] = '"';
+    memcpy(slot + 1, s, n);
+    slot[n + 1] = '"';
+    memset(slot + n + 2, ' ', width - n - 2);
+    return true;
+}
+
+// Вільний heap після кожного beat (у стані спокою): baseline — після першого beat,
+// dropBeats — скільки beat-ів закінчились з меншим вільним heap, ніж будь-коли до того.
+class PbHeapWatch {
+public:
+    void sample(uint32_t freeBytes) {
+        if (samples_ == 0) {
+            baseline_ = freeBytes;
+            low_ = freeBytes;
+        } else if (freeBytes < low_) {
+            low_ = freeBytes;
+            dropBeats_++;
+        }
+        last_ = freeBytes;
+        samples_++;
+    }
+
+    uint32_t samples() const { return samples_; }
+    uint32_t baseline() const { return baseline_; }
+    uint32_t last() const { return last_; }
+    uint32_t low() const { return low_; }
+    uint32_t dropBeats() const { return dropBeats_; }
+    // На скільки байт вільний heap зараз нижчий за baseline (0 — не нижчий).
+    uint32_t drift() const { return last_ < baseline_ ? baseline_ - last_ : 0; }
+
+private:
+    uint32_t samples_ = 0;
+    uint32_t baseline_ = 0;
+    uint32_t last_ = 0;
+    uint32_t low_ = 0;
+    uint32_t dropBeats_ = 0;
+};
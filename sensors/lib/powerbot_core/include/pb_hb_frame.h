@@ -0,0 +1,278 @@
+/*
+ * PowerBot: компактний бінарний heartbeat (PB_HB_FRAME=1) замість JSON з api_key.
+ *
+ * Layout (little-endian, 36 байт) — той самий, що й src/sensor_frame.py на сервері:
+ *   0   "PB"        magic
+ *   2   u8          version (PB_FRAME_VERSION)
+ *   3   u8          event (PbFrameEvent)
+ *   4   u16         building_id
+ *   6   u16         section_id
+ *   8   8 байт      SHA-256(sensor_uuid)[:8]
+ *   16  u32         seq
+ *   20  u32         uptime, секунди
+ *   24  u32         boot_count — лічильник завантажень з NVS
+ *   28  8 байт      HMAC-SHA256(API_KEY, bytes[0:28])[:8]
+ *
+ * API_KEY у мережу не йде. Підпис не містить часу, тож перехоплений frame валідний завжди:
+ * приймач бере лише frame, новіший за останній прийнятий за (boot_count, seq) — boot_count
+ * живе в NVS і не зменшується, тож frame (і boot) з минулих епох відкидається.
+ *
+ * HMAC рахується з midstate: ipad/opad блоки ключа проганяються через SHA-256 один раз
+ * (PbHmacKey), на кожен beat — лише дві компресії SHA-256.
+ *
+ * Header портабельний (без Arduino.h) — перевіряється на хості (test/test_hb_frame)
+ * тими ж тест-векторами, що й сервер (test/heartbeat_frame_vectors.txt).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define PB_FRAME_SIZE 36
+#define PB_FRAME_SIGNED_SIZE 28
+#define PB_FRAME_TAG_SIZE 8
+#define PB_FRAME_UUID_HASH_SIZE 8
+#define PB_FRAME_VERSION 2
+
+// Код event у frame (порядок = SENSOR_FRAME_EVENTS на сервері).
+enum class PbFrameEvent : uint8_t {
+    Heartbeat = 0,
+    Boot = 1,
+    PowerLost = 2,
+};
+
+// Мінімальний SHA-256 (FIPS 180-4) — без mbedtls, щоб той самий код перевірявся на хості.
+class PbSha256 {
+public:
+    static const size_t kBlockSize = 64;
+    static const size_t kDigestSize = 32;
+
+    PbSha256() { init(); }
+
+    void init() {
+        static const uint32_t kInit[8] = {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+            0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+        };
+        memcpy(h_, kInit, sizeof(h_));
+        total_ = 0;
+        used_ = 0;
+    }
+
+    void update(const uint8_t *data, size_t len) {
+        total_ += len;
+        while (len > 0) {
+            size_t take = kBlockSize - used_;
+            if (take > len) {
+                take = len;
+            }
+            memcpy(block_ + used_, data, take);
+            used_ += take;
+            data += take;
+            len -= take;
+            if (used_ == kBlockSize) {
+                compress(block_);
+                used_ = 0;
+            }
+        }
+    }
+
+    void finish(uint8_t out[kDigestSize]) {
+        const uint64_t bits = total_ * 8u;
+        const uint8_t pad = 0x80;
+        const uint8_t zero = 0;
+        update(&pad, 1);
+        while (used_ != kBlockSize - 8) {
+            update(&zero, 1);
+        }
+        uint8_t lenBytes[8];
+        for (int i = 0; i < 8; i++) {
+            lenBytes[i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+        }
+        update(lenBytes, sizeof(lenBytes));
+        for (int i = 0; i < 8; i++) {
+            out[4 * i] = static_cast<uint8_t>(h_[i] >> 24);
+            out[4 * i + 1] = static_cast<uint8_t>(h_[i] >> 16);
+            out[4 * i + 2] = static_cast<uint8_t>(h_[i] >> 8);
+            out[4 * i + 3] = static_cast<uint8_t>(h_[i]);
+        }
+    }
+
+private:
+    static uint32_t rotr(uint32_t x, unsigned n) { return (x >> n) | (x << (32 - n)); }
+
+    void compress(const uint8_t *p) {
+        static const uint32_t k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+        };
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (static_cast<uint32_t>(p[4 * i]) << 24) | (static_cast<uint32_t>(p[4 * i + 1]) << 16) |
+                   (static_cast<uint32_t>(p[4 * i + 2]) << 8) | static_cast<uint32_t>(p[4 * i + 3]);
+        }
+        for (int i = 16; i < 64; i++) {
+            const uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            const uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = h_[0], b = h_[1], c = h_[2], d = h_[3], e = h_[4], f = h_[5], g = h_[6], h = h_[7];
+        for (int i = 0; i < 64; i++) {
+            const uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            const uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        h_[0] += a;
+        h_[1] += b;
+        h_[2] += c;
+        h_[3] += d;
+        h_[4] += e;
+        h_[5] += f;
+        h_[6] += g;
+        h_[7] += h;
+    }
+
+    uint32_t h_[8];
+    uint8_t block_[kBlockSize];
+    uint64_t total_;
+    size_t used_;
+};
+
+// HMAC-SHA256 з попередньо обчисленим midstate ключа (ключ після конструктора не потрібен).
+class PbHmacKey {
+public:
+    PbHmacKey(const uint8_t *key, size_t keyLen) {
+        uint8_t k[PbSha256::kBlockSize] = {0};
+        if (keyLen > PbSha256::kBlockSize) {
+            PbSha256 kh;
+            kh.update(key, keyLen);
+            kh.finish(k);
+        } else {
+            memcpy(k, key, keyLen);
+        }
+        uint8_t pad[PbSha256::kBlockSize];
+        for (size_t i = 0; i < sizeof(pad); i++) {
+            pad[i] = k[i] ^ 0x36;
+        }
+        inner_.update(pad, sizeof(pad));
+        for (size_t i = 0; i < sizeof(pad); i++) {
+            pad[i] = k[i] ^ 0x5c;
+        }
+        outer_.update(pad, sizeof(pad));
+    }
+
+    void mac(const uint8_t *msg, size_t len, uint8_t out[PbSha256::kDigestSize]) const {
+        uint8_t innerDigest[PbSha256::kDigestSize];
+        PbSha256 innerCtx = inner_;
+        innerCtx.update(msg, len);
+        innerCtx.finish(innerDigest);
+        PbSha256 outerCtx = outer_;
+        outerCtx.update(innerDigest, sizeof(innerDigest));
+        outerCtx.finish(out);
+    }
+
+private:
+    PbSha256 inner_;
+    PbSha256 outer_;
+};
+
+// Короткий ідентифікатор сенсора у frame; рахується один раз при старті.
+inline void pbFrameUuidHash(const char *uuid, uint8_t out[PB_FRAME_UUID_HASH_SIZE]) {
+    uint8_t digest[PbSha256::kDigestSize];
+    PbSha256 h;
+    h.update(reinterpret_cast<const uint8_t *>(uuid), strlen(uuid));
+    h.finish(digest);
+    memcpy(out, digest, PB_FRAME_UUID_HASH_SIZE);
+}
+
+inline void pbFramePutU16(uint8_t *p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+inline void pbFramePutU32(uint8_t *p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+    p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+// Зібрати підписаний frame (рівно PB_FRAME_SIZE байт в out).
+inline void pbFrameEncode(uint8_t out[PB_FRAME_SIZE], const PbHmacKey &key, PbFrameEvent event,
+                          uint16_t buildingId, uint16_t sectionId,
+                          const uint8_t uuidHash[PB_FRAME_UUID_HASH_SIZE], uint32_t seq, uint32_t uptimeS,
+                          uint32_t bootCount) {
+    out[0] = 'P';
+    out[1] = 'B';
+    out[2] = PB_FRAME_VERSION;
+    out[3] = static_cast<uint8_t>(event);
+    pbFramePutU16(out + 4, buildingId);
+    pbFramePutU16(out + 6, sectionId);
+    memcpy(out + 8, uuidHash, PB_FRAME_UUID_HASH_SIZE);
+    pbFramePutU32(out + 16, seq);
+    pbFramePutU32(out + 20, uptimeS);
+    pbFramePutU32(out + 24, bootCount);
+    uint8_t tag[PbSha256::kDigestSize];
+    key.mac(out, PB_FRAME_SIGNED_SIZE, tag);
+    memcpy(out + PB_FRAME_SIGNED_SIZE, tag, PB_FRAME_TAG_SIZE);
+}
+
+inline uint16_t pbFrameGetU16(const uint8_t *p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline uint32_t pbFrameGetU32(const uint8_t *p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Поля перевіреного frame (агрегатор будинку приймає frame-и сусідів).
+struct PbFrame {
+    PbFrameEvent event;
+    uint16_t buildingId;
+    uint16_t sectionId;
+    uint8_t uuidHash[PB_FRAME_UUID_HASH_SIZE];
+    uint32_t seq;
+    uint32_t uptimeS;
+    uint32_t bootCount;
+};
+
+// Розібрати frame і перевірити підпис. false — не frame, чужа версія / event або підпис не той.
+inline bool pbFrameDecode(const uint8_t *in, size_t len, const PbHmacKey &key, PbFrame *out) {
+    if (len != PB_FRAME_SIZE || in[0] != 'P' || in[1] != 'B' || in[2] != PB_FRAME_VERSION ||
+        in[3] > static_cast<uint8_t>(PbFrameEvent::PowerLost)) {
+        return false;
+    }
+    uint8_t tag[PbSha256::kDigestSize];
+    key.mac(in, PB_FRAME_SIGNED_SIZE, tag);
+    uint8_t diff = 0;   // без раннього виходу: час перевірки не залежить від того, де розбіжність
+    for (size_t i = 0; i < PB_FRAME_TAG_SIZE; i++) {
+        diff = static_cast<uint8_t>(diff | (tag[i] ^ in[PB_FRAME_SIGNED_SIZE + i]));
+    }
+    if (diff != 0) {
+        return false;
+    }
+    out->event = static_cast<PbFrameEvent>(in[3]);
+    out->buildingId = pbFrameGetU16(in + 4);
+    out->sectionId = pbFrameGetU16(in + 6);
+    memcpy(out->uuidHash, in + 8, PB_FRAME_UUID_HASH_SIZE);
+    out->seq = pbFrameGetU32(in + 16);
+    out->uptimeS = pbFrameGetU32(in + 20);
+    out->bootCount = pbFrameGetU32(in + 24);
+    return true;
+}
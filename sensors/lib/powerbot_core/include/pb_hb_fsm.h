@@ -0,0 +1,404 @@
+/*
+ * PowerBot: покроковий (non-blocking) heartbeat HTTP-обмін.
+ *
+ * loop() викликає step(millis()) — кожен виклик лише "підштовхує" запит на один
+ * крок і одразу повертається, тож link monitoring / LED / вимірювання працюють,
+ * поки запит у польоті.
+ *
+ *   Idle -> Resolve -> Connect -> Write -> AwaitStatus -> Headers -> Body -> Done
+ *                                                                    \-> Failed
+ *
+ * Header портабельний (без Arduino.h): мережу дає шаблонний параметр Net, тож
+ * машину можна ганяти на хості з fake-клієнтом (test/test_hb_fsm).
+ *
+ * start()/step() приймають ще й мікросекунди (micros()): на межах фаз машина ставить
+ * мітки і після завершення віддає timings() для PbHbLatency (pb_hb_latency.h).
+ *
+ * Відповідь розбирає PbHttpResponse (pb_http_resp.h) прямо з 64-байтного шматка на стеку.
+ *
+ * Net має надати non-blocking операції:
+ *   bool isOpen();                      // сокет відкритий і peer його не закрив
+ *   int  startResolve(const char *host);// PB_NET_OK / PB_NET_PENDING / PB_NET_FAIL
+ *   int  pollResolve();
+ *   int  startConnect(uint16_t port);   // до адреси з resolve
+ *   int  pollConnect();
+ *   long write(const uint8_t *data, size_t len); // >0 прийнято, 0 = буфер зайнятий, <0 = помилка
+ *   long read(uint8_t *buf, size_t cap);         // >0 байт, 0 = поки нічого, <0 = peer закрив/помилка
+ *   void close();
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "pb_hb_latency.h"
+#include "pb_http_resp.h"
+
+enum PbNetPoll {
+    PB_NET_FAIL = -1,
+    PB_NET_PENDING = 0,
+    PB_NET_OK = 1,
+};
+
+enum class PbHbState : uint8_t {
+    Idle,
+    Resolve,
+    Connect,
+    Write,
+    AwaitStatus,
+    Headers,
+    Body,
+    Done,
+    Failed,
+};
+
+enum class PbHbError : uint8_t {
+    None,
+    ResolveFailed,
+    ResolveTimeout,
+    ConnectFailed,
+    ConnectTimeout,
+    WriteFailed,
+    WriteTimeout,
+    StatusTimeout,   // немає (повного) status line / заголовків за ioTimeoutMs
+    Closed,          // peer закрив сокет до кінця заголовків
+    BadStatusLine,
+    BadResponse,     // зіпсований Content-Length / інструкція сервера
+};
+
+inline const char *pbHbStateName(PbHbState s) {
+    switch (s) {
+        case PbHbState::Idle:        return "idle";
+        case PbHbState::Resolve:     return "resolve";
+        case PbHbState::Connect:     return "connect";
+        case PbHbState::Write:       return "write";
+        case PbHbState::AwaitStatus: return "await_status";
+        case PbHbState::Headers:     return "headers";
+        case PbHbState::Body:        return "body";
+        case PbHbState::Done:        return "done";
+        case PbHbState::Failed:      return "failed";
+    }
+    return "?";
+}
+
+// Фаза латентності, у якій перебуває стан (для фейлів: на чому beat упав).
+inline PbHbPhase pbHbPhaseOf(PbHbState s) {
+    switch (s) {
+        case PbHbState::Resolve:     return PbHbPhase::Dns;
+        case PbHbState::Connect:     return PbHbPhase::Connect;
+        case PbHbState::Write:       return PbHbPhase::Write;
+        case PbHbState::AwaitStatus: return PbHbPhase::Ttfb;
+        case PbHbState::Headers:
+        case PbHbState::Body:        return PbHbPhase::Response;
+        default:                     return PbHbPhase::None;
+    }
+}
+
+struct PbHbConfig {
+    const char *host;
+    uint16_t port;
+    uint32_t resolveTimeoutMs;
+    uint32_t connectTimeoutMs;
+    uint32_t ioTimeoutMs;   // окремо на write, на status+headers і на body
+    bool keepAlive;
+};
+
+template <class Net, size_t kRequestCap = 1024, size_t kLineCap = 128, size_t kBodyCap = 160>
+class PbHbMachine {
+public:
+    PbHbMachine(Net &net, const PbHbConfig &cfg) : net_(net), cfg_(cfg) {}
+
+    // Буфер під повний HTTP-запит (head + body); caller заповнює його і викликає start().
+    char *requestBuffer() { return request_; }
+    static constexpr size_t requestCapacity() { return kRequestCap; }
+
+    // false — машина ще зайнята або len не влазить у буфер.
+    bool start(size_t len, uint32_t now) { return start(len, now, now * 1000u); }
+    bool start(size_t len, uint32_t now, uint32_t nowUs) {
+        if (busy() || len == 0 || len > kRequestCap) {
+            return false;
+        }
+        nowUs_ = nowUs;
+        markUs_ = nowUs;
+        timings_.clear();
+        requestLen_ = len;
+        error_ = PbHbError::None;
+        reused_ = false;
+        retried_ = false;
+        respBytes_ = 0;
+        resp_.reset();
+
+        if (cfg_.keepAlive && net_.isOpen()) {
+            reused_ = true;
+            connReused_++;
+            enterWrite(now);
+        } else {
+            net_.close();
+            enter(PbHbState::Resolve, now);
+            resolveStarted_ = false;
+        }
+        return true;
+    }
+
+    // Один крок; ніколи не блокує. Повертає поточний стан.
+    PbHbState step(uint32_t now) { return step(now, now * 1000u); }
+    PbHbState step(uint32_t now, uint32_t nowUs) {
+        nowUs_ = nowUs;
+        switch (state_) {
+            case PbHbState::Resolve:     stepResolve(now); break;
+            case PbHbState::Connect:     stepConnect(now); break;
+            case PbHbState::Write:       stepWrite(now); break;
+            case PbHbState::AwaitStatus:
+            case PbHbState::Headers:
+            case PbHbState::Body:        stepRead(now); break;
+            default: break;
+        }
+        return state_;
+    }
+
+    // Перервати запит (наприклад, link down) і закрити сокет.
+    void abort() {
+        if (busy()) {
+            net_.close();
+            state_ = PbHbState::Idle;
+        }
+    }
+
+    // Забрати результат: Done/Failed -> Idle (keep-alive сокет лишається відкритим).
+    void reset() {
+        if (finished()) {
+            state_ = PbHbState::Idle;
+        }
+    }
+
+    PbHbState state() const { return state_; }
+    bool busy() const { return state_ != PbHbState::Idle && !finished(); }
+    bool finished() const { return state_ == PbHbState::Done || state_ == PbHbState::Failed; }
+    bool ok() const { return state_ == PbHbState::Done && resp_.status() == 200; }
+    int httpStatus() const { return resp_.status(); }
+    PbHbError error() const { return error_; }
+    bool reused() const { return reused_; }
+    // true — перевикористаний сокет виявився закритим сервером, запит повторено на новому.
+    bool retried() const { return retried_; }
+    const char *statusLine() const { return resp_.statusLine(); }
+    const char *body() const { return resp_.body(); }   // обрізаний до kBodyCap-1 (для логів)
+    // Інструкція сервера X-PB-Interval-Ms з останньої відповіді (0 — не було).
+    uint32_t intervalMs() const { return resp_.intervalMs(); }
+
+    // З моменту завантаження: нові TCP-з'єднання vs перевикористані keep-alive.
+    uint32_t connNew() const { return connNew_; }
+    uint32_t connReused() const { return connReused_; }
+
+    // Тривалості фаз останнього beat (мкс); дійсні після finished().
+    const PbHbTimings &timings() const { return timings_; }
+
+private:
+    void enter(PbHbState s, uint32_t now) {
+        // Resolve -> Connect -> Write -> AwaitStatus: закрита фаза = попередній стан.
+        if (s > state_ && state_ >= PbHbState::Resolve && state_ <= PbHbState::Write) {
+            timings_.set(pbHbPhaseOf(state_), nowUs_ - markUs_);
+        }
+        if (s == PbHbState::AwaitStatus) {
+            writtenUs_ = nowUs_;
+        }
+        markUs_ = nowUs_;
+        state_ = s;
+        phaseStart_ = now;
+    }
+
+    void enterWrite(uint32_t now) {
+        written_ = 0;
+        enter(PbHbState::Write, now);
+    }
+
+    bool expired(uint32_t now, uint32_t timeoutMs) const {
+        return static_cast<uint32_t>(now - phaseStart_) > timeoutMs;
+    }
+
+    void fail(PbHbError err) {
+        net_.close();
+        error_ = err;
+        timings_.failedAt = pbHbPhaseOf(state_);
+        state_ = PbHbState::Failed;
+    }
+
+    // Перевикористаний сокет закрився ще до першого байта відповіді: сервер
+    // прибрав idle-з'єднання між beat-ами, запит безпечно повторити один раз.
+    bool retryStale(uint32_t now) {
+        if (!reused_ || retried_ || respBytes_ > 0) {
+            return false;
+        }
+        net_.close();
+        retried_ = true;
+        reused_ = false;
+        connReused_--;
+        // Час на мертвому сокеті — не латентність аплінку: міряємо з нового з'єднання.
+        timings_.clear();
+        enter(PbHbState::Resolve, now);
+        resolveStarted_ = false;
+        return true;
+    }
+
+    void stepResolve(uint32_t now) {
+        int r;
+        if (!resolveStarted_) {
+            resolveStarted_ = true;
+            r = net_.startResolve(cfg_.host);
+        } else {
+            r = net_.pollResolve();
+        }
+        if (r == PB_NET_OK) {
+            enter(PbHbState::Connect, now);
+            connectStarted_ = false;
+        } else if (r == PB_NET_FAIL) {
+            fail(PbHbError::ResolveFailed);
+        } else if (expired(now, cfg_.resolveTimeoutMs)) {
+            fail(PbHbError::ResolveTimeout);
+        }
+    }
+
+    void stepConnect(uint32_t now) {
+        int r;
+        if (!connectStarted_) {
+            connectStarted_ = true;
+            r = net_.startConnect(cfg_.port);
+        } else {
+            r = net_.pollConnect();
+        }
+        if (r == PB_NET_OK) {
+            connNew_++;
+            enterWrite(now);
+        } else if (r == PB_NET_FAIL) {
+            fail(PbHbError::ConnectFailed);
+        } else if (expired(now, cfg_.connectTimeoutMs)) {
+            fail(PbHbError::ConnectTimeout);
+        }
+    }
+
+    void stepWrite(uint32_t now) {
+        const long n = net_.write(reinterpret_cast<const uint8_t *>(request_) + written_,
+                                  requestLen_ - written_);
+        if (n < 0) {
+            if (!retryStale(now)) {
+                fail(PbHbError::WriteFailed);
+            }
+            return;
+        }
+        written_ += static_cast<size_t>(n);
+        if (written_ >= requestLen_) {
+            respBytes_ = 0;
+            resp_.reset();
+            serverClose_ = false;
+            enter(PbHbState::AwaitStatus, now);
+        } else if (expired(now, cfg_.ioTimeoutMs)) {
+            fail(PbHbError::WriteTimeout);
+        }
+    }
+
+    // AwaitStatus / Headers / Body: дочитуємо все, що вже є в сокеті, і виходимо.
+    // Дедлайн ioTimeoutMs окремо для status+headers (від кінця запису) і для body.
+    void stepRead(uint32_t now) {
+        uint8_t chunk[64];
+        for (;;) {
+            size_t want = sizeof(chunk);
+            if (state_ == PbHbState::Body && resp_.contentLength() >= 0) {
+                want = resp_.bodyLeft() < want ? resp_.bodyLeft() : want;
+            }
+            const long n = net_.read(chunk, want);
+            if (n < 0) {
+                if (state_ == PbHbState::Body) {
+                    // Peer закрив сокет: без Content-Length це і є кінець відповіді.
+                    resp_.eof();
+                    complete();
+                } else if (!retryStale(now)) {
+                    fail(PbHbError::Closed);
+                }
+                return;
+            }
+            if (n == 0) {
+                break;
+            }
+            if (respBytes_ == 0) {
+                timings_.set(PbHbPhase::Ttfb, nowUs_ - writtenUs_);
+            }
+            respBytes_ += static_cast<size_t>(n);
+            resp_.feed(reinterpret_cast<const char *>(chunk), static_cast<size_t>(n));
+            if (!follow(now)) {
+                return;
+            }
+        }
+        if (!expired(now, cfg_.ioTimeoutMs)) {
+            return;
+        }
+        if (state_ == PbHbState::Body) {
+            // Статус уже відомий — результат за ним, але недочитаний сокет не перевикористовуємо.
+            serverClose_ = true;
+            complete();
+        } else {
+            fail(PbHbError::StatusTimeout);
+        }
+    }
+
+    // Стан машини за станом парсера; false — відповідь завершена або зіпсована, далі не читаємо.
+    bool follow(uint32_t now) {
+        switch (resp_.state()) {
+            case PbHttpRespState::Status:
+                return true;
+            case PbHttpRespState::Bad:
+                fail(resp_.status() > 0 ? PbHbError::BadResponse : PbHbError::BadStatusLine);
+                return false;
+            case PbHttpRespState::Done:
+                complete();
+                return false;
+            case PbHttpRespState::Headers:
+                state_ = PbHbState::Headers;
+                return true;
+            case PbHttpRespState::Body:
+                if (state_ != PbHbState::Body) {
+                    enter(PbHbState::Body, now);
+                }
+                return true;
+        }
+        return true;
+    }
+
+    void complete() {
+        // Без Content-Length межу відповіді не визначити — з'єднання далі не використовуємо.
+        if (!cfg_.keepAlive || serverClose_ || resp_.serverClose() || resp_.contentLength() < 0 ||
+            resp_.status() != 200) {
+            net_.close();
+        }
+        timings_.set(PbHbPhase::Response, nowUs_ - writtenUs_);
+        state_ = PbHbState::Done;
+    }
+
+    Net &net_;
+    PbHbConfig cfg_;
+
+    PbHbState state_ = PbHbState::Idle;
+    PbHbError error_ = PbHbError::None;
+    uint32_t phaseStart_ = 0;
+    bool resolveStarted_ = false;
+    bool connectStarted_ = false;
+    bool reused_ = false;
+    bool retried_ = false;
+    bool serverClose_ = false;
+
+    char request_[kRequestCap];
+    size_t requestLen_ = 0;
+    size_t written_ = 0;
+
+    size_t respBytes_ = 0;
+
+    uint32_t nowUs_ = 0;
+    uint32_t markUs_ = 0;      // початок поточної фази
+    uint32_t writtenUs_ = 0;   // кінець запису: від нього TTFB і повна відповідь
+    PbHbTimings timings_ = {{0}, 0, PbHbPhase::None};
+
+    PbHttpResponse<kLineCap, kBodyCap> resp_;
+
+    uint32_t connNew_ = 0;
+    uint32_t connReused_ = 0;
+};
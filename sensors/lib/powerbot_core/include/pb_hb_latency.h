@@ -0,0 +1,196 @@
+/*
+ * PowerBot: латентність фаз heartbeat (DNS, connect, write, TTFB, повна відповідь).
+ *
+ * State machine (pb_hb_fsm.h / pb_udp_beat.h) ставить мікросекундні мітки на межах фаз
+ * і віддає PbHbTimings одного beat. PbHbLatency складає їх у гістограми з фіксованими
+ * log2-кошиками (16 x uint32_t на фазу, без heap) і рахує фейли по фазі, на якій beat упав.
+ *
+ * Вікно статистики = beat-и з моменту останнього доставленого підсумку: p50/p95/max і
+ * фейли їдуть у JSON наступного beat ("hb_lat"), після його успіху вікно починається заново.
+ *
+ * Header портабельний (без Arduino.h) — перевіряється на хості (test/test_hb_latency).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pb_hb_body.h"
+
+enum class PbHbPhase : uint8_t {
+    Dns,
+    Connect,
+    Write,
+    Ttfb,       // від кінця запису до першого байта відповіді
+    Response,   // від кінця запису до повної відповіді
+    None,
+};
+
+static const uint8_t kPbHbPhaseCount = 5;
+
+inline const char *pbHbPhaseName(PbHbPhase p) {
+    switch (p) {
+        case PbHbPhase::Dns:      return "dns";
+        case PbHbPhase::Connect:  return "connect";
+        case PbHbPhase::Write:    return "write";
+        case PbHbPhase::Ttfb:     return "ttfb";
+        case PbHbPhase::Response: return "response";
+        default:                  return "none";
+    }
+}
+
+// Один beat: тривалість кожної пройденої фази (мкс) і фаза, на якій він упав.
+// Фази, яких beat не проходив (keep-alive без DNS/connect), не позначені в measured.
+struct PbHbTimings {
+    uint32_t us[kPbHbPhaseCount];
+    uint8_t measured;
+    PbHbPhase failedAt;
+
+    void clear() {
+        for (uint8_t i = 0; i < kPbHbPhaseCount; i++) {
+            us[i] = 0;
+        }
+        measured = 0;
+        failedAt = PbHbPhase::None;
+    }
+    void set(PbHbPhase p, uint32_t v) {
+        us[static_cast<uint8_t>(p)] = v;
+        measured = static_cast<uint8_t>(measured | (1u << static_cast<uint8_t>(p)));
+    }
+    bool has(PbHbPhase p) const { return (measured & (1u << static_cast<uint8_t>(p))) != 0; }
+    uint32_t get(PbHbPhase p) const { return us[static_cast<uint8_t>(p)]; }
+};
+
+// Кошик 0: < 256 мкс; кошик i: [2^(i+7), 2^(i+8)) мкс; останній — усе від ~4.2 с.
+// Перцентиль — верхня межа кошика (не більше за max), тобто оцінка зверху з точністю x2.
+class PbLatencyHist {
+public:
+    static const uint8_t kBuckets = 16;
+
+    static uint8_t bucketOf(uint32_t us) {
+        uint8_t b = 0;
+        for (uint32_t v = us >> 8; v != 0 && b < kBuckets - 1; v >>= 1) {
+            b++;
+        }
+        return b;
+    }
+
+    void add(uint32_t us) {
+        buckets_[bucketOf(us)]++;
+        count_++;
+        if (us > max_) {
+            max_ = us;
+        }
+    }
+
+    uint32_t percentile(uint8_t pct) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        // Ранг ceil(count * pct / 100), щонайменше 1.
+        uint32_t rank = static_cast<uint32_t>((static_cast<uint64_t>(count_) * pct + 99) / 100);
+        if (rank == 0) {
+            rank = 1;
+        }
+        uint32_t seen = 0;
+        for (uint8_t b = 0; b < kBuckets; b++) {
+            seen += buckets_[b];
+            if (seen >= rank) {
+                const uint32_t upper = b + 1 < kBuckets ? (1u << (b + 8)) - 1 : max_;
+                return upper < max_ ? upper : max_;
+            }
+        }
+        return max_;
+    }
+
+    uint32_t count() const { return count_; }
+    uint32_t max() const { return max_; }
+    uint32_t bucket(uint8_t b) const { return b < kBuckets ? buckets_[b] : 0; }
+
+    void clear() {
+        for (uint8_t b = 0; b < kBuckets; b++) {
+            buckets_[b] = 0;
+        }
+        count_ = 0;
+        max_ = 0;
+    }
+
+private:
+    uint32_t buckets_[kBuckets] = {0};
+    uint32_t count_ = 0;
+    uint32_t max_ = 0;
+};
+
+class PbHbLatency {
+public:
+    void record(const PbHbTimings &t) {
+        for (uint8_t i = 0; i < kPbHbPhaseCount; i++) {
+            if (t.has(static_cast<PbHbPhase>(i))) {
+                hist_[i].add(t.us[i]);
+            }
+        }
+        if (t.failedAt != PbHbPhase::None) {
+            fails_[static_cast<uint8_t>(t.failedAt)]++;
+        }
+        beats_++;
+    }
+
+    // Beat завершився. delivered — він доніс підсумок попереднього вікна, тож вікно
+    // починається заново (з цього beat). Інакше накопичуємо далі.
+    void finish(const PbHbTimings &t, bool delivered) {
+        if (delivered) {
+            clear();
+        }
+        record(t);
+    }
+
+    const PbLatencyHist &hist(PbHbPhase p) const { return hist_[static_cast<uint8_t>(p)]; }
+    uint32_t fails(PbHbPhase p) const { return fails_[static_cast<uint8_t>(p)]; }
+    uint32_t beats() const { return beats_; }
+
+    void clear() {
+        for (uint8_t i = 0; i < kPbHbPhaseCount; i++) {
+            hist_[i].clear();
+            fails_[i] = 0;
+        }
+        beats_ = 0;
+    }
+
+private:
+    PbLatencyHist hist_[kPbHbPhaseCount];
+    uint32_t fails_[kPbHbPhaseCount] = {0};
+    uint32_t beats_ = 0;
+};
+
+// JSON-шаблон підсумку: {"dns":[p50,p95,max,fails],...} — по 4 слоти PB_SLOT_U32 на фазу.
+#define PB_HB_LAT_ARR "[" PB_SLOT_U32 "," PB_SLOT_U32 "," PB_SLOT_U32 "," PB_SLOT_U32 "]"
+#define PB_HB_LAT_JSON                 \
+    "{\"dns\":" PB_HB_LAT_ARR          \
+    ",\"connect\":" PB_HB_LAT_ARR      \
+    ",\"write\":" PB_HB_LAT_ARR        \
+    ",\"ttfb\":" PB_HB_LAT_ARR         \
+    ",\"response\":" PB_HB_LAT_ARR "}"
+
+// Вписати підсумок у шаблон PB_HB_LAT_JSON (obj вказує на його '{'). Фази йдуть у
+// порядку PbHbPhase, тож масиви шукаємо по '[' — зсувів для кожного слота не треба.
+inline void pbHbLatencyPut(char *obj, size_t len, const PbHbLatency &lat) {
+    const size_t w = sizeof(PB_SLOT_U32) - 1;
+    size_t at = 0;
+    for (uint8_t i = 0; i < kPbHbPhaseCount; i++) {
+        while (at < len && obj[at] != '[') {
+            at++;
+        }
+        if (at + 4 * (w + 1) > len) {
+            return;
+        }
+        const PbHbPhase p = static_cast<PbHbPhase>(i);
+        const PbLatencyHist &h = lat.hist(p);
+        char *slot = obj + at + 1;
+        pbSlotPutUint(slot, w, h.percentile(50));
+        pbSlotPutUint(slot + (w + 1), w, h.percentile(95));
+        pbSlotPutUint(slot + 2 * (w + 1), w, h.max());
+        pbSlotPutUint(slot + 3 * (w + 1), w, lat.fails(p));
+        at += 4 * (w + 1);
+    }
+}
@@ -0,0 +1,258 @@
+/*
+ * PowerBot: покроковий парсер HTTP/1.1 відповіді на heartbeat.
+ *
+ * Байти йдуть у feed() так, як прийшли з сокета — будь-якими шматками, хоч по одному.
+ * Стан парсера — лише фіксовані буфери (рядок заголовка, копія status line і початку body
+ * для логів), без heap і без String. Результат:
+ *  - status — числом з "HTTP/1.x DDD", рівно три цифри (а не пошук "200" будь-де в рядку);
+ *  - Content-Length — межа body, щоб keep-alive з'єднання можна було перевикористати;
+ *  - Connection: close — сервер закриє сокет;
+ *  - X-PB-Interval-Ms — інструкція сервера: новий період heartbeat (0 — не було).
+ *
+ * Невідомі заголовки пропускаються. Зіпсований status line, Content-Length або інструкція —
+ * Bad: таку відповідь не можна ні прийняти, ні дочитати до межі.
+ *
+ * Header портабельний (без Arduino.h) — fuzz/property-тести на хості (test/test_http_resp).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+enum class PbHttpRespState : uint8_t {
+    Status,    // чекаємо status line
+    Headers,
+    Body,
+    Done,
+    Bad,
+};
+
+// Content-Length більший за це — явно не відповідь на heartbeat.
+static const uint32_t kPbHttpMaxContentLength = 1000000000u;
+
+template <size_t kLineCap = 128, size_t kBodyCap = 160>
+class PbHttpResponse {
+    static_assert(kLineCap >= 32, "рядок заголовка: щонайменше 32 байти");
+    static_assert(kBodyCap >= 1, "body: щонайменше термінатор");
+
+public:
+    void reset() {
+        state_ = PbHttpRespState::Status;
+        status_ = 0;
+        contentLength_ = -1;
+        intervalMs_ = 0;
+        close_ = false;
+        lineLen_ = 0;
+        lineOverflow_ = false;
+        statusLine_[0] = '\0';
+        body_[0] = '\0';
+        bodyLen_ = 0;
+        bodyRead_ = 0;
+    }
+
+    // Скільки байтів з data спожито; після Done / Bad решта не споживається.
+    size_t feed(const char *data, size_t len) {
+        size_t i = 0;
+        while (i < len && !finished()) {
+            if (state_ == PbHttpRespState::Body) {
+                i += feedBody(data + i, len - i);
+            } else {
+                feedHead(data[i++]);
+            }
+        }
+        return i;
+    }
+
+    // Peer закрив сокет. Body без Content-Length цим і завершується; до кінця заголовків — Bad.
+    void eof() {
+        if (state_ == PbHttpRespState::Body) {
+            close_ = true;
+            state_ = PbHttpRespState::Done;
+        } else if (!finished()) {
+            state_ = PbHttpRespState::Bad;
+        }
+    }
+
+    PbHttpRespState state() const { return state_; }
+    bool finished() const { return state_ == PbHttpRespState::Done || state_ == PbHttpRespState::Bad; }
+    bool headersDone() const { return state_ == PbHttpRespState::Body || state_ == PbHttpRespState::Done; }
+
+    int status() const { return status_; }
+    long contentLength() const { return contentLength_; }       // -1 — не вказано
+    // Скільки body ще чекати (лише з Content-Length; інакше 0).
+    size_t bodyLeft() const {
+        return contentLength_ >= 0 ? static_cast<size_t>(contentLength_) - bodyRead_ : 0;
+    }
+    size_t bodyRead() const { return bodyRead_; }
+    bool serverClose() const { return close_; }
+    uint32_t intervalMs() const { return intervalMs_; }
+    const char *statusLine() const { return statusLine_; }
+    const char *body() const { return body_; }   // обрізаний до kBodyCap-1 (для логів)
+
+private:
+    void feedHead(char c) {
+        if (c == '\r') {
+            return;
+        }
+        if (c != '\n') {
+            if (lineLen_ + 1 < kLineCap) {
+                line_[lineLen_++] = c;
+            } else {
+                lineOverflow_ = true;
+            }
+            return;
+        }
+        line_[lineLen_] = '\0';
+        const size_t len = lineLen_;
+        const bool overflow = lineOverflow_;
+        lineLen_ = 0;
+        lineOverflow_ = false;
+
+        if (state_ == PbHttpRespState::Status) {
+            memcpy(statusLine_, line_, len + 1);
+            status_ = parseStatus(line_);
+            state_ = status_ > 0 ? PbHttpRespState::Headers : PbHttpRespState::Bad;
+            return;
+        }
+        if (len == 0) {
+            state_ = contentLength_ == 0 ? PbHttpRespState::Done : PbHttpRespState::Body;
+            return;
+        }
+        const char *value = headerValue(line_, "content-length");
+        if (value != nullptr) {
+            const long n = overflow ? -1 : parseUint(value, kPbHttpMaxContentLength);
+            // Два різні Content-Length — межа body невідома (request smuggling).
+            if (n < 0 || (contentLength_ >= 0 && n != contentLength_)) {
+                state_ = PbHttpRespState::Bad;
+                return;
+            }
+            contentLength_ = n;
+        } else if ((value = headerValue(line_, "connection")) != nullptr) {
+            if (containsToken(value, "close")) {
+                close_ = true;
+            }
+        } else if ((value = headerValue(line_, "x-pb-interval-ms")) != nullptr) {
+            const long n = overflow ? -1 : parseUint(value, UINT32_MAX);
+            if (n < 0) {
+                state_ = PbHttpRespState::Bad;
+                return;
+            }
+            intervalMs_ = static_cast<uint32_t>(n);
+        }
+    }
+
+    size_t feedBody(const char *data, size_t len) {
+        size_t n = len;
+        if (contentLength_ >= 0 && n > bodyLeft()) {
+            n = bodyLeft();
+        }
+        for (size_t i = 0; i < n && bodyLen_ + 1 < kBodyCap; i++) {
+            body_[bodyLen_++] = data[i];
+        }
+        body_[bodyLen_] = '\0';
+        bodyRead_ += n;
+        if (contentLength_ >= 0 && bodyLeft() == 0) {
+            state_ = PbHttpRespState::Done;
+        }
+        return n;
+    }
+
+    // "HTTP/1.x" SP 3DIGIT (SP reason | кінець рядка); код 100..599, інакше -1.
+    static int parseStatus(const char *line) {
+        if (strncmp(line, "HTTP/1.", 7) != 0 || line[7] < '0' || line[7] > '9' || line[8] != ' ') {
+            return -1;
+        }
+        const char *p = line + 9;
+        int code = 0;
+        for (int i = 0; i < 3; i++) {
+            if (p[i] < '0' || p[i] > '9') {
+                return -1;
+            }
+            code = code * 10 + (p[i] - '0');
+        }
+        if (p[3] != ' ' && p[3] != '\0') {
+            return -1;
+        }
+        return code >= 100 && code <= 599 ? code : -1;
+    }
+
+    // Значення заголовка name (ім'я без урахування регістру) без OWS на початку, або nullptr.
+    static const char *headerValue(const char *line, const char *name) {
+        size_t i = 0;
+        for (; name[i] != '\0'; i++) {
+            if (lowerAscii(line[i]) != name[i]) {
+                return nullptr;
+            }
+        }
+        if (line[i] != ':') {
+            return nullptr;
+        }
+        const char *v = line + i + 1;
+        while (*v == ' ' || *v == '\t') {
+            v++;
+        }
+        return v;
+    }
+
+    // Десяткове число з OWS у кінці; > maxValue, порожнє чи з іншими символами — -1.
+    static long parseUint(const char *s, uint32_t maxValue) {
+        if (*s < '0' || *s > '9') {
+            return -1;
+        }
+        uint64_t v = 0;
+        for (; *s >= '0' && *s <= '9'; s++) {
+            v = v * 10 + static_cast<uint64_t>(*s - '0');
+            if (v > maxValue) {
+                return -1;
+            }
+        }
+        while (*s == ' ' || *s == '\t') {
+            s++;
+        }
+        return *s == '\0' ? static_cast<long>(v) : -1;
+    }
+
+    // Токен у списку через кому, без урахування регістру ("keep-alive, Close").
+    static bool containsToken(const char *list, const char *token) {
+        const size_t n = strlen(token);
+        const char *p = list;
+        for (;;) {
+            while (*p == ' ' || *p == '\t' || *p == ',') {
+                p++;
+            }
+            if (*p == '\0') {
+                return false;
+            }
+            size_t i = 0;
+            while (i < n && lowerAscii(p[i]) == token[i]) {
+                i++;
+            }
+            const char end = p[i];
+            if (i == n && (end == '\0' || end == ',' || end == ' ' || end == '\t')) {
+                return true;
+            }
+            while (*p != '\0' && *p != ',') {
+                p++;
+            }
+        }
+    }
+
+    static char lowerAscii(char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; }
+
+    PbHttpRespState state_ = PbHttpRespState::Status;
+    int status_ = 0;
+    long contentLength_ = -1;
+    uint32_t intervalMs_ = 0;
+    bool close_ = false;
+
+    char line_[kLineCap];
+    size_t lineLen_ = 0;
+    bool lineOverflow_ = false;
+    char statusLine_[kLineCap] = {0};
+
+    char body_[kBodyCap] = {0};
+    size_t bodyLen_ = 0;
+    size_t bodyRead_ = 0;
+};
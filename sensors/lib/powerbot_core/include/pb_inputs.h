@@ -0,0 +1,73 @@
+/*
+ * PowerBot: кілька входів живлення на одній платі (PB_INPUTS) — антидребезг у бітову маску.
+ *
+ * Кожен вхід — оптопара (або компаратор) від окремої секції / фази. Оптопара на змінній
+ * напрузі не тримає рівень, а блимає з частотою мережі: активна частину кожного напівперіоду.
+ * Тому вхід вважається:
+ *   - увімкненим після onSamples активних семплів (не обов'язково поспіль) — імпульси
+ *     мережі набирають їх за перший період, поодинока завада — ні;
+ *   - вимкненим після offSamples неактивних семплів поспіль — довше за паузу між імпульсами
+ *     (> 20 мс на 50 Гц), тож вимкнення фіксується за ~2 періоди мережі.
+ * Після offSamples тиші лічильник активних семплів обнуляється.
+ *
+ * feed() викликається з ISR апаратного таймера (pb_sensor.h): без алокацій і ділень,
+ * O(N) на семпл. Header портабельний (без Arduino.h) — перевіряється на хості (test/test_inputs).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(ARDUINO)
+#include <esp_attr.h>
+#define PB_INPUTS_ISR IRAM_ATTR
+#else
+#define PB_INPUTS_ISR
+#endif
+
+struct PbInputsConfig {
+    uint8_t onSamples;     // активних семплів до "увімкнено"
+    uint16_t offSamples;   // неактивних семплів поспіль до "вимкнено"
+};
+
+// N входів; біт i маски — вхід i (input_sections[i] на сервері).
+template <uint8_t N>
+class PbInputDebouncer {
+    static_assert(N > 0 && N <= 16, "PbInputDebouncer: 1..16 входів");
+
+public:
+    explicit PbInputDebouncer(const PbInputsConfig &cfg)
+        : onSamples_(cfg.onSamples > 0 ? cfg.onSamples : 1), offSamples_(cfg.offSamples > 0 ? cfg.offSamples : 1) {}
+
+    // Один семпл усіх входів (біт = вхід активний). true — стабільна маска змінилась.
+    PB_INPUTS_ISR bool feed(uint32_t activeMask) {
+        const uint16_t before = state_;
+        for (uint8_t i = 0; i < N; i++) {
+            const uint16_t bit = static_cast<uint16_t>(1u << i);
+            if (activeMask & bit) {
+                idle_[i] = 0;
+                if (hits_[i] < 0xFF) {
+                    hits_[i]++;
+                }
+                if (hits_[i] >= onSamples_) {
+                    state_ |= bit;
+                }
+            } else if (idle_[i] < offSamples_) {
+                if (++idle_[i] >= offSamples_) {
+                    hits_[i] = 0;
+                    state_ &= static_cast<uint16_t>(~bit);
+                }
+            }
+        }
+        return state_ != before;
+    }
+
+    uint16_t state() const { return state_; }
+
+private:
+    uint8_t onSamples_;
+    uint16_t offSamples_;
+    uint16_t state_ = 0;
+    uint8_t hits_[N] = {};
+    uint16_t idle_[N] = {};
+};
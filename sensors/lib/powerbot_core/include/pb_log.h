@@ -0,0 +1,296 @@
+/*
+ * PowerBot: відкладений логер для heartbeat-шляху.
+ *
+ * Serial.printf на 115200 бод блокує задачу ~87 мкс на байт, коли FIFO UART повний;
+ * beat з десятком рядків простоював так десятки мілісекунд. Тут виклик лише кладе в
+ * lock-free ring номер формату (pb_log_formats.h) і аргументи в бінарному вигляді,
+ * а текст збирає і пише в Serial окрема низькопріоритетна задача (main.cpp).
+ *
+ * Запис: [len u8][level u8][id u16] + аргументи з тегом: 'u'/'d' + 4 байти LE,
+ * 's' + довжина u8 + байти (рядок копіюється: буфери машини перезаписуються наступним beat).
+ *
+ * PbLogRing — single-producer/single-consumer: пише лише net-задача, читає лише дренер.
+ * Що не влазить — відкидається і рахується в dropped(), producer ніколи не чекає.
+ *
+ * Рівень фільтрується на етапі компіляції: PB_LOGD(...) при PB_LOG_LEVEL > DEBUG —
+ * порожній макрос, аргументи навіть не обчислюються.
+ *
+ * Header портабельний (без Arduino.h) — перевіряється на хості (test/test_log).
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+#include "pb_log_formats.h"
+
+#define PB_LOG_LEVEL_DEBUG 0
+#define PB_LOG_LEVEL_INFO 1
+#define PB_LOG_LEVEL_WARN 2
+#define PB_LOG_LEVEL_ERROR 3
+#define PB_LOG_LEVEL_NONE 4
+
+#ifndef PB_LOG_LEVEL
+#define PB_LOG_LEVEL PB_LOG_LEVEL_INFO
+#endif
+
+#define PB_LOG_ID_(id, fmt) id,
+enum class PbLogId : uint16_t { PB_LOG_FORMATS(PB_LOG_ID_) Count };
+#undef PB_LOG_ID_
+
+#define PB_LOG_FMT_(id, fmt) fmt,
+static const char *const kPbLogFormats[] = {PB_LOG_FORMATS(PB_LOG_FMT_)};
+#undef PB_LOG_FMT_
+
+static_assert(sizeof(kPbLogFormats) / sizeof(kPbLogFormats[0]) == static_cast<size_t>(PbLogId::Count),
+              "pb_log_formats.h: таблиця і enum розійшлись");
+
+static const size_t kPbLogMaxRecord = 192;
+static const size_t kPbLogHeader = 4;
+static const size_t kPbLogMaxLine = 384;   // текст запису: найдовший формат (HbConnectFail) з запасом
+static const uint8_t kPbLogSync = 0x1E;   // перед кожним записом у бінарному режимі (PB_LOG_BINARY)
+
+// Один запис, зібраний на стеку producer-а (без heap).
+class PbLogRecord {
+public:
+    PbLogRecord(uint8_t level, PbLogId id) : len_(kPbLogHeader) {
+        buf_[1] = level;
+        buf_[2] = static_cast<uint8_t>(static_cast<uint16_t>(id) & 0xFF);
+        buf_[3] = static_cast<uint8_t>(static_cast<uint16_t>(id) >> 8);
+    }
+
+    template <class T>
+    typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type add(T v) {
+        putWord(std::is_signed<T>::value ? 'd' : 'u', static_cast<uint32_t>(v));
+    }
+    void add(const char *s) {
+        if (s == nullptr) {
+            s = "(null)";
+        }
+        size_t n = strlen(s);
+        if (len_ + 2 > kPbLogMaxRecord) {
+            return;
+        }
+        // Довгий рядок (body, payload) обрізаємо під залишок запису.
+        const size_t room = kPbLogMaxRecord - len_ - 2;
+        n = n < room ? n : room;
+        n = n < 255 ? n : 255;
+        buf_[len_++] = 's';
+        buf_[len_++] = static_cast<uint8_t>(n);
+        memcpy(buf_ + len_, s, n);
+        len_ += n;
+    }
+    void add(char *s) { add(static_cast<const char *>(s)); }
+
+    const uint8_t *finish() {
+        buf_[0] = static_cast<uint8_t>(len_);
+        return buf_;
+    }
+    size_t size() const { return len_; }
+
+private:
+    void putWord(char tag, uint32_t v) {
+        if (len_ + 5 > kPbLogMaxRecord) {
+            return;
+        }
+        buf_[len_++] = static_cast<uint8_t>(tag);
+        for (int i = 0; i < 4; i++) {
+            buf_[len_++] = static_cast<uint8_t>(v >> (8 * i));
+        }
+    }
+
+    uint8_t buf_[kPbLogMaxRecord];
+    size_t len_;
+};
+
+inline void pbLogAddAll(PbLogRecord &) {}
+template <class T, class... Rest>
+inline void pbLogAddAll(PbLogRecord &r, T v, Rest... rest) {
+    r.add(v);
+    pbLogAddAll(r, rest...);
+}
+
+// SPSC ring з записами змінної довжини; kCap — степінь двійки.
+template <size_t kCap>
+class PbLogRing {
+    static_assert((kCap & (kCap - 1)) == 0 && kCap >= 2 * kPbLogMaxRecord, "kCap: степінь двійки, >= 2 записів");
+
+public:
+    // Producer. false — місця немає, запис відкинуто (dropped()++).
+    bool push(const uint8_t *rec, size_t len) {
+        const uint32_t head = head_.load(std::memory_order_relaxed);
+        const uint32_t tail = tail_.load(std::memory_order_acquire);
+        if (len == 0 || kCap - (head - tail) < len) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        for (size_t i = 0; i < len; i++) {
+            buf_[(head + i) & (kCap - 1)] = rec[i];
+        }
+        head_.store(head + static_cast<uint32_t>(len), std::memory_order_release);
+        return true;
+    }
+
+    // Consumer. Довжина запису в out, 0 — порожньо.
+    size_t pop(uint8_t *out, size_t cap) {
+        const uint32_t tail = tail_.load(std::memory_order_relaxed);
+        const uint32_t head = head_.load(std::memory_order_acquire);
+        if (head == tail) {
+            return 0;
+        }
+        const size_t len = buf_[tail & (kCap - 1)];
+        const size_t n = len < cap ? len : cap;
+        for (size_t i = 0; i < n; i++) {
+            out[i] = buf_[(tail + i) & (kCap - 1)];
+        }
+        tail_.store(tail + static_cast<uint32_t>(len), std::memory_order_release);
+        return n;
+    }
+
+    bool empty() const { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_relaxed); }
+    uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    uint8_t buf_[kCap];
+    std::atomic<uint32_t> head_{0};
+    std::atomic<uint32_t> tail_{0};
+    std::atomic<uint32_t> dropped_{0};
+};
+
+// Текст запису в out (з '\0'); повертає довжину. Аргументів менше, ніж у формату, — "?".
+inline size_t pbLogRender(const uint8_t *rec, size_t len, char *out, size_t cap) {
+    if (cap == 0) {
+        return 0;
+    }
+    size_t o = 0;
+    auto put = [&](char c) {
+        if (o + 1 < cap) {
+            out[o++] = c;
+        }
+    };
+    if (len < kPbLogHeader) {
+        out[0] = '\0';
+        return 0;
+    }
+    const uint16_t id = static_cast<uint16_t>(rec[2] | (rec[3] << 8));
+    if (id >= static_cast<uint16_t>(PbLogId::Count)) {
+        out[0] = '\0';
+        return 0;
+    }
+    size_t a = kPbLogHeader;
+    for (const char *f = kPbLogFormats[id]; *f != '\0'; f++) {
+        if (*f != '%') {
+            put(*f);
+            continue;
+        }
+        f++;
+        if (*f == '%') {
+            put('%');
+            continue;
+        }
+        const bool zero = *f == '0';
+        if (zero) {
+            f++;
+        }
+        unsigned width = 0;
+        while (*f >= '0' && *f <= '9') {
+            width = width * 10 + static_cast<unsigned>(*f++ - '0');
+        }
+        while (*f == 'l' || *f == 'h') {
+            f++;
+        }
+        if (*f == '\0') {
+            break;
+        }
+        const char conv = *f;
+        char digits[12];
+        size_t nd = 0;
+        const char *str = nullptr;
+        size_t strLen = 0;
+        if (a >= len) {
+            str = "?";
+            strLen = 1;
+        } else if (rec[a] == 's' && a + 2 <= len) {
+            strLen = rec[a + 1];
+            strLen = a + 2 + strLen <= len ? strLen : len - a - 2;
+            str = reinterpret_cast<const char *>(rec + a + 2);
+            a += 2 + rec[a + 1];
+        } else if ((rec[a] == 'u' || rec[a] == 'd') && a + 5 <= len) {
+            uint32_t v = 0;
+            for (int i = 0; i < 4; i++) {
+                v |= static_cast<uint32_t>(rec[a + 1 + i]) << (8 * i);
+            }
+            const bool neg = rec[a] == 'd' && (conv == 'd' || conv == 'i') && static_cast<int32_t>(v) < 0;
+            if (conv == 'c') {
+                digits[nd++] = static_cast<char>(v);
+            } else {
+                const uint32_t base = (conv == 'x' || conv == 'X') ? 16 : 10;
+                uint32_t m = neg ? 0u - v : v;
+                do {
+                    const uint32_t d = m % base;
+                    digits[nd++] = static_cast<char>(d < 10 ? '0' + d : (conv == 'X' ? 'A' : 'a') + d - 10);
+                    m /= base;
+                } while (m != 0);
+                if (neg) {
+                    digits[nd++] = '-';
+                }
+                // Цифри зібрані задом наперед.
+                for (size_t i = 0; i < nd / 2; i++) {
+                    const char t = digits[i];
+                    digits[i] = digits[nd - 1 - i];
+                    digits[nd - 1 - i] = t;
+                }
+            }
+            str = digits;
+            strLen = nd;
+            a += 5;
+        } else {
+            str = "?";
+            strLen = 1;
+            a = len;
+        }
+        for (size_t pad = strLen; pad < width; pad++) {
+            put(zero && conv != 's' ? '0' : ' ');
+        }
+        for (size_t i = 0; i < strLen; i++) {
+            put(str[i]);
+        }
+    }
+    out[o] = '\0';
+    return o;
+}
+
+// Ціль макросів: визначає main.cpp (ring + дренер або, з PB_LOG_DIRECT, одразу Serial).
+void pbLogPush(const uint8_t *rec, size_t len);
+
+template <class... A>
+inline void pbLogWrite(uint8_t level, PbLogId id, A... args) {
+    PbLogRecord r(level, id);
+    pbLogAddAll(r, args...);
+    pbLogPush(r.finish(), r.size());
+}
+
+#if PB_LOG_LEVEL <= PB_LOG_LEVEL_DEBUG
+#define PB_LOGD(id, ...) pbLogWrite(PB_LOG_LEVEL_DEBUG, PbLogId::id, ##__VA_ARGS__)
+#else
+#define PB_LOGD(id, ...) do {} while (0)
+#endif
+#if PB_LOG_LEVEL <= PB_LOG_LEVEL_INFO
+#define PB_LOGI(id, ...) pbLogWrite(PB_LOG_LEVEL_INFO, PbLogId::id, ##__VA_ARGS__)
+#else
+#define PB_LOGI(id, ...) do {} while (0)
+#endif
+#if PB_LOG_LEVEL <= PB_LOG_LEVEL_WARN
+#define PB_LOGW(id, ...) pbLogWrite(PB_LOG_LEVEL_WARN, PbLogId::id, ##__VA_ARGS__)
+#else
+#define PB_LOGW(id, ...) do {} while (0)
+#endif
+#if PB_LOG_LEVEL <= PB_LOG_LEVEL_ERROR
+#define PB_LOGE(id, ...) pbLogWrite(PB_LOG_LEVEL_ERROR, PbLogId::id, ##__VA_ARGS__)
+#else
+#define PB_LOGE(id, ...) do {} while (0)
+#endif
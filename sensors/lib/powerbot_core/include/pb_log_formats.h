@@ -0,0 +1,78 @@
+/*
+ * PowerBot: таблиця форматів відкладеного логера (pb_log.h).
+ *
+ * У ring-буфер пишеться лише номер рядка з цієї таблиці + аргументи; текст збирає
+ * задача-дренер (або хост: scripts/sensor_log_decode.py читає цей файл як є — тож
+ * один рядок = один X(Id, "формат"), порядок = номер). Нові формати — лише в кінець,
+ * щоб старі бінарні дампи декодувались тією ж таблицею.
+ *
+ * Специфікатори: %s, %c, %d/%i, %u, %x/%X з прапорцем 0 і шириною; l ігнорується (усе 32 біти).
+ */
+
+#pragma once
+
+#define PB_LOG_FORMATS(X)                                                                        \
+    X(LogDropped, "⚠️ Лог: пропущено %lu рядків")                                                \
+    X(HbSend, "\n📤 Відправка heartbeat...")                                                     \
+    X(LinkDown, "❌ Ethernet link down!")                                                        \
+    X(HbTargetUdp, "🌐 UDP heartbeat на %s:%u")                                                  \
+    X(HbTarget, "🌐 Підключення до %s:%u")                                                       \
+    X(HbLocalIp, "   Local IP: %u.%u.%u.%u")                                                     \
+    X(HbGateway, "   Gateway:  %u.%u.%u.%u")                                                     \
+    X(HbLink, "   Link:     %s")                                                                 \
+    X(HbFrame, "📦 Frame: seq=%lu, %u байт")                                                     \
+    X(HbPayload, "📦 Payload: %s")                                                               \
+    X(HbReuse, "   Keep-alive: перевикористовую з'єднання")                                      \
+    X(HbStaleRetry, "↻ Keep-alive з'єднання закрите сервером, перепідключення...")               \
+    X(HbConnectTry, "   Спроба connect()...")                                                    \
+    X(HbUdpTarget, "   UDP -> %s:%u")                                                            \
+    X(HbConnectOk, "   Connect result: 1")                                                       \
+    X(HbTimings, "   ⏱ dns=%lu connect=%lu write=%lu ttfb=%lu response=%lu мкс%s%s")             \
+    X(HbDnsFail, "❌ DNS: не вдалося отримати адресу %s%s")                                      \
+    X(HbConnectFail, "   Connect result: 0\n❌ Не вдалося підключитися до сервера!\n"            \
+                     "   Можливі причини:\n   - Немає маршруту до інтернету\n"                   \
+                     "   - Firewall блокує з'єднання\n   - Сервер недоступний")                  \
+    X(HbWriteFail, "❌ Не вдалося відправити запит!")                                            \
+    X(HbStatusTimeout, "❌ Таймаут відповіді!")                                                  \
+    X(HbClosed, "❌ Сервер закрив з'єднання без відповіді!")                                     \
+    X(HbBadStatus, "❌ Некоректна відповідь сервера!")                                           \
+    X(HbStatus, "📨 %s")                                                                         \
+    X(HbBody, "📨 Body: %s")                                                                     \
+    X(HbConnections, "   Connections: new=%lu, reused=%lu")                                      \
+    X(HbFrameRejected, "⚠️ Frame не прийнято — наступний beat піде JSON")                        \
+    X(HbHeap, "   Heap: free=%lu, low=%lu, drops=%lu; log drops=%lu")                            \
+    X(HbBeatTime, "   ⏱ beat: %lu мкс (p50 %lu, p95 %lu)")                                       \
+    X(HbOk, "✅ Heartbeat успішно!")                                                             \
+    X(HbBootToFirst, "⏱ Boot -> перший heartbeat: %lu ms (профіль %s; probe: %u за %lu ms; "     \
+                     "link @%lu ms; IP @%lu ms)")                                                \
+    X(HbFailed, "❌ Помилка heartbeat!")                                                         \
+    X(HbNext, "⏰ Наступний через %d сек")                                                       \
+    X(LastGaspNotSent, "❌ Last-gasp не відправлено")                                            \
+    X(LastGaspPending, "🪫 power_lost відправлено (%s), чекаю відповідь...")                     \
+    X(LastGaspDone, "🪫 power_lost: %s за %lu мс")                                               \
+    X(PowerLost, "\n🪫 Живлення пропадає — last-gasp power_lost")                                \
+    X(PowerLostNoNet, "   Мережі немає — сервер побачить таймаут heartbeat")                     \
+    X(PowerRestored, "\n🔋 Живлення повернулось — позачерговий heartbeat")                       \
+    X(EthCableOff, "❌ Ethernet кабель відключено!")                                             \
+    X(HbParsedIp, "   Parsed IP: %u.%u.%u.%u")                                                  \
+    X(HbInterval, "   ⏱ інтервал: %lu мс, відхилення %ld мкс (p95 |відхилення| %lu мкс)")       \
+    X(PmWake, "   💤 пробудження p95 %lu мкс (max %lu), guard %lu мкс, без сну %u.%u%%")         \
+    X(JournalAdd, "📒 beat #%lu у журнал: %u записів (крок %lu)")                                \
+    X(JournalSend, "📒 Журнал: %u записів (крок %lu) -> /api/v1/heartbeat/bulk")                 \
+    X(JournalSent, "📒 Журнал доставлено: %u записів")                                           \
+    X(JournalRejected, "⚠️ Журнал відхилено (HTTP %d), %u записів відкинуто")                   \
+    X(JournalRetry, "⚠️ Журнал не доставлено — повтор після наступного beat")                   \
+    X(HbBadResponse, "❌ Некоректні заголовки відповіді сервера!")                               \
+    X(HbPeriodSet, "⏰ Сервер: період heartbeat %lu мс")                                         \
+    X(DnsResolved, "🌐 DNS %s -> %u.%u.%u.%u (TTL %lu с, %lu мкс)")                              \
+    X(DnsFailed, "⚠️ DNS %s не відповів (%lu мкс) — %s; повтор через %lu с")                    \
+    X(DnsSeed, "🌐 DNS %s: з NVS %u.%u.%u.%u, поки DNS не відповів")                          \
+    X(AggListen, "🏢 Агрегатор: beat-и сусідів на UDP %u")                                       \
+    X(AggListenFail, "⚠️ Агрегатор: UDP %u не відкрито — повтор")                               \
+    X(AggPeer, "🏢 Сусід -> %s")                                                                 \
+    X(AggBatch, "🏢 Пакет: свій beat + %u сусідів, %u байт -> /api/v1/heartbeat/batch")          \
+    X(AggPending, "🏢 Beat-ів сусідів чекає наступного пакета: %u")                             \
+    X(InputsChanged, "\n🔌 Входи: 0x%04x — позачерговий heartbeat")                         \
+    X(MainsSummary, "   ⚡ мережа %lu.%lu В (%lu.%lu..%lu.%lu), %lu.%03lu Гц (%lu..%lu мГц), періодів %lu; " \
+                    "%lu тактів/семпл, розривів DMA %lu")                                       \
+    X(HbJson, "📦 JSON beat: event=%s, seq=%lu, %u байт")
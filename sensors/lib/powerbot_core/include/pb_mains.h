@@ -0,0 +1,244 @@
+/*
+ * PowerBot: якість мережі — RMS напруги і частота по кожному періоду (PB_MAINS).
+ *
+ * ADC у continuous-режимі (DMA) безперервно семплює вихід трансформатора напруги (ZMPT101B
+ * тощо, зміщений у середину шкали). Блоки семплів ідуть у PbMainsMeter::feed() з окремої задачі;
+ * на кожен семпл — лише додавання, множення і порівняння:
+ *   - sumX / sumX² за поточний період -> RMS змінної складової точно, без оцінки зміщення:
+ *     n·Σx² − (Σx)² = n²·σ²; корінь — цілочисельний, раз на період;
+ *   - перетин нуля вгору з гістерезисом (центр — середнє попередніх періодів) з інтерполяцією
+ *     між семплами в Q16 -> період у частках семпла, частота в мГц.
+ * Без float: Q8/Q16 і 64-бітні цілі, ділення — лише на межі періоду.
+ *
+ * Розрив потоку семплів (переповнення DMA) — resync(): період з дірою не рахується.
+ * Період без перетину довше за 1/minHz (світла немає, обрив датчика) закривається сам: RMS
+ * рахується (≈0 В при відключенні), частота — ні. PbMainsStats — min / avg / max за вікно між
+ * доставленими beat-ами: просідання / перенапруга одного періоду видно в min / max.
+ *
+ * Header портабельний (без Arduino.h) — перевіряється на хості (test/test_mains).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pb_hb_body.h"
+
+struct PbMainsConfig {
+    uint32_t sampleHz;     // частота семплів ADC
+    uint32_t uvPerCount;   // калібрування: мкВ мережі (RMS) на одиницю ADC (RMS)
+    uint16_t hystCounts;   // гістерезис перетину нуля, одиниці ADC (вище шуму ADC)
+    uint8_t minHz;         // допустима частота мережі, Гц; довший період — без частоти
+    uint8_t maxHz;
+};
+
+// Цілочисельний корінь (floor) для uint64, по біту за крок.
+inline uint32_t pbIsqrt64(uint64_t v) {
+    uint64_t root = 0;
+    uint64_t bit = static_cast<uint64_t>(1) << 62;
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return static_cast<uint32_t>(root);
+}
+
+// Підсумок періодів за вікно: напруга в дВ (0.1 В), частота в мГц.
+class PbMainsStats {
+public:
+    void add(uint32_t dV, uint32_t mHz) {
+        if (cycles_ == 0 || dV < vMin_) {
+            vMin_ = dV;
+        }
+        if (dV > vMax_) {
+            vMax_ = dV;
+        }
+        vSum_ += dV;
+        cycles_++;
+        if (mHz == 0) {
+            return;   // період без перетину нуля / поза minHz..maxHz
+        }
+        if (fCycles_ == 0 || mHz < fMin_) {
+            fMin_ = mHz;
+        }
+        if (mHz > fMax_) {
+            fMax_ = mHz;
+        }
+        fSum_ += mHz;
+        fCycles_++;
+    }
+
+    void merge(const PbMainsStats &o) {
+        if (o.cycles_ > 0) {
+            vMin_ = (cycles_ == 0 || o.vMin_ < vMin_) ? o.vMin_ : vMin_;
+            vMax_ = o.vMax_ > vMax_ ? o.vMax_ : vMax_;
+            vSum_ += o.vSum_;
+            cycles_ += o.cycles_;
+        }
+        if (o.fCycles_ > 0) {
+            fMin_ = (fCycles_ == 0 || o.fMin_ < fMin_) ? o.fMin_ : fMin_;
+            fMax_ = o.fMax_ > fMax_ ? o.fMax_ : fMax_;
+            fSum_ += o.fSum_;
+            fCycles_ += o.fCycles_;
+        }
+    }
+
+    void clear() { *this = PbMainsStats(); }
+
+    uint32_t cycles() const { return cycles_; }
+    uint32_t vMin() const { return vMin_; }
+    uint32_t vMax() const { return vMax_; }
+    uint32_t vAvg() const { return cycles_ > 0 ? static_cast<uint32_t>(vSum_ / cycles_) : 0; }
+    uint32_t freqCycles() const { return fCycles_; }
+    uint32_t fMin() const { return fMin_; }
+    uint32_t fMax() const { return fMax_; }
+    uint32_t fAvg() const { return fCycles_ > 0 ? static_cast<uint32_t>(fSum_ / fCycles_) : 0; }
+
+private:
+    uint32_t cycles_ = 0;
+    uint32_t vMin_ = 0;
+    uint32_t vMax_ = 0;
+    uint64_t vSum_ = 0;
+    uint32_t fCycles_ = 0;
+    uint32_t fMin_ = 0;
+    uint32_t fMax_ = 0;
+    uint64_t fSum_ = 0;
+};
+
+class PbMainsMeter {
+public:
+    // n² · 4095² · 2¹⁶ у uint64 -> період не довший за 4095 семплів.
+    static const uint32_t kMaxCycleSamples = 4095;
+
+    explicit PbMainsMeter(const PbMainsConfig &cfg, uint16_t midCounts = 2048)
+        : cfg_(cfg),
+          hystQ8_(static_cast<int32_t>(cfg.hystCounts) << 8),
+          offQ8_(static_cast<int32_t>(midCounts) << 8) {
+        const uint32_t maxSamples = cfg.sampleHz / (cfg.minHz > 0 ? cfg.minHz : 1);
+        maxSamples_ = maxSamples < kMaxCycleSamples ? maxSamples : kMaxCycleSamples;
+        minPeriodQ16_ = static_cast<uint32_t>((static_cast<uint64_t>(cfg.sampleHz) << 16) / (cfg.maxHz > 0 ? cfg.maxHz : 1));
+        maxPeriodQ16_ = maxSamples_ << 16;
+    }
+
+    // Блок сирих кодів ADC (0..4095). Кожен завершений період — у stats.
+    void feed(const uint16_t *samples, size_t n, PbMainsStats &stats) {
+        for (size_t i = 0; i < n; i++) {
+            const uint32_t x = samples[i];
+            const int32_t c = static_cast<int32_t>(x << 8) - offQ8_;
+            if (c < -hystQ8_) {
+                armed_ = true;
+            } else if (armed_ && c >= 0 && prevQ8_ < 0) {
+                armed_ = false;
+                crossing(c, stats);
+            }
+            sumX_ += x;
+            sumX2_ += x * x;
+            count_++;
+            prevQ8_ = c;
+            index_++;
+            if (count_ >= maxSamples_) {
+                closeCycle(0, stats);   // перетину немає: напруга без частоти
+                synced_ = false;
+            }
+        }
+    }
+
+    // Розрив потоку (DMA не встиг, семпли втрачено): незавершений період відкидається,
+    // наступний починається з першого перетину після розриву.
+    void resync() {
+        resetCycle();
+        armed_ = false;
+        synced_ = false;
+    }
+
+    uint32_t offsetQ8() const { return static_cast<uint32_t>(offQ8_); }
+
+private:
+    // Перетин між попереднім семплом (prevQ8_ < 0) і поточним (c >= 0).
+    void crossing(int32_t c, PbMainsStats &stats) {
+        const uint32_t rise = static_cast<uint32_t>(c - prevQ8_);
+        const uint32_t frac = static_cast<uint32_t>((static_cast<uint64_t>(-prevQ8_) << 16) / rise);
+        const uint32_t atQ16 = ((index_ - 1) << 16) + frac;
+        if (!synced_) {
+            // Перший перетин: період починається тут, накопичене до нього — не період.
+            synced_ = true;
+            lastQ16_ = atQ16;
+            resetCycle();
+            return;
+        }
+        const uint32_t periodQ16 = atQ16 - lastQ16_;
+        lastQ16_ = atQ16;
+        uint32_t mHz = 0;
+        if (periodQ16 >= minPeriodQ16_ && periodQ16 <= maxPeriodQ16_) {
+            mHz = static_cast<uint32_t>((static_cast<uint64_t>(cfg_.sampleHz) * 1000u << 16) / periodQ16);
+        }
+        closeCycle(mHz, stats);
+    }
+
+    void closeCycle(uint32_t mHz, PbMainsStats &stats) {
+        const uint64_t n = count_;
+        if (n == 0) {
+            return;
+        }
+        // n²·σ² у Q16 -> σ у Q8.
+        const uint64_t varN2 = n * sumX2_ - static_cast<uint64_t>(sumX_) * sumX_;
+        const uint32_t rmsQ8 = pbIsqrt64((varN2 << 16) / (n * n));
+        const uint32_t dV = static_cast<uint32_t>(static_cast<uint64_t>(rmsQ8) * cfg_.uvPerCount / 25600000u);
+        stats.add(dV, mHz);
+        // Центр для перетину нуля — середнє періоду, згладжене (×3/4 старого).
+        const int32_t meanQ8 = static_cast<int32_t>((static_cast<uint64_t>(sumX_) << 8) / n);
+        offQ8_ += (meanQ8 - offQ8_) / 4;
+        resetCycle();
+    }
+
+    void resetCycle() {
+        sumX_ = 0;
+        sumX2_ = 0;
+        count_ = 0;
+    }
+
+    PbMainsConfig cfg_;
+    int32_t hystQ8_;
+    int32_t offQ8_;
+    uint32_t maxSamples_;
+    uint32_t minPeriodQ16_;
+    uint32_t maxPeriodQ16_;
+
+    uint32_t sumX_ = 0;
+    uint64_t sumX2_ = 0;
+    uint32_t count_ = 0;
+    int32_t prevQ8_ = 0;
+    bool armed_ = false;
+    bool synced_ = false;
+    uint32_t index_ = 0;
+    uint32_t lastQ16_ = 0;
+};
+
+// JSON-шаблони: "mains_v" — [min, avg, max (дВ), періодів], "mains_hz" — [min, avg, max (мГц),
+// періодів з частотою].
+#define PB_MAINS_V_JSON "[" PB_SLOT_U32 "," PB_SLOT_U32 "," PB_SLOT_U32 "," PB_SLOT_U32 "]"
+#define PB_MAINS_HZ_JSON PB_MAINS_V_JSON
+
+inline void pbMainsStatsPut(char *vArr, char *hzArr, size_t len, const PbMainsStats &s) {
+    const size_t w = sizeof(PB_SLOT_U32) - 1;
+    if (len < 1 + 4 * (w + 1)) {
+        return;
+    }
+    pbSlotPutUint(vArr + 1, w, s.vMin());
+    pbSlotPutUint(vArr + 1 + (w + 1), w, s.vAvg());
+    pbSlotPutUint(vArr + 1 + 2 * (w + 1), w, s.vMax());
+    pbSlotPutUint(vArr + 1 + 3 * (w + 1), w, s.cycles());
+    pbSlotPutUint(hzArr + 1, w, s.fMin());
+    pbSlotPutUint(hzArr + 1 + (w + 1), w, s.fAvg());
+    pbSlotPutUint(hzArr + 1 + 2 * (w + 1), w, s.fMax());
+    pbSlotPutUint(hzArr + 1 + 3 * (w + 1), w, s.freqCycles());
+}
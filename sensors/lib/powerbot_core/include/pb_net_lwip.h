@@ -0,0 +1,295 @@
+/*
+ * PowerBot: адаптер плати — сокети lwIP: ESP32 EMAC (ETH.h, WT32-ETH01 / ESP32-ETH01) і W5500
+ * через esp_eth (Waveshare, PB_W5500_DRIVER_ESP_ETH).
+ *
+ * PbLwipNet — Net для PbHbMachine / PbUdpBeat, PbLwipDnsNet — для PbDnsResolver,
+ * PbLwipUdpListener — прийом beat-ів сусідів агрегатором (pb_agg.h). Усі
+ * non-blocking: кожна операція лише "питає" стан і повертається. Тип адаптера — параметр
+ * шаблону state machine, тож виклики на гарячому шляху статичні (без virtual).
+ *
+ * Не портабельний (lwIP / Arduino-ESP32): підключається лише з main.cpp плати.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <errno.h>
+#include <lwip/dns.h>
+#include <lwip/sockets.h>
+
+#include "pb_dns_cache.h"
+#include "pb_hb_fsm.h"
+
+// Non-blocking UDP до першого DNS-сервера lwIP (з DHCP); новий сокет — новий локальний порт.
+class PbLwipDnsNet {
+public:
+    long dnsSend(const uint8_t *data, size_t len) {
+        if (fd_ < 0 && !open()) {
+            return -1;
+        }
+        const int n = lwip_send(fd_, data, len, MSG_DONTWAIT);
+        if (n > 0) {
+            return n;
+        }
+        return (n == 0 || errno == EWOULDBLOCK || errno == EAGAIN || errno == ENOMEM) ? 0 : -1;
+    }
+
+    long dnsRecv(uint8_t *buf, size_t cap) {
+        if (fd_ < 0) {
+            return -1;
+        }
+        const int n = lwip_recv(fd_, buf, cap, MSG_DONTWAIT);
+        if (n < 0) {
+            return (errno == EWOULDBLOCK || errno == EAGAIN) ? 0 : -1;
+        }
+        return n;
+    }
+
+    void dnsClose() {
+        if (fd_ >= 0) {
+            lwip_close(fd_);
+            fd_ = -1;
+        }
+    }
+
+private:
+    // connect() на UDP: чужі датаграми (не з DNS-сервера) lwIP відкине сам.
+    bool open() {
+        const ip_addr_t *server = dns_getserver(0);
+        if (server == nullptr || ip_addr_isany(server) || !IP_IS_V4(server)) {
+            return false;
+        }
+        fd_ = lwip_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (fd_ < 0) {
+            return false;
+        }
+        lwip_fcntl(fd_, F_SETFL, lwip_fcntl(fd_, F_GETFL, 0) | O_NONBLOCK);
+        struct sockaddr_in sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons(53);
+        sa.sin_addr.s_addr = ip4_addr_get_u32(ip_2_ip4(server));
+        if (lwip_connect(fd_, reinterpret_cast<struct sockaddr *>(&sa), sizeof(sa)) != 0) {
+            dnsClose();
+            return false;
+        }
+        return true;
+    }
+
+    int fd_ = -1;
+};
+
+// Non-blocking TCP поверх lwIP для PbHbMachine: WiFiClient::connect() і hostByName()
+// блокують loop() до таймауту, тут кожна операція лише "питає" стан і повертається.
+class PbLwipNet {
+public:
+    explicit PbLwipNet(PbDnsResolver<PbLwipDnsNet> &dns) : dns_(dns) {}
+
+    bool isOpen() {
+        if (fd_ < 0) {
+            return false;
+        }
+        uint8_t b;
+        const int n = lwip_recv(fd_, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (n == 0) {
+            return false;  // сервер/traefik закрив сокет (FIN)
+        }
+        return n > 0 || errno == EWOULDBLOCK || errno == EAGAIN;
+    }
+
+    // IP-літерал — як є; інакше адреса з кешу DNS, навіть прострочена (оновлює його net-задача).
+    // Чекаємо на DNS лише тоді, коли адреси ще немає зовсім.
+    int startResolve(const char *host) {
+        if (pbParseIpv4(host, addr_)) {
+            return PB_NET_OK;
+        }
+        if (!dns_.has()) {
+            dns_.kick(millis());
+        }
+        return pollResolve();
+    }
+
+    int pollResolve() {
+        if (!dns_.has()) {
+            return PB_NET_PENDING;   // таймаут resolve — у PbHbMachine
+        }
+        addr_ = dns_.addr();
+        return PB_NET_OK;
+    }
+
+    int startConnect(uint16_t port) {
+        close();
+        fd_ = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (fd_ < 0) {
+            return PB_NET_FAIL;
+        }
+        lwip_fcntl(fd_, F_SETFL, lwip_fcntl(fd_, F_GETFL, 0) | O_NONBLOCK);
+
+        struct sockaddr_in sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons(port);
+        sa.sin_addr.s_addr = addr_;
+        if (lwip_connect(fd_, reinterpret_cast<struct sockaddr *>(&sa), sizeof(sa)) == 0) {
+            return PB_NET_OK;
+        }
+        if (errno == EINPROGRESS) {
+            return PB_NET_PENDING;
+        }
+        close();
+        return PB_NET_FAIL;
+    }
+
+    int pollConnect() {
+        if (fd_ < 0) {
+            return PB_NET_FAIL;
+        }
+        fd_set wfds;
+        FD_ZERO(&wfds);
+        FD_SET(fd_, &wfds);
+        struct timeval tv = {0, 0};
+        const int r = lwip_select(fd_ + 1, nullptr, &wfds, nullptr, &tv);
+        if (r == 0) {
+            return PB_NET_PENDING;
+        }
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (r < 0 || lwip_getsockopt(fd_, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+            close();
+            return PB_NET_FAIL;
+        }
+        return PB_NET_OK;
+    }
+
+    long write(const uint8_t *data, size_t len) {
+        const int n = lwip_send(fd_, data, len, MSG_DONTWAIT);
+        if (n >= 0) {
+            return n;
+        }
+        return (errno == EWOULDBLOCK || errno == EAGAIN) ? 0 : -1;
+    }
+
+    long read(uint8_t *buf, size_t cap) {
+        const int n = lwip_recv(fd_, buf, cap, MSG_DONTWAIT);
+        if (n > 0) {
+            return n;
+        }
+        if (n < 0 && (errno == EWOULDBLOCK || errno == EAGAIN)) {
+            return 0;
+        }
+        return -1;
+    }
+
+    // UDP-транспорт (PbUdpBeat): окремий datagram-сокет, адреса — з того ж resolve.
+    long sendDatagram(const uint8_t *data, size_t len, uint16_t port) {
+        if (udpFd_ < 0) {
+            udpFd_ = lwip_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+            if (udpFd_ < 0) {
+                return -1;
+            }
+            lwip_fcntl(udpFd_, F_SETFL, lwip_fcntl(udpFd_, F_GETFL, 0) | O_NONBLOCK);
+        }
+        struct sockaddr_in sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons(port);
+        sa.sin_addr.s_addr = addr_;
+        const int n = lwip_sendto(udpFd_, data, len, 0, reinterpret_cast<struct sockaddr *>(&sa), sizeof(sa));
+        if (n > 0) {
+            return n;
+        }
+        return (n == 0 || errno == EWOULDBLOCK || errno == EAGAIN || errno == ENOMEM) ? 0 : -1;
+    }
+
+    long recvDatagram(uint8_t *buf, size_t cap) {
+        if (udpFd_ < 0) {
+            return -1;
+        }
+        struct sockaddr_in from;
+        socklen_t fromLen = sizeof(from);
+        const int n = lwip_recvfrom(udpFd_, buf, cap, MSG_DONTWAIT,
+                                    reinterpret_cast<struct sockaddr *>(&from), &fromLen);
+        if (n < 0) {
+            return (errno == EWOULDBLOCK || errno == EAGAIN) ? 0 : -1;
+        }
+        // Датаграми не від сервера (або порожні) просто пропускаємо.
+        return (n > 0 && from.sin_addr.s_addr == addr_) ? n : 0;
+    }
+
+    void closeDatagram() {
+        if (udpFd_ >= 0) {
+            lwip_close(udpFd_);
+            udpFd_ = -1;
+        }
+    }
+
+    void close() {
+        if (fd_ >= 0) {
+            lwip_close(fd_);
+            fd_ = -1;
+        }
+    }
+
+private:
+    PbDnsResolver<PbLwipDnsNet> &dns_;
+    int fd_ = -1;
+    int udpFd_ = -1;
+    uint32_t addr_ = 0;     // network byte order
+};
+
+// Агрегатор будинку (pb_agg.h): UDP-сокет на PB_AGG_UDP_PORT, відповідь — туди, звідки прийшло.
+class PbLwipUdpListener {
+public:
+    bool listen(uint16_t port) {
+        if (fd_ >= 0) {
+            return true;
+        }
+        fd_ = lwip_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (fd_ < 0) {
+            return false;
+        }
+        lwip_fcntl(fd_, F_SETFL, lwip_fcntl(fd_, F_GETFL, 0) | O_NONBLOCK);
+        struct sockaddr_in sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons(port);
+        sa.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (lwip_bind(fd_, reinterpret_cast<struct sockaddr *>(&sa), sizeof(sa)) != 0) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // >0 довжина датаграми, 0 = нічого, <0 = помилка сокета.
+    long recvFrom(uint8_t *buf, size_t cap) {
+        if (fd_ < 0) {
+            return -1;
+        }
+        fromLen_ = sizeof(from_);
+        const int n = lwip_recvfrom(fd_, buf, cap, MSG_DONTWAIT, reinterpret_cast<struct sockaddr *>(&from_), &fromLen_);
+        if (n < 0) {
+            return (errno == EWOULDBLOCK || errno == EAGAIN) ? 0 : -1;
+        }
+        return n;
+    }
+
+    // Відповідь відправнику останньої датаграми; втрачений ack сусід переживе як таймаут.
+    void replyTo(const uint8_t *data, size_t len) {
+        if (fd_ >= 0) {
+            lwip_sendto(fd_, data, len, MSG_DONTWAIT, reinterpret_cast<struct sockaddr *>(&from_), fromLen_);
+        }
+    }
+
+    void close() {
+        if (fd_ >= 0) {
+            lwip_close(fd_);
+            fd_ = -1;
+        }
+    }
+
+private:
+    int fd_ = -1;
+    struct sockaddr_in from_;
+    socklen_t fromLen_ = 0;
+};
@@ -0,0 +1,233 @@
+/*
+ * PowerBot: адаптер плати — W5500 по SPI (Ethernet.h, Waveshare ESP32-S3-POE-ETH з
+ * PB_W5500_DRIVER_ARDUINO; за замовчуванням плата на esp_eth + pb_net_lwip.h).
+ *
+ * PbW5500Net — Net для PbHbMachine / PbUdpBeat, PbW5500DnsNet — для PbDnsResolver,
+ * PbW5500UdpListener — прийом beat-ів сусідів агрегатором (pb_agg.h). Тип
+ * адаптера — параметр шаблону state machine, тож виклики на гарячому шляху статичні (без virtual).
+ * Таймаут connect і локальний UDP-порт — HTTP_TIMEOUT_MS і PB_UDP_LOCAL_PORT з config.h плати.
+ *
+ * Не портабельний (Arduino-ESP32 + Ethernet): підключається лише з main.cpp плати, після config.h.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Ethernet.h>
+
+#include "pb_dns_cache.h"
+#include "pb_hb_fsm.h"
+#include "pb_log.h"
+
+// UDP до DNS-сервера з DHCP через EthernetUDP: на відміну від DNSClient::getHostByName()
+// нічого не чекає. Кожен запит — з нового випадкового локального порту.
+class PbW5500DnsNet {
+public:
+    long dnsSend(const uint8_t *data, size_t len) {
+        server_ = Ethernet.dnsServerIP();
+        if (static_cast<uint32_t>(server_) == 0) {
+            return -1;
+        }
+        if (!open_) {
+            open_ = udp_.begin(static_cast<uint16_t>(49152 + esp_random() % 16384)) == 1;
+            if (!open_) {
+                return -1;
+            }
+        }
+        if (udp_.beginPacket(server_, 53) != 1) {
+            return -1;
+        }
+        udp_.write(data, len);
+        return udp_.endPacket() == 1 ? static_cast<long>(len) : -1;
+    }
+
+    long dnsRecv(uint8_t *buf, size_t cap) {
+        if (!open_) {
+            return -1;
+        }
+        if (udp_.parsePacket() <= 0) {
+            return 0;
+        }
+        if (udp_.remoteIP() != server_) {
+            udp_.flush();
+            return 0;
+        }
+        const int n = udp_.read(buf, cap);
+        return n > 0 ? n : 0;
+    }
+
+    void dnsClose() {
+        if (open_) {
+            udp_.stop();
+            open_ = false;
+        }
+    }
+
+private:
+    EthernetUDP udp_;
+    IPAddress server_;
+    bool open_ = false;
+};
+
+// Адаптер EthernetClient (W5500) для PbHbMachine.
+// Write / read / стан сокета — non-blocking (W5500 тримає буфери і TCP-стан сам).
+// connect() Ethernet-бібліотека робить лише блокуюче (socketConnect() тощо приватні),
+// тож він обмежений setConnectionTimeout(HTTP_TIMEOUT_MS).
+class PbW5500Net {
+public:
+    explicit PbW5500Net(PbDnsResolver<PbW5500DnsNet> &dns) : dns_(dns) {}
+
+    bool isOpen() { return open_ && client_.connected(); }
+
+    // IP-літерал — як є; інакше адреса з кешу DNS, навіть прострочена (оновлює його net-задача).
+    // Чекаємо на DNS лише тоді, коли адреси ще немає зовсім.
+    int startResolve(const char *host) {
+        uint32_t literal;
+        if (pbParseIpv4(host, literal)) {
+            addr_ = IPAddress(literal);
+            PB_LOGD(HbParsedIp, addr_[0], addr_[1], addr_[2], addr_[3]);
+            return PB_NET_OK;
+        }
+        if (!dns_.has()) {
+            dns_.kick(millis());
+        }
+        return pollResolve();
+    }
+
+    int pollResolve() {
+        if (!dns_.has()) {
+            return PB_NET_PENDING;   // таймаут resolve — у PbHbMachine
+        }
+        addr_ = IPAddress(dns_.addr());
+        return PB_NET_OK;
+    }
+
+    int startConnect(uint16_t port) {
+        close();
+        client_.setConnectionTimeout(HTTP_TIMEOUT_MS);
+        open_ = client_.connect(addr_, port) == 1;
+        return open_ ? PB_NET_OK : PB_NET_FAIL;
+    }
+
+    int pollConnect() { return PB_NET_FAIL; }  // startConnect() завжди дає кінцевий результат
+
+    long write(const uint8_t *data, size_t len) {
+        if (!client_.connected()) {
+            return -1;
+        }
+        const size_t n = client_.write(data, len);
+        return n > 0 ? static_cast<long>(n) : -1;
+    }
+
+    long read(uint8_t *buf, size_t cap) {
+        const int avail = client_.available();
+        if (avail > 0) {
+            const size_t want = static_cast<size_t>(avail) < cap ? static_cast<size_t>(avail) : cap;
+            const int n = client_.read(buf, want);
+            return n > 0 ? n : 0;
+        }
+        return client_.connected() ? 0 : -1;
+    }
+
+    // UDP-транспорт (PbUdpBeat): EthernetUDP на PB_UDP_LOCAL_PORT, адреса — з того ж resolve.
+    long sendDatagram(const uint8_t *data, size_t len, uint16_t port) {
+        if (!udpOpen_) {
+            udpOpen_ = udp_.begin(PB_UDP_LOCAL_PORT) == 1;
+            if (!udpOpen_) {
+                return -1;
+            }
+        }
+        if (udp_.beginPacket(addr_, port) != 1) {
+            return -1;
+        }
+        udp_.write(data, len);
+        return udp_.endPacket() == 1 ? static_cast<long>(len) : -1;
+    }
+
+    long recvDatagram(uint8_t *buf, size_t cap) {
+        if (!udpOpen_) {
+            return -1;
+        }
+        if (udp_.parsePacket() <= 0) {
+            return 0;
+        }
+        if (udp_.remoteIP() != addr_) {
+            udp_.flush();
+            return 0;
+        }
+        const int n = udp_.read(buf, cap);
+        return n > 0 ? n : 0;
+    }
+
+    void closeDatagram() {
+        if (udpOpen_) {
+            udp_.stop();
+            udpOpen_ = false;
+        }
+    }
+
+    void close() {
+        if (open_) {
+            client_.stop();
+            open_ = false;
+        }
+    }
+
+private:
+    PbDnsResolver<PbW5500DnsNet> &dns_;
+    EthernetClient client_;
+    IPAddress addr_;
+    bool open_ = false;
+    EthernetUDP udp_;
+    bool udpOpen_ = false;
+};
+
+// Агрегатор будинку (pb_agg.h): EthernetUDP на PB_AGG_UDP_PORT (окремий сокет W5500).
+class PbW5500UdpListener {
+public:
+    bool listen(uint16_t port) {
+        if (!open_) {
+            open_ = udp_.begin(port) == 1;
+        }
+        return open_;
+    }
+
+    // >0 довжина датаграми, 0 = нічого, <0 = сокет не відкрито.
+    long recvFrom(uint8_t *buf, size_t cap) {
+        if (!open_) {
+            return -1;
+        }
+        const int size = udp_.parsePacket();
+        if (size <= 0) {
+            return 0;
+        }
+        if (static_cast<size_t>(size) > cap) {
+            udp_.flush();   // не наш beat: frame і JSON сусіда значно менші
+            return 0;
+        }
+        from_ = udp_.remoteIP();
+        fromPort_ = udp_.remotePort();
+        const int n = udp_.read(buf, cap);
+        return n > 0 ? n : 0;
+    }
+
+    void replyTo(const uint8_t *data, size_t len) {
+        if (open_ && udp_.beginPacket(from_, fromPort_) == 1) {
+            udp_.write(data, len);
+            udp_.endPacket();
+        }
+    }
+
+    void close() {
+        if (open_) {
+            udp_.stop();
+            open_ = false;
+        }
+    }
+
+private:
+    EthernetUDP udp_;
+    bool open_ = false;
+    IPAddress from_;
+    uint16_t fromPort_ = 0;
+};
@@ -0,0 +1,67 @@
+/*
+ * PowerBot: детектор просідання живлення для last-gasp повідомлення.
+ *
+ * Прошивка семплює напругу живлення (ADC через дільник) або brownout/power-good
+ * GPIO і годує семпли в PbPowerWatch::feed(). Коли напруга тримається нижче
+ * lostBelowMv confirmSamples семплів поспіль — подія Lost (прошивка одразу шле
+ * "power_lost", поки конденсатори / PoE hold-up ще тримають плату). Повернення
+ * вище restoredAboveMv (гістерезис) так само підтверджене — подія Restored.
+ *
+ * Header портабельний (без Arduino.h) — перевіряється на хості (test/test_power_watch).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+enum class PbPowerEvent : uint8_t {
+    None,
+    Lost,
+    Restored,
+};
+
+struct PbPowerWatchConfig {
+    uint16_t lostBelowMv;      // нижче — живлення пропадає
+    uint16_t restoredAboveMv;  // вище — живлення повернулось (має бути > lostBelowMv)
+    uint8_t confirmSamples;    // антидребезг: стільки семплів поспіль по той бік порогу
+};
+
+class PbPowerWatch {
+public:
+    explicit PbPowerWatch(const PbPowerWatchConfig &cfg) : cfg_(cfg) {}
+
+    // Один семпл напруги живлення (мВ, вже з урахуванням дільника).
+    PbPowerEvent feed(uint16_t supplyMv) {
+        const bool crossing = lost_ ? supplyMv >= cfg_.restoredAboveMv : supplyMv < cfg_.lostBelowMv;
+        if (!crossing) {
+            streak_ = 0;
+            return PbPowerEvent::None;
+        }
+        if (++streak_ < confirmSamples()) {
+            return PbPowerEvent::None;
+        }
+        streak_ = 0;
+        lost_ = !lost_;
+        return lost_ ? PbPowerEvent::Lost : PbPowerEvent::Restored;
+    }
+
+    // Brownout / power-good вхід: true = живлення в нормі.
+    PbPowerEvent feedLevel(bool supplyOk) {
+        return feed(supplyOk ? cfg_.restoredAboveMv : 0);
+    }
+
+    bool lost() const { return lost_; }
+
+private:
+    uint8_t confirmSamples() const { return cfg_.confirmSamples > 0 ? cfg_.confirmSamples : 1; }
+
+    PbPowerWatchConfig cfg_;
+    bool lost_ = false;
+    uint8_t streak_ = 0;
+};
+
+// Напруга живлення з показу ADC (мВ на піні) і дільника (коефіцієнт ×1000, 2:1 = 2000).
+inline uint16_t pbPowerSupplyMv(uint32_t pinMv, uint32_t dividerX1000) {
+    const uint32_t mv = pinMv * dividerX1000 / 1000u;
+    return mv > 0xFFFFu ? 0xFFFFu : static_cast<uint16_t>(mv);
+}
@@ -0,0 +1,1727 @@
+/*
+ * PowerBot: спільна прошивка heartbeat-сенсора — все, крім Ethernet плати.
+ *
+ * Задачі FreeRTOS (net / led / log / loop), розклад beat, сон між beat-ами, кеш DNS,
+ * heartbeat (HTTP / UDP, JSON / frame), офлайн-журнал, last-gasp, входи кількох секцій
+ * і setup() / loop().
+ *
+ * Підключається рівно один раз — з main.cpp плати, після config.h і адаптера мережі
+ * (pb_net_lwip.h / pb_net_w5500.h). Перед ним плата задає типи адаптерів:
+ *   typedef PbLwipDnsNet PbBoardDnsNet;
+ *   typedef PbLwipNet PbBoardNet;
+ *   typedef PbLwipUdpListener PbBoardUdpListener;   // лише для PB_ROLE_AGGREGATOR (pb_agg.h)
+ * а після нього визначає хуки pbBoard*() (Ethernet, лінк, банер). Тип адаптера — параметр
+ * шаблонів, тож на гарячому шляху немає virtual. Визначення тут не inline: друге
+ * підключення (в інший .cpp) дасть помилку лінковки setup() / loop(), а не тиху копію стану.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_pm.h>
+#include <esp_timer.h>
+#include <Preferences.h>
+
+#include "pb_dns_cache.h"
+#include "pb_hb_fsm.h"
+#include "pb_hb_body.h"
+#include "pb_hb_frame.h"
+#include "pb_hb_latency.h"
+#include "pb_beat_journal.h"
+#include "pb_beat_schedule.h"
+#include "pb_sleep_plan.h"
+#include "pb_log.h"
+#include "pb_task_stats.h"
+#include "pb_udp_beat.h"
+#include "pb_power_watch.h"
+#include "pb_agg.h"
+#include "pb_inputs.h"
+#include "pb_mains.h"
+
+#if PB_MAINS
+#if ESP_IDF_VERSION_MAJOR >= 5
+#include <esp_adc/adc_continuous.h>
+#else
+#include <driver/adc.h>
+#endif
+#endif
+
+// ─── Задачі FreeRTOS ───
+// net (ядро PB_NET_TASK_CORE) — лінк, живлення, heartbeat і last-gasp; led — індикація;
+// log — дренер pb_log; mains — блоки ADC DMA (PB_MAINS); loop() — супервізор зі статистикою задач. Стан між задачами —
+// event group і черга, а не глобальні прапорці.
+static EventGroupHandle_t pbNetEvents = nullptr;
+static const EventBits_t kPbEvEthUp = 1u << 0;     // є лінк і IP
+static const EventBits_t kPbEvBeatNow = 1u << 1;   // позачерговий beat (живлення повернулось, фронт входу)
+static const EventBits_t kPbEvBeatDue = 1u << 2;   // дедлайн розкладу (pbBeatTimer)
+
+// Розклад beat за абсолютними дедлайнами (pb_beat_schedule.h); веде лише net-задача,
+// esp_timer лише будить її на дедлайн.
+static PbBeatSchedule pbBeatSchedule;
+static esp_timer_handle_t pbBeatTimer = nullptr;
+
+// Патерн блимання для задачі led (черга pbLedQueue).
+struct PbLedBlink {
+    uint8_t times;
+    uint16_t ms;
+};
+static QueueHandle_t pbLedQueue = nullptr;
+
+static PbTaskLoad pbNetLoad("net");
+static PbTaskLoad pbLedLoad("led");
+static PbTaskLoad pbLogLoad("log");
+static PbTaskLoad pbLoopLoad("loop");
+static TaskHandle_t pbNetTaskHandle = nullptr;
+static TaskHandle_t pbLedTaskHandle = nullptr;
+static TaskHandle_t pbLogTaskHandle = nullptr;
+static TaskHandle_t pbLoopTaskHandle = nullptr;
+
+static bool pbEthUp() {
+    return (xEventGroupGetBits(pbNetEvents) & kPbEvEthUp) != 0;
+}
+
+// Перший успішний beat після старту йде з event="boot".
+bool pbBootAnnounced = false;
+
+// Порядковий номер beat з моменту boot: сервер рахує по ньому втрачені heartbeat.
+uint32_t pbHbSeq = 0;
+
+// Агрегатор будинку (pb_agg.h): власний beat і beat-и сусідів — одним HTTP-пакетом.
+#if PB_ROLE == PB_ROLE_AGGREGATOR
+#define PB_AGG 1
+static_assert(PB_TRANSPORT != PB_TRANSPORT_UDP, "PB_ROLE_AGGREGATOR: лише PB_TRANSPORT_HTTP");
+static_assert(PB_POWER_SAVE != 2, "PB_ROLE_AGGREGATOR: без light-sleep — сокет сусідів опитується постійно");
+#else
+#define PB_AGG 0
+#endif
+
+// Входи кількох секцій (pb_inputs.h): маску веде ISR апаратного таймера, net-задача лише читає.
+#if PB_INPUTS > 0
+static_assert(PB_INPUTS <= 16, "PB_INPUTS: не більше 16 входів");
+static_assert(PB_POWER_SAVE == 0, "PB_INPUTS: таймер семплів тактується від APB — без DFS / light-sleep");
+// DRAM_ATTR: ISR читає таблицю і тоді, коли кеш flash вимкнено (запис NVS).
+static const DRAM_ATTR uint8_t kPbInputPins[] = {PB_INPUT_PINS};
+static const uint8_t kPbInputSections[] = {PB_INPUT_SECTIONS};
+static_assert(sizeof(kPbInputPins) == PB_INPUTS && sizeof(kPbInputSections) == PB_INPUTS,
+              "PB_INPUT_PINS / PB_INPUT_SECTIONS: по PB_INPUTS значень");
+static PbInputDebouncer<PB_INPUTS> pbInputs(
+    PbInputsConfig{PB_INPUT_ON_SAMPLES, PB_INPUT_OFF_MS * 1000u / PB_INPUT_SAMPLE_US});
+static volatile uint16_t pbInputMask = 0;
+static uint16_t pbInputMaskLogged = 0;
+static hw_timer_t *pbInputTimer = nullptr;
+#endif
+
+// Якість мережі (pb_mains.h): ADC у DMA-режимі, блоки рахує задача mains, net-задача лише
+// забирає підсумок під pbMainsMux.
+#if PB_MAINS
+static_assert(PB_POWER_SAVE == 0, "PB_MAINS: ADC DMA тактується від APB — без DFS / light-sleep");
+static_assert(PB_POWER_SENSE_MODE != 1, "PB_MAINS: ADC1 зайнятий DMA — last-gasp лише PB_POWER_SENSE_MODE=2");
+static_assert(PB_MAINS_SAMPLE_HZ / PB_MAINS_MIN_HZ <= PbMainsMeter::kMaxCycleSamples,
+              "PB_MAINS_SAMPLE_HZ / PB_MAINS_MIN_HZ: період не довший за 4095 семплів");
+static PbMainsMeter pbMains(PbMainsConfig{PB_MAINS_SAMPLE_HZ, PB_MAINS_UV_PER_COUNT, PB_MAINS_HYST_COUNTS,
+                                          PB_MAINS_MIN_HZ, PB_MAINS_MAX_HZ});
+static portMUX_TYPE pbMainsMux = portMUX_INITIALIZER_UNLOCKED;
+static PbMainsStats pbMainsShared;       // під pbMainsMux: періоди, які net ще не забрала
+static uint64_t pbMainsFeedCycles = 0;   // під pbMainsMux: такти CPU і семпли задачі mains з boot
+static uint64_t pbMainsFeedSamples = 0;
+static uint32_t pbMainsGaps = 0;         // під pbMainsMux: розриви потоку (пул DMA переповнився)
+// Net-задача: вікно, яке пішло в JSON beat і ще не доставлене (невдалий beat його не губить).
+static PbMainsStats pbMainsPending;
+static uint64_t pbMainsLoggedCycles = 0;
+static uint64_t pbMainsLoggedSamples = 0;
+static PbTaskLoad pbMainsLoad("mains");
+static TaskHandle_t pbMainsTaskHandle = nullptr;
+
+static const PbMainsStats &pbMainsTake() {
+    portENTER_CRITICAL(&pbMainsMux);
+    pbMainsPending.merge(pbMainsShared);
+    pbMainsShared.clear();
+    portEXIT_CRITICAL(&pbMainsMux);
+    return pbMainsPending;
+}
+#endif
+
+#if PB_HB_FRAME || PB_AGG
+// HMAC midstate ключа рахується один раз при старті; далі beat — 36 байт без JSON.
+static const PbHmacKey pbFrameKey(reinterpret_cast<const uint8_t *>(API_KEY), strlen(API_KEY));
+#endif
+#if PB_HB_FRAME
+static uint8_t pbFrameUuid[PB_FRAME_UUID_HASH_SIZE];
+static bool pbFrameUuidReady = false;
+// JSON — для реєстрації (перший beat) і як fallback, якщо сервер відхилив frame.
+static bool pbHbSendJson = true;
+static bool pbHbFrameInFlight = false;
+#endif
+
+// Uptime у секундах для frame, JSON beat і журналу: з 64-бітного esp_timer, а не millis() —
+// той переповнюється через ~49.7 доби, і uptime/вік записів журналу стрибнули б назад.
+static uint32_t pbUptimeS() {
+    return static_cast<uint32_t>(esp_timer_get_time() / 1000000);
+}
+
+// Лічильник завантажень (NVS): +1 раз на boot, іде у frame і JSON beat. Приймач бере frame,
+// лише новіший за (boot_count, seq), тож перехоплений frame минулого boot не повторити.
+static uint32_t pbBootCount = 0;
+static bool pbBootCountReady = false;
+
+static uint32_t pbBootCountGet() {
+    if (pbBootCountReady) {
+        return pbBootCount;
+    }
+    pbBootCountReady = true;
+    Preferences prefs;
+    if (!prefs.begin("pb_boot", false)) {
+        return pbBootCount;
+    }
+    uint32_t n = 0;
+    if (prefs.getBytesLength("n") == sizeof(n)) {
+        prefs.getBytes("n", &n, sizeof(n));
+    }
+    pbBootCount = n + 1;
+    prefs.putBytes("n", &pbBootCount, sizeof(pbBootCount));
+    prefs.end();
+    return pbBootCount;
+}
+
+// Пауза net-задачі без запиту в польоті; з last-gasp — частіше, щоб семплювати живлення.
+// З light-sleep — рідше: beat і так будить таймер, а кожне пробудження коштує струму.
+#if PB_POWER_SENSE_MODE != 0
+#define PB_LOOP_IDLE_MS PB_POWER_SAMPLE_MS
+#elif PB_POWER_SAVE == 2
+#define PB_LOOP_IDLE_MS 1000
+#else
+#define PB_LOOP_IDLE_MS 100
+#endif
+
+// Сон net-задачі між beat-ами (pb_sleep_plan.h); веде лише net-задача. Колбек таймера
+// лише міряє свою затримку від алярму — з неї guard перед дедлайном.
+static PbSleepPlanner pbSleep(PB_LOOP_IDLE_MS, PB_PM_MAX_GUARD_US);
+static const uint32_t kPbNoWake = UINT32_MAX;
+static std::atomic<uint32_t> pbBeatAlarmUs{0};
+static std::atomic<uint32_t> pbBeatWakeUs{kPbNoWake};
+static bool pbAwakeHeld = false;
+#if PB_POWER_SAVE
+static esp_pm_lock_handle_t pbAwakeLock = nullptr;
+#endif
+
+// ─── Відкладений лог heartbeat-шляху (pb_log.h) ───
+// net-задача (єдиний producer) лише кладе запис у ring; текст у Serial пише задача pb_log
+// з найнижчим пріоритетом.
+#if !PB_LOG_DIRECT
+static PbLogRing<PB_LOG_RING_BYTES> pbLogRing;
+#endif
+
+static void pbLogEmit(const uint8_t *rec, size_t len) {
+#if PB_LOG_BINARY
+    Serial.write(kPbLogSync);
+    Serial.write(rec, len);
+#else
+    char line[kPbLogMaxLine];
+    const size_t n = pbLogRender(rec, len, line, sizeof(line));
+    Serial.write(reinterpret_cast<const uint8_t *>(line), n);
+    Serial.println();
+#endif
+}
+
+void pbLogPush(const uint8_t *rec, size_t len) {
+#if PB_LOG_DIRECT
+    pbLogEmit(rec, len);   // як до pb_log: синхронно, для порівняння "⏱ beat"
+#else
+    pbLogRing.push(rec, len);
+#endif
+}
+
+static uint32_t pbLogDropped() {
+#if PB_LOG_DIRECT
+    return 0;
+#else
+    return pbLogRing.dropped();
+#endif
+}
+
+#if !PB_LOG_DIRECT
+static void pbLogDrainTask(void *) {
+    uint8_t rec[kPbLogMaxRecord];
+    uint32_t reported = 0;
+    for (;;) {
+        pbLogLoad.begin(micros());
+        size_t n;
+        while ((n = pbLogRing.pop(rec, sizeof(rec))) > 0) {
+            pbLogEmit(rec, n);
+        }
+        const uint32_t dropped = pbLogRing.dropped();
+        if (dropped != reported) {
+            PbLogRecord r(PB_LOG_LEVEL_WARN, PbLogId::LogDropped);
+            r.add(dropped - reported);
+            pbLogEmit(r.finish(), r.size());
+            reported = dropped;
+        }
+        pbLogLoad.end(micros());
+        vTaskDelay(pdMS_TO_TICKS(PB_LOG_DRAIN_MS));
+    }
+}
+#endif
+
+static void pbLogBegin() {
+#if !PB_LOG_DIRECT
+    xTaskCreate(pbLogDrainTask, "pb_log", 4096, nullptr, tskIDLE_PRIORITY, &pbLogTaskHandle);
+#endif
+}
+
+// Прототипи функцій
+bool startHeartbeat();
+void pollHeartbeat();
+bool heartbeatInFlight();
+void setupDnsCache();
+void pollDns();
+bool dnsInFlight();
+void abortHeartbeat();
+void reportHeartbeatResult(bool ok);
+void flushBeatJournal();
+void journalMissedSlot();
+void journalPowerLost();
+void setupPowerWatch();
+void pollPowerWatch();
+bool powerLost();
+void setupInputs();
+void pollInputs();
+void setupMains();
+void mainsWindowDelivered();
+void blinkLED(int times, int delayMs);
+void setupTasks();
+void reportTasks();
+void pollAggregator();
+
+// Хуки плати: визначає main.cpp плати після цього заголовка.
+void pbBoardBanner();          // рядки банера про плату / Ethernet
+void pbBoardSetupEthernet();   // підняти Ethernet і дочекатися DHCP (kPbEvEthUp)
+bool pbBoardNetReady();        // net-задача: лінк і IP є; веде kPbEvEthUp
+bool pbBoardLinkUp();
+IPAddress pbBoardLocalIp();
+IPAddress pbBoardGatewayIp();
+void pbBoardBeatDelivered();   // після кожного доставленого beat
+
+void setup() {
+    Serial.begin(115200);
+    pbNetEvents = xEventGroupCreate();
+    pbLedQueue = xQueueCreate(4, sizeof(PbLedBlink));
+    pbLogBegin();
+    delay(2000);
+
+    Serial.println();
+    Serial.println("================================================");
+    pbBoardBanner();
+    Serial.printf("  Building: %s (ID: %d)\n", BUILDING_NAME, BUILDING_ID);
+    Serial.printf("  Section:  %d\n", SECTION_ID);
+    Serial.printf("  Sensor:   %s\n", SENSOR_UUID);
+    Serial.printf("  Server:   %s:%d\n", SERVER_HOST, SERVER_PORT);
+#if PB_AGG
+    Serial.printf("  Aggregator: UDP %d, до %d сусідів\n", PB_AGG_UDP_PORT, PB_AGG_PEERS);
+#endif
+#if PB_INPUTS > 0
+    Serial.printf("  Inputs:   %d -> секції %s\n", PB_INPUTS, PB_STRV(PB_INPUT_SECTIONS));
+#endif
+#if PB_MAINS
+    Serial.printf("  Mains:    GPIO%d, %d Гц\n", PB_MAINS_PIN, PB_MAINS_SAMPLE_HZ);
+#endif
+    Serial.println("================================================");
+    Serial.println();
+
+#if defined(LED_PIN) && (LED_PIN >= 0)
+    pinMode(LED_PIN, OUTPUT);
+    digitalWrite(LED_PIN, LOW);
+#endif
+
+    setupPowerWatch();
+    setupInputs();
+    setupMains();
+    setupDnsCache();
+    pbBoardSetupEthernet();
+    setupTasks();
+}
+
+// loop() — супервізор: мережа й індикація живуть у своїх задачах (setupTasks()).
+void loop() {
+    pbLoopLoad.begin(micros());
+    reportTasks();
+    pbLoopLoad.end(micros());
+    delay(PB_TASK_STATS_MS > 0 ? PB_TASK_STATS_MS : 1000);
+}
+
+static void pbBeatTimerFired(void *) {
+    const uint32_t nowUs = static_cast<uint32_t>(esp_timer_get_time());
+    pbBeatWakeUs.store(nowUs - pbBeatAlarmUs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    xEventGroupSetBits(pbNetEvents, kPbEvBeatDue);
+}
+
+// Таймер на наступний дедлайн розкладу (один раз, перевзводиться після кожного beat).
+// Будить на guard раніше: решту net-задача дочекає без сну і стартує точно в дедлайн.
+static void pbBeatArm(uint64_t nowUs) {
+    esp_timer_stop(pbBeatTimer);   // ще не спрацював — зупиняємо, інакше start_once відмовить
+    const uint64_t wake = pbSleep.wakeAt(pbBeatSchedule.next());
+    const uint64_t afterUs = wake > nowUs ? wake - nowUs : 1;
+    pbBeatAlarmUs.store(static_cast<uint32_t>(nowUs + afterUs), std::memory_order_relaxed);
+    esp_timer_start_once(pbBeatTimer, afterUs);
+}
+
+// Lock "pb_beat" (CPU на максимумі, без light-sleep) — поки beat у польоті і у вікні guard.
+static void pbAwake(uint64_t nowUs, bool awake) {
+    pbSleep.account(nowUs, awake);
+    if (awake == pbAwakeHeld) {
+        return;
+    }
+    pbAwakeHeld = awake;
+#if PB_POWER_SAVE
+    if (pbAwakeLock != nullptr) {
+        if (awake) {
+            esp_pm_lock_acquire(pbAwakeLock);
+        } else {
+            esp_pm_lock_release(pbAwakeLock);
+        }
+    }
+#endif
+}
+
+// До наступного дедлайну, секунди (округлено).
+static int32_t pbBeatNextSec() {
+    const uint64_t nowUs = esp_timer_get_time();
+    const uint64_t next = pbBeatSchedule.next();
+    return next > nowUs ? static_cast<int32_t>((next - nowUs + 500000) / 1000000) : 0;
+}
+
+// Інструкція сервера X-PB-Interval-Ms (0 — не було): новий період розкладу в межах
+// PB_HB_INTERVAL_MIN_MS..PB_HB_INTERVAL_MAX_MS, таймер перевзводиться на новий дедлайн.
+static void applyServerPeriod(uint32_t ms) {
+    if (ms == 0) {
+        return;
+    }
+    ms = ms < PB_HB_INTERVAL_MIN_MS ? PB_HB_INTERVAL_MIN_MS : (ms > PB_HB_INTERVAL_MAX_MS ? PB_HB_INTERVAL_MAX_MS : ms);
+    if (static_cast<uint64_t>(ms) * 1000u == pbBeatSchedule.periodUs()) {
+        return;
+    }
+    pbBeatSchedule.setPeriod(ms);
+    pbBeatArm(esp_timer_get_time());
+    PB_LOGI(HbPeriodSet, ms);
+}
+
+// Beat за розкладом стартує: дедлайн іде по сітці, а не від моменту старту.
+static void pbBeatStarted(uint64_t nowUs) {
+    const uint32_t intervalUs = pbBeatSchedule.started(nowUs);
+    if (intervalUs != 0) {
+        PB_LOGI(HbInterval, intervalUs / 1000,
+                static_cast<int32_t>(intervalUs) - static_cast<int32_t>(pbBeatSchedule.periodUs()),
+                pbBeatSchedule.deviation().percentile(95));
+    }
+#if PB_POWER_SAVE
+    PB_LOGI(PmWake, pbSleep.wakeLatency().percentile(95), pbSleep.wakeLatency().max(), pbSleep.guardUs(),
+            pbSleep.awakePermille() / 10, pbSleep.awakePermille() % 10);
+    pbSleep.clearStats();
+#endif
+    pbBeatArm(nowUs);
+}
+
+// Один прохід net-задачі; повертає, скільки спати (мс), якщо нічого не станеться раніше,
+// і чи можна при цьому light-sleep.
+static PbSleepPlan pbNetPoll() {
+    const uint32_t wakeUs = pbBeatWakeUs.exchange(kPbNoWake, std::memory_order_relaxed);
+    if (wakeUs != kPbNoWake) {
+        pbSleep.woke(wakeUs);
+    }
+
+    // Живлення семплюємо завжди; last-gasp шлемо, лише якщо мережа є.
+    pollPowerWatch();
+    pollInputs();
+
+    // Лінк / IP — справа плати; без них запит у польоті вже не живий.
+    if (!pbBoardNetReady()) {
+        abortHeartbeat();
+        journalMissedSlot();
+        return PbSleepPlan{1000, false};
+    }
+
+    // Beat-и сусідів (агрегатор): ack одразу; boot / power_lost сусіда — позачерговий пакет.
+    pollAggregator();
+
+    // Час відправляти heartbeat: дедлайн розкладу або позачерговий beat.
+    const uint64_t nowUs = esp_timer_get_time();
+    const bool scheduled = pbBeatSchedule.due(nowUs);
+    if (!scheduled) {
+        xEventGroupClearBits(pbNetEvents, kPbEvBeatDue);
+    }
+    const bool beatNow = (xEventGroupGetBits(pbNetEvents) & kPbEvBeatNow) != 0;
+    if (!heartbeatInFlight() && !powerLost() && (scheduled || beatNow)) {
+        xEventGroupClearBits(pbNetEvents, kPbEvBeatNow | kPbEvBeatDue);
+        PB_LOGI(HbSend);
+
+        if (scheduled) {
+            pbBeatStarted(nowUs);
+        }
+        if (!startHeartbeat()) {
+            reportHeartbeatResult(false);
+        }
+    }
+
+    // Після відновлення зв'язку — офлайн-журнал одним запитом (між beat-ами).
+    flushBeatJournal();
+
+    // DNS оновлюється між beat-ами; beat, що чекає на першу адресу, отримає її тут же.
+    pollDns();
+
+    // Запит у польоті просуваємо по кроку за прохід, не блокуючи задачу.
+    pollHeartbeat();
+    PbSleepPlan plan = pbSleep.plan(esp_timer_get_time(), pbBeatSchedule.next(),
+                                    heartbeatInFlight() || dnsInFlight(), !powerLost());
+#if PB_AGG
+    if (plan.waitMs > PB_AGG_POLL_MS) {
+        plan.waitMs = PB_AGG_POLL_MS;   // сусід чекає ack не довше PB_UDP_ACK_TIMEOUT_MS
+    }
+#endif
+    return plan;
+}
+
+// Один оберт net-задачі: прохід і сон до наступної події. Хостова симуляція (test/sim)
+// крутить саме його замість задачі.
+static void pbNetTaskStep() {
+    pbNetLoad.begin(micros());
+    const PbSleepPlan plan = pbNetPoll();
+    pbAwake(esp_timer_get_time(), plan.awake);
+    pbNetLoad.end(micros());
+    if (heartbeatInFlight() || dnsInFlight() || powerLost()) {
+        // delay(1) віддає CPU idle task (watchdog), поки чекаємо мережу.
+        delay(plan.waitMs);
+    } else {
+        // Дедлайн beat / позачерговий beat / поява мережі будять задачу раніше.
+        xEventGroupWaitBits(pbNetEvents, pbEthUp() ? (kPbEvBeatDue | kPbEvBeatNow) : kPbEvEthUp, pdFALSE,
+                            pdFALSE, pdMS_TO_TICKS(plan.waitMs));
+    }
+}
+
+static void pbNetTaskLoop(void *) {
+    for (;;) {
+        pbNetTaskStep();
+    }
+}
+
+#if defined(LED_PIN) && (LED_PIN >= 0)
+static void pbLedDelay(int ms) {
+    pbLedLoad.end(micros());
+    delay(ms);
+    pbLedLoad.begin(micros());
+}
+
+// Блимання з черги; без мережі — повільне (500 мс) раз на ~1.5 с.
+static void pbLedTaskLoop(void *) {
+    PbLedBlink b;
+    for (;;) {
+        if (xQueueReceive(pbLedQueue, &b, pdMS_TO_TICKS(1000)) != pdTRUE) {
+            if (pbEthUp()) {
+                continue;
+            }
+            b.times = 1;
+            b.ms = 500;
+        }
+        pbLedLoad.begin(micros());
+        for (uint8_t i = 0; i < b.times; i++) {
+            digitalWrite(LED_PIN, HIGH);
+            pbLedDelay(b.ms);
+            digitalWrite(LED_PIN, LOW);
+            if (i + 1 < b.times) {
+                pbLedDelay(b.ms);
+            }
+        }
+        pbLedLoad.end(micros());
+    }
+}
+#endif
+
+// DFS / automatic light-sleep (PB_POWER_SAVE). Без CONFIG_PM_ENABLE у sdkconfig esp_pm_configure()
+// відмовить — тоді працюємо на повній частоті, як з PB_POWER_SAVE=0.
+static void setupPowerSave() {
+#if PB_POWER_SAVE
+#if ESP_IDF_VERSION_MAJOR >= 5
+    esp_pm_config_t pm = {};
+#elif CONFIG_IDF_TARGET_ESP32S3
+    esp_pm_config_esp32s3_t pm = {};
+#else
+    esp_pm_config_esp32_t pm = {};
+#endif
+    pm.max_freq_mhz = PB_PM_MAX_MHZ;
+    pm.min_freq_mhz = PB_PM_MIN_MHZ;
+    pm.light_sleep_enable = PB_POWER_SAVE == 2;
+    const esp_err_t err = esp_pm_configure(&pm);
+    if (err != ESP_OK) {
+        Serial.printf("⚠️ esp_pm: %s — енергозбереження вимкнено\n", esp_err_to_name(err));
+        return;
+    }
+    esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "pb_beat", &pbAwakeLock);
+    Serial.printf("💤 Енергозбереження: CPU %d..%d МГц%s\n", PB_PM_MIN_MHZ, PB_PM_MAX_MHZ,
+                  PB_POWER_SAVE == 2 ? ", light-sleep між beat-ами" : "");
+#endif
+}
+
+void setupTasks() {
+    const uint32_t now = micros();
+    pbNetLoad.sample(now);
+    pbLedLoad.sample(now);
+    pbLogLoad.sample(now);
+    pbLoopLoad.sample(now);
+#if PB_MAINS
+    pbMainsLoad.sample(now);
+#endif
+    pbLoopTaskHandle = xTaskGetCurrentTaskHandle();
+    setupPowerSave();
+
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = pbBeatTimerFired;
+    timerArgs.name = "pb_beat";
+    esp_timer_create(&timerArgs, &pbBeatTimer);
+    // Перший beat — одразу (сигнал відновлення живлення), далі сітка зі зсувом з SENSOR_UUID.
+    const uint32_t phaseMs = pbBeatPhaseMs(SENSOR_UUID, PB_HB_PHASE_SPREAD_MS);
+    pbBeatSchedule.begin(esp_timer_get_time(), HEARTBEAT_INTERVAL_MS, phaseMs);
+    Serial.printf("⏰ Розклад: кожні %d мс, зсув сенсора %lu мс\n", HEARTBEAT_INTERVAL_MS,
+                  static_cast<unsigned long>(phaseMs));
+    xTaskCreatePinnedToCore(pbNetTaskLoop, "pb_net", PB_NET_TASK_STACK, nullptr, PB_NET_TASK_PRIORITY,
+                            &pbNetTaskHandle, PB_NET_TASK_CORE);
+#if defined(LED_PIN) && (LED_PIN >= 0)
+    xTaskCreate(pbLedTaskLoop, "pb_led", 2048, nullptr, 1, &pbLedTaskHandle);
+#endif
+}
+
+static void reportTask(TaskHandle_t task, PbTaskLoad &load, uint32_t nowUs) {
+    if (task == nullptr) {
+        return;
+    }
+    const uint16_t permille = load.sample(nowUs);
+    Serial.printf("   %-4s стек вільно min %u B, CPU %u.%u%%\n", load.name(),
+                  static_cast<unsigned>(uxTaskGetStackHighWaterMark(task)), permille / 10, permille % 10);
+}
+
+// Мінімум вільного стеку (за весь час) і частка CPU за вікно — чи лишився запас після розділу.
+void reportTasks() {
+#if PB_TASK_STATS_MS > 0
+    const uint32_t now = micros();
+    Serial.printf("📊 Задачі за %d с (net на ядрі %d), heap free=%lu\n", PB_TASK_STATS_MS / 1000,
+                  PB_NET_TASK_CORE, static_cast<unsigned long>(ESP.getFreeHeap()));
+    reportTask(pbNetTaskHandle, pbNetLoad, now);
+    reportTask(pbLedTaskHandle, pbLedLoad, now);
+    reportTask(pbLogTaskHandle, pbLogLoad, now);
+    reportTask(pbLoopTaskHandle, pbLoopLoad, now);
+#if PB_MAINS
+    reportTask(pbMainsTaskHandle, pbMainsLoad, now);
+#endif
+#endif
+}
+
+// ═══ DNS: кеш адреси SERVER_HOST (pb_dns_cache.h) ═══
+
+static PbBoardDnsNet pbDnsNet;
+static const PbDnsConfig pbDnsConfig = {
+    PB_DNS_TTL_MIN_S, PB_DNS_TTL_MAX_S, PB_DNS_TIMEOUT_MS, PB_DNS_RETRY_MIN_MS, PB_DNS_RETRY_MAX_MS,
+};
+static PbDnsResolver<PbBoardDnsNet> pbDns(pbDnsNet, SERVER_HOST, pbDnsConfig);
+static uint32_t pbServerLiteral = 0;
+static const bool pbServerIsLiteral = pbParseIpv4(SERVER_HOST, pbServerLiteral);
+
+// Last-known-good у NVS: адреса разом з хешем SERVER_HOST — після перепрошивки на інший
+// сервер стара адреса не підхопиться.
+struct PbDnsRecord {
+    uint32_t hostHash;
+    uint32_t addr;
+};
+
+static uint32_t pbDnsHostHash() {
+    uint32_t h = 2166136261u;   // FNV-1a
+    for (const char *c = SERVER_HOST; *c != '\0'; c++) {
+        h = (h ^ static_cast<uint8_t>(*c)) * 16777619u;
+    }
+    return h;
+}
+
+static bool pbDnsLoadRecord(PbDnsRecord &rec) {
+    Preferences prefs;
+    if (!prefs.begin("pb_dns", false)) {
+        return false;
+    }
+    bool ok = false;
+    if (prefs.getBytesLength("lkg") == sizeof(rec)) {
+        ok = (prefs.getBytes("lkg", &rec, sizeof(rec)) == sizeof(rec));
+    }
+    prefs.end();
+    return ok && rec.hostHash == pbDnsHostHash() && rec.addr != 0;
+}
+
+// Лише коли адреса змінилась: DNS відповідає щоразу після TTL, flash від цього не зношується.
+static void pbDnsStoreRecord(uint32_t addr) {
+    PbDnsRecord rec = {pbDnsHostHash(), addr};
+    PbDnsRecord old = {};
+    if (pbDnsLoadRecord(old) && old.addr == addr) {
+        return;
+    }
+    Preferences prefs;
+    if (!prefs.begin("pb_dns", false)) {
+        return;
+    }
+    prefs.putBytes("lkg", &rec, sizeof(rec));
+    prefs.end();
+}
+
+// i-й октет адреси в network byte order (для логів "a.b.c.d").
+static unsigned pbIp4Octet(uint32_t addr, int i) {
+    return reinterpret_cast<const uint8_t *>(&addr)[i];
+}
+
+static void pbDnsLogResolved(bool changed) {
+    if (changed) {
+        PB_LOGI(DnsResolved, SERVER_HOST, pbIp4Octet(pbDns.addr(), 0), pbIp4Octet(pbDns.addr(), 1),
+                pbIp4Octet(pbDns.addr(), 2), pbIp4Octet(pbDns.addr(), 3), pbDns.ttlS(), pbDns.lastUs());
+    } else {
+        PB_LOGD(DnsResolved, SERVER_HOST, pbIp4Octet(pbDns.addr(), 0), pbIp4Octet(pbDns.addr(), 1),
+                pbIp4Octet(pbDns.addr(), 2), pbIp4Octet(pbDns.addr(), 3), pbDns.ttlS(), pbDns.lastUs());
+    }
+}
+
+void setupDnsCache() {
+    PbDnsRecord rec = {};
+    if (pbServerIsLiteral || !pbDnsLoadRecord(rec)) {
+        return;
+    }
+    pbDns.seed(rec.addr, millis());
+    PB_LOGI(DnsSeed, SERVER_HOST, pbIp4Octet(rec.addr, 0), pbIp4Octet(rec.addr, 1), pbIp4Octet(rec.addr, 2),
+            pbIp4Octet(rec.addr, 3));
+}
+
+// Крок резолвера; нова адреса — у NVS.
+void pollDns() {
+    if (pbServerIsLiteral) {
+        return;
+    }
+    const uint32_t nowMs = millis();
+    switch (pbDns.poll(nowMs, micros(), true)) {
+        case PbDnsEvent::Changed:
+            pbDnsLogResolved(true);
+            pbDnsStoreRecord(pbDns.addr());
+            break;
+        case PbDnsEvent::Resolved:
+            pbDnsLogResolved(false);
+            break;
+        case PbDnsEvent::Failed:
+            PB_LOGW(DnsFailed, SERVER_HOST, pbDns.lastUs(),
+                    pbDns.has() ? "лишається остання відома адреса" : "адреси немає", (pbDns.dueMs() - nowMs) / 1000);
+            break;
+        case PbDnsEvent::None:
+            break;
+    }
+}
+
+bool dnsInFlight() {
+    return pbDns.inFlight();
+}
+
+// ═══ Heartbeat: покроковий HTTP-обмін (без блокування loop) ═══
+
+static PbBoardNet pbHbNet(pbDns);
+// Офлайн-журнал (pb_beat_journal.h) — лише HTTP: пакет не влазить у датаграму.
+// Пакет — найбільший запит: заголовок, поля сенсора і до PB_JOURNAL_BEATS + 1 записів.
+// Пакет агрегатора — ще до PB_AGG_PEERS записів сусідів і обгортка пакета.
+#if PB_TRANSPORT != PB_TRANSPORT_UDP && PB_JOURNAL_BEATS > 0
+#define PB_JOURNAL 1
+#define PB_HB_JOURNAL_CAP ((PB_JOURNAL_BEATS + 1) * kPbJournalRecJsonMax)
+#else
+#define PB_JOURNAL 0
+#define PB_HB_JOURNAL_CAP 0
+#endif
+#if PB_AGG
+#define PB_HB_REQUEST_CAP (1024 + PB_HB_JOURNAL_CAP + 256 + PB_AGG_PEERS * kPbAggRecJsonMax)
+#else
+#define PB_HB_REQUEST_CAP (1024 + PB_HB_JOURNAL_CAP)
+#endif
+
+#if PB_TRANSPORT == PB_TRANSPORT_UDP
+static const PbHbConfig pbHbConfig = {
+    SERVER_HOST, SERVER_UDP_PORT, HTTP_TIMEOUT_MS, HTTP_TIMEOUT_MS, PB_UDP_ACK_TIMEOUT_MS, false,
+};
+// Маска входів з input_sections додає до JSON ~60 байт: датаграма — до межі сервера (1024).
+static PbUdpBeat<PbBoardNet, (PB_INPUTS > 0 || PB_MAINS ? 1024 : 832)> pbHb(pbHbNet, pbHbConfig);
+#else
+static const PbHbConfig pbHbConfig = {
+    SERVER_HOST, SERVER_PORT, HTTP_TIMEOUT_MS, HTTP_TIMEOUT_MS, HTTP_TIMEOUT_MS, PB_HTTP_KEEPALIVE != 0,
+};
+static PbHbMachine<PbBoardNet, PB_HB_REQUEST_CAP> pbHb(pbHbNet, pbHbConfig);
+#endif
+static PbHbState pbHbLoggedState = PbHbState::Idle;
+
+static void pbHbLogTransition(PbHbState state) {
+    switch (state) {
+        case PbHbState::Resolve:
+            if (pbHb.retried()) {
+                PB_LOGW(HbStaleRetry);
+            }
+            break;
+        case PbHbState::Connect:
+            PB_LOGD(HbConnectTry);
+            break;
+        case PbHbState::Write:
+#if PB_TRANSPORT == PB_TRANSPORT_UDP
+            PB_LOGD(HbUdpTarget, SERVER_HOST, SERVER_UDP_PORT);
+#else
+            if (!pbHb.reused()) {
+                PB_LOGD(HbConnectOk);
+            }
+#endif
+            break;
+        default:
+            break;
+    }
+}
+
+// Тривалості фаз beat (мкс); непройдені фази (keep-alive без DNS/connect) — 0.
+static void pbHbLogTimings(const PbHbTimings &t) {
+    PB_LOGI(HbTimings, t.get(PbHbPhase::Dns), t.get(PbHbPhase::Connect), t.get(PbHbPhase::Write),
+            t.get(PbHbPhase::Ttfb), t.get(PbHbPhase::Response),
+            t.failedAt != PbHbPhase::None ? ", збій на " : "",
+            t.failedAt != PbHbPhase::None ? pbHbPhaseName(t.failedAt) : "");
+}
+
+static void pbHbLogError(PbHbError err) {
+    switch (err) {
+        case PbHbError::ResolveFailed:
+        case PbHbError::ResolveTimeout:
+            PB_LOGE(HbDnsFail, SERVER_HOST, err == PbHbError::ResolveTimeout ? " (таймаут)" : "");
+            break;
+        case PbHbError::ConnectFailed:
+        case PbHbError::ConnectTimeout:
+            PB_LOGE(HbConnectFail);
+            break;
+        case PbHbError::WriteFailed:
+        case PbHbError::WriteTimeout:
+            PB_LOGE(HbWriteFail);
+            break;
+        case PbHbError::StatusTimeout:
+            PB_LOGE(HbStatusTimeout);
+            break;
+        case PbHbError::Closed:
+            PB_LOGE(HbClosed);
+            break;
+        case PbHbError::BadStatusLine:
+            PB_LOGE(HbBadStatus);
+            break;
+        case PbHbError::BadResponse:
+            PB_LOGE(HbBadResponse);
+            break;
+        case PbHbError::None:
+            break;
+    }
+}
+
+#if PB_JOURNAL
+static PbBeatJournal<PB_JOURNAL_BEATS> pbJournal;
+static bool pbJournalInFlight = false;
+static bool pbJournalFlushDue = false;
+static uint8_t pbJournalOkStreak = 0;
+static uint64_t pbJournalNoLinkUs = 0;
+#endif
+
+#if PB_AGG
+static PbBoardUdpListener pbAggListener;
+static PbAggTable<PB_AGG_PEERS> pbAgg(pbFrameKey, API_KEY, BUILDING_ID, PB_AGG_FORGET_MS);
+static bool pbAggListening = false;
+static bool pbAggListenLogged = false;
+static bool pbAggBatchInFlight = false;
+#endif
+
+// Недоставлений beat — у журнал (якщо живлення є). Журнал відправляємо після другого
+// доставленого поспіль: до того монітор сервера ще може не встигнути записати "up", і
+// пара down/up, яку журнал спростовує, з'явилась би вже після нього.
+static void journalBeatResult(bool ok) {
+#if PB_JOURNAL
+    if (ok) {
+        if (pbJournalOkStreak < 2) {
+            pbJournalOkStreak++;
+        }
+        pbJournalFlushDue = pbJournalOkStreak >= 2 && !pbJournal.empty();
+        return;
+    }
+    pbJournalOkStreak = 0;
+    if (!powerLost()) {
+        pbJournal.add(pbHbSeq, pbUptimeS());
+        PB_LOGD(JournalAdd, pbHbSeq, static_cast<unsigned>(pbJournal.size()), pbJournal.stride());
+    }
+#endif
+}
+
+void reportHeartbeatResult(bool ok) {
+    if (ok) {
+        PB_LOGI(HbOk);
+        pbBoardBeatDelivered();
+        blinkLED(1, 100);
+    } else {
+        PB_LOGE(HbFailed);
+        blinkLED(3, 200);
+    }
+    journalBeatResult(ok);
+    PB_LOGI(HbNext, pbBeatNextSec());
+}
+
+bool heartbeatInFlight() {
+    return pbHb.busy();
+}
+
+// Запит у польоті і keep-alive сокет після втрати лінку вже не живі.
+void abortHeartbeat() {
+#if PB_AGG
+    if (pbAggBatchInFlight) {
+        pbAgg.applyResults(false, "");   // пакет не дійшов: beat-и сусідів чекають наступного
+        pbAggBatchInFlight = false;
+    }
+#endif
+#if PB_JOURNAL
+    if (pbHb.busy() && !pbJournalInFlight) {
+        journalBeatResult(false);   // обірваний beat не доставлено — як і будь-який інший збій
+    }
+    pbJournalInFlight = false;   // журнал лишається, відправимо після наступного beat
+#endif
+    pbHb.abort();
+    pbHbNet.close();
+    pbHbNet.closeDatagram();
+    pbHbLoggedState = PbHbState::Idle;
+}
+
+#if PB_HB_FRAME
+static size_t pbHbBuildFrame(uint8_t *out, PbFrameEvent event, uint32_t seq) {
+    if (!pbFrameUuidReady) {
+        pbFrameUuidHash(SENSOR_UUID, pbFrameUuid);
+        pbFrameUuidReady = true;
+    }
+    pbFrameEncode(out, pbFrameKey, event, BUILDING_ID, SECTION_ID, pbFrameUuid, seq, pbUptimeS(), pbBootCountGet());
+    return PB_FRAME_SIZE;
+}
+#endif
+
+// ─── Heartbeat запит: шаблон у flash, динамічні поля — у слотах ───
+// Статичні поля — #define з config.h, тож запит склеюється з літералів на етапі компіляції.
+
+#if !defined(SENSOR_COMMENT)
+#define SENSOR_COMMENT ""
+#endif
+static_assert(pbJsonLiteralSafe(API_KEY) && pbJsonLiteralSafe(SENSOR_UUID) && pbJsonLiteralSafe(SENSOR_COMMENT),
+              "API_KEY / SENSOR_UUID / SENSOR_COMMENT: без лапок, \\ і керуючих символів");
+
+#if PB_HTTP_KEEPALIVE
+#define PB_HB_CONNECTION "keep-alive"
+#else
+#define PB_HB_CONNECTION "close"
+#endif
+
+// Без завершального CRLF після body: він "перетік" би в наступний keep-alive запит.
+#define PB_HTTP_HEAD(path, contentType)          \
+    "POST " path " HTTP/1.1\r\n"                 \
+    "Host: " SERVER_HOST "\r\n"                  \
+    "Content-Type: " contentType "\r\n"          \
+    "Connection: " PB_HB_CONNECTION "\r\n"       \
+    "Content-Length: "
+#define PB_HB_HTTP_HEAD(contentType) PB_HTTP_HEAD("/api/v1/heartbeat", contentType)
+
+#define PB_HB_BODY_0                                                  \
+    "{\"api_key\":\"" API_KEY "\","                                   \
+    "\"building_id\":" PB_STR(BUILDING_ID) ","                        \
+    "\"section_id\":" PB_STR(SECTION_ID) ","                          \
+    "\"sensor_uuid\":\"" SENSOR_UUID "\","                            \
+    "\"comment\":\"" SENSOR_COMMENT "\","                             \
+    "\"event\":"
+#define PB_HB_BODY_1 PB_HB_BODY_0 PB_SLOT_EVENT ",\"seq\":"
+#define PB_HB_BODY_2 PB_HB_BODY_1 PB_SLOT_U32 ",\"uptime_s\":"
+#define PB_HB_BODY_3 PB_HB_BODY_2 PB_SLOT_U32 ",\"boot_count\":"
+#define PB_HB_BODY_4 PB_HB_BODY_3 PB_SLOT_U32 ",\"heap_free\":"
+#define PB_HB_BODY_5 PB_HB_BODY_4 PB_SLOT_U32 ",\"heap_min\":"
+#define PB_HB_BODY_6 PB_HB_BODY_5 PB_SLOT_U32 ",\"heap_drops\":"
+#define PB_HB_BODY_7 PB_HB_BODY_6 PB_SLOT_U32 ",\"log_drops\":"
+#if PB_TRANSPORT == PB_TRANSPORT_UDP
+#define PB_HB_BODY_LAT PB_HB_BODY_7 PB_SLOT_U32 ",\"hb_lat\":"
+#define PB_HB_JSON_HEAD ""
+#else
+#define PB_HB_BODY_8 PB_HB_BODY_7 PB_SLOT_U32 ",\"conn_new\":"
+#define PB_HB_BODY_9 PB_HB_BODY_8 PB_SLOT_U32 ",\"conn_reused\":"
+#define PB_HB_BODY_LAT PB_HB_BODY_9 PB_SLOT_U32 ",\"hb_lat\":"
+#define PB_HB_JSON_HEAD PB_HB_HTTP_HEAD("application/json") PB_SLOT_U32 "\r\n\r\n"
+#endif
+#define PB_HB_BODY_INT PB_HB_BODY_LAT PB_HB_LAT_JSON ",\"hb_int\":"
+#define PB_HB_BODY_DNS PB_HB_BODY_INT PB_HB_INT_JSON ",\"hb_dns\":"
+#if PB_MAINS
+#define PB_HB_BODY_MAINS_V PB_HB_BODY_DNS PB_HB_DNS_JSON ",\"mains_v\":"
+#define PB_HB_BODY_MAINS_HZ PB_HB_BODY_MAINS_V PB_MAINS_V_JSON ",\"mains_hz\":"
+#define PB_HB_BODY_TELEMETRY PB_HB_BODY_MAINS_HZ PB_MAINS_HZ_JSON
+#else
+#define PB_HB_BODY_TELEMETRY PB_HB_BODY_DNS PB_HB_DNS_JSON
+#endif
+#if PB_INPUTS > 0
+#define PB_HB_BODY_INPUTS PB_HB_BODY_TELEMETRY ",\"input_sections\":[" PB_STRV(PB_INPUT_SECTIONS) "],\"inputs\":"
+#define PB_HB_BODY PB_HB_BODY_INPUTS PB_SLOT_U32 "}"
+#else
+#define PB_HB_BODY PB_HB_BODY_TELEMETRY "}"
+#endif
+
+static const char kPbHbJsonRequest[] = PB_HB_JSON_HEAD PB_HB_BODY;
+static const size_t kPbHbJsonBodyAt = sizeof(PB_HB_JSON_HEAD) - 1;
+static const size_t kPbHbJsonBodyLen = sizeof(PB_HB_BODY) - 1;
+static_assert(sizeof(kPbHbJsonRequest) <= decltype(pbHb)::requestCapacity(), "heartbeat JSON не влазить у буфер");
+
+// Зсуви слотів від початку body.
+static const size_t kPbHbSlotEvent = sizeof(PB_HB_BODY_0) - 1;
+static const size_t kPbHbSlotSeq = sizeof(PB_HB_BODY_1) - 1;
+static const size_t kPbHbSlotUptime = sizeof(PB_HB_BODY_2) - 1;
+static const size_t kPbHbSlotBootCount = sizeof(PB_HB_BODY_3) - 1;
+static const size_t kPbHbSlotHeapFree = sizeof(PB_HB_BODY_4) - 1;
+static const size_t kPbHbSlotHeapMin = sizeof(PB_HB_BODY_5) - 1;
+static const size_t kPbHbSlotHeapDrops = sizeof(PB_HB_BODY_6) - 1;
+static const size_t kPbHbSlotLogDrops = sizeof(PB_HB_BODY_7) - 1;
+#if PB_TRANSPORT != PB_TRANSPORT_UDP
+static const size_t kPbHbSlotConnNew = sizeof(PB_HB_BODY_8) - 1;
+static const size_t kPbHbSlotConnReused = sizeof(PB_HB_BODY_9) - 1;
+#endif
+static const size_t kPbHbSlotLat = sizeof(PB_HB_BODY_LAT) - 1;
+static const size_t kPbHbSlotInt = sizeof(PB_HB_BODY_INT) - 1;
+static const size_t kPbHbSlotDns = sizeof(PB_HB_BODY_DNS) - 1;
+#if PB_MAINS
+static const size_t kPbHbSlotMainsV = sizeof(PB_HB_BODY_MAINS_V) - 1;
+static const size_t kPbHbSlotMainsHz = sizeof(PB_HB_BODY_MAINS_HZ) - 1;
+#endif
+#if PB_INPUTS > 0
+static const size_t kPbHbSlotInputs = sizeof(PB_HB_BODY_INPUTS) - 1;
+#endif
+
+// Вільний heap після кожного beat: має стояти рівно весь soak.
+static PbHeapWatch pbHeapWatch;
+
+// Латентність фаз beat-ів з моменту останнього доставленого "hb_lat".
+static PbHbLatency pbHbLatency;
+
+// Повний час beat з моменту startHeartbeat() (з логами) — з моменту boot.
+static uint32_t pbHbBeatStartUs = 0;
+static PbLatencyHist pbHbBeatHist;
+
+// Тіло JSON beat (kPbHbJsonBodyLen байт): шаблон з flash одним memcpy, далі лише слоти.
+static void pbHbPutJsonBody(char *body, const char *event, uint32_t seq) {
+    memcpy(body, kPbHbJsonRequest + kPbHbJsonBodyAt, kPbHbJsonBodyLen);
+    pbSlotPutStr(body + kPbHbSlotEvent, sizeof(PB_SLOT_EVENT) - 1, event);
+    pbSlotPutUint(body + kPbHbSlotSeq, sizeof(PB_SLOT_U32) - 1, seq);
+    pbSlotPutUint(body + kPbHbSlotUptime, sizeof(PB_SLOT_U32) - 1, pbUptimeS());
+    pbSlotPutUint(body + kPbHbSlotBootCount, sizeof(PB_SLOT_U32) - 1, pbBootCountGet());
+    pbSlotPutUint(body + kPbHbSlotHeapFree, sizeof(PB_SLOT_U32) - 1, ESP.getFreeHeap());
+    pbSlotPutUint(body + kPbHbSlotHeapMin, sizeof(PB_SLOT_U32) - 1, ESP.getMinFreeHeap());
+    pbSlotPutUint(body + kPbHbSlotHeapDrops, sizeof(PB_SLOT_U32) - 1, pbHeapWatch.dropBeats());
+    pbSlotPutUint(body + kPbHbSlotLogDrops, sizeof(PB_SLOT_U32) - 1, pbLogDropped());
+    pbHbLatencyPut(body + kPbHbSlotLat, sizeof(PB_HB_LAT_JSON) - 1, pbHbLatency);
+    pbBeatIntervalsPut(body + kPbHbSlotInt, sizeof(PB_HB_INT_JSON) - 1, pbBeatSchedule);
+    pbDnsStatsPut(body + kPbHbSlotDns, sizeof(PB_HB_DNS_JSON) - 1, pbDns);
+#if PB_MAINS
+    pbMainsStatsPut(body + kPbHbSlotMainsV, body + kPbHbSlotMainsHz, sizeof(PB_MAINS_V_JSON) - 1, pbMainsTake());
+#endif
+#if PB_INPUTS > 0
+    pbSlotPutUint(body + kPbHbSlotInputs, sizeof(PB_SLOT_U32) - 1, pbInputMask);
+#endif
+#if PB_TRANSPORT != PB_TRANSPORT_UDP
+    // Лічильники з'єднань на момент початку цього beat.
+    pbSlotPutUint(body + kPbHbSlotConnNew, sizeof(PB_SLOT_U32) - 1, pbHb.connNew());
+    pbSlotPutUint(body + kPbHbSlotConnReused, sizeof(PB_SLOT_U32) - 1, pbHb.connReused());
+#endif
+}
+
+// JSON beat (реєстрація / PB_HB_FRAME=0 / last-gasp без frame) у буфер state machine.
+static bool pbHbStartJsonBeat(const char *event, uint32_t seq) {
+    char *req = pbHb.requestBuffer();
+    memcpy(req, kPbHbJsonRequest, kPbHbJsonBodyAt);
+    char *body = req + kPbHbJsonBodyAt;
+#if PB_TRANSPORT != PB_TRANSPORT_UDP
+    pbSlotPutUint(req + sizeof(PB_HB_HTTP_HEAD("application/json")) - 1, sizeof(PB_SLOT_U32) - 1, kPbHbJsonBodyLen);
+#else
+    pbHb.expectSeq(seq);
+#endif
+    pbHbPutJsonBody(body, event, seq);
+    PB_LOGD(HbJson, event, seq, static_cast<unsigned>(kPbHbJsonBodyLen));   // не тіло: в ньому API_KEY
+    return pbHb.start(sizeof(kPbHbJsonRequest) - 1, millis(), micros());
+}
+
+#if PB_AGG
+// ─── Агрегатор: пакет beat-ів будинку (pb_agg.h) ───
+// {"api_key":..,"building_id":..,"sensor_uuid":..,"beats":[<свій JSON beat>,<сусіди>...]}
+
+#define PB_AGG_HEAD PB_HTTP_HEAD("/api/v1/heartbeat/batch", "application/json") PB_SLOT_U32 "\r\n\r\n"
+#define PB_AGG_BODY_HEAD                                              \
+    "{\"api_key\":\"" API_KEY "\","                                   \
+    "\"building_id\":" PB_STR(BUILDING_ID) ","                        \
+    "\"sensor_uuid\":\"" SENSOR_UUID "\","                            \
+    "\"beats\":["
+
+static const char kPbAggRequest[] = PB_AGG_HEAD PB_AGG_BODY_HEAD;
+static const size_t kPbAggBodyAt = sizeof(PB_AGG_HEAD) - 1;
+static_assert(sizeof(kPbAggRequest) - 1 + kPbHbJsonBodyLen + PB_AGG_PEERS * kPbAggRecJsonMax + 2 <=
+                  decltype(pbHb)::requestCapacity(),
+              "пакет агрегатора не влазить у буфер");
+
+// Свій beat першим (results[0]), далі — сусіди, від яких є непідтверджений beat.
+static bool pbAggStartBatch(const char *event, uint32_t seq) {
+    char *req = pbHb.requestBuffer();
+    size_t len = sizeof(kPbAggRequest) - 1;
+    memcpy(req, kPbAggRequest, len);
+    pbHbPutJsonBody(req + len, event, seq);
+    len += kPbHbJsonBodyLen;
+    len += pbAgg.putBeatsJson(req + len, decltype(pbHb)::requestCapacity() - len - 2, millis());
+    req[len++] = ']';
+    req[len++] = '}';
+    pbSlotPutUint(req + sizeof(PB_HTTP_HEAD("/api/v1/heartbeat/batch", "application/json")) - 1,
+                  sizeof(PB_SLOT_U32) - 1, len - kPbAggBodyAt);
+    PB_LOGI(AggBatch, static_cast<unsigned>(pbAgg.sent()), static_cast<unsigned>(len));
+    pbAggBatchInFlight = pbHb.start(len, millis(), micros());
+    return pbAggBatchInFlight;
+}
+#endif
+
+// Прийом beat-ів сусідів: кілька датаграм за прохід, ack — одразу з таблиці.
+void pollAggregator() {
+#if PB_AGG
+    if (!pbAggListening) {
+        pbAggListening = pbAggListener.listen(PB_AGG_UDP_PORT);
+        if (pbAggListening) {
+            PB_LOGI(AggListen, PB_AGG_UDP_PORT);
+            pbAggListenLogged = false;
+        } else if (!pbAggListenLogged) {
+            PB_LOGW(AggListenFail, PB_AGG_UDP_PORT);
+            pbAggListenLogged = true;
+        }
+        if (!pbAggListening) {
+            return;
+        }
+    }
+    static uint8_t dgram[kPbAggDatagramCap];   // лише net-задача
+    char ack[32];
+    for (int i = 0; i < PB_AGG_PEERS; i++) {
+        const long n = pbAggListener.recvFrom(dgram, sizeof(dgram));
+        if (n < 0) {
+            pbAggListener.close();
+            pbAggListening = false;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        const size_t ackLen = pbAgg.accept(dgram, static_cast<size_t>(n), millis(), ack, sizeof(ack) - 1);
+        if (ackLen > 0) {
+            pbAggListener.replyTo(reinterpret_cast<const uint8_t *>(ack), ackLen);
+            ack[ackLen] = '\0';
+            PB_LOGD(AggPeer, ack);
+        }
+    }
+    if (pbAgg.takeUrgent()) {
+        xEventGroupSetBits(pbNetEvents, kPbEvBeatNow);
+    }
+#endif
+}
+
+#if PB_HB_FRAME
+#if PB_TRANSPORT != PB_TRANSPORT_UDP
+static const char kPbHbFrameHead[] =
+    PB_HB_HTTP_HEAD("application/octet-stream") PB_STR(PB_FRAME_SIZE) "\r\n\r\n";
+#endif
+
+// Frame у буфер state machine і старт обміну: UDP — датаграма як є, HTTP — POST з готовим заголовком.
+static bool pbHbStartFrame(PbFrameEvent event, uint32_t seq) {
+    char *req = pbHb.requestBuffer();
+#if PB_TRANSPORT == PB_TRANSPORT_UDP
+    pbHbBuildFrame(reinterpret_cast<uint8_t *>(req), event, seq);
+    pbHb.expectSeq(seq);
+    return pbHb.start(PB_FRAME_SIZE, millis(), micros());
+#else
+    memcpy(req, kPbHbFrameHead, sizeof(kPbHbFrameHead) - 1);
+    pbHbBuildFrame(reinterpret_cast<uint8_t *>(req) + sizeof(kPbHbFrameHead) - 1, event, seq);
+    return pbHb.start(sizeof(kPbHbFrameHead) - 1 + PB_FRAME_SIZE, millis(), micros());
+#endif
+}
+#endif
+
+#if PB_HB_FRAME
+// Frame не несе "hb_lat": раз на PB_HB_LAT_JSON_EVERY beat-ів замість нього йде JSON.
+static bool pbHbLatencyDue() {
+#if PB_HB_LAT_JSON_EVERY > 0
+    return pbHbLatency.beats() >= PB_HB_LAT_JSON_EVERY;
+#else
+    return false;   // 0 — підсумки лише в JSON beat-ах (boot, fallback після 4xx)
+#endif
+}
+#endif
+
+// Формує запит і запускає state machine; далі його веде pollHeartbeat() з loop().
+bool startHeartbeat() {
+    pbHbBeatStartUs = micros();
+#if PB_TRANSPORT == PB_TRANSPORT_UDP
+    PB_LOGI(HbTargetUdp, SERVER_HOST, SERVER_UDP_PORT);
+#else
+    PB_LOGI(HbTarget, SERVER_HOST, SERVER_PORT);
+#endif
+    PB_LOGD(HbLocalIp, pbBoardLocalIp()[0], pbBoardLocalIp()[1], pbBoardLocalIp()[2], pbBoardLocalIp()[3]);
+    PB_LOGD(HbGateway, pbBoardGatewayIp()[0], pbBoardGatewayIp()[1], pbBoardGatewayIp()[2],
+            pbBoardGatewayIp()[3]);
+    PB_LOGD(HbLink, pbBoardLinkUp() ? "ON" : "OFF");
+
+    bool started;
+#if PB_AGG
+#if PB_HB_FRAME
+    pbHbFrameInFlight = false;   // у пакеті свій beat — завжди JSON
+#endif
+    started = pbAggStartBatch(pbBootAnnounced ? "heartbeat" : "boot", ++pbHbSeq);
+#else
+#if PB_HB_FRAME
+    // Frame не несе маски входів (і затер би її в telemetry на сервері): з PB_INPUTS — лише JSON.
+    pbHbFrameInFlight = PB_INPUTS == 0 && !pbHbSendJson && !pbHbLatencyDue();
+    if (pbHbFrameInFlight) {
+        started = pbHbStartFrame(PbFrameEvent::Heartbeat, ++pbHbSeq);
+        PB_LOGI(HbFrame, pbHbSeq, PB_FRAME_SIZE);
+    } else
+#endif
+    {
+        started = pbHbStartJsonBeat(pbBootAnnounced ? "heartbeat" : "boot", ++pbHbSeq);
+    }
+#endif
+    if (!started) {
+        return false;
+    }
+    if (pbHb.reused()) {
+        PB_LOGI(HbReuse);
+    }
+    return true;
+}
+
+// ─── Офлайн-журнал: пакет недоставлених beat-ів ───
+// Ті самі поля сенсора, що в beat; вік записів рахується на момент відправки.
+
+#if PB_JOURNAL
+#define PB_JOURNAL_HEAD PB_HTTP_HEAD("/api/v1/heartbeat/bulk", "application/json") PB_SLOT_U32 "\r\n\r\n"
+#define PB_JOURNAL_BODY_0                                             \
+    "{\"api_key\":\"" API_KEY "\","                                   \
+    "\"building_id\":" PB_STR(BUILDING_ID) ","                        \
+    "\"section_id\":" PB_STR(SECTION_ID) ","                          \
+    "\"sensor_uuid\":\"" SENSOR_UUID "\","                            \
+    "\"period_ms\":"
+#define PB_JOURNAL_BODY_1 PB_JOURNAL_BODY_0 PB_SLOT_U32 ",\"stride\":"
+#define PB_JOURNAL_BODY_2 PB_JOURNAL_BODY_1 PB_SLOT_U32 ",\"beats\":"
+
+static const char kPbJournalRequest[] = PB_JOURNAL_HEAD PB_JOURNAL_BODY_2;
+static const size_t kPbJournalBodyAt = sizeof(PB_JOURNAL_HEAD) - 1;
+static_assert(sizeof(kPbJournalRequest) + 2 + (PB_JOURNAL_BEATS + 1) * kPbJournalRecJsonMax <=
+                  decltype(pbHb)::requestCapacity(),
+              "пакет журналу не влазить у буфер");
+
+static bool pbJournalStart() {
+    char *req = pbHb.requestBuffer();
+    size_t len = sizeof(kPbJournalRequest) - 1;
+    memcpy(req, kPbJournalRequest, len);
+    // Період — поточний (сервер міг його змінити), не HEARTBEAT_INTERVAL_MS.
+    pbSlotPutUint(req + kPbJournalBodyAt + sizeof(PB_JOURNAL_BODY_0) - 1, sizeof(PB_SLOT_U32) - 1,
+                  pbBeatSchedule.periodUs() / 1000);
+    pbSlotPutUint(req + kPbJournalBodyAt + sizeof(PB_JOURNAL_BODY_1) - 1, sizeof(PB_SLOT_U32) - 1,
+                  pbJournal.stride());
+    const size_t beats =
+        pbJournalPutJson(req + len, decltype(pbHb)::requestCapacity() - len - 1, pbJournal, pbUptimeS());
+    if (beats == 0) {
+        return false;
+    }
+    len += beats;
+    req[len++] = '}';
+    pbSlotPutUint(req + sizeof(PB_HTTP_HEAD("/api/v1/heartbeat/bulk", "application/json")) - 1,
+                  sizeof(PB_SLOT_U32) - 1, len - kPbJournalBodyAt);
+    return pbHb.start(len, millis(), micros());
+}
+
+// Результат пакета: доставлено — журнал чистий; 4xx (сервер без bulk / не знає сенсор) —
+// відкидаємо, щоб не слати його щобіту; інше — повтор після наступного beat.
+static void pbJournalFinish() {
+    pbJournalInFlight = false;
+    if (pbHb.ok()) {
+        PB_LOGI(JournalSent, static_cast<unsigned>(pbJournal.size()));
+        pbJournal.clear();
+    } else if (pbHb.httpStatus() >= 400 && pbHb.httpStatus() < 500) {
+        PB_LOGW(JournalRejected, pbHb.httpStatus(), static_cast<unsigned>(pbJournal.size()));
+        pbJournal.clear();
+    } else {
+        PB_LOGW(JournalRetry);
+    }
+    pbHb.reset();
+    pbHbLoggedState = PbHbState::Idle;
+}
+#endif
+
+// Після доставленого beat: журнал — одним запитом, поки state machine вільна.
+void flushBeatJournal() {
+#if PB_JOURNAL
+    if (!pbJournalFlushDue || pbHb.busy() || powerLost()) {
+        return;
+    }
+    pbJournalFlushDue = false;
+    PB_LOGI(JournalSend, static_cast<unsigned>(pbJournal.size()), pbJournal.stride());
+    pbJournalInFlight = pbJournalStart();
+    if (!pbJournalInFlight) {
+        PB_LOGW(JournalRetry);
+    }
+#endif
+}
+
+// Слот розкладу без мережі: beat навіть не стартує, але сенсор живий.
+void journalMissedSlot() {
+#if PB_JOURNAL
+    const uint64_t nowUs = esp_timer_get_time();
+    if (powerLost() || !pbBeatSchedule.due(nowUs) || nowUs - pbJournalNoLinkUs < pbBeatSchedule.periodUs()) {
+        return;
+    }
+    pbJournalNoLinkUs = nowUs;
+    pbJournal.add(++pbHbSeq, pbUptimeS());
+    PB_LOGD(JournalAdd, pbHbSeq, static_cast<unsigned>(pbJournal.size()), pbJournal.stride());
+#endif
+}
+
+void journalPowerLost() {
+#if PB_JOURNAL
+    pbJournal.markPowerLost(pbUptimeS());
+#endif
+}
+
+// Один крок heartbeat (non-blocking); після завершення — логи, LED, reset.
+void pollHeartbeat() {
+    if (!pbHb.busy() && !pbHb.finished()) {
+        return;
+    }
+    const PbHbState state = pbHb.step(millis(), micros());
+    if (state != pbHbLoggedState) {
+        pbHbLogTransition(state);
+        pbHbLoggedState = state;
+    }
+    if (!pbHb.finished()) {
+        return;
+    }
+
+    if (pbHb.statusLine()[0] != '\0') {
+        PB_LOGI(HbStatus, pbHb.statusLine());
+    }
+    if (pbHb.body()[0] != '\0') {
+        PB_LOGD(HbBody, pbHb.body());
+    }
+    pbHbLogError(pbHb.error());
+    if (pbHb.error() == PbHbError::ConnectFailed || pbHb.error() == PbHbError::ConnectTimeout) {
+        pbDns.kick(millis());   // сервер міг переїхати — не чекаємо кінця TTL
+    }
+#if PB_TRANSPORT != PB_TRANSPORT_UDP
+    PB_LOGD(HbConnections, pbHb.connNew(), pbHb.connReused());
+#endif
+#if PB_JOURNAL
+    if (pbJournalInFlight) {
+        pbJournalFinish();   // не beat: без статистики beat і LED
+        return;
+    }
+#endif
+
+#if PB_AGG
+    if (pbAggBatchInFlight) {
+        pbAggBatchInFlight = false;
+        pbAgg.applyResults(pbHb.ok(), pbHb.body());
+        if (pbAgg.pending() > 0) {
+            PB_LOGW(AggPending, static_cast<unsigned>(pbAgg.pending()));
+        }
+    }
+#endif
+
+    const bool ok = pbHb.ok();
+    if (ok) {
+        pbBootAnnounced = true;
+        applyServerPeriod(pbHb.intervalMs());
+    }
+#if PB_HB_FRAME
+    if (ok && !pbHbFrameInFlight) {
+        pbHbSendJson = false;   // сенсор зареєстрований — далі frame
+    } else if (pbHbFrameInFlight && pbHb.httpStatus() >= 400 && pbHb.httpStatus() < 500) {
+        // Сервер не знає сенсор (наприклад, нова БД) або не підтримує frame.
+        PB_LOGW(HbFrameRejected);
+        pbHbSendJson = true;
+    }
+#endif
+    pbHbLogTimings(pbHb.timings());
+    // Успішний JSON beat доніс "hb_lat" / "hb_int" / "hb_dns" / "mains_*" попереднього вікна; frame їх не несе.
+    bool latDelivered = ok;
+#if PB_HB_FRAME
+    latDelivered = ok && !pbHbFrameInFlight;
+#endif
+    pbHbLatency.finish(pbHb.timings(), latDelivered);
+    if (latDelivered) {
+        pbBeatSchedule.clearStats();   // "hb_int" і "hb_dns" поїхали разом з "hb_lat"
+        pbDns.clearStats();
+        mainsWindowDelivered();
+    }
+    pbHb.reset();
+    pbHbLoggedState = PbHbState::Idle;
+
+    pbHeapWatch.sample(ESP.getFreeHeap());
+    PB_LOGI(HbHeap, pbHeapWatch.last(), pbHeapWatch.low(), pbHeapWatch.dropBeats(), pbLogDropped());
+
+    // Старт beat -> результат оброблено, разом з усім логуванням на шляху (порівняння PB_LOG_DIRECT).
+    const uint32_t beatUs = micros() - pbHbBeatStartUs;
+    pbHbBeatHist.add(beatUs);
+    PB_LOGI(HbBeatTime, beatUs, pbHbBeatHist.percentile(50), pbHbBeatHist.percentile(95));
+    reportHeartbeatResult(ok);
+}
+
+// ═══ Last-gasp: детекція втрати живлення ═══
+
+#if PB_POWER_SENSE_MODE != 0
+static const PbPowerWatchConfig pbPowerWatchConfig = {
+    PB_POWER_LOST_MV, PB_POWER_RESTORED_MV, PB_POWER_CONFIRM_SAMPLES,
+};
+static PbPowerWatch pbPowerWatch(pbPowerWatchConfig);
+static unsigned long pbPowerLastSampleMs = 0;
+
+// Мінімальний "power_lost" — по змозі через уже відкритий keep-alive сокет
+// (один TCP-сегмент, без handshake). Heartbeat у польоті обриваємо: часу на
+// нього вже немає.
+static void sendLastGasp() {
+    if (pbHb.busy() || pbHb.finished()) {
+        abortHeartbeat();
+    }
+
+    const unsigned long started = millis();
+    bool sent;
+#if PB_HB_FRAME
+    pbHbFrameInFlight = !pbHbSendJson;
+    if (pbHbFrameInFlight) {
+        // seq не збільшуємо: power_lost не рахується як beat.
+        sent = pbHbStartFrame(PbFrameEvent::PowerLost, pbHbSeq);
+    } else
+#endif
+    {
+        sent = pbHbStartJsonBeat("power_lost", pbHbSeq);
+    }
+    if (!sent) {
+        PB_LOGE(LastGaspNotSent);
+        return;
+    }
+    // Доводимо обмін до кінця в межах бюджету: далі плата може просто вимкнутись.
+    while (pbHb.busy() && (millis() - started) < PB_LAST_GASP_BUDGET_MS) {
+        pbHb.step(millis(), micros());
+        delay(1);
+    }
+    if (pbHb.busy()) {
+        // Запит уже в сокеті; відповідь (якщо встигне) дочитає pollHeartbeat().
+        PB_LOGI(LastGaspPending, pbHb.reused() ? "keep-alive" : "нове з'єднання");
+        return;
+    }
+    PB_LOGI(LastGaspDone, pbHb.ok() ? "доставлено" : "помилка", millis() - started);
+    pbHbLogError(pbHb.error());
+    pbHb.reset();
+    pbHbLoggedState = PbHbState::Idle;
+}
+#endif
+
+void setupPowerWatch() {
+#if PB_POWER_SENSE_MODE == 1
+    analogSetPinAttenuation(PB_POWER_SENSE_PIN, ADC_11db);
+    Serial.printf("🔋 Last-gasp: ADC GPIO%d, поріг %d/%d мВ\n",
+                  PB_POWER_SENSE_PIN, PB_POWER_LOST_MV, PB_POWER_RESTORED_MV);
+#elif PB_POWER_SENSE_MODE == 2
+    pinMode(PB_POWER_SENSE_PIN, INPUT);
+    Serial.printf("🔋 Last-gasp: power-good GPIO%d\n", PB_POWER_SENSE_PIN);
+#endif
+}
+
+bool powerLost() {
+#if PB_POWER_SENSE_MODE != 0
+    return pbPowerWatch.lost();
+#else
+    return false;
+#endif
+}
+
+// Семпл живлення раз на PB_POWER_SAMPLE_MS; на підтвердженому фронті — last-gasp.
+void pollPowerWatch() {
+#if PB_POWER_SENSE_MODE != 0
+    const unsigned long now = millis();
+    if ((now - pbPowerLastSampleMs) < PB_POWER_SAMPLE_MS) {
+        return;
+    }
+    pbPowerLastSampleMs = now;
+
+#if PB_POWER_SENSE_MODE == 1
+    const PbPowerEvent ev = pbPowerWatch.feed(
+        pbPowerSupplyMv(analogReadMilliVolts(PB_POWER_SENSE_PIN), PB_POWER_DIVIDER_X1000));
+#else
+    const PbPowerEvent ev = pbPowerWatch.feedLevel(digitalRead(PB_POWER_SENSE_PIN) == HIGH);
+#endif
+
+    if (ev == PbPowerEvent::Lost) {
+        PB_LOGW(PowerLost);
+        journalPowerLost();
+        if (pbEthUp()) {
+            sendLastGasp();
+        } else {
+            PB_LOGW(PowerLostNoNet);
+        }
+    } else if (ev == PbPowerEvent::Restored) {
+        PB_LOGI(PowerRestored);
+        xEventGroupSetBits(pbNetEvents, kPbEvBeatNow);
+    }
+#endif
+}
+
+// ═══ Входи кількох секцій (PB_INPUTS) ═══
+
+#if PB_INPUTS > 0
+// Семпл усіх входів з апаратного таймера: два регістри GPIO_IN замість digitalRead() на пін.
+// На стабільній зміні маски — позачерговий beat.
+static void IRAM_ATTR pbInputSample() {
+    const uint32_t in0 = REG_READ(GPIO_IN_REG);
+    const uint32_t in1 = REG_READ(GPIO_IN1_REG);
+    uint32_t active = 0;
+    for (uint8_t i = 0; i < PB_INPUTS; i++) {
+        const uint8_t pin = kPbInputPins[i];
+        const bool high = (((pin < 32) ? (in0 >> pin) : (in1 >> (pin - 32))) & 1u) != 0;
+        if (high != (PB_INPUT_ACTIVE_LOW != 0)) {
+            active |= 1u << i;
+        }
+    }
+    if (!pbInputs.feed(active)) {
+        return;
+    }
+    pbInputMask = pbInputs.state();
+    BaseType_t woken = pdFALSE;
+    xEventGroupSetBitsFromISR(pbNetEvents, kPbEvBeatNow, &woken);
+    if (woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+#endif
+
+void setupInputs() {
+#if PB_INPUTS > 0
+    for (uint8_t i = 0; i < PB_INPUTS; i++) {
+        // GPIO34-39 внутрішньої підтяжки не мають — там потрібен зовнішній резистор.
+        pinMode(kPbInputPins[i], PB_INPUT_ACTIVE_LOW ? INPUT_PULLUP : INPUT);
+    }
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    pbInputTimer = timerBegin(1000000);
+    timerAttachInterrupt(pbInputTimer, &pbInputSample);
+    timerAlarm(pbInputTimer, PB_INPUT_SAMPLE_US, true, 0);
+#else
+    pbInputTimer = timerBegin(0, 80, true);   // 1 МГц від APB 80 МГц
+    timerAttachInterrupt(pbInputTimer, &pbInputSample, true);
+    timerAlarmWrite(pbInputTimer, PB_INPUT_SAMPLE_US, true);
+    timerAlarmEnable(pbInputTimer);
+#endif
+    Serial.printf("🔌 Входи: %d (піни %s), семпл %d мкс, вимкнення за %d мс\n",
+                  PB_INPUTS, PB_STRV(PB_INPUT_PINS), PB_INPUT_SAMPLE_US, PB_INPUT_OFF_MS);
+#endif
+}
+
+// Лише лог: позачерговий beat на фронті входу вже попросив ISR.
+void pollInputs() {
+#if PB_INPUTS > 0
+    const uint16_t mask = pbInputMask;
+    if (mask != pbInputMaskLogged) {
+        pbInputMaskLogged = mask;
+        PB_LOGI(InputsChanged, mask);
+    }
+#endif
+}
+
+// ═══ Якість мережі: напруга і частота (PB_MAINS) ═══
+
+#if PB_MAINS
+// Запис DMA: ESP32 — 2 байти (type1, ADC через I2S0), ESP32-S3 — 4 байти (type2).
+#if CONFIG_IDF_TARGET_ESP32
+#define PB_MAINS_RESULT_BYTES 2
+#define PB_MAINS_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#else
+#define PB_MAINS_RESULT_BYTES 4
+#define PB_MAINS_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#endif
+#if ESP_IDF_VERSION_MAJOR >= 5
+#define PB_MAINS_ATTEN ADC_ATTEN_DB_12
+#else
+#define PB_MAINS_ATTEN ADC_ATTEN_DB_11
+#endif
+
+alignas(4) static uint8_t pbMainsRaw[PB_MAINS_BLOCK_SAMPLES * PB_MAINS_RESULT_BYTES];
+static uint16_t pbMainsBlock[PB_MAINS_BLOCK_SAMPLES];
+static uint8_t pbMainsChannel = 0;
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+static adc_continuous_handle_t pbMainsAdc = nullptr;
+static std::atomic<bool> pbMainsOverflow{false};
+
+static bool IRAM_ATTR pbMainsPoolOvf(adc_continuous_handle_t, const adc_continuous_evt_data_t *, void *) {
+    pbMainsOverflow.store(true, std::memory_order_relaxed);
+    return false;
+}
+#endif
+
+// Блок DMA; ESP_ERR_INVALID_STATE (IDF 4.4) — пул переповнився, між блоками є розрив.
+static esp_err_t pbMainsRead(uint32_t *bytes) {
+#if ESP_IDF_VERSION_MAJOR >= 5
+    const esp_err_t err = adc_continuous_read(pbMainsAdc, pbMainsRaw, sizeof(pbMainsRaw), bytes, ADC_MAX_DELAY);
+    return (err == ESP_OK && pbMainsOverflow.exchange(false, std::memory_order_relaxed)) ? ESP_ERR_INVALID_STATE
+                                                                                          : err;
+#else
+    return adc_digi_read_bytes(pbMainsRaw, sizeof(pbMainsRaw), bytes, ADC_MAX_DELAY);
+#endif
+}
+
+// Коди свого каналу з блоку DMA у pbMainsBlock.
+static size_t pbMainsUnpack(uint32_t bytes) {
+    size_t n = 0;
+    for (uint32_t at = 0; at + PB_MAINS_RESULT_BYTES <= bytes; at += PB_MAINS_RESULT_BYTES) {
+        const adc_digi_output_data_t *d = reinterpret_cast<const adc_digi_output_data_t *>(pbMainsRaw + at);
+#if CONFIG_IDF_TARGET_ESP32
+        if (d->type1.channel == pbMainsChannel) {
+            pbMainsBlock[n++] = d->type1.data;
+        }
+#else
+        if (d->type2.channel == pbMainsChannel) {
+            pbMainsBlock[n++] = d->type2.data;
+        }
+#endif
+    }
+    return n;
+}
+
+// Задача mains: блок DMA -> періоди -> спільний підсумок. Не логує: лог пише лише net.
+static void pbMainsTaskLoop(void *) {
+    PbMainsStats block;
+    for (;;) {
+        uint32_t bytes = 0;
+        const esp_err_t err = pbMainsRead(&bytes);
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+            continue;
+        }
+        pbMainsLoad.begin(micros());
+        const bool gap = err == ESP_ERR_INVALID_STATE;
+        if (gap) {
+            pbMains.resync();
+        }
+        const uint32_t started = ESP.getCycleCount();
+        const size_t n = pbMainsUnpack(bytes);
+        pbMains.feed(pbMainsBlock, n, block);
+        const uint32_t cycles = ESP.getCycleCount() - started;
+        portENTER_CRITICAL(&pbMainsMux);
+        pbMainsShared.merge(block);
+        pbMainsFeedCycles += cycles;
+        pbMainsFeedSamples += n;
+        pbMainsGaps += gap ? 1 : 0;
+        portEXIT_CRITICAL(&pbMainsMux);
+        block.clear();
+        pbMainsLoad.end(micros());
+    }
+}
+
+static esp_err_t pbMainsStartAdc(const adc_digi_pattern_config_t &pattern) {
+    adc_digi_pattern_config_t pat = pattern;
+#if ESP_IDF_VERSION_MAJOR >= 5
+    adc_continuous_handle_cfg_t handleCfg = {};
+    handleCfg.max_store_buf_size = sizeof(pbMainsRaw) * 4;
+    handleCfg.conv_frame_size = sizeof(pbMainsRaw);
+    esp_err_t err = adc_continuous_new_handle(&handleCfg, &pbMainsAdc);
+    if (err != ESP_OK) {
+        return err;
+    }
+    adc_continuous_config_t cfg = {};
+    cfg.pattern_num = 1;
+    cfg.adc_pattern = &pat;
+    cfg.sample_freq_hz = PB_MAINS_SAMPLE_HZ;
+    cfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    cfg.format = PB_MAINS_FORMAT;
+    err = adc_continuous_config(pbMainsAdc, &cfg);
+    if (err != ESP_OK) {
+        return err;
+    }
+    adc_continuous_evt_cbs_t cbs = {};
+    cbs.on_pool_ovf = pbMainsPoolOvf;
+    adc_continuous_register_event_callbacks(pbMainsAdc, &cbs, nullptr);
+    return adc_continuous_start(pbMainsAdc);
+#else
+    adc_digi_init_config_t init = {};
+    init.max_store_buf_size = sizeof(pbMainsRaw) * 4;
+    init.conv_num_each_intr = sizeof(pbMainsRaw);
+    init.adc1_chan_mask = 1u << pattern.channel;
+    esp_err_t err = adc_digi_initialize(&init);
+    if (err != ESP_OK) {
+        return err;
+    }
+    adc_digi_configuration_t cfg = {};
+#if CONFIG_IDF_TARGET_ESP32
+    cfg.conv_limit_en = true;   // ESP32 (I2S0): обов'язково
+    cfg.conv_limit_num = 250;
+#endif
+    cfg.pattern_num = 1;
+    cfg.adc_pattern = &pat;
+    cfg.sample_freq_hz = PB_MAINS_SAMPLE_HZ;
+    cfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    cfg.format = PB_MAINS_FORMAT;
+    err = adc_digi_controller_configure(&cfg);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return adc_digi_start();
+#endif
+}
+#endif
+
+void setupMains() {
+#if PB_MAINS
+    // Arduino: ADC1 — канали 0..9, ADC2 — 10+; DMA-режим — лише ADC1.
+    const int8_t channel = digitalPinToAnalogChannel(PB_MAINS_PIN);
+    if (channel < 0 || channel >= 10) {
+        Serial.printf("❌ Мережа: GPIO%d — не ADC1, вимір вимкнено\n", PB_MAINS_PIN);
+        return;
+    }
+    pbMainsChannel = static_cast<uint8_t>(channel);
+    adc_digi_pattern_config_t pattern = {};
+    pattern.atten = PB_MAINS_ATTEN;
+    pattern.channel = pbMainsChannel;
+    pattern.unit = 0;   // ADC1
+    pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    const esp_err_t err = pbMainsStartAdc(pattern);
+    if (err != ESP_OK) {
+        Serial.printf("❌ Мережа: ADC DMA не запущено (%s), вимір вимкнено\n", esp_err_to_name(err));
+        return;
+    }
+    // Вище за net: пул DMA — лише 4 блоки (~50 мс на 20 кГц), формування beat не має його переповнити.
+    xTaskCreate(pbMainsTaskLoop, "pb_mains", 3072, nullptr, PB_NET_TASK_PRIORITY + 1, &pbMainsTaskHandle);
+    Serial.printf("⚡ Мережа: GPIO%d (ADC1_CH%d), %d Гц через DMA, блок %d семплів\n", PB_MAINS_PIN, channel,
+                  PB_MAINS_SAMPLE_HZ, PB_MAINS_BLOCK_SAMPLES);
+#endif
+}
+
+// Net-задача, після доставленого JSON beat: підсумок вікна в лог і нове вікно.
+void mainsWindowDelivered() {
+#if PB_MAINS
+    if (pbMainsTaskHandle == nullptr) {
+        return;   // ADC не запустився (setupMains())
+    }
+    portENTER_CRITICAL(&pbMainsMux);
+    const uint64_t cycles = pbMainsFeedCycles;
+    const uint64_t samples = pbMainsFeedSamples;
+    const uint32_t gaps = pbMainsGaps;
+    portEXIT_CRITICAL(&pbMainsMux);
+    const uint64_t n = samples - pbMainsLoggedSamples;
+    const uint32_t perSample = n > 0 ? static_cast<uint32_t>((cycles - pbMainsLoggedCycles) / n) : 0;
+    pbMainsLoggedCycles = cycles;
+    pbMainsLoggedSamples = samples;
+    const PbMainsStats &s = pbMainsPending;
+    PB_LOGI(MainsSummary, s.vAvg() / 10, s.vAvg() % 10, s.vMin() / 10, s.vMin() % 10, s.vMax() / 10, s.vMax() % 10,
+            s.fAvg() / 1000, s.fAvg() % 1000, s.fMin(), s.fMax(), s.cycles(), perSample, gaps);
+    pbMainsPending.clear();
+#endif
+}
+
+// Блимає задача led: net не чекає на delay() індикації.
+void blinkLED(int times, int delayMs) {
+#if defined(LED_PIN) && (LED_PIN >= 0)
+    const PbLedBlink b = {static_cast<uint8_t>(times), static_cast<uint16_t>(delayMs)};
+    xQueueSend(pbLedQueue, &b, 0);   // черга повна — цей патерн пропускаємо
+#else
+    (void)times;
+    (void)delayMs;
+#endif
+}
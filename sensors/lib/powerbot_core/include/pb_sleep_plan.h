@@ -0,0 +1,114 @@
+/*
+ * PowerBot: планувальник сну net-задачі між heartbeat (PB_POWER_SAVE).
+ *
+ * Між beat-ами net-задача чекає на event group; з esp_pm (DFS + automatic light-sleep)
+ * FreeRTOS у цей час знижує частоту або присипляє чип до найближчого таймауту. Тут лише
+ * рішення "скільки чекати і чи можна спати":
+ *  - запит у польоті — не спимо (lock "без light-sleep"), крок 1 мс;
+ *  - beat неможливий (немає мережі / живлення пропало) — чекаємо idleMs, спати можна:
+ *    поява мережі і так будить задачу подією;
+ *  - інакше спимо до дедлайну мінус guard. esp_timer будить на deadline - guard, і останній
+ *    відрізок задача чекає без сну, тож beat стартує точно в дедлайн, а не на затримку
+ *    пробудження пізніше.
+ * guard підлаштовується під p95 виміряної затримки пробудження (від алярму таймера до його
+ * колбеку), у межах [kMinGuardUs, maxGuardUs].
+ *
+ * Облік часу з lock-ом дає частку часу без сну — множник для оцінки струму
+ * (I ≈ awake·I_active + (1 - awake)·I_sleep; струм сам чип не міряє).
+ *
+ * Header портабельний (без Arduino.h) — симуляція на хості (test/test_sleep_plan).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "pb_hb_latency.h"
+
+struct PbSleepPlan {
+    uint32_t waitMs;   // скільки чекати (події будять раніше)
+    bool awake;        // тримати lock "без light-sleep"
+};
+
+class PbSleepPlanner {
+public:
+    static const uint32_t kMinGuardUs = 1000;
+
+    PbSleepPlanner(uint32_t idleMs, uint32_t maxGuardUs)
+        : idleMs_(idleMs), maxGuardUs_(maxGuardUs), guardUs_(2 * kMinGuardUs) {}
+
+    // canBeat — мережа є і живлення не пропало; deadlineUs — наступний дедлайн розкладу.
+    PbSleepPlan plan(uint64_t nowUs, uint64_t deadlineUs, bool inFlight, bool canBeat) const {
+        PbSleepPlan p;
+        if (inFlight) {
+            p.waitMs = 1;
+            p.awake = true;
+            return p;
+        }
+        if (!canBeat) {
+            p.waitMs = idleMs_;
+            p.awake = false;
+            return p;
+        }
+        const uint64_t left = deadlineUs > nowUs ? deadlineUs - nowUs : 0;
+        if (left <= guardUs_) {
+            // Вікно перед дедлайном: чекаємо точно, без сну.
+            p.waitMs = static_cast<uint32_t>((left + 999) / 1000);
+            p.awake = true;
+            return p;
+        }
+        const uint64_t sleepMs = (left - guardUs_) / 1000;
+        p.waitMs = sleepMs == 0 ? 1 : (sleepMs < idleMs_ ? static_cast<uint32_t>(sleepMs) : idleMs_);
+        p.awake = false;
+        return p;
+    }
+
+    // Коли будити таймером, щоб встигнути прокинутись до дедлайну.
+    uint64_t wakeAt(uint64_t deadlineUs) const { return deadlineUs > guardUs_ ? deadlineUs - guardUs_ : 0; }
+
+    // Затримка пробудження: алярм таймера -> його колбек.
+    void woke(uint32_t latencyUs) {
+        wake_.add(latencyUs);
+        uint32_t g = wake_.percentile(95);
+        g = g < kMinGuardUs ? kMinGuardUs : g;
+        guardUs_ = g < maxGuardUs_ ? g : maxGuardUs_;
+    }
+
+    // Стан lock-а змінився (або просто минув час) у nowUs.
+    void account(uint64_t nowUs, bool awake) {
+        if (started_) {
+            const uint64_t dt = nowUs - lastUs_;
+            totalUs_ += dt;
+            if (awake_) {
+                awakeUs_ += dt;
+            }
+        }
+        started_ = true;
+        lastUs_ = nowUs;
+        awake_ = awake;
+    }
+
+    // Частка часу без сну (проміле) з останнього clearStats().
+    uint16_t awakePermille() const {
+        return totalUs_ == 0 ? 0 : static_cast<uint16_t>(awakeUs_ * 1000u / totalUs_);
+    }
+    uint32_t guardUs() const { return guardUs_; }
+    const PbLatencyHist &wakeLatency() const { return wake_; }
+
+    // Нове вікно частки без сну; гістограма пробуджень лишається (на ній тримається guard).
+    void clearStats() {
+        awakeUs_ = 0;
+        totalUs_ = 0;
+    }
+
+private:
+    uint32_t idleMs_;
+    uint32_t maxGuardUs_;
+    uint32_t guardUs_;
+    PbLatencyHist wake_;
+    bool started_ = false;
+    bool awake_ = false;
+    uint64_t lastUs_ = 0;
+    uint64_t awakeUs_ = 0;
+    uint64_t totalUs_ = 0;
+};
@@ -0,0 +1,67 @@
+/*
+ * PowerBot: завантаження CPU задачами прошивки (net / led / log / loop).
+ *
+ * Arduino-ESP32 збирається без configGENERATE_RUN_TIME_STATS, тож vTaskGetRunTimeStats()
+ * недоступний. Кожна задача сама відмічає час "не у сні": begin() після пробудження,
+ * end() перед vTaskDelay / очікуванням черги чи event group. Супервізор (loop) раз на
+ * вікно бере sample() — частку CPU у проміле з попереднього sample().
+ *
+ * Оцінка зверху: якщо задачу між begin() і end() витіснила інша, цей час теж її.
+ * Пише лише задача-власник, sample() кличе лише супервізор — лічильник atomic, lock не треба.
+ *
+ * Header портабельний (без Arduino.h) — перевіряється на хості (test/test_task_stats).
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+class PbTaskLoad {
+public:
+    explicit PbTaskLoad(const char *name) : name_(name) {}
+
+    void begin(uint32_t nowUs) {
+        startUs_ = nowUs;
+        awake_ = true;
+    }
+    void end(uint32_t nowUs) {
+        if (!awake_) {
+            return;
+        }
+        awake_ = false;
+        busyUs_.fetch_add(nowUs - startUs_, std::memory_order_relaxed);
+    }
+
+    // Проміле CPU за вікно з попереднього sample(); перший виклик лише відкриває вікно (0).
+    // Вікно — до ~71 хв (переповнення micros()).
+    uint16_t sample(uint32_t nowUs) {
+        const uint32_t busy = busyUs_.load(std::memory_order_relaxed);
+        uint16_t permille = 0;
+        if (sampled_) {
+            const uint32_t window = nowUs - sampleUs_;
+            const uint64_t used = static_cast<uint32_t>(busy - sampleBusyUs_);
+            if (window != 0) {
+                const uint64_t pm = used * 1000u / window;
+                permille = static_cast<uint16_t>(pm < 1000u ? pm : 1000u);
+            }
+        }
+        sampled_ = true;
+        sampleUs_ = nowUs;
+        sampleBusyUs_ = busy;
+        return permille;
+    }
+
+    const char *name() const { return name_; }
+
+private:
+    const char *name_;
+    // Задача-власник.
+    uint32_t startUs_ = 0;
+    bool awake_ = false;
+    std::atomic<uint32_t> busyUs_{0};
+    // Супервізор.
+    bool sampled_ = false;
+    uint32_t sampleUs_ = 0;
+    uint32_t sampleBusyUs_ = 0;
+};
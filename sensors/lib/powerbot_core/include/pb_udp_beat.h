@@ -0,0 +1,266 @@
+/*
+ * PowerBot: heartbeat однією UDP-датаграмою (PB_TRANSPORT=PB_TRANSPORT_UDP).
+ *
+ * Та сама модель, що й PbHbMachine: loop() викликає step(millis()), нічого не
+ * блокує, стани/помилки — ті ж PbHbState/PbHbError, тож main.cpp веде обидва
+ * транспорти однаково.
+ *
+ *   Idle -> [Resolve] -> Write -> AwaitStatus -> Done
+ *                                            \-> Failed
+ *
+ * Датаграма — JSON heartbeat як є (без HTTP-обгортки). Сервер відповідає коротким
+ * ack "OK <seq>" / "ERR <status> <seq>"; ack з чужим seq (запізніле від попереднього
+ * beat) ігнорується. Адреса сервера кешується між beat-ами, DNS повторюється лише
+ * після збою.
+ *
+ * Латентність (timings()) — як у PbHbMachine; ack — одна датаграма, тож TTFB і повна
+ * відповідь збігаються, а фази connect немає.
+ *
+ * Header портабельний (без Arduino.h) — перевіряється на хості (test/test_udp_beat).
+ *
+ * Net, крім startResolve()/pollResolve() як для PbHbMachine, має надати:
+ *   long sendDatagram(const uint8_t *data, size_t len, uint16_t port); // >0 відправлено, 0 = зайнято, <0 = помилка
+ *   long recvDatagram(uint8_t *buf, size_t cap);  // >0 довжина датаграми, 0 = нічого, <0 = помилка
+ *   void closeDatagram();
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "pb_hb_fsm.h"
+
+// Розібрати ack сервера. false — не ack. status: 200 для "OK", інакше код з "ERR <status>".
+inline bool pbUdpParseAck(const char *buf, size_t len, int *status, uint32_t *seq, bool *hasSeq) {
+    size_t i = 0;
+    int code = 200;
+    if (len >= 2 && buf[0] == 'O' && buf[1] == 'K') {
+        i = 2;
+    } else if (len >= 4 && strncmp(buf, "ERR ", 4) == 0) {
+        i = 4;
+        code = 0;
+        const size_t digitsStart = i;
+        while (i < len && buf[i] >= '0' && buf[i] <= '9' && i - digitsStart < 3) {
+            code = code * 10 + (buf[i] - '0');
+            i++;
+        }
+        if (i == digitsStart) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    *status = code;
+    *hasSeq = false;
+    *seq = 0;
+    if (i == len) {
+        return true;
+    }
+    if (buf[i] != ' ' || i + 1 == len) {
+        return false;
+    }
+    i++;
+    uint32_t v = 0;
+    for (; i < len; i++) {
+        if (buf[i] < '0' || buf[i] > '9') {
+            return false;
+        }
+        v = v * 10u + static_cast<uint32_t>(buf[i] - '0');
+    }
+    *seq = v;
+    *hasSeq = true;
+    return true;
+}
+
+template <class Net, size_t kDatagramCap = 832, size_t kAckCap = 48>
+class PbUdpBeat {
+public:
+    PbUdpBeat(Net &net, const PbHbConfig &cfg) : net_(net), cfg_(cfg) {}
+
+    // Буфер під датаграму; caller заповнює його і викликає start().
+    char *requestBuffer() { return request_; }
+    static constexpr size_t requestCapacity() { return kDatagramCap; }
+
+    // seq цього beat: ack з іншим seq вважається запізнілим і пропускається.
+    void expectSeq(uint32_t seq) {
+        expectedSeq_ = seq;
+        hasExpectedSeq_ = true;
+    }
+
+    // false — машина ще зайнята або len не влазить у буфер.
+    bool start(size_t len, uint32_t now) { return start(len, now, now * 1000u); }
+    bool start(size_t len, uint32_t now, uint32_t nowUs) {
+        if (busy() || len == 0 || len > kDatagramCap) {
+            return false;
+        }
+        nowUs_ = nowUs;
+        markUs_ = nowUs;
+        timings_.clear();
+        requestLen_ = len;
+        status_ = 0;
+        error_ = PbHbError::None;
+        statusLine_[0] = '\0';
+        if (resolved_) {
+            enter(PbHbState::Write, now);
+        } else {
+            enter(PbHbState::Resolve, now);
+            resolveStarted_ = false;
+        }
+        return true;
+    }
+
+    // Один крок; ніколи не блокує. Повертає поточний стан.
+    PbHbState step(uint32_t now) { return step(now, now * 1000u); }
+    PbHbState step(uint32_t now, uint32_t nowUs) {
+        nowUs_ = nowUs;
+        switch (state_) {
+            case PbHbState::Resolve:     stepResolve(now); break;
+            case PbHbState::Write:       stepWrite(now); break;
+            case PbHbState::AwaitStatus: stepAck(now); break;
+            default: break;
+        }
+        return state_;
+    }
+
+    // Перервати beat (наприклад, link down); після нового лінку адресу резолвимо заново.
+    void abort() {
+        if (busy()) {
+            state_ = PbHbState::Idle;
+        }
+        resolved_ = false;
+    }
+
+    // Забрати результат: Done/Failed -> Idle.
+    void reset() {
+        if (finished()) {
+            state_ = PbHbState::Idle;
+        }
+    }
+
+    PbHbState state() const { return state_; }
+    bool busy() const { return state_ != PbHbState::Idle && !finished(); }
+    bool finished() const { return state_ == PbHbState::Done || state_ == PbHbState::Failed; }
+    bool ok() const { return state_ == PbHbState::Done && status_ == 200; }
+    int httpStatus() const { return status_; }   // зі статусу в ack
+    PbHbError error() const { return error_; }
+    bool reused() const { return false; }
+    bool retried() const { return false; }
+    const char *statusLine() const { return statusLine_; }   // текст ack
+    const char *body() const { return ""; }
+    uint32_t intervalMs() const { return 0; }   // ack інструкцій сервера не несе
+
+    // З'єднань у UDP немає; лічильники — для однакового коду в main.cpp.
+    uint32_t connNew() const { return 0; }
+    uint32_t connReused() const { return 0; }
+
+    // Тривалості фаз останнього beat (мкс); дійсні після finished().
+    const PbHbTimings &timings() const { return timings_; }
+
+private:
+    void enter(PbHbState s, uint32_t now) {
+        if (state_ == PbHbState::Resolve || state_ == PbHbState::Write) {
+            timings_.set(pbHbPhaseOf(state_), nowUs_ - markUs_);
+        }
+        markUs_ = nowUs_;
+        state_ = s;
+        phaseStart_ = now;
+    }
+
+    bool expired(uint32_t now, uint32_t timeoutMs) const {
+        return static_cast<uint32_t>(now - phaseStart_) > timeoutMs;
+    }
+
+    void fail(PbHbError err) {
+        net_.closeDatagram();
+        resolved_ = false;
+        error_ = err;
+        timings_.failedAt = pbHbPhaseOf(state_);
+        state_ = PbHbState::Failed;
+    }
+
+    void stepResolve(uint32_t now) {
+        int r;
+        if (!resolveStarted_) {
+            resolveStarted_ = true;
+            r = net_.startResolve(cfg_.host);
+        } else {
+            r = net_.pollResolve();
+        }
+        if (r == PB_NET_OK) {
+            resolved_ = true;
+            enter(PbHbState::Write, now);
+        } else if (r == PB_NET_FAIL) {
+            fail(PbHbError::ResolveFailed);
+        } else if (expired(now, cfg_.resolveTimeoutMs)) {
+            fail(PbHbError::ResolveTimeout);
+        }
+    }
+
+    void stepWrite(uint32_t now) {
+        const long n = net_.sendDatagram(reinterpret_cast<const uint8_t *>(request_), requestLen_, cfg_.port);
+        if (n < 0) {
+            fail(PbHbError::WriteFailed);
+        } else if (n > 0) {
+            enter(PbHbState::AwaitStatus, now);
+        } else if (expired(now, cfg_.ioTimeoutMs)) {
+            fail(PbHbError::WriteTimeout);
+        }
+    }
+
+    void stepAck(uint32_t now) {
+        char ack[kAckCap];
+        for (;;) {
+            const long n = net_.recvDatagram(reinterpret_cast<uint8_t *>(ack), sizeof(ack) - 1);
+            if (n < 0) {
+                fail(PbHbError::Closed);   // напр. ICMP port unreachable
+                return;
+            }
+            if (n == 0) {
+                break;
+            }
+            int status = 0;
+            uint32_t seq = 0;
+            bool hasSeq = false;
+            if (!pbUdpParseAck(ack, static_cast<size_t>(n), &status, &seq, &hasSeq)) {
+                continue;
+            }
+            if (hasSeq && hasExpectedSeq_ && seq != expectedSeq_) {
+                continue;
+            }
+            memcpy(statusLine_, ack, static_cast<size_t>(n));
+            statusLine_[n] = '\0';
+            status_ = status;
+            timings_.set(PbHbPhase::Ttfb, nowUs_ - markUs_);
+            timings_.set(PbHbPhase::Response, nowUs_ - markUs_);
+            state_ = PbHbState::Done;
+            return;
+        }
+        if (expired(now, cfg_.ioTimeoutMs)) {
+            fail(PbHbError::StatusTimeout);
+        }
+    }
+
+    Net &net_;
+    PbHbConfig cfg_;
+
+    PbHbState state_ = PbHbState::Idle;
+    PbHbError error_ = PbHbError::None;
+    uint32_t phaseStart_ = 0;
+    bool resolveStarted_ = false;
+    bool resolved_ = false;
+
+    uint32_t nowUs_ = 0;
+    uint32_t markUs_ = 0;   // початок поточної фази (для ack — кінець відправки)
+    PbHbTimings timings_ = {{0}, 0, PbHbPhase::None};
+
+    char request_[kDatagramCap];
+    size_t requestLen_ = 0;
+
+    uint32_t expectedSeq_ = 0;
+    bool hasExpectedSeq_ = false;
+    char statusLine_[kAckCap] = {0};
+    int status_ = 0;
+};
@@ -0,0 +1,244 @@
+/*
+ * PowerBot: хостова заміна Arduino-ESP32 (+ FreeRTOS з нього) для симуляції прошивки.
+ *
+ * Лише те, що використовує include/pb_sensor.h і тестова плата. Час — симульований
+ * (pb_sim.h): delay() і очікування FreeRTOS просувають годинник, виконуючи події по дорозі.
+ * Serial пише в pbSim().serial, NVS (Preferences.h) — у pbSim().nvs.
+ */
+
+#pragma once
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <deque>
+#include <string>
+
+#include "pb_sim.h"
+
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+inline unsigned long millis() {
+    return static_cast<unsigned long>(static_cast<uint32_t>(pbSim().nowUs / 1000u));   // 32 біти, як на ESP32
+}
+
+inline unsigned long micros() {
+    return static_cast<unsigned long>(static_cast<uint32_t>(pbSim().nowUs));
+}
+
+inline void delay(uint32_t ms) {
+    pbSimAdvanceUs(static_cast<uint64_t>(ms) * 1000u);
+}
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) {
+    return HIGH;
+}
+
+enum adc_attenuation_t { ADC_0db, ADC_2_5db, ADC_6db, ADC_11db };
+inline void analogSetPinAttenuation(uint8_t, adc_attenuation_t) {}
+inline uint32_t analogReadMilliVolts(uint8_t) {
+    return 2500;
+}
+
+inline uint32_t esp_random() {
+    return static_cast<uint32_t>(pbSim().nowUs * 2654435761u);
+}
+
+class IPAddress {
+public:
+    IPAddress() : addr_(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+        const uint8_t raw[4] = {a, b, c, d};
+        memcpy(&addr_, raw, 4);
+    }
+    IPAddress(uint32_t addr) : addr_(addr) {}   // network byte order, як на ESP32
+
+    operator uint32_t() const { return addr_; }
+    uint8_t operator[](int i) const { return reinterpret_cast<const uint8_t *>(&addr_)[i]; }
+    bool operator==(const IPAddress &o) const { return addr_ == o.addr_; }
+    bool operator!=(const IPAddress &o) const { return addr_ != o.addr_; }
+
+private:
+    uint32_t addr_;
+};
+
+class HardwareSerial {
+public:
+    void begin(unsigned long) {}
+
+    size_t write(uint8_t c) {
+        pbSim().serial += static_cast<char>(c);
+        return 1;
+    }
+    size_t write(const uint8_t *data, size_t len) {
+        pbSim().serial.append(reinterpret_cast<const char *>(data), len);
+        return len;
+    }
+
+    size_t print(const char *s) {
+        pbSim().serial += s;
+        return strlen(s);
+    }
+    size_t print(const IPAddress &ip) {
+        return printf("%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    }
+    template <class T>
+    size_t println(const T &v) {
+        const size_t n = print(v);
+        return n + println();
+    }
+    size_t println() {
+        pbSim().serial += "\r\n";
+        return 2;
+    }
+
+    size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char buf[512];
+        va_list ap;
+        va_start(ap, fmt);
+        const int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+        va_end(ap);
+        if (n <= 0) {
+            return 0;
+        }
+        pbSim().serial.append(buf, static_cast<size_t>(n) < sizeof(buf) ? static_cast<size_t>(n) : sizeof(buf) - 1);
+        return static_cast<size_t>(n);
+    }
+};
+
+static HardwareSerial Serial;
+
+// Heap у симуляції не рухається: PbHeapWatch бачить рівну лінію.
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 200000; }
+    uint32_t getMinFreeHeap() { return 180000; }
+};
+
+static EspClass ESP;
+
+// ─── FreeRTOS: лише те, що є у прошивці; задачі не запускаються ───
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t EventBits_t;
+typedef void (*TaskFunction_t)(void *);
+typedef void *TaskHandle_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS 1
+#define tskIDLE_PRIORITY 0
+#define pdMS_TO_TICKS(ms) (static_cast<TickType_t>(ms))   // тік = 1 мс
+
+struct PbSimEventGroup {
+    EventBits_t bits = 0;
+};
+typedef PbSimEventGroup *EventGroupHandle_t;
+
+inline EventGroupHandle_t xEventGroupCreate() {
+    return new PbSimEventGroup();
+}
+
+inline EventBits_t xEventGroupGetBits(EventGroupHandle_t g) {
+    return g->bits;
+}
+
+inline EventBits_t xEventGroupSetBits(EventGroupHandle_t g, EventBits_t bits) {
+    g->bits |= bits;
+    return g->bits;
+}
+
+inline EventBits_t xEventGroupClearBits(EventGroupHandle_t g, EventBits_t bits) {
+    const EventBits_t old = g->bits;
+    g->bits &= ~bits;
+    return old;
+}
+
+// Чекає, поки біти виставить якась подія симуляції, або до таймауту.
+inline EventBits_t xEventGroupWaitBits(EventGroupHandle_t g, EventBits_t bits, BaseType_t clearOnExit,
+                                       BaseType_t waitAll, TickType_t ticks) {
+    const std::function<bool()> ready = [g, bits, waitAll]() {
+        return waitAll ? (g->bits & bits) == bits : (g->bits & bits) != 0;
+    };
+    pbSimRunUntil(pbSim().nowUs + static_cast<uint64_t>(ticks) * 1000u, ready);
+    const EventBits_t got = g->bits;
+    if (clearOnExit && ready()) {
+        g->bits &= ~bits;
+    }
+    return got;
+}
+
+struct PbSimQueue {
+    size_t itemSize;
+    size_t cap;
+    std::deque<std::string> items;
+};
+typedef PbSimQueue *QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t itemSize) {
+    PbSimQueue *q = new PbSimQueue();
+    q->itemSize = itemSize;
+    q->cap = len;
+    return q;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t) {
+    if (q->items.size() >= q->cap) {
+        return pdFALSE;
+    }
+    q->items.push_back(std::string(static_cast<const char *>(item), q->itemSize));
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks) {
+    if (q->items.empty()) {
+        delay(ticks);
+        return pdFALSE;
+    }
+    memcpy(item, q->items.front().data(), q->itemSize);
+    q->items.pop_front();
+    return pdTRUE;
+}
+
+inline TaskHandle_t pbSimTaskHandle() {
+    static int task;
+    return &task;
+}
+
+inline BaseType_t xTaskCreate(TaskFunction_t, const char *, uint32_t, void *, UBaseType_t, TaskHandle_t *handle) {
+    if (handle != nullptr) {
+        *handle = pbSimTaskHandle();
+    }
+    return pdPASS;
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                          UBaseType_t prio, TaskHandle_t *handle, BaseType_t) {
+    return xTaskCreate(fn, name, stack, arg, prio, handle);
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return pbSimTaskHandle();
+}
+
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) {
+    return 4096;
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+    delay(ticks);
+}
@@ -0,0 +1,46 @@
+/*
+ * PowerBot: хостова заміна Preferences (NVS) для симуляції прошивки.
+ *
+ * Значення живуть у pbSim().nvs: тест може підкласти запис "з минулого boot" або перевірити,
+ * що прошивка зберегла.
+ */
+
+#pragma once
+
+#include <string.h>
+
+#include <string>
+
+#include "pb_sim.h"
+
+class Preferences {
+public:
+    bool begin(const char *name, bool) {
+        ns_ = name;
+        return true;
+    }
+
+    void end() { ns_.clear(); }
+
+    size_t getBytesLength(const char *key) {
+        const std::map<std::string, std::string>::const_iterator it = pbSim().nvs.find(ns_ + "/" + key);
+        return it == pbSim().nvs.end() ? 0 : it->second.size();
+    }
+
+    size_t getBytes(const char *key, void *buf, size_t cap) {
+        const std::map<std::string, std::string>::const_iterator it = pbSim().nvs.find(ns_ + "/" + key);
+        if (it == pbSim().nvs.end() || it->second.size() > cap) {
+            return 0;
+        }
+        memcpy(buf, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+
+    size_t putBytes(const char *key, const void *data, size_t len) {
+        pbSim().nvs[ns_ + "/" + key] = std::string(static_cast<const char *>(data), len);
+        return len;
+    }
+
+private:
+    std::string ns_;
+};
@@ -0,0 +1,111 @@
+/*
+ * Конфігурація симуляції прошивки (test/test_sensor) — замість include/config.h плати.
+ *
+ * Ті самі макроси, що в config.h плат; тест може перевизначити будь-який до #include.
+ * Лог пишеться в Serial одразу (PB_LOG_DIRECT): задачі-дренера в симуляції немає,
+ * а тест перевіряє рядки логу.
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#define SERVER_HOST     "powerbot.test"
+#define SERVER_PORT     18081
+#define API_KEY         "sim-api-key"
+#define BUILDING_ID     1
+#define SECTION_ID      2
+#define SENSOR_COMMENT  "sim"
+#define SENSOR_UUID     "sim-sensor-001"
+#define BUILDING_NAME   "Sim"
+
+#ifndef HEARTBEAT_INTERVAL_MS
+#define HEARTBEAT_INTERVAL_MS   10000
+#endif
+#ifndef PB_HB_PHASE_SPREAD_MS
+#define PB_HB_PHASE_SPREAD_MS   HEARTBEAT_INTERVAL_MS
+#endif
+#ifndef PB_HB_INTERVAL_MIN_MS
+#define PB_HB_INTERVAL_MIN_MS   1000
+#endif
+#ifndef PB_HB_INTERVAL_MAX_MS
+#define PB_HB_INTERVAL_MAX_MS   300000
+#endif
+#ifndef PB_JOURNAL_BEATS
+#define PB_JOURNAL_BEATS        32
+#endif
+#ifndef HTTP_TIMEOUT_MS
+#define HTTP_TIMEOUT_MS         3000
+#endif
+
+#define PB_DNS_TTL_MIN_S        30
+#define PB_DNS_TTL_MAX_S        86400
+#define PB_DNS_TIMEOUT_MS       2000
+#define PB_DNS_RETRY_MIN_MS     5000
+#define PB_DNS_RETRY_MAX_MS     300000
+
+#ifndef PB_HTTP_KEEPALIVE
+#define PB_HTTP_KEEPALIVE       1
+#endif
+#define PB_TRANSPORT_HTTP       0
+#define PB_TRANSPORT_UDP        1
+#define PB_TRANSPORT            PB_TRANSPORT_HTTP   // UDP у симуляції не моделюється
+#define SERVER_UDP_PORT         SERVER_PORT
+#define PB_UDP_ACK_TIMEOUT_MS   2000
+#ifndef PB_HB_FRAME
+#define PB_HB_FRAME             1
+#endif
+#define PB_HB_LAT_JSON_EVERY    60
+
+#define PB_ROLE_SENSOR          0
+#define PB_ROLE_AGGREGATOR      1
+#define PB_ROLE                 PB_ROLE_SENSOR      // агрегатор у симуляції не моделюється
+#define PB_AGG_UDP_PORT         18083
+#define PB_AGG_PEERS            8
+#define PB_AGG_FORGET_MS        600000
+#define PB_AGG_POLL_MS          10
+
+#define PB_INPUTS               0                   // входи (ISR таймера) у симуляції не моделюються
+#define PB_INPUT_PINS           39, 35, 32
+#define PB_INPUT_SECTIONS       1, 2, 3
+#define PB_INPUT_ACTIVE_LOW     1
+#define PB_INPUT_SAMPLE_US      1000
+#define PB_INPUT_ON_SAMPLES     5
+#define PB_INPUT_OFF_MS         40
+
+#define PB_MAINS                0                   // ADC DMA у симуляції не моделюється
+#define PB_MAINS_PIN            33
+#define PB_MAINS_SAMPLE_HZ      20000
+#define PB_MAINS_UV_PER_COUNT   175000
+#define PB_MAINS_HYST_COUNTS    40
+#define PB_MAINS_MIN_HZ         40
+#define PB_MAINS_MAX_HZ         70
+#define PB_MAINS_BLOCK_SAMPLES  256
+
+#ifndef PB_LOG_LEVEL
+#define PB_LOG_LEVEL            PB_LOG_LEVEL_INFO
+#endif
+#define PB_LOG_DIRECT           1
+#define PB_LOG_BINARY           0
+#define PB_LOG_RING_BYTES       2048
+#define PB_LOG_DRAIN_MS         10
+
+#define PB_NET_TASK_CORE        0
+#define PB_NET_TASK_STACK       8192
+#define PB_NET_TASK_PRIORITY    2
+#define PB_TASK_STATS_MS        60000
+
+#define PB_POWER_SAVE           0
+#define PB_PM_MAX_MHZ           240
+#define PB_PM_MIN_MHZ           80
+#define PB_PM_MAX_GUARD_US      5000
+
+#define PB_POWER_SENSE_MODE     0
+#define PB_POWER_SENSE_PIN      36
+#define PB_POWER_DIVIDER_X1000  2000
+#define PB_POWER_LOST_MV        4300
+#define PB_POWER_RESTORED_MV    4600
+#define PB_POWER_SAMPLE_MS      2
+#define PB_POWER_CONFIRM_SAMPLES 3
+#define PB_LAST_GASP_BUDGET_MS  250
+
+#endif // CONFIG_H
@@ -0,0 +1,35 @@
+/*
+ * PowerBot: хостова заміна esp_pm.h для симуляції прошивки (як IDF без CONFIG_PM_ENABLE).
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+#define ESP_IDF_VERSION_MAJOR 5
+
+struct esp_pm_config_t {
+    int max_freq_mhz;
+    int min_freq_mhz;
+    bool light_sleep_enable;
+};
+
+enum esp_pm_lock_type_t { ESP_PM_CPU_FREQ_MAX, ESP_PM_APB_FREQ_MAX, ESP_PM_NO_LIGHT_SLEEP };
+
+typedef struct PbSimPmLock *esp_pm_lock_handle_t;
+
+inline esp_err_t esp_pm_configure(const void *) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+inline esp_err_t esp_pm_lock_create(esp_pm_lock_type_t, int, const char *, esp_pm_lock_handle_t *) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+inline esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t) {
+    return ESP_OK;
+}
+
+inline esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t) {
+    return ESP_OK;
+}
@@ -0,0 +1,61 @@
+/*
+ * PowerBot: хостова заміна esp_timer для симуляції прошивки.
+ *
+ * Одноразові таймери — події pb_sim.h: колбек виконується в момент дедлайну, коли
+ * симуляція доходить до нього (у delay() / очікуванні net-задачі або в тесті).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "pb_sim.h"
+
+typedef void (*esp_timer_cb_t)(void *);
+
+struct esp_timer_create_args_t {
+    esp_timer_cb_t callback;
+    void *arg;
+    const char *name;
+};
+
+struct PbSimTimer {
+    esp_timer_cb_t callback;
+    void *arg;
+    uint64_t event;   // id події pb_sim.h; 0 — не зведений
+};
+typedef PbSimTimer *esp_timer_handle_t;
+
+inline int64_t esp_timer_get_time() {
+    return static_cast<int64_t>(pbSim().nowUs);
+}
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out) {
+    PbSimTimer *t = new PbSimTimer();
+    t->callback = args->callback;
+    t->arg = args->arg;
+    t->event = 0;
+    *out = t;
+    return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t afterUs) {
+    if (t->event != 0) {
+        return ESP_ERR_INVALID_STATE;   // як у IDF: вже зведений
+    }
+    t->event = pbSimAt(pbSim().nowUs + afterUs, [t]() {
+        t->event = 0;
+        t->callback(t->arg);
+    });
+    return ESP_OK;
+}
+
+inline esp_err_t esp_timer_stop(esp_timer_handle_t t) {
+    if (t->event == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    pbSimCancel(t->event);
+    t->event = 0;
+    return ESP_OK;
+}
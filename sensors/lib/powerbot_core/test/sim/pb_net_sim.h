@@ -0,0 +1,299 @@
+/*
+ * PowerBot: адаптер мережі для симуляції — сервер PowerBot і DNS за сценарієм тесту.
+ *
+ * PbSimNet / PbSimDnsNet мають той самий інтерфейс, що pb_net_lwip.h, тож pb_sensor.h
+ * збирається з ними без змін. Затримки — у симульованому часі (pb_sim.h): connect, DNS і
+ * кожна відповідь сервера "приходять" у свій момент, відповідь може йти шматками і
+ * обриватися. Лінк (pbSimServer().link) вимкнений — пакети нікуди не доходять.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "Arduino.h"
+#include "pb_dns_cache.h"
+#include "pb_hb_fsm.h"
+#include "pb_sim.h"
+
+static const uint32_t kPbSimNever = UINT32_MAX;
+
+inline uint32_t pbSimIp(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+    return static_cast<uint32_t>(IPAddress(a, b, c, d));
+}
+
+// Відповідь сервера на один запит.
+struct PbSimReply {
+    std::string bytes;
+    uint32_t delayMs;      // від останнього байта запиту до першого байта відповіді; kPbSimNever — мовчить
+    size_t chunk;          // байтів за шматок; 0 — все разом
+    uint32_t chunkGapMs;   // пауза між шматками
+    bool close;            // закрити з'єднання після відповіді
+};
+
+inline PbSimReply pbSimReplyOk(uint32_t delayMs, const char *extraHeaders = "") {
+    PbSimReply r;
+    r.bytes = std::string("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n") + extraHeaders +
+              "Content-Length: 15\r\n\r\n{\"status\":\"ok\"}";
+    r.delayMs = delayMs;
+    r.chunk = 0;
+    r.chunkGapMs = 0;
+    r.close = false;
+    return r;
+}
+
+// Запит, який сервер отримав повністю.
+struct PbSimRequest {
+    uint64_t atUs;
+    std::string path;
+    std::string head;
+    std::string body;
+    unsigned conn;   // номер TCP-з'єднання (1, 2, ...): однаковий — keep-alive
+};
+
+struct PbSimServer {
+    // Мережа
+    bool link = true;
+    uint32_t addr = pbSimIp(10, 0, 0, 2);   // адреса SERVER_HOST, network byte order
+    uint32_t connectMs = 3;
+    bool refuse = false;          // RST на connect
+    uint32_t dnsMs = 2;
+    uint32_t dnsTtlS = 300;
+    bool dnsDown = false;         // DNS не відповідає
+
+    // Відповіді: спершу script, далі reply
+    std::deque<PbSimReply> script;
+    PbSimReply reply = pbSimReplyOk(20);
+
+    // Що побачив сервер
+    std::vector<PbSimRequest> requests;
+    unsigned connects = 0;
+    unsigned dnsQueries = 0;
+
+    // Поточне з'єднання (0 — немає) і його буфери
+    unsigned conn = 0;
+    uint64_t connReadyUs = 0;
+    std::string rx;                                       // клієнт -> сервер, ще не розібране
+    std::deque<std::pair<uint64_t, std::string>> tx;      // сервер -> клієнт: (доступно з, байти)
+    uint64_t closeAtUs = 0;                               // FIN після відповіді; 0 — ні
+
+    void drop() {
+        conn = 0;
+        rx.clear();
+        tx.clear();
+        closeAtUs = 0;
+    }
+
+    // Повні запити з rx: заголовки до \r\n\r\n + Content-Length байтів тіла.
+    void parse() {
+        for (;;) {
+            const size_t headEnd = rx.find("\r\n\r\n");
+            if (headEnd == std::string::npos) {
+                return;
+            }
+            const size_t cl = rx.find("Content-Length: ");
+            const size_t bodyLen = (cl != std::string::npos && cl < headEnd) ? strtoul(rx.c_str() + cl + 16, nullptr, 10) : 0;
+            if (rx.size() < headEnd + 4 + bodyLen) {
+                return;
+            }
+            PbSimRequest req;
+            req.atUs = pbSim().nowUs;
+            req.head = rx.substr(0, headEnd + 4);
+            req.body = rx.substr(headEnd + 4, bodyLen);
+            const size_t sp = req.head.find(' ');
+            req.path = req.head.substr(sp + 1, req.head.find(' ', sp + 1) - sp - 1);
+            req.conn = conn;
+            rx.erase(0, headEnd + 4 + bodyLen);
+            requests.push_back(req);
+            respond();
+        }
+    }
+
+    void respond() {
+        PbSimReply r = reply;
+        if (!script.empty()) {
+            r = script.front();
+            script.pop_front();
+        }
+        if (r.delayMs == kPbSimNever) {
+            return;
+        }
+        uint64_t at = pbSim().nowUs + static_cast<uint64_t>(r.delayMs) * 1000u;
+        const size_t chunk = r.chunk == 0 ? r.bytes.size() : r.chunk;
+        for (size_t i = 0; i < r.bytes.size(); i += chunk) {
+            tx.push_back(std::make_pair(at, r.bytes.substr(i, chunk)));
+            at += static_cast<uint64_t>(r.chunkGapMs) * 1000u;
+        }
+        if (r.close) {
+            closeAtUs = tx.empty() ? pbSim().nowUs : tx.back().first;
+        }
+    }
+};
+
+inline PbSimServer &pbSimServer() {
+    static PbSimServer server;
+    return server;
+}
+
+// DNS-сервер з DHCP: на запит A відповідає адресою pbSimServer().addr через dnsMs.
+class PbSimDnsNet {
+public:
+    long dnsSend(const uint8_t *data, size_t len) {
+        PbSimServer &s = pbSimServer();
+        if (!s.link) {
+            return -1;
+        }
+        s.dnsQueries++;
+        if (s.dnsDown) {
+            return static_cast<long>(len);
+        }
+        // Відповідь: питання як є, одна A-відповідь з покажчиком на ім'я.
+        std::string m(reinterpret_cast<const char *>(data), len);
+        m[2] = static_cast<char>(0x81);
+        m[3] = static_cast<char>(0x80);
+        m[7] = 1;
+        const uint8_t rr[] = {0xC0, 0x0C, 0, 1, 0, 1,
+                              static_cast<uint8_t>(s.dnsTtlS >> 24), static_cast<uint8_t>(s.dnsTtlS >> 16),
+                              static_cast<uint8_t>(s.dnsTtlS >> 8), static_cast<uint8_t>(s.dnsTtlS), 0, 4};
+        m.append(reinterpret_cast<const char *>(rr), sizeof(rr));
+        m.append(reinterpret_cast<const char *>(&s.addr), 4);
+        answer_ = m;
+        answerAtUs_ = pbSim().nowUs + static_cast<uint64_t>(s.dnsMs) * 1000u;
+        return static_cast<long>(len);
+    }
+
+    long dnsRecv(uint8_t *buf, size_t cap) {
+        if (answer_.empty() || pbSim().nowUs < answerAtUs_ || !pbSimServer().link) {
+            return 0;
+        }
+        const size_t n = answer_.size() < cap ? answer_.size() : cap;
+        memcpy(buf, answer_.data(), n);
+        answer_.clear();
+        return static_cast<long>(n);
+    }
+
+    void dnsClose() { answer_.clear(); }
+
+private:
+    std::string answer_;
+    uint64_t answerAtUs_ = 0;
+};
+
+// TCP до pbSimServer(): той самий контракт non-blocking, що й PbLwipNet.
+class PbSimNet {
+public:
+    explicit PbSimNet(PbDnsResolver<PbSimDnsNet> &dns) : dns_(dns) {}
+
+    bool isOpen() {
+        PbSimServer &s = pbSimServer();
+        if (!open_ || s.conn != conn_) {
+            return false;
+        }
+        const bool fin = s.closeAtUs != 0 && pbSim().nowUs >= s.closeAtUs;
+        return !fin || !s.tx.empty();
+    }
+
+    int startResolve(const char *host) {
+        if (pbParseIpv4(host, addr_)) {
+            return PB_NET_OK;
+        }
+        if (!dns_.has()) {
+            dns_.kick(millis());
+        }
+        return pollResolve();
+    }
+
+    int pollResolve() {
+        if (!dns_.has()) {
+            return PB_NET_PENDING;
+        }
+        addr_ = dns_.addr();
+        return PB_NET_OK;
+    }
+
+    int startConnect(uint16_t) {
+        close();
+        PbSimServer &s = pbSimServer();
+        s.drop();
+        s.conn = conn_ = ++s.connects;
+        s.connReadyUs = pbSim().nowUs + static_cast<uint64_t>(s.connectMs) * 1000u;
+        open_ = true;
+        return pollConnect();
+    }
+
+    int pollConnect() {
+        PbSimServer &s = pbSimServer();
+        if (!open_ || s.conn != conn_ || addr_ != s.addr) {
+            return PB_NET_PENDING;   // SYN у нікуди: таймаут — у PbHbMachine
+        }
+        if (!s.link || pbSim().nowUs < s.connReadyUs) {
+            return PB_NET_PENDING;
+        }
+        if (s.refuse) {
+            close();
+            return PB_NET_FAIL;
+        }
+        return PB_NET_OK;
+    }
+
+    long write(const uint8_t *data, size_t len) {
+        PbSimServer &s = pbSimServer();
+        if (!open_ || s.conn != conn_) {
+            return -1;
+        }
+        if (!s.link) {
+            return 0;   // буфер відправки стоїть
+        }
+        s.rx.append(reinterpret_cast<const char *>(data), len);
+        s.parse();
+        return static_cast<long>(len);
+    }
+
+    long read(uint8_t *buf, size_t cap) {
+        PbSimServer &s = pbSimServer();
+        if (!open_ || s.conn != conn_) {
+            return -1;
+        }
+        if (!s.link) {
+            return 0;
+        }
+        if (!s.tx.empty() && s.tx.front().first <= pbSim().nowUs) {
+            std::string &front = s.tx.front().second;
+            const size_t n = front.size() < cap ? front.size() : cap;
+            memcpy(buf, front.data(), n);
+            front.erase(0, n);
+            if (front.empty()) {
+                s.tx.pop_front();
+            }
+            return static_cast<long>(n);
+        }
+        if (s.tx.empty() && s.closeAtUs != 0 && pbSim().nowUs >= s.closeAtUs) {
+            return -1;
+        }
+        return 0;
+    }
+
+    // UDP-транспорт у симуляції не моделюється.
+    long sendDatagram(const uint8_t *, size_t, uint16_t) { return -1; }
+    long recvDatagram(uint8_t *, size_t) { return -1; }
+    void closeDatagram() {}
+
+    void close() {
+        if (open_ && pbSimServer().conn == conn_) {
+            pbSimServer().drop();
+        }
+        open_ = false;
+    }
+
+private:
+    PbDnsResolver<PbSimDnsNet> &dns_;
+    bool open_ = false;
+    unsigned conn_ = 0;
+    uint32_t addr_ = 0;
+};
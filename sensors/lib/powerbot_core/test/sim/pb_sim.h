@@ -0,0 +1,88 @@
+/*
+ * PowerBot: ядро хостової симуляції прошивки — симульований годинник і черга подій.
+ *
+ * Весь "час" прошивки (millis / micros / esp_timer_get_time) — pbSim().nowUs. Він іде вперед
+ * лише тоді, коли прошивка чекає (delay(), xEventGroupWaitBits()) або тест явно просуває його;
+ * по дорозі в порядку часу виконуються події: таймери esp_timer і кроки сценарію тесту
+ * (лінк упав, DHCP видав адресу, сервер відповів). Тож кожен прогін детермінований.
+ *
+ * Справжніх задач FreeRTOS немає: net-задачу тест крутить сам (pbNetTaskStep()).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+
+struct PbSimWorld {
+    uint64_t nowUs = 0;
+    uint64_t nextId = 1;
+    std::map<std::pair<uint64_t, uint64_t>, std::function<void()>> events;   // (час, id) -> дія
+    std::map<uint64_t, uint64_t> eventAt;                                     // id -> час
+    std::string serial;                                                       // усе, що пішло в Serial
+    std::map<std::string, std::string> nvs;                                   // "namespace/key" -> байти
+};
+
+inline PbSimWorld &pbSim() {
+    static PbSimWorld world;
+    return world;
+}
+
+// Дія в момент atUs (не раніше "зараз"); id — для pbSimCancel().
+inline uint64_t pbSimAt(uint64_t atUs, std::function<void()> fn) {
+    PbSimWorld &w = pbSim();
+    const uint64_t at = atUs > w.nowUs ? atUs : w.nowUs;
+    const uint64_t id = w.nextId++;
+    w.events[std::make_pair(at, id)] = fn;
+    w.eventAt[id] = at;
+    return id;
+}
+
+inline uint64_t pbSimAfterMs(uint32_t ms, std::function<void()> fn) {
+    return pbSimAt(pbSim().nowUs + static_cast<uint64_t>(ms) * 1000u, fn);
+}
+
+inline void pbSimCancel(uint64_t id) {
+    PbSimWorld &w = pbSim();
+    std::map<uint64_t, uint64_t>::iterator it = w.eventAt.find(id);
+    if (it == w.eventAt.end()) {
+        return;
+    }
+    w.events.erase(std::make_pair(it->second, id));
+    w.eventAt.erase(it);
+}
+
+// Виконує події до targetUs включно і ставить годинник на targetUs. Якщо задано until —
+// зупиняється одразу після події, яка його виконала (годинник лишається на її часі).
+inline bool pbSimRunUntil(uint64_t targetUs, const std::function<bool()> &until = std::function<bool()>()) {
+    PbSimWorld &w = pbSim();
+    if (until && until()) {
+        return true;
+    }
+    while (!w.events.empty() && w.events.begin()->first.first <= targetUs) {
+        std::map<std::pair<uint64_t, uint64_t>, std::function<void()>>::iterator it = w.events.begin();
+        const uint64_t at = it->first.first;
+        const std::function<void()> fn = it->second;
+        w.eventAt.erase(it->first.second);
+        w.events.erase(it);
+        if (at > w.nowUs) {
+            w.nowUs = at;
+        }
+        fn();
+        if (until && until()) {
+            return true;
+        }
+    }
+    if (targetUs > w.nowUs) {
+        w.nowUs = targetUs;
+    }
+    return false;
+}
+
+inline void pbSimAdvanceUs(uint64_t us) {
+    pbSimRunUntil(pbSim().nowUs + us);
+}
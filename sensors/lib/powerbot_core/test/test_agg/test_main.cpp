@@ -0,0 +1,214 @@
+// Host-side tests for include/pb_agg.h (pio test -e native).
+//
+// Peers are built with the same pbFrameEncode() / JSON body the firmware sends, so the
+// aggregator sees exactly what a section sensor puts on the LAN.
+
+#include <unity.h>
+
+#include <string>
+
+#include "pb_agg.h"
+
+namespace {
+
+const char kApiKey[] = "agg-key";
+const PbHmacKey kKey(reinterpret_cast<const uint8_t *>(kApiKey), sizeof(kApiKey) - 1);
+
+std::string frame(const char *uuid, PbFrameEvent event, uint32_t seq, uint16_t building = 7, uint16_t section = 2,
+                  uint32_t bootCount = 1) {
+    uint8_t hash[PB_FRAME_UUID_HASH_SIZE];
+    pbFrameUuidHash(uuid, hash);
+    uint8_t out[PB_FRAME_SIZE];
+    pbFrameEncode(out, kKey, event, building, section, hash, seq, 100 + seq, bootCount);
+    return std::string(reinterpret_cast<const char *>(out), sizeof(out));
+}
+
+std::string json(const char *uuid, const char *event, uint32_t seq, const char *key = kApiKey, uint32_t bootCount = 1) {
+    // Як PB_HB_BODY: слоти, доповнені пробілами.
+    return std::string("{\"api_key\":\"") + key + "\",\"building_id\":7,\"section_id\":3,\"sensor_uuid\":\"" + uuid +
+           "\",\"comment\":\"\",\"event\":\"" + event + "\"    ,\"seq\":         " + std::to_string(seq) +
+           ",\"uptime_s\":        55,\"boot_count\":         " + std::to_string(bootCount) +
+           ",\"heap_free\":    100000}";
+}
+
+template <size_t N>
+std::string accept(PbAggTable<N> &t, const std::string &d, uint32_t nowMs = 1000) {
+    char ack[48];
+    const size_t n = t.accept(reinterpret_cast<const uint8_t *>(d.data()), d.size(), nowMs, ack, sizeof(ack));
+    return std::string(ack, n);
+}
+
+template <size_t N>
+std::string beats(PbAggTable<N> &t, uint32_t nowMs) {
+    char out[N * kPbAggRecJsonMax];
+    return std::string(out, t.putBeatsJson(out, sizeof(out), nowMs));
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_json_field_finder(void) {
+    const std::string j = json("s-1", "boot", 42);
+    uint32_t v = 0;
+    TEST_ASSERT_TRUE(pbAggJsonUint(j.data(), j.size(), "seq", &v));
+    TEST_ASSERT_EQUAL_UINT32(42, v);
+    TEST_ASSERT_TRUE(pbAggJsonStrIs(j.data(), j.size(), "event", "boot"));
+    TEST_ASSERT_FALSE(pbAggJsonStrIs(j.data(), j.size(), "event", "heartbeat"));
+    TEST_ASSERT_FALSE(pbAggJsonUint(j.data(), j.size(), "missing", &v));
+
+    const char esc[] = "{\"sensor_uuid\":\"a\\\"b\",\"heartbeat_seq\":9}";
+    const char *val;
+    size_t n;
+    TEST_ASSERT_FALSE(pbAggJsonField(esc, sizeof(esc) - 1, "sensor_uuid", &val, &n));
+    TEST_ASSERT_FALSE(pbAggJsonUint(esc, sizeof(esc) - 1, "seq", &v));   // не "heartbeat_seq"
+}
+
+void test_frame_and_json_beats_are_acked_and_batched(void) {
+    PbAggTable<4> t(kKey, kApiKey, 7, 60000);
+    TEST_ASSERT_EQUAL_STRING("OK 5", accept(t, frame("peer-a", PbFrameEvent::Heartbeat, 5)).c_str());
+    TEST_ASSERT_FALSE(t.takeUrgent());
+    TEST_ASSERT_EQUAL_STRING("OK 1", accept(t, json("peer-b", "boot", 1), 1500).c_str());
+    TEST_ASSERT_TRUE(t.takeUrgent());
+    TEST_ASSERT_FALSE(t.takeUrgent());
+    TEST_ASSERT_EQUAL(2, t.pending());
+
+    uint8_t hash[PB_FRAME_UUID_HASH_SIZE];
+    pbFrameUuidHash("peer-a", hash);
+    char hex[2 * PB_FRAME_UUID_HASH_SIZE + 1];
+    for (size_t i = 0; i < PB_FRAME_UUID_HASH_SIZE; i++) {
+        snprintf(hex + 2 * i, 3, "%02x", hash[i]);
+    }
+    const std::string expect = std::string(",{\"uuid_hash\":\"") + hex +
+                               "\",\"section_id\":2,\"event\":\"heartbeat\",\"seq\":5,\"uptime_s\":105,\"age_ms\":2000}"
+                               ",{\"sensor_uuid\":\"peer-b\",\"section_id\":3,\"event\":\"boot\",\"seq\":1,"
+                               "\"uptime_s\":55,\"age_ms\":1500}";
+    TEST_ASSERT_EQUAL_STRING(expect.c_str(), beats(t, 3000).c_str());
+}
+
+void test_results_clear_delivered_and_keep_the_rest(void) {
+    PbAggTable<4> t(kKey, kApiKey, 7, 60000);
+    accept(t, frame("peer-a", PbFrameEvent::Heartbeat, 5));
+    accept(t, frame("peer-b", PbFrameEvent::Heartbeat, 9));
+    accept(t, frame("peer-c", PbFrameEvent::Heartbeat, 2));
+    beats(t, 2000);
+
+    // Обрізане тіло: статус третього сусіда не дійшов — його beat піде в наступному пакеті.
+    t.applyResults(true, "{\"results\": [200, 200, 400, 50");
+    TEST_ASSERT_FALSE(t.at(0).fresh);
+    TEST_ASSERT_FALSE(t.at(1).fresh);
+    TEST_ASSERT_TRUE(t.at(2).fresh);
+    TEST_ASSERT_EQUAL(1, t.pending());
+    TEST_ASSERT_TRUE(t.uplinkOk());
+}
+
+void test_unknown_sensor_is_asked_for_json(void) {
+    PbAggTable<4> t(kKey, kApiKey, 7, 60000);
+    accept(t, frame("peer-a", PbFrameEvent::Heartbeat, 5));
+    beats(t, 2000);
+    t.applyResults(true, "{\"results\": [200, 404], \"status\": \"ok\"}");
+    TEST_ASSERT_FALSE(t.at(0).fresh);
+    TEST_ASSERT_EQUAL_STRING("ERR 404 6", accept(t, frame("peer-a", PbFrameEvent::Heartbeat, 6)).c_str());
+    TEST_ASSERT_EQUAL(0, t.pending());
+
+    // JSON beat (як після ERR 404 від сервера) реєструє сенсор: далі frame-и знову приймаються.
+    TEST_ASSERT_EQUAL_STRING("OK 7", accept(t, json("peer-a", "heartbeat", 7)).c_str());
+    TEST_ASSERT_EQUAL_STRING("OK 8", accept(t, frame("peer-a", PbFrameEvent::Heartbeat, 8)).c_str());
+    TEST_ASSERT_EQUAL_STRING("peer-a", t.at(0).uuid);   // і пересилається за uuid, не за хешем
+    TEST_ASSERT_NOT_EQUAL(std::string::npos, beats(t, 2000).find("\"sensor_uuid\":\"peer-a\""));
+}
+
+void test_failed_upload_naks_peers_until_next_success(void) {
+    PbAggTable<4> t(kKey, kApiKey, 7, 60000);
+    accept(t, frame("peer-a", PbFrameEvent::Heartbeat, 5));
+    beats(t, 2000);
+    t.applyResults(false, "");
+    TEST_ASSERT_FALSE(t.uplinkOk());
+    TEST_ASSERT_TRUE(t.at(0).fresh);
+    TEST_ASSERT_EQUAL_STRING("ERR 503 6", accept(t, frame("peer-a", PbFrameEvent::Heartbeat, 6)).c_str());
+
+    beats(t, 3000);
+    t.applyResults(true, "{\"results\": [200, 200]}");
+    TEST_ASSERT_EQUAL_STRING("OK 7", accept(t, frame("peer-a", PbFrameEvent::Heartbeat, 7)).c_str());
+}
+
+void test_beat_that_arrives_during_upload_stays_fresh(void) {
+    PbAggTable<4> t(kKey, kApiKey, 7, 60000);
+    accept(t, frame("peer-a", PbFrameEvent::Heartbeat, 5));
+    beats(t, 2000);
+    accept(t, frame("peer-a", PbFrameEvent::PowerLost, 5), 2100);
+    t.applyResults(true, "{\"results\": [200, 200]}");
+    TEST_ASSERT_TRUE(t.at(0).fresh);
+    TEST_ASSERT_TRUE(t.takeUrgent());
+    TEST_ASSERT_NOT_EQUAL(std::string::npos, beats(t, 2200).find("\"event\":\"power_lost\""));
+}
+
+void test_rejects_foreign_and_forged_beats(void) {
+    PbAggTable<2> t(kKey, kApiKey, 7, 60000);
+    TEST_ASSERT_EQUAL_STRING("ERR 400 5", accept(t, frame("peer-a", PbFrameEvent::Heartbeat, 5, 8)).c_str());
+    std::string forged = frame("peer-a", PbFrameEvent::Heartbeat, 5);
+    forged[PB_FRAME_SIZE - 1] ^= 0x01;
+    TEST_ASSERT_EQUAL_STRING("ERR 401 5", accept(t, forged).c_str());
+    TEST_ASSERT_EQUAL_STRING("ERR 401 3", accept(t, json("peer-a", "heartbeat", 3, "wrong")).c_str());
+    TEST_ASSERT_EQUAL_STRING("", accept(t, "hello").c_str());
+    TEST_ASSERT_EQUAL(0, t.pending());
+}
+
+void test_replayed_frames_do_not_overwrite_newer_beat(void) {
+    PbAggTable<2> t(kKey, kApiKey, 7, 60000);
+    const std::string old = frame("peer-a", PbFrameEvent::Heartbeat, 5, 7, 2, 3);
+    const std::string lost = frame("peer-a", PbFrameEvent::PowerLost, 6, 7, 2, 3);
+    TEST_ASSERT_EQUAL_STRING("OK 5", accept(t, old).c_str());
+    TEST_ASSERT_EQUAL_STRING("OK 6", accept(t, frame("peer-a", PbFrameEvent::Heartbeat, 6, 7, 2, 3)).c_str());
+    TEST_ASSERT_EQUAL_STRING("ERR 409 5", accept(t, old).c_str());
+    TEST_ASSERT_EQUAL_STRING("ERR 409 6", accept(t, frame("peer-a", PbFrameEvent::Heartbeat, 6, 7, 2, 3)).c_str());
+    TEST_ASSERT_EQUAL_UINT32(6, t.at(0).seq);
+
+    // power_lost з тим самим seq — новіший за beat; його повтор — ні.
+    TEST_ASSERT_EQUAL_STRING("OK 6", accept(t, lost).c_str());
+    TEST_ASSERT_EQUAL_STRING("ERR 409 6", accept(t, lost).c_str());
+    TEST_ASSERT_EQUAL(PbFrameEvent::PowerLost, t.at(0).event);
+
+    // Перехоплені frame-и минулого boot (і сам boot) не відкривають стару епоху, хоч seq і менший.
+    TEST_ASSERT_EQUAL_STRING("ERR 409 1", accept(t, frame("peer-a", PbFrameEvent::Boot, 1, 7, 2, 2)).c_str());
+    TEST_ASSERT_EQUAL_STRING("ERR 409 900", accept(t, frame("peer-a", PbFrameEvent::Heartbeat, 900, 7, 2, 2)).c_str());
+    TEST_ASSERT_EQUAL_UINT32(3, t.at(0).bootCount);
+
+    // Справжній перезапуск: boot_count більший — нова епоха, старі frame-и вже не проходять.
+    TEST_ASSERT_EQUAL_STRING("OK 1", accept(t, frame("peer-a", PbFrameEvent::Boot, 1, 7, 2, 4)).c_str());
+    TEST_ASSERT_EQUAL_STRING("ERR 409 7", accept(t, frame("peer-a", PbFrameEvent::Heartbeat, 7, 7, 2, 3)).c_str());
+
+    // JSON (реєстрація) — нова база з його boot_count.
+    TEST_ASSERT_EQUAL_STRING("OK 1", accept(t, json("peer-a", "boot", 1, kApiKey, 5)).c_str());
+    TEST_ASSERT_EQUAL_STRING("ERR 409 3", accept(t, frame("peer-a", PbFrameEvent::Heartbeat, 3, 7, 2, 4)).c_str());
+    TEST_ASSERT_EQUAL_STRING("OK 2", accept(t, frame("peer-a", PbFrameEvent::Heartbeat, 2, 7, 2, 5)).c_str());
+}
+
+void test_full_table_forgets_only_silent_peers(void) {
+    PbAggTable<2> t(kKey, kApiKey, 7, 60000);
+    accept(t, frame("peer-a", PbFrameEvent::Heartbeat, 1), 1000);
+    accept(t, frame("peer-b", PbFrameEvent::Heartbeat, 1), 2000);
+    TEST_ASSERT_EQUAL_STRING("ERR 503 1", accept(t, frame("peer-c", PbFrameEvent::Heartbeat, 1), 30000).c_str());
+
+    // peer-a мовчить довше за forgetMs — його запис переходить новому сусіду.
+    TEST_ASSERT_EQUAL_STRING("OK 1", accept(t, frame("peer-c", PbFrameEvent::Heartbeat, 1), 61500).c_str());
+    uint8_t hash[PB_FRAME_UUID_HASH_SIZE];
+    pbFrameUuidHash("peer-c", hash);
+    TEST_ASSERT_EQUAL_MEMORY(hash, t.at(0).uuidHash, PB_FRAME_UUID_HASH_SIZE);
+    TEST_ASSERT_EQUAL_STRING("OK 2", accept(t, frame("peer-b", PbFrameEvent::Heartbeat, 2), 61600).c_str());
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_json_field_finder);
+    RUN_TEST(test_frame_and_json_beats_are_acked_and_batched);
+    RUN_TEST(test_results_clear_delivered_and_keep_the_rest);
+    RUN_TEST(test_unknown_sensor_is_asked_for_json);
+    RUN_TEST(test_failed_upload_naks_peers_until_next_success);
+    RUN_TEST(test_beat_that_arrives_during_upload_stays_fresh);
+    RUN_TEST(test_rejects_foreign_and_forged_beats);
+    RUN_TEST(test_replayed_frames_do_not_overwrite_newer_beat);
+    RUN_TEST(test_full_table_forgets_only_silent_peers);
+    return UNITY_END();
+}
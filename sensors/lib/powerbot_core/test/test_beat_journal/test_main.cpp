@@ -0,0 +1,95 @@
+// Host-side tests for include/pb_beat_journal.h (pio test -e native).
+//
+// The journal must keep the start and the end of an outage no matter how long it
+// runs, and the catch-up body must be exactly what the bulk endpoint parses.
+
+#include <unity.h>
+
+#include <string.h>
+
+#include "pb_beat_journal.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_records_every_slot_until_full(void) {
+    PbBeatJournal<8> j;
+    TEST_ASSERT_TRUE(j.empty());
+    for (uint32_t i = 1; i <= 8; i++) {
+        j.add(i, i * 10);
+    }
+    TEST_ASSERT_EQUAL(8, j.size());
+    TEST_ASSERT_EQUAL(1, j.stride());
+    TEST_ASSERT_EQUAL(1, j.at(0).seq);
+    TEST_ASSERT_EQUAL(8, j.at(7).seq);
+}
+
+void test_full_journal_thins_and_keeps_both_ends(void) {
+    PbBeatJournal<8> j;
+    for (uint32_t i = 1; i <= 1000; i++) {
+        j.add(i, i * 10);
+        TEST_ASSERT_TRUE(j.size() <= 9);   // N + відкладений останній слот
+    }
+    TEST_ASSERT_EQUAL(1, j.at(0).seq);              // початок відключення
+    TEST_ASSERT_EQUAL(1000, j.at(j.size() - 1).seq);   // останній слот
+    TEST_ASSERT_TRUE(j.stride() >= 64);
+    for (size_t i = 1; i < j.size(); i++) {
+        TEST_ASSERT_TRUE(j.at(i).uptimeS > j.at(i - 1).uptimeS);
+    }
+}
+
+void test_power_lost_marker_survives_thinning(void) {
+    PbBeatJournal<8> j;
+    j.markPowerLost(5);   // порожній журнал — маркер не потрібен
+    TEST_ASSERT_TRUE(j.empty());
+    for (uint32_t i = 1; i <= 6; i++) {
+        j.add(i, i * 10);
+    }
+    j.markPowerLost(65);
+    for (uint32_t i = 7; i <= 200; i++) {
+        j.add(i, i * 10 + 100);
+    }
+    bool marker = false;
+    for (size_t i = 0; i < j.size(); i++) {
+        if (j.at(i).seq == 0) {
+            marker = true;
+            TEST_ASSERT_EQUAL(65, j.at(i).uptimeS);
+            TEST_ASSERT_TRUE(i > 0);
+            TEST_ASSERT_EQUAL(6, j.at(i - 1).seq);   // кінець відрізка до втрати живлення
+        }
+    }
+    TEST_ASSERT_TRUE(marker);
+}
+
+void test_json_uses_age_relative_to_send_time(void) {
+    PbBeatJournal<8> j;
+    j.add(41, 100);
+    j.add(42, 110);
+    char out[128];
+    const size_t n = pbJournalPutJson(out, sizeof(out), j, 130);
+    out[n] = '\0';
+    TEST_ASSERT_EQUAL_STRING("[[41,30],[42,20]]", out);
+    // Не влазить — 0, буфер не чіпаємо.
+    TEST_ASSERT_EQUAL(0, pbJournalPutJson(out, 16, j, 130));
+    j.clear();
+    TEST_ASSERT_EQUAL(2, pbJournalPutJson(out, sizeof(out), j, 130));
+}
+
+void test_worst_case_record_fits_budget(void) {
+    PbBeatJournal<4> j;
+    for (int i = 0; i < 4; i++) {
+        j.add(4294967295u, 0);
+    }
+    char out[2 + 4 * kPbJournalRecJsonMax];
+    TEST_ASSERT_TRUE(pbJournalPutJson(out, sizeof(out), j, 4294967295u) > 0);
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_records_every_slot_until_full);
+    RUN_TEST(test_full_journal_thins_and_keeps_both_ends);
+    RUN_TEST(test_power_lost_marker_survives_thinning);
+    RUN_TEST(test_json_uses_age_relative_to_send_time);
+    RUN_TEST(test_worst_case_record_fits_budget);
+    return UNITY_END();
+}
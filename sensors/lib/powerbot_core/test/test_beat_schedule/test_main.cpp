@@ -0,0 +1,124 @@
+// Host-side tests for include/pb_beat_schedule.h (pio test -e native).
+//
+// Deadlines must stay on the t0 + phase + k*period grid no matter how late a
+// beat starts, and the interval stats must only see real slot-to-slot gaps.
+
+#include <unity.h>
+
+#include <string.h>
+
+#include "pb_beat_schedule.h"
+
+namespace {
+
+const uint64_t kSec = 1000000;
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_phase_is_stable_and_in_range(void) {
+    const char *uuid = "esp32-newcastle-001";
+    TEST_ASSERT_EQUAL(pbBeatPhaseMs(uuid, 60000), pbBeatPhaseMs(uuid, 60000));
+    TEST_ASSERT_TRUE(pbBeatPhaseMs(uuid, 60000) < 60000);
+    TEST_ASSERT_EQUAL(0, pbBeatPhaseMs(uuid, 0));
+    // Сусідні UUID розходяться.
+    TEST_ASSERT_TRUE(pbBeatPhaseMs("esp32-newcastle-001", 60000) != pbBeatPhaseMs("esp32-newcastle-002", 60000));
+    TEST_ASSERT_EQUAL_HEX32(0x811C9DC5u, pbFnv1a(""));
+}
+
+void test_boot_beat_then_phase_then_grid(void) {
+    PbBeatSchedule s;
+    s.begin(5 * kSec, 10000, 3000);
+    TEST_ASSERT_TRUE(s.due(5 * kSec));
+    TEST_ASSERT_EQUAL(0, s.started(5 * kSec));
+    TEST_ASSERT_EQUAL(8 * kSec, s.next());
+    TEST_ASSERT_FALSE(s.due(8 * kSec - 1));
+    TEST_ASSERT_EQUAL(0, s.started(8 * kSec));   // зсув — не інтервал
+    TEST_ASSERT_EQUAL(18 * kSec, s.next());
+    TEST_ASSERT_EQUAL(10 * kSec, s.started(18 * kSec));
+    TEST_ASSERT_EQUAL(28 * kSec, s.next());
+}
+
+void test_late_beat_does_not_shift_grid(void) {
+    PbBeatSchedule s;
+    s.begin(0, 10000, 0);
+    s.started(0);
+    s.started(10 * kSec);
+    // Beat запізнився на 4 с (запит у польоті): дедлайн не "їде" за ним.
+    TEST_ASSERT_EQUAL(14 * kSec, s.started(24 * kSec));
+    TEST_ASSERT_EQUAL(30 * kSec, s.next());
+    TEST_ASSERT_EQUAL(6 * kSec, s.started(30 * kSec));
+    TEST_ASSERT_EQUAL(4 * kSec, s.deviation().max());
+    TEST_ASSERT_EQUAL(2, s.deviation().count());
+    TEST_ASSERT_EQUAL(0, s.skipped());
+}
+
+void test_missed_slots_are_skipped_not_replayed(void) {
+    PbBeatSchedule s;
+    s.begin(0, 10000, 0);
+    s.started(0);
+    s.started(10 * kSec);
+    // Мережі не було 45 с: один beat одразу, далі знову по сітці.
+    TEST_ASSERT_EQUAL(0, s.started(57 * kSec));
+    TEST_ASSERT_EQUAL(60 * kSec, s.next());
+    TEST_ASSERT_EQUAL(3, s.skipped());   // 30, 40, 50; слот 20 обслужив цей beat
+    TEST_ASSERT_EQUAL(0, s.deviation().count());
+    TEST_ASSERT_EQUAL(3 * kSec, s.started(60 * kSec));
+    s.clearStats();
+    TEST_ASSERT_EQUAL(0, s.skipped());
+    TEST_ASSERT_EQUAL(0, s.deviation().count());
+}
+
+void test_server_period_change(void) {
+    PbBeatSchedule s;
+    s.begin(0, 60000, 0);
+    s.started(0);
+    s.started(60 * kSec);
+    TEST_ASSERT_EQUAL(120 * kSec, s.next());
+    // Сервер попросив 10 с одразу після beat о 60 с: наступний — від останнього beat, а не о 120 с.
+    s.setPeriod(10000);
+    TEST_ASSERT_EQUAL(70 * kSec, s.next());
+    TEST_ASSERT_EQUAL(10 * kSec, s.periodUs());
+    TEST_ASSERT_EQUAL(0, s.started(70 * kSec));   // межа періодів — не інтервал
+    TEST_ASSERT_EQUAL(80 * kSec, s.next());
+    TEST_ASSERT_EQUAL(10 * kSec, s.started(80 * kSec));
+    // Довший період: вже запланований дедлайн лишається.
+    s.setPeriod(30000);
+    TEST_ASSERT_EQUAL(90 * kSec, s.next());
+    s.started(90 * kSec);
+    TEST_ASSERT_EQUAL(120 * kSec, s.next());
+    TEST_ASSERT_EQUAL(0, s.skipped());
+}
+
+void test_json_slots(void) {
+    PbBeatSchedule s;
+    s.begin(0, 10000, 0);
+    s.started(0);
+    s.started(10 * kSec);
+    s.started(20 * kSec + 300);
+    s.started(45 * kSec);
+    char arr[] = PB_HB_INT_JSON;
+    pbBeatIntervalsPut(arr, sizeof(arr) - 1, s);
+    char compact[sizeof(arr)];
+    size_t n = 0;
+    for (const char *c = arr; *c != '\0'; c++) {
+        if (*c != ' ') {
+            compact[n++] = *c;
+        }
+    }
+    compact[n] = '\0';
+    TEST_ASSERT_EQUAL_STRING("[300,300,300,1]", compact);
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_phase_is_stable_and_in_range);
+    RUN_TEST(test_boot_beat_then_phase_then_grid);
+    RUN_TEST(test_late_beat_does_not_shift_grid);
+    RUN_TEST(test_missed_slots_are_skipped_not_replayed);
+    RUN_TEST(test_server_period_change);
+    RUN_TEST(test_json_slots);
+    return UNITY_END();
+}
@@ -0,0 +1,394 @@
+// Host-side tests for include/pb_dns_cache.h (pio test -e native).
+//
+// FakeDnsNet answers from a script, so TTL expiry, background refresh,
+// last-known-good fallback and retry backoff are all deterministic.
+
+#include <unity.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "pb_dns_cache.h"
+
+namespace {
+
+const char *kHost = "sensors.Example.com";
+
+typedef std::vector<uint8_t> Bytes;
+
+uint32_t ip(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+    const uint8_t raw[4] = {a, b, c, d};
+    uint32_t v;
+    memcpy(&v, raw, 4);
+    return v;
+}
+
+void put16(Bytes &m, uint16_t v) {
+    m.push_back(static_cast<uint8_t>(v >> 8));
+    m.push_back(static_cast<uint8_t>(v));
+}
+
+void put32(Bytes &m, uint32_t v) {
+    put16(m, static_cast<uint16_t>(v >> 16));
+    put16(m, static_cast<uint16_t>(v));
+}
+
+struct Rr {
+    uint16_t type;
+    uint32_t ttl;
+    Bytes data;
+};
+
+// Response to pbDnsBuildQuery(id, name): question echoed, answers use a pointer to it.
+Bytes response(uint16_t id, const char *name, uint8_t rcode, const std::vector<Rr> &answers) {
+    uint8_t query[kPbDnsMsgMax];
+    const size_t qlen = pbDnsBuildQuery(query, sizeof(query), id, name);
+    Bytes m(query, query + qlen);
+    m[2] = 0x81;   // QR + RD
+    m[3] = static_cast<uint8_t>(0x80 | rcode);
+    m[6] = 0;
+    m[7] = static_cast<uint8_t>(answers.size());
+    for (size_t i = 0; i < answers.size(); i++) {
+        put16(m, 0xC00C);
+        put16(m, answers[i].type);
+        put16(m, 1);
+        put32(m, answers[i].ttl);
+        put16(m, static_cast<uint16_t>(answers[i].data.size()));
+        m.insert(m.end(), answers[i].data.begin(), answers[i].data.end());
+    }
+    return m;
+}
+
+Rr a(uint8_t d, uint32_t ttl) {
+    Rr r = {1, ttl, Bytes()};
+    const uint8_t raw[4] = {10, 0, 0, d};
+    r.data.assign(raw, raw + 4);
+    return r;
+}
+
+Rr cname(uint32_t ttl) {
+    Rr r = {5, ttl, Bytes()};
+    const uint8_t target[] = {3, 'c', 'd', 'n', 0xC0, 0x0C};
+    r.data.assign(target, target + sizeof(target));
+    return r;
+}
+
+struct FakeDnsNet {
+    std::vector<Bytes> sent;
+    std::deque<Bytes> rx;       // empty Bytes => nothing available on this call
+    bool sendFail = false;
+    bool recvFail = false;
+    int closes = 0;
+
+    long dnsSend(const uint8_t *data, size_t len) {
+        if (sendFail) {
+            return -1;
+        }
+        sent.push_back(Bytes(data, data + len));
+        return static_cast<long>(len);
+    }
+    long dnsRecv(uint8_t *buf, size_t cap) {
+        if (recvFail) {
+            return -1;
+        }
+        if (rx.empty()) {
+            return 0;
+        }
+        Bytes m = rx.front();
+        rx.pop_front();
+        const size_t n = m.size() < cap ? m.size() : cap;
+        memcpy(buf, m.data(), n);
+        return static_cast<long>(n);
+    }
+    void dnsClose() { closes++; }
+
+    uint16_t lastId() const { return static_cast<uint16_t>((sent.back()[0] << 8) | sent.back()[1]); }
+    void answer(uint8_t rcode, const std::vector<Rr> &answers) { rx.push_back(response(lastId(), kHost, rcode, answers)); }
+};
+
+const PbDnsConfig kCfg = {30, 3600, 2000, 5000, 40000};
+
+typedef PbDnsResolver<FakeDnsNet> Resolver;
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_ipv4_literal(void) {
+    uint32_t v = 0;
+    TEST_ASSERT_TRUE(pbParseIpv4("192.168.1.20", v));
+    TEST_ASSERT_EQUAL_HEX32(ip(192, 168, 1, 20), v);
+    TEST_ASSERT_TRUE(pbParseIpv4("0.0.0.0", v));
+    const char *const bad[] = {"256.1.1.1", "1.2.3", "1.2.3.4.5", "1.2.3.4 ", "a.b.c.d", "1..2.3", "", "1234.1.1.1",
+                               "sensors.example.com"};
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        TEST_ASSERT_FALSE_MESSAGE(pbParseIpv4(bad[i], v), bad[i]);
+    }
+}
+
+void test_query_wire_format(void) {
+    uint8_t q[64];
+    const size_t n = pbDnsBuildQuery(q, sizeof(q), 0xBEEF, "a.bc");
+    const uint8_t expected[] = {0xBE, 0xEF, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 0,
+                                1, 'a', 2, 'b', 'c', 0, 0, 1, 0, 1};
+    TEST_ASSERT_EQUAL(sizeof(expected), n);
+    TEST_ASSERT_EQUAL_MEMORY(expected, q, n);
+    TEST_ASSERT_EQUAL(0, pbDnsBuildQuery(q, sizeof(q), 1, "a..b"));
+    TEST_ASSERT_EQUAL(0, pbDnsBuildQuery(q, sizeof(q), 1, "trailing."));
+    TEST_ASSERT_EQUAL(0, pbDnsBuildQuery(q, 10, 1, "a.bc"));
+    TEST_ASSERT_EQUAL(0, pbDnsBuildQuery(q, sizeof(q), 1, ""));
+}
+
+void test_parse_answers(void) {
+    uint32_t addr = 0;
+    uint32_t ttl = 0;
+    Bytes m = response(7, kHost, 0, std::vector<Rr>(1, a(5, 300)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsParse::Ok), static_cast<int>(pbDnsParseResponse(m.data(), m.size(), 7, kHost, addr, ttl)));
+    TEST_ASSERT_EQUAL_HEX32(ip(10, 0, 0, 5), addr);
+    TEST_ASSERT_EQUAL_UINT32(300, ttl);
+
+    // CNAME -> A: the chain's smallest TTL wins; name match is case-insensitive.
+    std::vector<Rr> chain;
+    chain.push_back(cname(60));
+    chain.push_back(a(9, 3600));
+    m = response(7, "SENSORS.example.COM", 0, chain);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsParse::Ok), static_cast<int>(pbDnsParseResponse(m.data(), m.size(), 7, kHost, addr, ttl)));
+    TEST_ASSERT_EQUAL_HEX32(ip(10, 0, 0, 9), addr);
+    TEST_ASSERT_EQUAL_UINT32(60, ttl);
+
+    // TTL with the top bit set is treated as 0 (RFC 2181).
+    m = response(7, kHost, 0, std::vector<Rr>(1, a(5, 0x80000000u)));
+    pbDnsParseResponse(m.data(), m.size(), 7, kHost, addr, ttl);
+    TEST_ASSERT_EQUAL_UINT32(0, ttl);
+
+    // Not ours: other id, other name, a query instead of a response.
+    m = response(8, kHost, 0, std::vector<Rr>(1, a(5, 300)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsParse::Foreign), static_cast<int>(pbDnsParseResponse(m.data(), m.size(), 7, kHost, addr, ttl)));
+    m = response(7, "evil.example.com", 0, std::vector<Rr>(1, a(5, 300)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsParse::Foreign), static_cast<int>(pbDnsParseResponse(m.data(), m.size(), 7, kHost, addr, ttl)));
+    m = response(7, kHost, 0, std::vector<Rr>(1, a(5, 300)));
+    m[2] = 0x01;
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsParse::Foreign), static_cast<int>(pbDnsParseResponse(m.data(), m.size(), 7, kHost, addr, ttl)));
+
+    // NXDOMAIN, SERVFAIL, no A record.
+    m = response(7, kHost, 3, std::vector<Rr>());
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsParse::Failed), static_cast<int>(pbDnsParseResponse(m.data(), m.size(), 7, kHost, addr, ttl)));
+    m = response(7, kHost, 2, std::vector<Rr>());
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsParse::Failed), static_cast<int>(pbDnsParseResponse(m.data(), m.size(), 7, kHost, addr, ttl)));
+    m = response(7, kHost, 0, std::vector<Rr>(1, cname(60)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsParse::Failed), static_cast<int>(pbDnsParseResponse(m.data(), m.size(), 7, kHost, addr, ttl)));
+
+    // Cut inside the answer.
+    m = response(7, kHost, 0, std::vector<Rr>(1, a(5, 300)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsParse::Malformed), static_cast<int>(pbDnsParseResponse(m.data(), m.size() - 2, 7, kHost, addr, ttl)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsParse::Malformed), static_cast<int>(pbDnsParseResponse(m.data(), 11, 7, kHost, addr, ttl)));
+}
+
+void test_random_corruption_never_overruns(void) {
+    std::vector<Rr> chain;
+    chain.push_back(cname(60));
+    chain.push_back(a(9, 3600));
+    const Bytes good = response(7, kHost, 0, chain);
+    uint32_t seed = 0xd115u;
+    for (int round = 0; round < 20000; round++) {
+        Bytes m = good;
+        for (int e = 0; e < 3; e++) {
+            seed = seed * 1664525u + 1013904223u;
+            const size_t at = 12 + (seed >> 8) % (m.size() - 12);
+            m[at] = static_cast<uint8_t>(seed >> 24);
+        }
+        seed = seed * 1664525u + 1013904223u;
+        const size_t len = (seed >> 8) % (m.size() + 1);
+        // Exact-size heap copy: ASan flags any read past the message.
+        uint8_t *copy = new uint8_t[len + 1];
+        memcpy(copy, m.data(), len);
+        uint32_t addr = 0;
+        uint32_t ttl = 0;
+        pbDnsParseResponse(copy, len, 7, kHost, addr, ttl);
+        delete[] copy;
+    }
+}
+
+void test_seed_is_used_at_once_and_refreshed_in_background(void) {
+    FakeDnsNet net;
+    Resolver r(net, kHost, kCfg);
+    TEST_ASSERT_FALSE(r.has());
+    r.seed(ip(10, 0, 0, 1), 0);
+    TEST_ASSERT_TRUE(r.has());
+    TEST_ASSERT_TRUE(r.seeded());
+    TEST_ASSERT_EQUAL_HEX32(ip(10, 0, 0, 1), r.addr());
+
+    // No link — no query.
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsEvent::None), static_cast<int>(r.poll(0, 0, false)));
+    TEST_ASSERT_EQUAL(0, net.sent.size());
+
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsEvent::None), static_cast<int>(r.poll(10, 10000, true)));
+    TEST_ASSERT_EQUAL(1, net.sent.size());
+    TEST_ASSERT_TRUE(r.inFlight());
+    TEST_ASSERT_EQUAL_HEX32(ip(10, 0, 0, 1), r.addr());   // beat still gets the NVS address
+
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsEvent::None), static_cast<int>(r.poll(20, 20000, true)));
+    net.answer(0, std::vector<Rr>(1, a(2, 120)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsEvent::Changed), static_cast<int>(r.poll(40, 43000, true)));
+    TEST_ASSERT_EQUAL_HEX32(ip(10, 0, 0, 2), r.addr());
+    TEST_ASSERT_FALSE(r.seeded());
+    TEST_ASSERT_FALSE(r.stale(40));
+    TEST_ASSERT_EQUAL_UINT32(120, r.ttlS());
+    TEST_ASSERT_EQUAL_UINT32(33000, r.lastUs());
+    TEST_ASSERT_EQUAL(1, r.latency().count());
+    TEST_ASSERT_EQUAL(1, net.closes);
+
+    // Next query only once the TTL is up; the same answer is not a change.
+    r.poll(120039, 0, true);
+    TEST_ASSERT_EQUAL(1, net.sent.size());
+    TEST_ASSERT_TRUE(r.stale(120040));
+    r.poll(120040, 0, true);
+    TEST_ASSERT_EQUAL(2, net.sent.size());
+    net.answer(0, std::vector<Rr>(1, a(2, 120)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsEvent::Resolved), static_cast<int>(r.poll(120050, 0, true)));
+}
+
+void test_ttl_is_clamped(void) {
+    FakeDnsNet net;
+    Resolver r(net, kHost, kCfg);
+    r.poll(0, 0, true);
+    net.answer(0, std::vector<Rr>(1, a(2, 0)));
+    r.poll(1, 0, true);
+    TEST_ASSERT_EQUAL_UINT32(30, r.ttlS());
+    r.poll(30001, 0, true);
+    net.answer(0, std::vector<Rr>(1, a(2, 86400 * 7)));
+    r.poll(30002, 0, true);
+    TEST_ASSERT_EQUAL_UINT32(3600, r.ttlS());
+}
+
+void test_failures_keep_last_known_good_and_back_off(void) {
+    FakeDnsNet net;
+    Resolver r(net, kHost, kCfg);
+    r.poll(0, 0, true);
+    net.answer(0, std::vector<Rr>(1, a(2, 60)));
+    r.poll(1, 0, true);
+
+    // Upstream DNS dies: timeout, SERVFAIL, socket error — the address stays.
+    uint32_t now = 60001;
+    r.poll(now, 0, true);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsEvent::None), static_cast<int>(r.poll(now + 2000, 0, true)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsEvent::Failed), static_cast<int>(r.poll(now + 2001, 0, true)));
+    TEST_ASSERT_EQUAL_HEX32(ip(10, 0, 0, 2), r.addr());
+    TEST_ASSERT_TRUE(r.stale(now + 2001));
+    now += 2001;
+
+    // Backoff 5 s, then 10 s, 20 s, capped at 40 s.
+    const uint32_t waits[] = {5000, 10000, 20000, 40000, 40000};
+    for (size_t i = 0; i < sizeof(waits) / sizeof(waits[0]); i++) {
+        const size_t before = net.sent.size();
+        r.poll(now + waits[i] - 1, 0, true);
+        TEST_ASSERT_EQUAL(before, net.sent.size());
+        // A failed connect does not bypass the backoff while an address is known.
+        r.kick(now);
+        r.poll(now + 1, 0, true);
+        TEST_ASSERT_EQUAL(before, net.sent.size());
+        now += waits[i];
+        r.poll(now, 0, true);
+        TEST_ASSERT_EQUAL(before + 1, net.sent.size());
+        net.answer(2, std::vector<Rr>());
+        TEST_ASSERT_EQUAL(static_cast<int>(PbDnsEvent::Failed), static_cast<int>(r.poll(now, 0, true)));
+    }
+    TEST_ASSERT_EQUAL(6, r.fails());
+    TEST_ASSERT_EQUAL_HEX32(ip(10, 0, 0, 2), r.addr());
+
+    // Recovery resets the backoff.
+    now += 40000;
+    r.poll(now, 0, true);
+    net.answer(0, std::vector<Rr>(1, a(2, 60)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsEvent::Resolved), static_cast<int>(r.poll(now, 0, true)));
+    TEST_ASSERT_EQUAL_UINT32(5000, r.retryMs());
+
+    r.clearStats();
+    TEST_ASSERT_EQUAL(0, r.fails());
+    TEST_ASSERT_EQUAL(0, r.latency().count());
+
+    net.recvFail = true;
+    r.kick(now);   // connect failed, DNS healthy: refresh right away
+    r.poll(now + 1, 0, true);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsEvent::Failed), static_cast<int>(r.poll(now + 2, 0, true)));
+    net.recvFail = false;
+    net.sendFail = true;
+    r.poll(now + 5002, 0, true);
+    TEST_ASSERT_EQUAL(2, r.fails());
+}
+
+void test_no_address_kick_ignores_backoff(void) {
+    FakeDnsNet net;
+    Resolver r(net, kHost, kCfg);
+    r.poll(0, 0, true);
+    net.answer(3, std::vector<Rr>());
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsEvent::Failed), static_cast<int>(r.poll(1, 0, true)));
+    TEST_ASSERT_FALSE(r.has());
+    // A beat needs the address: ask again now, not in 5 s.
+    r.kick(2);
+    r.poll(2, 0, true);
+    TEST_ASSERT_EQUAL(2, net.sent.size());
+    // Foreign datagrams are skipped, the real answer is taken.
+    net.rx.push_back(response(static_cast<uint16_t>(net.lastId() + 1), kHost, 0, std::vector<Rr>(1, a(6, 60))));
+    net.rx.push_back(response(net.lastId(), "other.example.com", 0, std::vector<Rr>(1, a(6, 60))));
+    net.answer(0, std::vector<Rr>(1, a(3, 60)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbDnsEvent::Changed), static_cast<int>(r.poll(3, 0, true)));
+    TEST_ASSERT_EQUAL_HEX32(ip(10, 0, 0, 3), r.addr());
+    // Query ids differ between attempts.
+    TEST_ASSERT_TRUE(net.sent[0][0] != net.sent[1][0] || net.sent[0][1] != net.sent[1][1]);
+}
+
+void test_millis_wraparound(void) {
+    FakeDnsNet net;
+    Resolver r(net, kHost, kCfg);
+    const uint32_t t0 = 0xFFFFFFFFu - 10000;
+    r.seed(ip(10, 0, 0, 1), t0);
+    r.poll(t0, 0, true);
+    net.answer(0, std::vector<Rr>(1, a(2, 60)));
+    r.poll(t0 + 1, 0, true);
+    TEST_ASSERT_FALSE(r.stale(t0 + 59000));
+    r.poll(t0 + 59000, 0, true);
+    TEST_ASSERT_EQUAL(1, net.sent.size());
+    TEST_ASSERT_TRUE(r.stale(t0 + 60001));
+    r.poll(t0 + 60001, 0, true);
+    TEST_ASSERT_EQUAL(2, net.sent.size());
+}
+
+void test_stats_json(void) {
+    FakeDnsNet net;
+    Resolver r(net, kHost, kCfg);
+    r.poll(0, 1000, true);
+    net.answer(0, std::vector<Rr>(1, a(2, 60)));
+    r.poll(1, 1250, true);
+    r.poll(60001, 0, true);
+    net.answer(2, std::vector<Rr>());
+    r.poll(60002, 0, true);
+    char arr[] = PB_HB_DNS_JSON;
+    pbDnsStatsPut(arr, sizeof(arr) - 1, r);
+    char compact[sizeof(arr)];
+    size_t n = 0;
+    for (const char *c = arr; *c != '\0'; c++) {
+        if (*c != ' ') {
+            compact[n++] = *c;
+        }
+    }
+    compact[n] = '\0';
+    TEST_ASSERT_EQUAL_STRING("[250,250,250,1]", compact);
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_ipv4_literal);
+    RUN_TEST(test_query_wire_format);
+    RUN_TEST(test_parse_answers);
+    RUN_TEST(test_random_corruption_never_overruns);
+    RUN_TEST(test_seed_is_used_at_once_and_refreshed_in_background);
+    RUN_TEST(test_ttl_is_clamped);
+    RUN_TEST(test_failures_keep_last_known_good_and_back_off);
+    RUN_TEST(test_no_address_kick_ignores_backoff);
+    RUN_TEST(test_millis_wraparound);
+    RUN_TEST(test_stats_json);
+    return UNITY_END();
+}
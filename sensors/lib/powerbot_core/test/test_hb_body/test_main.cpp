@@ -0,0 +1,106 @@
+// Host-side tests for include/pb_hb_body.h (pio test -e native).
+//
+// The template below is built the same way main.cpp builds the heartbeat body:
+// string literals + whitespace slots, offsets from sizeof() of the literal prefixes.
+
+#include <unity.h>
+
+#include <string>
+
+#include "pb_hb_body.h"
+
+#define T_BUILDING 11
+#define T_BODY_0 "{\"building_id\":" PB_STR(T_BUILDING) ",\"event\":"
+#define T_BODY_1 T_BODY_0 PB_SLOT_EVENT ",\"seq\":"
+#define T_BODY T_BODY_1 PB_SLOT_U32 "}"
+
+namespace {
+
+const char kTemplate[] = T_BODY;
+const size_t kSlotEvent = sizeof(T_BODY_0) - 1;
+const size_t kSlotSeq = sizeof(T_BODY_1) - 1;
+
+static_assert(pbJsonLiteralSafe("esp32-newcastle-001"), "plain uuid must be safe");
+static_assert(pbJsonLiteralSafe(""), "empty comment must be safe");
+static_assert(!pbJsonLiteralSafe("кв \"12\""), "quotes must be rejected");
+static_assert(!pbJsonLiteralSafe("a\\b"), "backslash must be rejected");
+static_assert(!pbJsonLiteralSafe("a\nb"), "control chars must be rejected");
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_slot_uint_right_aligned(void) {
+    char slot[11] = "xxxxxxxxxx";
+    TEST_ASSERT_TRUE(pbSlotPutUint(slot, 10, 42));
+    TEST_ASSERT_EQUAL_STRING("        42", slot);
+    TEST_ASSERT_TRUE(pbSlotPutUint(slot, 10, 0));
+    TEST_ASSERT_EQUAL_STRING("         0", slot);
+    TEST_ASSERT_TRUE(pbSlotPutUint(slot, 10, 4294967295u));
+    TEST_ASSERT_EQUAL_STRING("4294967295", slot);
+}
+
+void test_slot_uint_too_wide_leaves_slot_untouched(void) {
+    char slot[4] = "   ";
+    TEST_ASSERT_FALSE(pbSlotPutUint(slot, 3, 1000));
+    TEST_ASSERT_EQUAL_STRING("   ", slot);
+    TEST_ASSERT_TRUE(pbSlotPutUint(slot, 3, 999));
+    TEST_ASSERT_EQUAL_STRING("999", slot);
+}
+
+void test_slot_str_quoted_and_padded(void) {
+    char slot[13] = "xxxxxxxxxxxx";
+    TEST_ASSERT_TRUE(pbSlotPutStr(slot, 12, "boot"));
+    TEST_ASSERT_EQUAL_STRING("\"boot\"      ", slot);
+    TEST_ASSERT_TRUE(pbSlotPutStr(slot, 12, "power_lost"));
+    TEST_ASSERT_EQUAL_STRING("\"power_lost\"", slot);
+    TEST_ASSERT_FALSE(pbSlotPutStr(slot, 12, "power_lost!"));
+    TEST_ASSERT_EQUAL_STRING("\"power_lost\"", slot);
+}
+
+void test_template_patch_keeps_layout(void) {
+    char buf[sizeof(kTemplate)];
+    memcpy(buf, kTemplate, sizeof(kTemplate));
+    TEST_ASSERT_TRUE(pbSlotPutStr(buf + kSlotEvent, sizeof(PB_SLOT_EVENT) - 1, "heartbeat"));
+    TEST_ASSERT_TRUE(pbSlotPutUint(buf + kSlotSeq, sizeof(PB_SLOT_U32) - 1, 7));
+    TEST_ASSERT_EQUAL_STRING("{\"building_id\":11,\"event\":\"heartbeat\" ,\"seq\":         7}", buf);
+
+    // Повторний patch тим самим буфером (без нового memcpy) теж коректний.
+    TEST_ASSERT_TRUE(pbSlotPutStr(buf + kSlotEvent, sizeof(PB_SLOT_EVENT) - 1, "boot"));
+    TEST_ASSERT_TRUE(pbSlotPutUint(buf + kSlotSeq, sizeof(PB_SLOT_U32) - 1, 123456));
+    TEST_ASSERT_EQUAL_STRING("{\"building_id\":11,\"event\":\"boot\"      ,\"seq\":    123456}", buf);
+    TEST_ASSERT_EQUAL(sizeof(kTemplate) - 1, strlen(buf));
+}
+
+void test_heap_watch_baseline_and_drops(void) {
+    PbHeapWatch w;
+    TEST_ASSERT_EQUAL(0, w.samples());
+    w.sample(200000);
+    TEST_ASSERT_EQUAL(200000, w.baseline());
+    TEST_ASSERT_EQUAL(0, w.dropBeats());
+    TEST_ASSERT_EQUAL(0, w.drift());
+
+    w.sample(200400);   // вище baseline — не drop
+    w.sample(200000);
+    TEST_ASSERT_EQUAL(0, w.dropBeats());
+
+    w.sample(199000);   // новий мінімум
+    TEST_ASSERT_EQUAL(1, w.dropBeats());
+    TEST_ASSERT_EQUAL(1000, w.drift());
+    w.sample(199500);   // не новий мінімум
+    TEST_ASSERT_EQUAL(1, w.dropBeats());
+    TEST_ASSERT_EQUAL(500, w.drift());
+    TEST_ASSERT_EQUAL(199000, w.low());
+    TEST_ASSERT_EQUAL(5, w.samples());
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_slot_uint_right_aligned);
+    RUN_TEST(test_slot_uint_too_wide_leaves_slot_untouched);
+    RUN_TEST(test_slot_str_quoted_and_padded);
+    RUN_TEST(test_template_patch_keeps_layout);
+    RUN_TEST(test_heap_watch_baseline_and_drops);
+    return UNITY_END();
+}
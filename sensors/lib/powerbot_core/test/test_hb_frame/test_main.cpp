@@ -0,0 +1,210 @@
+// Host-side tests for include/pb_hb_frame.h (pio test -e native).
+//
+// Frame bytes are checked against test/heartbeat_frame_vectors.txt — the same file the
+// server-side smoke (scripts/smoke_sensor_heartbeat_frame_vectors.py) verifies, so the
+// firmware encoder and the Python decoder can't drift apart.
+
+#include <unity.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+#include "pb_hb_frame.h"
+
+#ifndef PB_FRAME_VECTORS_PATH
+#define PB_FRAME_VECTORS_PATH "test/heartbeat_frame_vectors.txt"
+#endif
+
+namespace {
+
+std::string hex(const uint8_t *p, size_t n) {
+    static const char kDigits[] = "0123456789abcdef";
+    std::string s;
+    for (size_t i = 0; i < n; i++) {
+        s += kDigits[p[i] >> 4];
+        s += kDigits[p[i] & 0x0f];
+    }
+    return s;
+}
+
+std::string sha256Hex(const std::string &msg) {
+    uint8_t d[PbSha256::kDigestSize];
+    PbSha256 h;
+    h.update(reinterpret_cast<const uint8_t *>(msg.data()), msg.size());
+    h.finish(d);
+    return hex(d, sizeof(d));
+}
+
+std::string hmacHex(const std::string &key, const std::string &msg) {
+    uint8_t d[PbSha256::kDigestSize];
+    PbHmacKey k(reinterpret_cast<const uint8_t *>(key.data()), key.size());
+    k.mac(reinterpret_cast<const uint8_t *>(msg.data()), msg.size(), d);
+    return hex(d, sizeof(d));
+}
+
+PbFrameEvent parseEvent(const char *name) {
+    if (strcmp(name, "boot") == 0) {
+        return PbFrameEvent::Boot;
+    }
+    if (strcmp(name, "power_lost") == 0) {
+        return PbFrameEvent::PowerLost;
+    }
+    TEST_ASSERT_EQUAL_STRING("heartbeat", name);
+    return PbFrameEvent::Heartbeat;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_sha256_known_answers(void) {
+    TEST_ASSERT_EQUAL_STRING("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", sha256Hex("").c_str());
+    TEST_ASSERT_EQUAL_STRING("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", sha256Hex("abc").c_str());
+    // 56 байт: padding не влазить у блок даних, потрібна друга компресія.
+    TEST_ASSERT_EQUAL_STRING("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+                             sha256Hex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq").c_str());
+}
+
+void test_sha256_incremental_update_matches_one_shot(void) {
+    const std::string msg(200, 'x');
+    uint8_t d[PbSha256::kDigestSize];
+    PbSha256 h;
+    for (size_t i = 0; i < msg.size(); i += 7) {
+        const size_t n = msg.size() - i < 7 ? msg.size() - i : 7;
+        h.update(reinterpret_cast<const uint8_t *>(msg.data()) + i, n);
+    }
+    h.finish(d);
+    TEST_ASSERT_EQUAL_STRING(sha256Hex(msg).c_str(), hex(d, sizeof(d)).c_str());
+}
+
+void test_hmac_rfc4231(void) {
+    // Test case 1.
+    TEST_ASSERT_EQUAL_STRING("b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7",
+                             hmacHex(std::string(20, '\x0b'), "Hi There").c_str());
+    // Test case 2 (короткий ключ).
+    TEST_ASSERT_EQUAL_STRING("5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843",
+                             hmacHex("Jefe", "what do ya want for nothing?").c_str());
+    // Test case 6 (ключ довший за блок — спершу хешується).
+    TEST_ASSERT_EQUAL_STRING("60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54",
+                             hmacHex(std::string(131, '\xaa'),
+                                     "Test Using Larger Than Block-Size Key - Hash Key First").c_str());
+}
+
+void test_hmac_key_is_reusable(void) {
+    // Midstate не має "зношуватись": той самий PbHmacKey дає однаковий MAC щоразу.
+    const std::string key = "powerbot";
+    PbHmacKey k(reinterpret_cast<const uint8_t *>(key.data()), key.size());
+    uint8_t a[PbSha256::kDigestSize];
+    uint8_t b[PbSha256::kDigestSize];
+    k.mac(reinterpret_cast<const uint8_t *>("beat"), 4, a);
+    k.mac(reinterpret_cast<const uint8_t *>("other"), 5, b);
+    k.mac(reinterpret_cast<const uint8_t *>("beat"), 4, b);
+    TEST_ASSERT_EQUAL_MEMORY(a, b, sizeof(a));
+}
+
+void test_shared_vectors(void) {
+    FILE *f = fopen(PB_FRAME_VECTORS_PATH, "r");
+    TEST_ASSERT_NOT_NULL_MESSAGE(f, "cannot open " PB_FRAME_VECTORS_PATH);
+    char line[512];
+    int checked = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        char key[256];
+        char uuid[128];
+        char event[32];
+        char frameHex[2 * PB_FRAME_SIZE + 1];
+        unsigned building = 0;
+        unsigned section = 0;
+        unsigned long seq = 0;
+        unsigned long uptime = 0;
+        unsigned long bootCount = 0;
+        const int n = sscanf(line, "%255s %u %u %127s %31s %lu %lu %lu %72s",
+                             key, &building, &section, uuid, event, &seq, &uptime, &bootCount, frameHex);
+        TEST_ASSERT_EQUAL_MESSAGE(9, n, line);
+
+        PbHmacKey k(reinterpret_cast<const uint8_t *>(key), strlen(key));
+        uint8_t uuidHash[PB_FRAME_UUID_HASH_SIZE];
+        pbFrameUuidHash(uuid, uuidHash);
+        uint8_t frame[PB_FRAME_SIZE];
+        pbFrameEncode(frame, k, parseEvent(event), static_cast<uint16_t>(building), static_cast<uint16_t>(section),
+                      uuidHash, static_cast<uint32_t>(seq), static_cast<uint32_t>(uptime),
+                      static_cast<uint32_t>(bootCount));
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(frameHex, hex(frame, sizeof(frame)).c_str(), line);
+        checked++;
+    }
+    fclose(f);
+    TEST_ASSERT_TRUE(checked > 0);
+}
+
+void test_tag_covers_every_signed_field(void) {
+    const std::string key = "k";
+    PbHmacKey k(reinterpret_cast<const uint8_t *>(key.data()), key.size());
+    uint8_t uuidHash[PB_FRAME_UUID_HASH_SIZE];
+    pbFrameUuidHash("x", uuidHash);
+    uint8_t base[PB_FRAME_SIZE];
+    pbFrameEncode(base, k, PbFrameEvent::Heartbeat, 7, 3, uuidHash, 0, 0, 0);
+
+    uint8_t other[PB_FRAME_SIZE];
+    pbFrameEncode(other, k, PbFrameEvent::Heartbeat, 7, 3, uuidHash, 1, 0, 0);
+    TEST_ASSERT_EQUAL_MEMORY(base, other, 16);
+    TEST_ASSERT_FALSE(memcmp(base + PB_FRAME_SIGNED_SIZE, other + PB_FRAME_SIGNED_SIZE, PB_FRAME_TAG_SIZE) == 0);
+
+    pbFrameEncode(other, k, PbFrameEvent::Heartbeat, 7, 3, uuidHash, 0, 0, 1);
+    TEST_ASSERT_EQUAL_MEMORY(base, other, 24);
+    TEST_ASSERT_FALSE(memcmp(base + PB_FRAME_SIGNED_SIZE, other + PB_FRAME_SIGNED_SIZE, PB_FRAME_TAG_SIZE) == 0);
+
+    pbFrameEncode(other, k, PbFrameEvent::Boot, 7, 3, uuidHash, 0, 0, 0);
+    TEST_ASSERT_FALSE(memcmp(base + PB_FRAME_SIGNED_SIZE, other + PB_FRAME_SIGNED_SIZE, PB_FRAME_TAG_SIZE) == 0);
+
+    const std::string otherKey = "K";
+    PbHmacKey k2(reinterpret_cast<const uint8_t *>(otherKey.data()), otherKey.size());
+    pbFrameEncode(other, k2, PbFrameEvent::Heartbeat, 7, 3, uuidHash, 0, 0, 0);
+    TEST_ASSERT_EQUAL_MEMORY(base, other, PB_FRAME_SIGNED_SIZE);
+    TEST_ASSERT_FALSE(memcmp(base + PB_FRAME_SIGNED_SIZE, other + PB_FRAME_SIGNED_SIZE, PB_FRAME_TAG_SIZE) == 0);
+}
+
+void test_decode_round_trip_and_rejects(void) {
+    const std::string key = "k";
+    PbHmacKey k(reinterpret_cast<const uint8_t *>(key.data()), key.size());
+    uint8_t uuidHash[PB_FRAME_UUID_HASH_SIZE];
+    pbFrameUuidHash("peer", uuidHash);
+    uint8_t frame[PB_FRAME_SIZE];
+    pbFrameEncode(frame, k, PbFrameEvent::PowerLost, 513, 2, uuidHash, 70000, 123456, 42);
+
+    PbFrame f;
+    TEST_ASSERT_TRUE(pbFrameDecode(frame, sizeof(frame), k, &f));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbFrameEvent::PowerLost), static_cast<int>(f.event));
+    TEST_ASSERT_EQUAL_UINT16(513, f.buildingId);
+    TEST_ASSERT_EQUAL_UINT16(2, f.sectionId);
+    TEST_ASSERT_EQUAL_MEMORY(uuidHash, f.uuidHash, PB_FRAME_UUID_HASH_SIZE);
+    TEST_ASSERT_EQUAL_UINT32(70000, f.seq);
+    TEST_ASSERT_EQUAL_UINT32(123456, f.uptimeS);
+    TEST_ASSERT_EQUAL_UINT32(42, f.bootCount);
+
+    TEST_ASSERT_FALSE(pbFrameDecode(frame, sizeof(frame) - 1, k, &f));
+    const std::string otherKey = "K";
+    PbHmacKey k2(reinterpret_cast<const uint8_t *>(otherKey.data()), otherKey.size());
+    TEST_ASSERT_FALSE(pbFrameDecode(frame, sizeof(frame), k2, &f));
+    for (size_t i = 0; i < PB_FRAME_SIZE; i++) {
+        uint8_t bad[PB_FRAME_SIZE];
+        memcpy(bad, frame, sizeof(bad));
+        bad[i] ^= 0x01;
+        TEST_ASSERT_FALSE_MESSAGE(pbFrameDecode(bad, sizeof(bad), k, &f), "бітовий збій у будь-якому байті");
+    }
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sha256_known_answers);
+    RUN_TEST(test_sha256_incremental_update_matches_one_shot);
+    RUN_TEST(test_hmac_rfc4231);
+    RUN_TEST(test_hmac_key_is_reusable);
+    RUN_TEST(test_shared_vectors);
+    RUN_TEST(test_tag_covers_every_signed_field);
+    RUN_TEST(test_decode_round_trip_and_rejects);
+    return UNITY_END();
+}
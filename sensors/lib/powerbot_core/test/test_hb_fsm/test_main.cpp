@@ -0,0 +1,575 @@
+// Host-side tests for include/pb_hb_fsm.h (pio test -e native).
+//
+// FakeNet is a scripted socket: every step() sees exactly what the test queued,
+// so each timeout / partial-read / stale keep-alive path is deterministic.
+
+#include <unity.h>
+
+#include <deque>
+#include <string>
+
+#include "pb_hb_fsm.h"
+
+namespace {
+
+struct FakeNet {
+    // Resolve/connect: number of PENDING polls before the final result.
+    int resolvePending = 0;
+    int resolveResult = PB_NET_OK;
+    int connectPending = 0;
+    int connectResult = PB_NET_OK;
+
+    // Write: at most writeChunk bytes per call; writeFail => -1; writeStall => 0 forever.
+    size_t writeChunk = 1024;
+    bool writeFail = false;
+    bool writeStall = false;
+
+    // Read script: "" => nothing available on this call, "\x01CLOSE" => peer closed.
+    std::deque<std::string> rx;
+
+    bool open = false;
+    bool peerClosed = false;
+    std::string sent;
+    int resolves = 0;
+    int connects = 0;
+    int closes = 0;
+
+    bool isOpen() { return open && !peerClosed; }
+
+    int startResolve(const char *) {
+        resolves++;
+        return pollResolve();
+    }
+    int pollResolve() {
+        if (resolvePending > 0) {
+            resolvePending--;
+            return PB_NET_PENDING;
+        }
+        return resolveResult;
+    }
+
+    int startConnect(uint16_t) {
+        connects++;
+        return pollConnect();
+    }
+    int pollConnect() {
+        if (connectPending > 0) {
+            connectPending--;
+            return PB_NET_PENDING;
+        }
+        if (connectResult == PB_NET_OK) {
+            open = true;
+            peerClosed = false;
+        }
+        return connectResult;
+    }
+
+    long write(const uint8_t *data, size_t len) {
+        if (writeFail) {
+            return -1;
+        }
+        if (writeStall) {
+            return 0;
+        }
+        const size_t n = len < writeChunk ? len : writeChunk;
+        sent.append(reinterpret_cast<const char *>(data), n);
+        return static_cast<long>(n);
+    }
+
+    long read(uint8_t *buf, size_t cap) {
+        if (rx.empty()) {
+            return peerClosed ? -1 : 0;
+        }
+        std::string &front = rx.front();
+        if (front == "\x01" "CLOSE") {
+            rx.pop_front();
+            peerClosed = true;
+            return -1;
+        }
+        if (front.empty()) {
+            rx.pop_front();
+            return 0;
+        }
+        const size_t n = front.size() < cap ? front.size() : cap;
+        memcpy(buf, front.data(), n);
+        front.erase(0, n);
+        if (front.empty()) {
+            rx.pop_front();
+        }
+        return static_cast<long>(n);
+    }
+
+    void close() {
+        if (open) {
+            closes++;
+        }
+        open = false;
+        peerClosed = false;
+    }
+};
+
+const PbHbConfig kCfg = {"example.test", 80, 1000, 2000, 3000, true};
+const char kOk[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: 15\r\n"
+    "\r\n"
+    "{\"status\":\"ok\"}";
+
+typedef PbHbMachine<FakeNet> Machine;
+
+size_t put(Machine &m, const char *req) {
+    const size_t len = strlen(req);
+    memcpy(m.requestBuffer(), req, len);
+    return len;
+}
+
+// Drives the machine until it finishes (or maxSteps), advancing the clock by tickMs per step.
+PbHbState run(Machine &m, uint32_t &now, uint32_t tickMs = 10, int maxSteps = 10000) {
+    for (int i = 0; i < maxSteps && m.busy(); i++) {
+        m.step(now);
+        now += tickMs;
+    }
+    return m.state();
+}
+
+// Same as run(), with a microsecond clock for the phase timings.
+PbHbState runUs(Machine &m, uint32_t &us, uint32_t tickUs, int maxSteps = 10000) {
+    for (int i = 0; i < maxSteps && m.busy(); i++) {
+        m.step(us / 1000, us);
+        us += tickUs;
+    }
+    return m.state();
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_happy_path_with_pending_phases_and_fragmented_response(void) {
+    FakeNet net;
+    net.resolvePending = 3;
+    net.connectPending = 2;
+    net.writeChunk = 7;
+    // Split mid status line, mid header name, mid CRLF and mid body.
+    net.rx = {"", "HTTP/1.1 2", "00 OK\r\nCont", "", "ent-Length: 15\r", "\n\r\n{\"sta", "", "tus\":\"ok\"}"};
+    Machine m(net, kCfg);
+    uint32_t now = 0;
+
+    TEST_ASSERT_TRUE(m.start(put(m, "POST / HTTP/1.1\r\n\r\nbody"), now));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Resolve), static_cast<int>(m.state()));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Done), static_cast<int>(run(m, now)));
+    TEST_ASSERT_TRUE(m.ok());
+    TEST_ASSERT_EQUAL(200, m.httpStatus());
+    TEST_ASSERT_EQUAL_STRING("HTTP/1.1 200 OK", m.statusLine());
+    TEST_ASSERT_EQUAL_STRING("{\"status\":\"ok\"}", m.body());
+    TEST_ASSERT_EQUAL_STRING("POST / HTTP/1.1\r\n\r\nbody", net.sent.c_str());
+    TEST_ASSERT_TRUE(net.isOpen());  // keep-alive: socket stays for the next beat
+    TEST_ASSERT_EQUAL_UINT32(1, m.connNew());
+    TEST_ASSERT_EQUAL_UINT32(0, m.connReused());
+}
+
+void test_step_never_blocks_while_waiting(void) {
+    FakeNet net;
+    Machine m(net, kCfg);
+    uint32_t now = 0;
+    TEST_ASSERT_TRUE(m.start(put(m, "GET"), now));
+    // No response bytes at all: each step returns immediately, still busy.
+    for (int i = 0; i < 50; i++) {
+        m.step(now);
+        now += 1;
+    }
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::AwaitStatus), static_cast<int>(m.state()));
+    TEST_ASSERT_TRUE(m.busy());
+    TEST_ASSERT_FALSE(m.start(put(m, "GET"), now));  // busy: second start is rejected
+}
+
+void test_resolve_failure(void) {
+    FakeNet net;
+    net.resolveResult = PB_NET_FAIL;
+    Machine m(net, kCfg);
+    uint32_t now = 0;
+    m.start(put(m, "GET"), now);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Failed), static_cast<int>(run(m, now)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::ResolveFailed), static_cast<int>(m.error()));
+    TEST_ASSERT_EQUAL(0, net.connects);
+}
+
+void test_resolve_timeout(void) {
+    FakeNet net;
+    net.resolvePending = 1000000;
+    Machine m(net, kCfg);
+    uint32_t now = 0;
+    m.start(put(m, "GET"), now);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Failed), static_cast<int>(run(m, now, 100)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::ResolveTimeout), static_cast<int>(m.error()));
+    TEST_ASSERT_UINT32_WITHIN(200, kCfg.resolveTimeoutMs, now);
+}
+
+void test_connect_failure_and_timeout(void) {
+    {
+        FakeNet net;
+        net.connectResult = PB_NET_FAIL;
+        Machine m(net, kCfg);
+        uint32_t now = 0;
+        m.start(put(m, "GET"), now);
+        run(m, now);
+        TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::ConnectFailed), static_cast<int>(m.error()));
+        TEST_ASSERT_EQUAL_UINT32(0, m.connNew());
+    }
+    {
+        FakeNet net;
+        net.connectPending = 1000000;
+        Machine m(net, kCfg);
+        uint32_t now = 0;
+        m.start(put(m, "GET"), now);
+        run(m, now, 100);
+        TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::ConnectTimeout), static_cast<int>(m.error()));
+    }
+}
+
+void test_write_failure_and_stall(void) {
+    {
+        FakeNet net;
+        net.writeFail = true;
+        Machine m(net, kCfg);
+        uint32_t now = 0;
+        m.start(put(m, "GET"), now);
+        run(m, now);
+        TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::WriteFailed), static_cast<int>(m.error()));
+        TEST_ASSERT_FALSE(net.open);
+    }
+    {
+        FakeNet net;
+        net.writeStall = true;
+        Machine m(net, kCfg);
+        uint32_t now = 0;
+        m.start(put(m, "GET"), now);
+        run(m, now, 100);
+        TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::WriteTimeout), static_cast<int>(m.error()));
+        TEST_ASSERT_FALSE(net.open);
+    }
+}
+
+void test_status_timeout_without_bytes_and_with_partial_line(void) {
+    {
+        FakeNet net;
+        Machine m(net, kCfg);
+        uint32_t now = 0;
+        m.start(put(m, "GET"), now);
+        run(m, now, 100);
+        TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::StatusTimeout), static_cast<int>(m.error()));
+        TEST_ASSERT_FALSE(net.open);
+    }
+    {
+        FakeNet net;
+        net.rx = {"HTTP/1.1 200 O"};
+        Machine m(net, kCfg);
+        uint32_t now = 0;
+        m.start(put(m, "GET"), now);
+        run(m, now, 100);
+        TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::StatusTimeout), static_cast<int>(m.error()));
+    }
+    {
+        // Status line arrived but the header block never terminates.
+        FakeNet net;
+        net.rx = {"HTTP/1.1 200 OK\r\nContent-Length: 2\r\n"};
+        Machine m(net, kCfg);
+        uint32_t now = 0;
+        m.start(put(m, "GET"), now);
+        run(m, now, 100);
+        TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Failed), static_cast<int>(m.state()));
+        TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::StatusTimeout), static_cast<int>(m.error()));
+        TEST_ASSERT_EQUAL(200, m.httpStatus());
+    }
+}
+
+void test_bad_status_line(void) {
+    FakeNet net;
+    net.rx = {"garbage\r\n"};
+    Machine m(net, kCfg);
+    uint32_t now = 0;
+    m.start(put(m, "GET"), now);
+    run(m, now);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::BadStatusLine), static_cast<int>(m.error()));
+}
+
+void test_peer_closes_during_headers(void) {
+    FakeNet net;
+    net.rx = {"HTTP/1.1 200 OK\r\nConte", "\x01" "CLOSE"};
+    Machine m(net, kCfg);
+    uint32_t now = 0;
+    m.start(put(m, "GET"), now);
+    run(m, now);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::Closed), static_cast<int>(m.error()));
+}
+
+void test_body_timeout_keeps_status_but_drops_socket(void) {
+    FakeNet net;
+    net.rx = {"HTTP/1.1 200 OK\r\nContent-Length: 15\r\n\r\n{\"sta"};
+    Machine m(net, kCfg);
+    uint32_t now = 0;
+    m.start(put(m, "GET"), now);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Done), static_cast<int>(run(m, now, 100)));
+    TEST_ASSERT_TRUE(m.ok());
+    TEST_ASSERT_EQUAL_STRING("{\"sta", m.body());
+    TEST_ASSERT_FALSE(net.open);  // half-read socket must not be reused
+}
+
+void test_peer_close_mid_body_and_no_content_length(void) {
+    {
+        FakeNet net;
+        net.rx = {"HTTP/1.1 200 OK\r\nContent-Length: 15\r\n\r\n{\"st", "\x01" "CLOSE"};
+        Machine m(net, kCfg);
+        uint32_t now = 0;
+        m.start(put(m, "GET"), now);
+        run(m, now);
+        TEST_ASSERT_TRUE(m.ok());
+        TEST_ASSERT_FALSE(net.open);
+    }
+    {
+        // Without Content-Length the body ends when the server closes the socket.
+        FakeNet net;
+        net.rx = {"HTTP/1.0 200 OK\r\n\r\n", "{\"status\":", "", "\"ok\"}", "\x01" "CLOSE"};
+        Machine m(net, kCfg);
+        uint32_t now = 0;
+        m.start(put(m, "GET"), now);
+        run(m, now);
+        TEST_ASSERT_TRUE(m.ok());
+        TEST_ASSERT_EQUAL_STRING("{\"status\":\"ok\"}", m.body());
+        TEST_ASSERT_FALSE(net.open);
+    }
+}
+
+void test_non_200_and_connection_close(void) {
+    {
+        FakeNet net;
+        net.rx = {"HTTP/1.1 401 Unauthorized\r\nContent-Length: 2\r\n\r\n{}"};
+        Machine m(net, kCfg);
+        uint32_t now = 0;
+        m.start(put(m, "GET"), now);
+        TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Done), static_cast<int>(run(m, now)));
+        TEST_ASSERT_FALSE(m.ok());
+        TEST_ASSERT_EQUAL(401, m.httpStatus());
+        TEST_ASSERT_FALSE(net.open);
+    }
+    {
+        FakeNet net;
+        net.rx = {"HTTP/1.1 200 OK\r\nCONNECTION: Close\r\nContent-Length: 0\r\n\r\n"};
+        Machine m(net, kCfg);
+        uint32_t now = 0;
+        m.start(put(m, "GET"), now);
+        run(m, now);
+        TEST_ASSERT_TRUE(m.ok());
+        TEST_ASSERT_FALSE(net.open);
+    }
+}
+
+void test_server_interval_and_bad_headers(void) {
+    {
+        FakeNet net;
+        net.rx = {"HTTP/1.1 200 OK\r\nX-PB-", "Interval-Ms: 30000\r\nContent-Length: 2\r\n\r\n{}"};
+        Machine m(net, kCfg);
+        uint32_t now = 0;
+        m.start(put(m, "GET"), now);
+        run(m, now);
+        TEST_ASSERT_TRUE(m.ok());
+        TEST_ASSERT_EQUAL_UINT32(30000, m.intervalMs());
+        TEST_ASSERT_TRUE(net.open);   // keep-alive: межа body відома
+    }
+    {
+        // Два різні Content-Length: межа відповіді невідома — сокет не перевикористовуємо.
+        FakeNet net;
+        net.rx = {"HTTP/1.1 200 OK\r\nContent-Length: 2\r\nContent-Length: 20\r\n\r\n{}"};
+        Machine m(net, kCfg);
+        uint32_t now = 0;
+        m.start(put(m, "GET"), now);
+        TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Failed), static_cast<int>(run(m, now)));
+        TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::BadResponse), static_cast<int>(m.error()));
+        TEST_ASSERT_EQUAL(200, m.httpStatus());
+        TEST_ASSERT_FALSE(m.ok());
+        TEST_ASSERT_FALSE(net.open);
+    }
+}
+
+void test_keepalive_reuses_open_socket(void) {
+    FakeNet net;
+    net.rx = {kOk};
+    Machine m(net, kCfg);
+    uint32_t now = 0;
+    m.start(put(m, "A"), now);
+    run(m, now);
+    TEST_ASSERT_TRUE(m.ok());
+    m.reset();
+
+    net.rx = {kOk};
+    TEST_ASSERT_TRUE(m.start(put(m, "B"), now));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Write), static_cast<int>(m.state()));
+    run(m, now);
+    TEST_ASSERT_TRUE(m.ok());
+    TEST_ASSERT_TRUE(m.reused());
+    TEST_ASSERT_EQUAL(1, net.resolves);
+    TEST_ASSERT_EQUAL(1, net.connects);
+    TEST_ASSERT_EQUAL_STRING("AB", net.sent.c_str());
+    TEST_ASSERT_EQUAL_UINT32(1, m.connNew());
+    TEST_ASSERT_EQUAL_UINT32(1, m.connReused());
+}
+
+void test_stale_keepalive_socket_is_retried_once(void) {
+    FakeNet net;
+    net.rx = {kOk};
+    Machine m(net, kCfg);
+    uint32_t now = 0;
+    m.start(put(m, "A"), now);
+    run(m, now);
+    m.reset();
+
+    // Server dropped the idle socket: the first read on the reused socket sees EOF.
+    net.rx = {"\x01" "CLOSE", kOk};
+    m.start(put(m, "B"), now);
+    run(m, now);
+    TEST_ASSERT_TRUE(m.ok());
+    TEST_ASSERT_TRUE(m.retried());
+    TEST_ASSERT_FALSE(m.reused());
+    TEST_ASSERT_EQUAL(2, net.connects);
+    TEST_ASSERT_EQUAL_UINT32(2, m.connNew());
+    TEST_ASSERT_EQUAL_UINT32(0, m.connReused());
+}
+
+void test_stale_write_retry_and_no_second_retry(void) {
+    FakeNet net;
+    net.rx = {kOk};
+    Machine m(net, kCfg);
+    uint32_t now = 0;
+    m.start(put(m, "A"), now);
+    run(m, now);
+    m.reset();
+
+    // Write fails on the reused socket and keeps failing on the fresh one: exactly one retry.
+    net.writeFail = true;
+    m.start(put(m, "B"), now);
+    run(m, now);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::WriteFailed), static_cast<int>(m.error()));
+    TEST_ASSERT_TRUE(m.retried());
+    TEST_ASSERT_EQUAL(2, net.connects);
+}
+
+void test_fresh_connection_close_is_not_retried(void) {
+    FakeNet net;
+    net.rx = {"\x01" "CLOSE"};
+    Machine m(net, kCfg);
+    uint32_t now = 0;
+    m.start(put(m, "A"), now);
+    run(m, now);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::Closed), static_cast<int>(m.error()));
+    TEST_ASSERT_FALSE(m.retried());
+    TEST_ASSERT_EQUAL(1, net.connects);
+}
+
+void test_abort_and_oversized_request(void) {
+    FakeNet net;
+    Machine m(net, kCfg);
+    uint32_t now = 0;
+    TEST_ASSERT_FALSE(m.start(Machine::requestCapacity() + 1, now));
+    TEST_ASSERT_FALSE(m.start(0, now));
+
+    m.start(put(m, "A"), now);
+    run(m, now, 1, 5);
+    TEST_ASSERT_TRUE(m.busy());
+    m.abort();
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Idle), static_cast<int>(m.state()));
+    TEST_ASSERT_FALSE(net.open);
+}
+
+void test_clock_wraparound(void) {
+    FakeNet net;
+    net.rx = {"", "", kOk};
+    Machine m(net, kCfg);
+    uint32_t now = 0xFFFFFFF0u;  // millis() rolls over mid-request
+    m.start(put(m, "A"), now);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Done), static_cast<int>(run(m, now, 10)));
+    TEST_ASSERT_TRUE(m.ok());
+}
+
+void test_phase_timings_in_microseconds(void) {
+    FakeNet net;
+    net.resolvePending = 2;
+    net.connectPending = 1;
+    net.rx = {"", "HTTP/1.1 200 OK\r\nContent-Length: 15\r\n", "", "\r\n{\"status\":\"ok\"}"};
+    Machine m(net, kCfg);
+    uint32_t us = 0;
+    m.start(put(m, "A"), 0, us);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Done), static_cast<int>(runUs(m, us, 250)));
+
+    const PbHbTimings &t = m.timings();
+    TEST_ASSERT_EQUAL_UINT32(500, t.get(PbHbPhase::Dns));      // 2 pending polls + OK
+    TEST_ASSERT_EQUAL_UINT32(500, t.get(PbHbPhase::Connect));
+    TEST_ASSERT_EQUAL_UINT32(250, t.get(PbHbPhase::Write));
+    TEST_ASSERT_EQUAL_UINT32(500, t.get(PbHbPhase::Ttfb));     // one empty poll, then the status line
+    TEST_ASSERT_EQUAL_UINT32(750, t.get(PbHbPhase::Response));
+    TEST_ASSERT_TRUE(t.failedAt == PbHbPhase::None);
+}
+
+void test_phase_timings_keepalive_failure_and_retry(void) {
+    FakeNet net;
+    net.rx = {kOk};
+    Machine m(net, kCfg);
+    uint32_t us = 0;
+    m.start(put(m, "A"), 0, us);
+    runUs(m, us, 100);
+    m.reset();
+
+    // Reused socket: no DNS / connect phases at all.
+    net.rx = {"", kOk};
+    m.start(put(m, "B"), us / 1000, us);
+    runUs(m, us, 100);
+    TEST_ASSERT_FALSE(m.timings().has(PbHbPhase::Dns));
+    TEST_ASSERT_FALSE(m.timings().has(PbHbPhase::Connect));
+    TEST_ASSERT_TRUE(m.timings().has(PbHbPhase::Response));
+    m.reset();
+
+    // Stale socket: timings restart from the new connection.
+    net.rx = {"\x01" "CLOSE", kOk};
+    m.start(put(m, "C"), us / 1000, us);
+    runUs(m, us, 100);
+    TEST_ASSERT_TRUE(m.ok());
+    TEST_ASSERT_TRUE(m.timings().has(PbHbPhase::Dns));
+    TEST_ASSERT_TRUE(m.timings().has(PbHbPhase::Connect));
+    TEST_ASSERT_TRUE(m.timings().failedAt == PbHbPhase::None);
+    m.reset();
+
+    // Nothing comes back: the beat is charged to TTFB.
+    net.rx.clear();
+    m.start(put(m, "D"), us / 1000, us);
+    runUs(m, us, 100000);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::StatusTimeout), static_cast<int>(m.error()));
+    TEST_ASSERT_TRUE(m.timings().failedAt == PbHbPhase::Ttfb);
+    TEST_ASSERT_FALSE(m.timings().has(PbHbPhase::Ttfb));
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_happy_path_with_pending_phases_and_fragmented_response);
+    RUN_TEST(test_step_never_blocks_while_waiting);
+    RUN_TEST(test_resolve_failure);
+    RUN_TEST(test_resolve_timeout);
+    RUN_TEST(test_connect_failure_and_timeout);
+    RUN_TEST(test_write_failure_and_stall);
+    RUN_TEST(test_status_timeout_without_bytes_and_with_partial_line);
+    RUN_TEST(test_bad_status_line);
+    RUN_TEST(test_peer_closes_during_headers);
+    RUN_TEST(test_body_timeout_keeps_status_but_drops_socket);
+    RUN_TEST(test_peer_close_mid_body_and_no_content_length);
+    RUN_TEST(test_non_200_and_connection_close);
+    RUN_TEST(test_server_interval_and_bad_headers);
+    RUN_TEST(test_keepalive_reuses_open_socket);
+    RUN_TEST(test_stale_keepalive_socket_is_retried_once);
+    RUN_TEST(test_stale_write_retry_and_no_second_retry);
+    RUN_TEST(test_fresh_connection_close_is_not_retried);
+    RUN_TEST(test_abort_and_oversized_request);
+    RUN_TEST(test_clock_wraparound);
+    RUN_TEST(test_phase_timings_in_microseconds);
+    RUN_TEST(test_phase_timings_keepalive_failure_and_retry);
+    return UNITY_END();
+}
@@ -0,0 +1,113 @@
+// Host-side tests for include/pb_hb_latency.h (pio test -e native).
+//
+// Bucket edges, percentile estimates, the "window since last delivered summary"
+// rule and the in-place JSON slots that carry the summary in the next beat.
+
+#include <unity.h>
+
+#include <string.h>
+
+#include "pb_hb_latency.h"
+
+namespace {
+
+PbHbTimings beat(uint32_t dns, uint32_t ttfb, PbHbPhase failedAt = PbHbPhase::None) {
+    PbHbTimings t;
+    t.clear();
+    t.set(PbHbPhase::Dns, dns);
+    if (failedAt == PbHbPhase::None) {
+        t.set(PbHbPhase::Ttfb, ttfb);
+    }
+    t.failedAt = failedAt;
+    return t;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_bucket_edges(void) {
+    TEST_ASSERT_EQUAL(0, PbLatencyHist::bucketOf(0));
+    TEST_ASSERT_EQUAL(0, PbLatencyHist::bucketOf(255));
+    TEST_ASSERT_EQUAL(1, PbLatencyHist::bucketOf(256));
+    TEST_ASSERT_EQUAL(1, PbLatencyHist::bucketOf(511));
+    TEST_ASSERT_EQUAL(2, PbLatencyHist::bucketOf(512));
+    TEST_ASSERT_EQUAL(14, PbLatencyHist::bucketOf((1u << 22) - 1));
+    TEST_ASSERT_EQUAL(15, PbLatencyHist::bucketOf(1u << 22));
+    TEST_ASSERT_EQUAL(15, PbLatencyHist::bucketOf(0xFFFFFFFFu));
+}
+
+void test_percentiles_are_bucket_upper_bounds_capped_by_max(void) {
+    PbLatencyHist h;
+    TEST_ASSERT_EQUAL_UINT32(0, h.percentile(50));
+
+    h.add(1000);
+    TEST_ASSERT_EQUAL_UINT32(1000, h.percentile(50));   // один семпл: межа кошика обрізана max
+
+    // 90 x ~3 мс + 10 x ~300 мс.
+    for (int i = 0; i < 89; i++) {
+        h.add(3000);
+    }
+    for (int i = 0; i < 10; i++) {
+        h.add(300000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(100, h.count());
+    TEST_ASSERT_EQUAL_UINT32(4095, h.percentile(50));
+    TEST_ASSERT_EQUAL_UINT32(300000, h.percentile(95));
+    TEST_ASSERT_EQUAL_UINT32(300000, h.max());
+
+    h.add(9000000);   // > 4.2 с — останній кошик, оцінка = max
+    TEST_ASSERT_EQUAL_UINT32(9000000, h.percentile(100));
+    h.clear();
+    TEST_ASSERT_EQUAL_UINT32(0, h.count());
+    TEST_ASSERT_EQUAL_UINT32(0, h.max());
+}
+
+void test_window_restarts_only_after_delivery(void) {
+    PbHbLatency lat;
+    lat.finish(beat(400, 2000), false);
+    lat.finish(beat(400, 0, PbHbPhase::Ttfb), false);
+    TEST_ASSERT_EQUAL_UINT32(2, lat.beats());
+    TEST_ASSERT_EQUAL_UINT32(2, lat.hist(PbHbPhase::Dns).count());
+    TEST_ASSERT_EQUAL_UINT32(1, lat.hist(PbHbPhase::Ttfb).count());
+    TEST_ASSERT_EQUAL_UINT32(1, lat.fails(PbHbPhase::Ttfb));
+    TEST_ASSERT_EQUAL_UINT32(0, lat.hist(PbHbPhase::Connect).count());
+
+    // Beat доставив підсумок: нове вікно — лише з нього самого.
+    lat.finish(beat(100, 5000), true);
+    TEST_ASSERT_EQUAL_UINT32(1, lat.beats());
+    TEST_ASSERT_EQUAL_UINT32(0, lat.fails(PbHbPhase::Ttfb));
+    TEST_ASSERT_EQUAL_UINT32(5000, lat.hist(PbHbPhase::Ttfb).max());
+}
+
+void test_json_slots(void) {
+    char obj[] = PB_HB_LAT_JSON;
+    PbHbLatency lat;
+    lat.finish(beat(300, 70000), false);
+    lat.finish(beat(300, 0, PbHbPhase::Ttfb), false);
+    pbHbLatencyPut(obj, sizeof(obj) - 1, lat);
+
+    // Без пробілів (слоти вирівняні праворуч) — для порівняння.
+    char compact[sizeof(obj)];
+    size_t n = 0;
+    for (size_t i = 0; obj[i] != '\0'; i++) {
+        if (obj[i] != ' ') {
+            compact[n++] = obj[i];
+        }
+    }
+    compact[n] = '\0';
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"dns\":[300,300,300,0],\"connect\":[0,0,0,0],\"write\":[0,0,0,0],"
+        "\"ttfb\":[70000,70000,70000,1],\"response\":[0,0,0,0]}",
+        compact);
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_bucket_edges);
+    RUN_TEST(test_percentiles_are_bucket_upper_bounds_capped_by_max);
+    RUN_TEST(test_window_restarts_only_after_delivery);
+    RUN_TEST(test_json_slots);
+    return UNITY_END();
+}
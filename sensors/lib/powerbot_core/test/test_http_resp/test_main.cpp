@@ -0,0 +1,289 @@
+// Host-side tests for include/pb_http_resp.h (pio test -e native).
+//
+// Property/fuzz style: every response is fed whole, split at every byte, split
+// into random chunks and truncated at every byte — the parse must not depend on
+// how the socket delivered it. Random mutations must never crash or overrun.
+
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "pb_http_resp.h"
+
+namespace {
+
+typedef PbHttpResponse<64, 32> Resp;
+
+struct Parsed {
+    PbHttpRespState state;
+    int status;
+    long contentLength;
+    uint32_t intervalMs;
+    bool close;
+    size_t bodyRead;
+    std::string statusLine;
+    std::string body;
+    size_t consumed;
+};
+
+Parsed snapshot(const Resp &r, size_t consumed) {
+    Parsed p = {r.state(), r.status(), r.contentLength(), r.intervalMs(), r.serverClose(),
+                r.bodyRead(), r.statusLine(), r.body(), consumed};
+    return p;
+}
+
+// Chunks are the split points; eof = peer closed after the last byte.
+Parsed parseChunks(const std::string &raw, const std::vector<size_t> &cuts, bool eof) {
+    Resp r;
+    r.reset();
+    size_t at = 0;
+    size_t consumed = 0;
+    for (size_t i = 0; i <= cuts.size(); i++) {
+        const size_t end = i < cuts.size() ? cuts[i] : raw.size();
+        consumed += r.feed(raw.data() + at, end - at);
+        at = end;
+    }
+    if (eof) {
+        r.eof();
+    }
+    return snapshot(r, consumed);
+}
+
+Parsed parseWhole(const std::string &raw, bool eof = false) {
+    return parseChunks(raw, std::vector<size_t>(), eof);
+}
+
+void assertSame(const Parsed &a, const Parsed &b, const char *what) {
+    TEST_ASSERT_EQUAL_MESSAGE(static_cast<int>(a.state), static_cast<int>(b.state), what);
+    TEST_ASSERT_EQUAL_MESSAGE(a.status, b.status, what);
+    TEST_ASSERT_EQUAL_MESSAGE(a.contentLength, b.contentLength, what);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(a.intervalMs, b.intervalMs, what);
+    TEST_ASSERT_EQUAL_MESSAGE(a.close, b.close, what);
+    TEST_ASSERT_EQUAL_MESSAGE(a.bodyRead, b.bodyRead, what);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(a.statusLine.c_str(), b.statusLine.c_str(), what);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(a.body.c_str(), b.body.c_str(), what);
+    TEST_ASSERT_EQUAL_MESSAGE(a.consumed, b.consumed, what);
+}
+
+// Deterministic LCG: the same "random" splits and mutations on every run.
+uint32_t lcg(uint32_t &s) {
+    s = s * 1664525u + 1013904223u;
+    return s >> 8;
+}
+
+// Responses the server (aiohttp) and proxies in front of it actually send, plus edge cases.
+const char *const kValid[] = {
+    "HTTP/1.1 200 OK\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: 17\r\n"
+    "Date: Thu, 01 Jan 2026 00:00:00 GMT\r\nServer: Python/3.12 aiohttp/3.9\r\n\r\n{\"status\": \"ok\"}\n",
+    "HTTP/1.1 200 OK\r\nX-PB-Interval-Ms: 30000\r\nContent-Length: 2\r\n\r\n{}",
+    "HTTP/1.1 404 Not Found\r\nConnection: close\r\nContent-Length: 0\r\n\r\n",
+    "HTTP/1.1 503 Service 200 Unavailable\r\ncontent-length: 5\r\n\r\nbusy!",
+    "HTTP/1.0 200 OK\nContent-Length: 3\n\nabc",
+    "HTTP/1.1 204\r\nConnection: keep-alive, Close\r\nContent-Length: 0\r\n\r\n",
+    "HTTP/1.1 200 OK\r\nX-Very-Long-Header: " "0123456789012345678901234567890123456789012345678901234567890123456789"
+    "\r\nContent-Length:4\r\n\r\nbody",
+};
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_status_is_parsed_numerically() {
+    const Parsed ok = parseWhole(kValid[0]);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHttpRespState::Done), static_cast<int>(ok.state));
+    TEST_ASSERT_EQUAL(200, ok.status);
+    TEST_ASSERT_EQUAL(17, ok.contentLength);
+    TEST_ASSERT_EQUAL_STRING("{\"status\": \"ok\"}\n", ok.body.c_str());
+
+    // "200" in the reason phrase is not a success.
+    TEST_ASSERT_EQUAL(503, parseWhole(kValid[3]).status);
+    TEST_ASSERT_EQUAL(204, parseWhole(kValid[5]).status);
+
+    const char *const bad[] = {
+        "HTTP/1.1 2000 OK\r\n\r\n", "HTTP/1.1 20 OK\r\n\r\n", "HTTP/1.1 099 Odd\r\n\r\n",
+        "HTTP/1.1 600 Odd\r\n\r\n", "HTTP/1.1  200 OK\r\n\r\n", "http/1.1 200 OK\r\n\r\n",
+        "HTTP/2 200\r\n\r\n", "SSH-2.0-OpenSSH\r\n\r\n", "\r\n",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        const Parsed p = parseWhole(bad[i]);
+        TEST_ASSERT_EQUAL_MESSAGE(static_cast<int>(PbHttpRespState::Bad), static_cast<int>(p.state), bad[i]);
+    }
+}
+
+void test_content_length_bounds_the_body() {
+    // Bytes after the body belong to the next response: not consumed.
+    const std::string raw = std::string(kValid[1]) + "HTTP/1.1 200 OK\r\n";
+    const Parsed p = parseWhole(raw);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHttpRespState::Done), static_cast<int>(p.state));
+    TEST_ASSERT_EQUAL(strlen(kValid[1]), p.consumed);
+    TEST_ASSERT_EQUAL_STRING("{}", p.body.c_str());
+
+    // Zero length: done right at the blank line.
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHttpRespState::Done), static_cast<int>(parseWhole(kValid[2]).state));
+
+    // No Content-Length: the body runs until the peer closes.
+    const char *noLen = "HTTP/1.1 200 OK\r\n\r\nstream";
+    const Parsed open = parseWhole(noLen);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHttpRespState::Body), static_cast<int>(open.state));
+    const Parsed closed = parseWhole(noLen, true);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHttpRespState::Done), static_cast<int>(closed.state));
+    TEST_ASSERT_TRUE(closed.close);
+    TEST_ASSERT_EQUAL(6, closed.bodyRead);
+
+    // Long body: counted in full, only the head kept for logs.
+    Resp r;
+    r.reset();
+    const std::string big = "HTTP/1.1 200 OK\r\nContent-Length: 100\r\n\r\n" + std::string(100, 'x');
+    TEST_ASSERT_EQUAL(big.size(), r.feed(big.data(), big.size()));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHttpRespState::Done), static_cast<int>(r.state()));
+    TEST_ASSERT_EQUAL(100, r.bodyRead());
+    TEST_ASSERT_EQUAL(31, strlen(r.body()));
+}
+
+void test_bad_content_length_is_rejected() {
+    const char *const bad[] = {
+        "HTTP/1.1 200 OK\r\nContent-Length: -1\r\n\r\n",
+        "HTTP/1.1 200 OK\r\nContent-Length: 12abc\r\n\r\n",
+        "HTTP/1.1 200 OK\r\nContent-Length:\r\n\r\n",
+        "HTTP/1.1 200 OK\r\nContent-Length: 99999999999999999999\r\n\r\n",
+        "HTTP/1.1 200 OK\r\nContent-Length: 2\r\nContent-Length: 3\r\n\r\nabc",
+        "HTTP/1.1 200 OK\r\nX-PB-Interval-Ms: soon\r\n\r\n",
+        "HTTP/1.1 200 OK\r\nX-PB-Interval-Ms: 4294967296\r\n\r\n",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        const Parsed p = parseWhole(bad[i]);
+        TEST_ASSERT_EQUAL_MESSAGE(static_cast<int>(PbHttpRespState::Bad), static_cast<int>(p.state), bad[i]);
+        TEST_ASSERT_EQUAL_MESSAGE(200, p.status, bad[i]);
+    }
+    // A repeated identical Content-Length is harmless.
+    const Parsed dup = parseWhole("HTTP/1.1 200 OK\r\nContent-Length: 2\r\ncontent-length:2 \r\n\r\nab");
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHttpRespState::Done), static_cast<int>(dup.state));
+}
+
+void test_headers_are_case_insensitive_and_unknown_ones_skipped() {
+    const Parsed p = parseWhole(
+        "HTTP/1.1 200 OK\r\nx-pb-interval-ms:\t15000 \r\nCONNECTION: Close\r\nX-Content-Length: 9\r\n"
+        "Content-Lengthy: 7\r\nno colon here\r\nContent-Length: 0\r\n\r\n");
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHttpRespState::Done), static_cast<int>(p.state));
+    TEST_ASSERT_EQUAL_UINT32(15000, p.intervalMs);
+    TEST_ASSERT_TRUE(p.close);
+    TEST_ASSERT_EQUAL(0, p.contentLength);
+
+    TEST_ASSERT_FALSE(parseWhole("HTTP/1.1 200 OK\r\nConnection: closed\r\nContent-Length: 0\r\n\r\n").close);
+    TEST_ASSERT_TRUE(parseWhole(kValid[5]).close);
+    TEST_ASSERT_EQUAL_UINT32(30000, parseWhole(kValid[1]).intervalMs);
+    TEST_ASSERT_EQUAL_UINT32(0, parseWhole(kValid[0]).intervalMs);
+
+    // Over-long unknown header: truncated and ignored, parsing goes on.
+    const Parsed longHdr = parseWhole(kValid[6]);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHttpRespState::Done), static_cast<int>(longHdr.state));
+    TEST_ASSERT_EQUAL_STRING("body", longHdr.body.c_str());
+}
+
+void test_any_split_gives_the_same_result() {
+    for (size_t v = 0; v < sizeof(kValid) / sizeof(kValid[0]); v++) {
+        const std::string raw = kValid[v];
+        const Parsed whole = parseWhole(raw);
+        TEST_ASSERT_EQUAL(static_cast<int>(PbHttpRespState::Done), static_cast<int>(whole.state));
+
+        for (size_t cut = 0; cut <= raw.size(); cut++) {
+            assertSame(whole, parseChunks(raw, std::vector<size_t>(1, cut), false), raw.c_str());
+        }
+        // Byte by byte.
+        std::vector<size_t> every;
+        for (size_t i = 1; i < raw.size(); i++) {
+            every.push_back(i);
+        }
+        assertSame(whole, parseChunks(raw, every, false), raw.c_str());
+
+        uint32_t seed = 0x5eed0000u + static_cast<uint32_t>(v);
+        for (int round = 0; round < 200; round++) {
+            std::vector<size_t> cuts;
+            size_t at = 0;
+            while (true) {
+                at += 1 + lcg(seed) % 9;
+                if (at >= raw.size()) {
+                    break;
+                }
+                cuts.push_back(at);
+            }
+            assertSame(whole, parseChunks(raw, cuts, false), raw.c_str());
+        }
+    }
+}
+
+void test_truncated_response_is_never_accepted() {
+    for (size_t v = 0; v < sizeof(kValid) / sizeof(kValid[0]); v++) {
+        const std::string raw = kValid[v];
+        const Parsed whole = parseWhole(raw);
+        for (size_t len = 0; len < raw.size(); len++) {
+            const std::string prefix = raw.substr(0, len);
+            const Parsed p = parseWhole(prefix);
+            // A valid prefix is never Bad and never Done before the last body byte.
+            TEST_ASSERT_NOT_EQUAL_MESSAGE(static_cast<int>(PbHttpRespState::Bad), static_cast<int>(p.state),
+                                          prefix.c_str());
+            TEST_ASSERT_NOT_EQUAL_MESSAGE(static_cast<int>(PbHttpRespState::Done), static_cast<int>(p.state),
+                                          prefix.c_str());
+            TEST_ASSERT_EQUAL(len, p.consumed);
+
+            // Peer closed there: before the blank line that's Bad; inside a sized body the
+            // response is cut short (Done via close, fewer bytes than Content-Length).
+            const Parsed cut = parseWhole(prefix, true);
+            if (cut.state == PbHttpRespState::Done) {
+                TEST_ASSERT_TRUE(cut.close);
+                TEST_ASSERT_TRUE(cut.contentLength < 0 || cut.bodyRead < static_cast<size_t>(cut.contentLength));
+                TEST_ASSERT_EQUAL(whole.status, cut.status);
+            } else {
+                TEST_ASSERT_EQUAL(static_cast<int>(PbHttpRespState::Bad), static_cast<int>(cut.state));
+            }
+        }
+    }
+}
+
+void test_random_mutations_keep_invariants() {
+    uint32_t seed = 0xf022u;
+    for (int round = 0; round < 20000; round++) {
+        std::string raw = kValid[lcg(seed) % (sizeof(kValid) / sizeof(kValid[0]))];
+        const int edits = 1 + static_cast<int>(lcg(seed) % 4);
+        for (int e = 0; e < edits && !raw.empty(); e++) {
+            const size_t at = lcg(seed) % raw.size();
+            switch (lcg(seed) % 4) {
+                case 0: raw[at] = static_cast<char>(lcg(seed) & 0xff); break;
+                case 1: raw.erase(at, 1 + lcg(seed) % 8); break;
+                case 2: raw.insert(at, 1, "\r\n:0 aZ\t\x00\xff"[lcg(seed) % 11]); break;
+                default: raw.insert(at, raw.substr(0, lcg(seed) % 80)); break;
+            }
+        }
+        std::vector<size_t> cuts;
+        for (size_t at = 1 + lcg(seed) % 7; at < raw.size(); at += 1 + lcg(seed) % 13) {
+            cuts.push_back(at);
+        }
+        const Parsed p = parseChunks(raw, cuts, (lcg(seed) & 1) != 0);
+        TEST_ASSERT_TRUE(p.consumed <= raw.size());
+        TEST_ASSERT_TRUE(p.statusLine.size() < 64);
+        TEST_ASSERT_TRUE(p.body.size() < 32);
+        if (p.state == PbHttpRespState::Headers || p.state == PbHttpRespState::Body ||
+            p.state == PbHttpRespState::Done) {
+            TEST_ASSERT_TRUE(p.status >= 100 && p.status <= 599);
+        }
+        if (p.state == PbHttpRespState::Done && !p.close) {
+            TEST_ASSERT_EQUAL(p.contentLength, static_cast<long>(p.bodyRead));
+        }
+        // Split must not matter, mutated or not.
+        assertSame(parseWhole(raw), parseChunks(raw, cuts, false), "mutated split");
+    }
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_status_is_parsed_numerically);
+    RUN_TEST(test_content_length_bounds_the_body);
+    RUN_TEST(test_bad_content_length_is_rejected);
+    RUN_TEST(test_headers_are_case_insensitive_and_unknown_ones_skipped);
+    RUN_TEST(test_any_split_gives_the_same_result);
+    RUN_TEST(test_truncated_response_is_never_accepted);
+    RUN_TEST(test_random_mutations_keep_invariants);
+    return UNITY_END();
+}
@@ -0,0 +1,108 @@
+// Host-side tests for include/pb_inputs.h (pio test -e native).
+//
+// 1 ms samples of optocoupler inputs on 50 Hz mains: a half-wave opto is active ~7 ms of
+// every 20 ms period, a DC-fed input is steady. Checks the debounced mask against
+// mains pulses, outages, glitches and independent channels.
+
+#include <unity.h>
+
+#include "pb_inputs.h"
+
+namespace {
+
+const PbInputsConfig kCfg = {5, 40};
+
+// Half-wave opto on 50 Hz: active on samples 0..6 of each 20-sample period.
+bool mainsActive(int sample) {
+    return (sample % 20) < 7;
+}
+
+// Feeds `count` samples of `maskAt(sample)`; returns how many feeds reported a change,
+// the sample index of the first one goes to *firstAt.
+template <uint8_t N, typename F>
+int feedN(PbInputDebouncer<N> &d, int count, F maskAt, int *firstAt = nullptr) {
+    int changes = 0;
+    for (int i = 0; i < count; i++) {
+        if (d.feed(maskAt(i))) {
+            if (changes == 0 && firstAt != nullptr) {
+                *firstAt = i;
+            }
+            changes++;
+        }
+    }
+    return changes;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_dark_inputs_stay_off(void) {
+    PbInputDebouncer<3> d(kCfg);
+    TEST_ASSERT_EQUAL(0, feedN(d, 1000, [](int) { return 0u; }));
+    TEST_ASSERT_EQUAL_HEX16(0, d.state());
+}
+
+void test_mains_pulses_turn_on_once_and_hold(void) {
+    PbInputDebouncer<1> d(kCfg);
+    int at = -1;
+    TEST_ASSERT_EQUAL(1, feedN(d, 2000, [](int i) { return mainsActive(i) ? 1u : 0u; }, &at));
+    TEST_ASSERT_EQUAL(kCfg.onSamples - 1, at);   // within the first half-wave
+    TEST_ASSERT_EQUAL_HEX16(1, d.state());        // 13 ms gaps between pulses never drop it
+}
+
+void test_outage_turns_off_after_off_samples(void) {
+    PbInputDebouncer<1> d(kCfg);
+    feedN(d, 987, [](int i) { return mainsActive(i) ? 1u : 0u; });   // ends on the last sample of a pulse
+    int at = -1;
+    TEST_ASSERT_EQUAL(1, feedN(d, 500, [](int) { return 0u; }, &at));
+    TEST_ASSERT_EQUAL(kCfg.offSamples - 1, at);
+    TEST_ASSERT_EQUAL_HEX16(0, d.state());
+
+    // Power back: on again within one period.
+    at = -1;
+    TEST_ASSERT_EQUAL(1, feedN(d, 100, [](int i) { return mainsActive(i) ? 1u : 0u; }, &at));
+    TEST_ASSERT_TRUE(at < 20);
+}
+
+void test_sparse_glitches_are_ignored(void) {
+    PbInputDebouncer<1> d(kCfg);
+    // One-sample spike every 50 ms: the idle run between them resets the count.
+    TEST_ASSERT_EQUAL(0, feedN(d, 5000, [](int i) { return (i % 50) == 0 ? 1u : 0u; }));
+    TEST_ASSERT_EQUAL_HEX16(0, d.state());
+}
+
+void test_channels_are_independent(void) {
+    PbInputDebouncer<3> d(kCfg);
+    // in1 — mains opto, in2 — DC, in3 — dark.
+    feedN(d, 200, [](int i) { return (mainsActive(i) ? 1u : 0u) | 2u; });
+    TEST_ASSERT_EQUAL_HEX16(0x3, d.state());
+
+    // in1 loses mains, in2 keeps going: a single change, only bit 0 drops.
+    TEST_ASSERT_EQUAL(1, feedN(d, 200, [](int) { return 2u; }));
+    TEST_ASSERT_EQUAL_HEX16(0x2, d.state());
+
+    // Bits above N are ignored.
+    TEST_ASSERT_EQUAL(0, feedN(d, 200, [](int) { return 2u | 0xFFF8u; }));
+    TEST_ASSERT_EQUAL_HEX16(0x2, d.state());
+}
+
+void test_sixteen_inputs(void) {
+    PbInputDebouncer<16> d(kCfg);
+    feedN(d, 100, [](int) { return 0x8001u; });
+    TEST_ASSERT_EQUAL_HEX16(0x8001, d.state());
+    feedN(d, 100, [](int) { return 0x0001u; });
+    TEST_ASSERT_EQUAL_HEX16(0x0001, d.state());
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_dark_inputs_stay_off);
+    RUN_TEST(test_mains_pulses_turn_on_once_and_hold);
+    RUN_TEST(test_outage_turns_off_after_off_samples);
+    RUN_TEST(test_sparse_glitches_are_ignored);
+    RUN_TEST(test_channels_are_independent);
+    RUN_TEST(test_sixteen_inputs);
+    return UNITY_END();
+}
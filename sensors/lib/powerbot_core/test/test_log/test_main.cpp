@@ -0,0 +1,136 @@
+// Host-side tests for include/pb_log.h (pio test -e native).
+//
+// Records go through the same PbLogRing + pbLogRender pair the drain task uses;
+// the native build keeps the default PB_LOG_LEVEL (INFO), so PB_LOGD must vanish.
+
+#include <unity.h>
+
+#include <string>
+
+#include "pb_log.h"
+
+namespace {
+
+PbLogRing<512> ring;
+int pushes = 0;
+
+std::string drainOne() {
+    uint8_t rec[kPbLogMaxRecord];
+    char line[kPbLogMaxLine];
+    const size_t n = ring.pop(rec, sizeof(rec));
+    if (n == 0) {
+        return "<empty>";
+    }
+    pbLogRender(rec, n, line, sizeof(line));
+    return line;
+}
+
+int sideEffect(int &calls) {
+    return ++calls;
+}
+
+}  // namespace
+
+void pbLogPush(const uint8_t *rec, size_t len) {
+    pushes++;
+    ring.push(rec, len);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_render_ints_strings_and_ip(void) {
+    PB_LOGI(HbTarget, "example.test", 18081u);
+    PB_LOGI(HbLocalIp, 192, 168, 1, 77);
+    PB_LOGI(HbNext, -5);
+    PB_LOGI(HbFrameRejected);
+    TEST_ASSERT_EQUAL_STRING("🌐 Підключення до example.test:18081", drainOne().c_str());
+    TEST_ASSERT_EQUAL_STRING("   Local IP: 192.168.1.77", drainOne().c_str());
+    TEST_ASSERT_EQUAL_STRING("⏰ Наступний через -5 сек", drainOne().c_str());
+    TEST_ASSERT_EQUAL_STRING("⚠️ Frame не прийнято — наступний beat піде JSON", drainOne().c_str());
+    TEST_ASSERT_EQUAL_STRING("<empty>", drainOne().c_str());
+}
+
+void test_strings_are_copied_and_long_ones_truncated(void) {
+    char status[32] = "HTTP/1.1 200 OK";
+    PB_LOGI(HbStatus, status);
+    strcpy(status, "overwritten");   // наступний beat перезаписує буфер машини
+    TEST_ASSERT_EQUAL_STRING("📨 HTTP/1.1 200 OK", drainOne().c_str());
+
+    std::string body(400, 'x');
+    PB_LOGI(HbBody, body.c_str());
+    const std::string line = drainOne();
+    TEST_ASSERT_EQUAL(strlen("📨 Body: ") + kPbLogMaxRecord - kPbLogHeader - 2, line.size());
+}
+
+void test_missing_args_render_as_question_mark(void) {
+    PB_LOGI(HbConnections, 3u);
+    TEST_ASSERT_EQUAL_STRING("   Connections: new=3, reused=?", drainOne().c_str());
+}
+
+void test_debug_is_compiled_out(void) {
+    int calls = 0;
+    const int before = pushes;
+    PB_LOGD(HbPayload, sideEffect(calls));
+    TEST_ASSERT_EQUAL(0, calls);
+    TEST_ASSERT_EQUAL(before, pushes);
+    PB_LOGI(HbNext, sideEffect(calls));
+    TEST_ASSERT_EQUAL(1, calls);
+    TEST_ASSERT_EQUAL(before + 1, pushes);
+    drainOne();
+}
+
+void test_full_ring_drops_and_counts(void) {
+    PbLogRing<512> small;
+    PbLogRecord r(PB_LOG_LEVEL_INFO, PbLogId::HbHeap);
+    pbLogAddAll(r, 1u, 2u, 3u, 4u);
+    const uint8_t *rec = r.finish();
+    int accepted = 0;
+    for (int i = 0; i < 100; i++) {
+        accepted += small.push(rec, r.size()) ? 1 : 0;
+    }
+    TEST_ASSERT_EQUAL(512 / r.size(), accepted);
+    TEST_ASSERT_EQUAL_UINT32(100 - accepted, small.dropped());
+
+    // Дренер звільнив місце — знову приймає, записи цілі після wrap-around.
+    uint8_t out[kPbLogMaxRecord];
+    char line[128];
+    for (int round = 0; round < 50; round++) {
+        TEST_ASSERT_EQUAL(r.size(), small.pop(out, sizeof(out)));
+        TEST_ASSERT_TRUE(small.push(rec, r.size()));
+    }
+    pbLogRender(out, r.size(), line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("   Heap: free=1, low=2, drops=3; log drops=4", line);
+}
+
+void test_unknown_id_and_short_record_render_empty(void) {
+    // Дамп з новішої прошивки: id поза таблицею.
+    uint8_t rec[] = {4, 0, 0xFF, 0x7F};
+    char line[16] = "unchanged";
+    TEST_ASSERT_EQUAL(0, pbLogRender(rec, sizeof(rec), line, sizeof(line)));
+    TEST_ASSERT_EQUAL_STRING("", line);
+    TEST_ASSERT_EQUAL(0, pbLogRender(rec, 2, line, sizeof(line)));
+}
+
+void test_every_format_fits_a_line(void) {
+    // Дренер рендерить у char[kPbLogMaxLine]: жоден формат не має обрізатись (рядок-"?" на аргумент).
+    char line[kPbLogMaxLine + 1];
+    for (uint16_t id = 0; id < static_cast<uint16_t>(PbLogId::Count); id++) {
+        PbLogRecord r(PB_LOG_LEVEL_INFO, static_cast<PbLogId>(id));
+        const size_t n = pbLogRender(r.finish(), r.size(), line, sizeof(line));
+        TEST_ASSERT_TRUE_MESSAGE(n > 0, kPbLogFormats[id]);
+        TEST_ASSERT_TRUE_MESSAGE(n < kPbLogMaxLine - 64, kPbLogFormats[id]);
+    }
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_render_ints_strings_and_ip);
+    RUN_TEST(test_strings_are_copied_and_long_ones_truncated);
+    RUN_TEST(test_missing_args_render_as_question_mark);
+    RUN_TEST(test_debug_is_compiled_out);
+    RUN_TEST(test_full_ring_drops_and_counts);
+    RUN_TEST(test_unknown_id_and_short_record_render_empty);
+    RUN_TEST(test_every_format_fits_a_line);
+    return UNITY_END();
+}
@@ -0,0 +1,263 @@
+// Host-side tests for include/pb_mains.h (pio test -e native).
+//
+// Synthetic mains waveforms (12-bit ADC codes at 20 kHz, as the DMA task delivers them)
+// through the fixed-point kernel: RMS and frequency accuracy, DC offset and noise, a sag,
+// an outage, block boundaries, the JSON slots — and a cycles-per-sample benchmark.
+// The generator uses floating point; the kernel under test does not.
+
+#include <unity.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <vector>
+
+#include "pb_mains.h"
+
+namespace {
+
+const uint32_t kSampleHz = 20000;
+// ZMPT101B-style front end: 230 V RMS ≈ 1314 counts RMS.
+const PbMainsConfig kCfg = {kSampleHz, 175000, 40, 40, 70};
+
+struct Wave {
+    double volts;   // RMS
+    double hz;
+    double mid;     // DC bias, counts
+    int noise;      // ± counts, uniform
+};
+
+// Appends `seconds` of a sine to `out`, continuing the phase in *phase.
+void gen(std::vector<uint16_t> &out, const Wave &w, double seconds, double *phase, uint32_t *rng) {
+    const double ampCounts = w.volts * 1e6 / kCfg.uvPerCount * sqrt(2.0);
+    const int n = static_cast<int>(seconds * kSampleHz);
+    for (int i = 0; i < n; i++) {
+        double v = w.mid + ampCounts * sin(*phase);
+        if (w.noise > 0) {
+            *rng = *rng * 1664525u + 1013904223u;
+            v += static_cast<int>((*rng >> 16) % (2 * w.noise + 1)) - w.noise;
+        }
+        const long code = lround(v);
+        out.push_back(static_cast<uint16_t>(code < 0 ? 0 : (code > 4095 ? 4095 : code)));
+        *phase += 2.0 * M_PI * w.hz / kSampleHz;
+    }
+}
+
+PbMainsStats run(const std::vector<uint16_t> &samples, size_t block = 256) {
+    PbMainsMeter meter(kCfg);
+    PbMainsStats stats;
+    for (size_t at = 0; at < samples.size(); at += block) {
+        const size_t n = samples.size() - at < block ? samples.size() - at : block;
+        meter.feed(samples.data() + at, n, stats);
+    }
+    return stats;
+}
+
+PbMainsStats runWave(const Wave &w, double seconds) {
+    std::vector<uint16_t> s;
+    double phase = 0;
+    uint32_t rng = 1;
+    gen(s, w, seconds, &phase, &rng);
+    return run(s);
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_isqrt(void) {
+    TEST_ASSERT_EQUAL_UINT32(0, pbIsqrt64(0));
+    TEST_ASSERT_EQUAL_UINT32(1, pbIsqrt64(3));
+    TEST_ASSERT_EQUAL_UINT32(2, pbIsqrt64(4));
+    TEST_ASSERT_EQUAL_UINT32(65535, pbIsqrt64(0xFFFFFFFFull));
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFFu, pbIsqrt64(0xFFFFFFFFFFFFFFFFull));
+    TEST_ASSERT_EQUAL_UINT32(3000000, pbIsqrt64(9000000000000ull));
+}
+
+void test_clean_230v_50hz(void) {
+    const PbMainsStats s = runWave({230.0, 50.0, 2048, 0}, 1.0);
+    // 50 periods; the first crossing only syncs.
+    TEST_ASSERT_INT_WITHIN(1, 49, static_cast<int>(s.cycles()));
+    TEST_ASSERT_EQUAL_UINT32(s.cycles(), s.freqCycles());
+    TEST_ASSERT_UINT32_WITHIN(3, 2300, s.vMin());
+    TEST_ASSERT_UINT32_WITHIN(3, 2300, s.vMax());
+    TEST_ASSERT_UINT32_WITHIN(2, 50000, s.fMin());
+    TEST_ASSERT_UINT32_WITHIN(2, 50000, s.fMax());
+}
+
+void test_frequency_between_samples(void) {
+    // 49.5 / 50.5 / 60 Hz: the period is not a whole number of samples.
+    const double hz[] = {49.5, 50.5, 60.0};
+    for (double f : hz) {
+        const PbMainsStats s = runWave({220.0, f, 2048, 0}, 1.0);
+        const uint32_t want = static_cast<uint32_t>(f * 1000);
+        TEST_ASSERT_UINT32_WITHIN(5, want, s.fAvg());
+        TEST_ASSERT_UINT32_WITHIN(20, want, s.fMin());
+        TEST_ASSERT_UINT32_WITHIN(20, want, s.fMax());
+        TEST_ASSERT_UINT32_WITHIN(3, 2200, s.vAvg());
+    }
+}
+
+void test_offset_and_noise(void) {
+    // Bias far from mid-scale and ±12 counts of noise: RMS of the AC part still within 0.5 V
+    // (noise adds ~7 counts RMS in quadrature), no false crossings.
+    const PbMainsStats s = runWave({230.0, 50.0, 1900, 12}, 2.0);
+    TEST_ASSERT_INT_WITHIN(2, 99, static_cast<int>(s.cycles()));
+    TEST_ASSERT_EQUAL_UINT32(s.cycles(), s.freqCycles());
+    TEST_ASSERT_UINT32_WITHIN(5, 2300, s.vAvg());
+    // Noise moves each crossing by a fraction of a sample: per-period spread, unbiased mean.
+    TEST_ASSERT_UINT32_WITHIN(5, 50000, s.fAvg());
+    TEST_ASSERT_UINT32_WITHIN(250, 50000, s.fMin());
+    TEST_ASSERT_UINT32_WITHIN(250, 50000, s.fMax());
+}
+
+void test_sag_shows_in_min(void) {
+    std::vector<uint16_t> samples;
+    double phase = 0;
+    uint32_t rng = 1;
+    gen(samples, {230.0, 50.0, 2048, 0}, 0.2, &phase, &rng);
+    gen(samples, {180.0, 50.0, 2048, 0}, 0.1, &phase, &rng);   // 5 periods of sag
+    gen(samples, {250.0, 50.0, 2048, 0}, 0.1, &phase, &rng);   // then a swell
+    gen(samples, {230.0, 50.0, 2048, 0}, 0.2, &phase, &rng);
+    const PbMainsStats s = run(samples);
+    TEST_ASSERT_UINT32_WITHIN(10, 1800, s.vMin());
+    TEST_ASSERT_UINT32_WITHIN(10, 2500, s.vMax());
+    TEST_ASSERT_TRUE(s.vAvg() > 2200 && s.vAvg() < 2300);
+    TEST_ASSERT_UINT32_WITHIN(50, 50000, s.fMin());
+}
+
+void test_outage_closes_cycles_without_frequency(void) {
+    std::vector<uint16_t> samples;
+    double phase = 0;
+    uint32_t rng = 1;
+    gen(samples, {230.0, 50.0, 2048, 0}, 0.5, &phase, &rng);
+    gen(samples, {0.0, 50.0, 2048, 5}, 0.5, &phase, &rng);   // board on UPS, mains gone
+    const PbMainsStats s = run(samples);
+    TEST_ASSERT_TRUE(s.vMin() < 20);                              // < 2 V: ADC noise only
+    TEST_ASSERT_UINT32_WITHIN(3, 2300, s.vMax());
+    TEST_ASSERT_TRUE(s.cycles() > s.freqCycles());                // dead periods: voltage only
+    TEST_ASSERT_INT_WITHIN(1, 24, static_cast<int>(s.freqCycles()));
+    TEST_ASSERT_UINT32_WITHIN(2, 50000, s.fMin());
+
+    // No signal at all: one period per 1/minHz, never a frequency.
+    const PbMainsStats dead = runWave({0.0, 50.0, 2048, 5}, 1.0);
+    TEST_ASSERT_EQUAL_UINT32(kCfg.minHz, dead.cycles());
+    TEST_ASSERT_EQUAL_UINT32(0, dead.freqCycles());
+    TEST_ASSERT_EQUAL_UINT32(0, dead.fAvg());
+}
+
+void test_resync_drops_the_broken_period(void) {
+    std::vector<uint16_t> samples;
+    double phase = 0;
+    uint32_t rng = 1;
+    gen(samples, {230.0, 50.0, 2048, 0}, 1.0, &phase, &rng);
+    PbMainsMeter meter(kCfg);
+    PbMainsStats stats;
+    meter.feed(samples.data(), 10130, stats);
+    // 37 samples lost between DMA blocks: without resync that period would read ~55 Hz.
+    meter.resync();
+    meter.feed(samples.data() + 10167, samples.size() - 10167, stats);
+    TEST_ASSERT_INT_WITHIN(1, 47, static_cast<int>(stats.cycles()));
+    TEST_ASSERT_EQUAL_UINT32(stats.cycles(), stats.freqCycles());
+    TEST_ASSERT_UINT32_WITHIN(2, 50000, stats.fMin());
+    TEST_ASSERT_UINT32_WITHIN(2, 50000, stats.fMax());
+    TEST_ASSERT_UINT32_WITHIN(3, 2300, stats.vMin());
+}
+
+void test_block_size_does_not_matter(void) {
+    std::vector<uint16_t> samples;
+    double phase = 0;
+    uint32_t rng = 7;
+    gen(samples, {231.0, 49.9, 2000, 8}, 0.5, &phase, &rng);
+    const PbMainsStats a = run(samples, 1);
+    const PbMainsStats b = run(samples, 256);
+    const PbMainsStats c = run(samples, 1000);
+    TEST_ASSERT_EQUAL_UINT32(a.cycles(), b.cycles());
+    TEST_ASSERT_EQUAL_UINT32(a.vAvg(), b.vAvg());
+    TEST_ASSERT_EQUAL_UINT32(a.fMin(), c.fMin());
+    TEST_ASSERT_EQUAL_UINT32(a.fMax(), c.fMax());
+}
+
+void test_merge_and_json_slots(void) {
+    PbMainsStats a;
+    PbMainsStats b;
+    a.add(2300, 50010);
+    a.add(2280, 0);
+    b.add(2350, 49990);
+    a.merge(b);
+    a.merge(PbMainsStats());
+    TEST_ASSERT_EQUAL_UINT32(3, a.cycles());
+    TEST_ASSERT_EQUAL_UINT32(2280, a.vMin());
+    TEST_ASSERT_EQUAL_UINT32(2310, a.vAvg());
+    TEST_ASSERT_EQUAL_UINT32(2350, a.vMax());
+    TEST_ASSERT_EQUAL_UINT32(2, a.freqCycles());
+    TEST_ASSERT_EQUAL_UINT32(49990, a.fMin());
+    TEST_ASSERT_EQUAL_UINT32(50000, a.fAvg());
+
+    char v[] = PB_MAINS_V_JSON;
+    char hz[] = PB_MAINS_HZ_JSON;
+    pbMainsStatsPut(v, hz, sizeof(v) - 1, a);
+    TEST_ASSERT_EQUAL_STRING("[      2280,      2310,      2350,         3]", v);
+    TEST_ASSERT_EQUAL_STRING("[     49990,     50000,     50010,         2]", hz);
+
+    a.clear();
+    TEST_ASSERT_EQUAL_UINT32(0, a.cycles());
+    TEST_ASSERT_EQUAL_UINT32(0, a.vAvg());
+}
+
+// Not a pass/fail gate: prints the kernel cost so changes to feed() can be compared.
+// On the ESP32 the DMA task logs the same figure from the CPU cycle counter.
+void test_benchmark_cycles_per_sample(void) {
+    std::vector<uint16_t> samples;
+    double phase = 0;
+    uint32_t rng = 3;
+    gen(samples, {230.0, 50.0, 2048, 8}, 10.0, &phase, &rng);
+    PbMainsMeter meter(kCfg);
+    PbMainsStats stats;
+    const int rounds = 10;
+    timespec t0;
+    timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+#if defined(__x86_64__) || defined(__i386__)
+    const uint64_t c0 = __builtin_ia32_rdtsc();
+#endif
+    for (int r = 0; r < rounds; r++) {
+        for (size_t at = 0; at < samples.size(); at += 256) {
+            meter.feed(samples.data() + at, 256, stats);
+        }
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    const uint64_t c1 = __builtin_ia32_rdtsc();
+#endif
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    const double total = static_cast<double>(samples.size()) * rounds;
+    const double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+    char msg[128];
+#if defined(__x86_64__) || defined(__i386__)
+    snprintf(msg, sizeof(msg), "PbMainsMeter::feed: %.2f ns/sample, %.1f TSC cycles/sample (%u periods)",
+             ns / total, static_cast<double>(c1 - c0) / total, static_cast<unsigned>(stats.cycles()));
+#else
+    snprintf(msg, sizeof(msg), "PbMainsMeter::feed: %.2f ns/sample (%u periods)", ns / total,
+             static_cast<unsigned>(stats.cycles()));
+#endif
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_INT_WITHIN(10, 500 * rounds - 1, static_cast<int>(stats.cycles()));
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_isqrt);
+    RUN_TEST(test_clean_230v_50hz);
+    RUN_TEST(test_frequency_between_samples);
+    RUN_TEST(test_offset_and_noise);
+    RUN_TEST(test_sag_shows_in_min);
+    RUN_TEST(test_outage_closes_cycles_without_frequency);
+    RUN_TEST(test_resync_drops_the_broken_period);
+    RUN_TEST(test_block_size_does_not_matter);
+    RUN_TEST(test_merge_and_json_slots);
+    RUN_TEST(test_benchmark_cycles_per_sample);
+    return UNITY_END();
+}
@@ -0,0 +1,137 @@
+// Host-side tests for include/pb_power_watch.h (pio test -e native).
+//
+// Simulates the supply rail around an outage: a clean drop, a slow capacitor
+// discharge, mains glitches that must not trigger, and recovery with hysteresis.
+
+#include <unity.h>
+
+#include "pb_power_watch.h"
+
+namespace {
+
+const PbPowerWatchConfig kCfg = {4300, 4600, 3};
+
+// Feeds `count` identical samples, returns the first non-None event (or None).
+PbPowerEvent feedN(PbPowerWatch &w, uint16_t mv, int count, int *atSample = nullptr) {
+    for (int i = 0; i < count; i++) {
+        const PbPowerEvent ev = w.feed(mv);
+        if (ev != PbPowerEvent::None) {
+            if (atSample != nullptr) {
+                *atSample = i;
+            }
+            return ev;
+        }
+    }
+    return PbPowerEvent::None;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_steady_supply_never_fires(void) {
+    PbPowerWatch w(kCfg);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbPowerEvent::None), static_cast<int>(feedN(w, 5000, 1000)));
+    TEST_ASSERT_FALSE(w.lost());
+}
+
+void test_hard_drop_fires_after_confirm_samples(void) {
+    PbPowerWatch w(kCfg);
+    feedN(w, 5000, 10);
+    int at = -1;
+    TEST_ASSERT_EQUAL(static_cast<int>(PbPowerEvent::Lost), static_cast<int>(feedN(w, 0, 10, &at)));
+    TEST_ASSERT_EQUAL(kCfg.confirmSamples - 1, at);
+    TEST_ASSERT_TRUE(w.lost());
+    // Fires exactly once per edge.
+    TEST_ASSERT_EQUAL(static_cast<int>(PbPowerEvent::None), static_cast<int>(feedN(w, 0, 100)));
+}
+
+void test_capacitor_discharge_ramp(void) {
+    PbPowerWatch w(kCfg);
+    // 5.0 V decaying by 50 mV per sample: the edge is the first sample below 4.3 V + confirm.
+    uint16_t mv = 5000;
+    int sample = 0;
+    PbPowerEvent ev = PbPowerEvent::None;
+    while (ev == PbPowerEvent::None && mv > 0) {
+        ev = w.feed(mv);
+        mv = static_cast<uint16_t>(mv - 50);
+        sample++;
+    }
+    TEST_ASSERT_EQUAL(static_cast<int>(PbPowerEvent::Lost), static_cast<int>(ev));
+    // 5000 -> 4250 is 15 steps, +2 more samples to confirm => fired on the 18th sample.
+    TEST_ASSERT_EQUAL(18, sample);
+}
+
+void test_short_glitches_are_ignored(void) {
+    PbPowerWatch w(kCfg);
+    for (int i = 0; i < 50; i++) {
+        TEST_ASSERT_EQUAL(static_cast<int>(PbPowerEvent::None), static_cast<int>(w.feed(3000)));
+        TEST_ASSERT_EQUAL(static_cast<int>(PbPowerEvent::None), static_cast<int>(w.feed(3000)));
+        TEST_ASSERT_EQUAL(static_cast<int>(PbPowerEvent::None), static_cast<int>(w.feed(5000)));
+    }
+    TEST_ASSERT_FALSE(w.lost());
+}
+
+void test_restore_needs_hysteresis_and_confirm(void) {
+    PbPowerWatch w(kCfg);
+    feedN(w, 0, 10);
+    TEST_ASSERT_TRUE(w.lost());
+    // Between thresholds: still "lost", no chatter around a single threshold.
+    TEST_ASSERT_EQUAL(static_cast<int>(PbPowerEvent::None), static_cast<int>(feedN(w, 4450, 100)));
+    TEST_ASSERT_TRUE(w.lost());
+    // One good sample followed by a dip restarts the confirm streak.
+    w.feed(4700);
+    w.feed(4700);
+    w.feed(4000);
+    TEST_ASSERT_TRUE(w.lost());
+    int at = -1;
+    TEST_ASSERT_EQUAL(static_cast<int>(PbPowerEvent::Restored), static_cast<int>(feedN(w, 4700, 10, &at)));
+    TEST_ASSERT_EQUAL(kCfg.confirmSamples - 1, at);
+    TEST_ASSERT_FALSE(w.lost());
+}
+
+void test_repeated_outages(void) {
+    PbPowerWatch w(kCfg);
+    for (int cycle = 0; cycle < 5; cycle++) {
+        TEST_ASSERT_EQUAL(static_cast<int>(PbPowerEvent::Lost), static_cast<int>(feedN(w, 1000, 10)));
+        TEST_ASSERT_EQUAL(static_cast<int>(PbPowerEvent::Restored), static_cast<int>(feedN(w, 5000, 10)));
+    }
+}
+
+void test_brownout_gpio_level(void) {
+    PbPowerWatch w(kCfg);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbPowerEvent::None), static_cast<int>(w.feedLevel(true)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbPowerEvent::None), static_cast<int>(w.feedLevel(false)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbPowerEvent::None), static_cast<int>(w.feedLevel(false)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbPowerEvent::Lost), static_cast<int>(w.feedLevel(false)));
+    w.feedLevel(true);
+    w.feedLevel(true);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbPowerEvent::Restored), static_cast<int>(w.feedLevel(true)));
+}
+
+void test_zero_confirm_means_single_sample(void) {
+    const PbPowerWatchConfig cfg = {4300, 4600, 0};
+    PbPowerWatch w(cfg);
+    TEST_ASSERT_EQUAL(static_cast<int>(PbPowerEvent::Lost), static_cast<int>(w.feed(100)));
+}
+
+void test_supply_mv_divider_scaling(void) {
+    TEST_ASSERT_EQUAL_UINT16(5000, pbPowerSupplyMv(2500, 2000));
+    TEST_ASSERT_EQUAL_UINT16(3300, pbPowerSupplyMv(3300, 1000));
+    TEST_ASSERT_EQUAL_UINT16(0xFFFF, pbPowerSupplyMv(3300, 100000));
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_steady_supply_never_fires);
+    RUN_TEST(test_hard_drop_fires_after_confirm_samples);
+    RUN_TEST(test_capacitor_discharge_ramp);
+    RUN_TEST(test_short_glitches_are_ignored);
+    RUN_TEST(test_restore_needs_hysteresis_and_confirm);
+    RUN_TEST(test_repeated_outages);
+    RUN_TEST(test_brownout_gpio_level);
+    RUN_TEST(test_zero_confirm_means_single_sample);
+    RUN_TEST(test_supply_mv_divider_scaling);
+    return UNITY_END();
+}
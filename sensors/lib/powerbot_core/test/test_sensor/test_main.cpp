@@ -0,0 +1,342 @@
+// Host-side simulation of the whole firmware, include/pb_sensor.h (pio test -e native).
+//
+// test/sim stands in for Arduino / FreeRTOS / esp_timer / NVS with a simulated clock, and
+// pb_net_sim.h for the network: a scripted server and DNS with latencies in simulated time.
+// The firmware is built unmodified; the test drives its net task one turn at a time
+// (pbNetTaskStep()), so every run is deterministic and takes milliseconds.
+//
+// The firmware keeps its state in statics (one boot per binary), so the tests are a single
+// timeline: each one picks up the sensor where the previous one left it.
+
+#include <unity.h>
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+
+#include "config.h"
+#include "pb_net_sim.h"
+
+typedef PbSimDnsNet PbBoardDnsNet;
+typedef PbSimNet PbBoardNet;
+
+#include "pb_sensor.h"
+
+// ─── Плата симуляції: лінк і DHCP — події сценарію, як ETH-події на WT32-ETH01 ───
+
+static const uint32_t kDhcpMs = 1200;
+static uint64_t simFirstBeatUs = 0;
+static unsigned simDelivered = 0;
+
+static void simGotIp() {
+    if (pbSimServer().link) {
+        xEventGroupSetBits(pbNetEvents, kPbEvEthUp);
+    }
+}
+
+static void simLinkDown() {
+    pbSimServer().link = false;
+}
+
+// Кабель повернувся: IP — після DHCP.
+static void simLinkUp() {
+    pbSimServer().link = true;
+    pbSimAfterMs(kDhcpMs, simGotIp);
+}
+
+void pbBoardBanner() {
+    Serial.println("  PowerBot Sim Heartbeat Sensor");
+}
+
+void pbBoardSetupEthernet() {
+    pbSimAfterMs(kDhcpMs, simGotIp);
+    xEventGroupWaitBits(pbNetEvents, kPbEvEthUp, pdFALSE, pdTRUE, pdMS_TO_TICKS(15000));
+}
+
+bool pbBoardNetReady() {
+    if (pbEthUp() && !pbSimServer().link) {
+        PB_LOGE(LinkDown);
+        xEventGroupClearBits(pbNetEvents, kPbEvEthUp);
+    }
+    return pbEthUp();
+}
+
+bool pbBoardLinkUp() {
+    return pbSimServer().link;
+}
+
+IPAddress pbBoardLocalIp() {
+    return IPAddress(10, 0, 0, 50);
+}
+
+IPAddress pbBoardGatewayIp() {
+    return IPAddress(10, 0, 0, 1);
+}
+
+void pbBoardBeatDelivered() {
+    if (simDelivered++ == 0) {
+        simFirstBeatUs = pbSim().nowUs;
+    }
+}
+
+// ─── Хелпери сценарію ───
+
+namespace {
+
+const uint64_t kMs = 1000;
+const uint64_t kPeriodUs = HEARTBEAT_INTERVAL_MS * kMs;
+
+// Boot (затримка Serial у setup() + DHCP) -> перший доставлений beat у симуляції:
+// DNS 2 мс, connect 3 мс, відповідь 20 мс. Запас — на кроки net-задачі, не на таймаути.
+const uint64_t kBootToFirstBeatBudgetUs = (2000 + kDhcpMs + 100) * kMs;
+
+void runUntilUs(uint64_t atUs) {
+    while (pbSim().nowUs < atUs) {
+        pbNetTaskStep();
+    }
+}
+
+void runMs(uint64_t ms) {
+    runUntilUs(pbSim().nowUs + ms * kMs);
+}
+
+// Net-задача до n-го запиту на сервері (з обмеженням часу, щоб тест не завис).
+bool runUntilRequests(size_t n, uint64_t limitMs) {
+    const uint64_t deadline = pbSim().nowUs + limitMs * kMs;
+    while (pbSimServer().requests.size() < n && pbSim().nowUs < deadline) {
+        pbNetTaskStep();
+    }
+    return pbSimServer().requests.size() >= n;
+}
+
+bool runUntilDelivered(unsigned n, uint64_t limitMs) {
+    const uint64_t deadline = pbSim().nowUs + limitMs * kMs;
+    while (simDelivered < n && pbSim().nowUs < deadline) {
+        pbNetTaskStep();
+    }
+    return simDelivered >= n;
+}
+
+const PbSimRequest &lastRequest() {
+    return pbSimServer().requests.back();
+}
+
+bool serialHas(const char *text) {
+    return pbSim().serial.find(text) != std::string::npos;
+}
+
+// Слоти JSON-шаблону вирівняні пробілами: "seq":         1.
+unsigned long jsonU32(const std::string &body, const char *key) {
+    const std::string k = std::string("\"") + key + "\":";
+    const size_t at = body.find(k);
+    return at == std::string::npos ? 0 : strtoul(body.c_str() + at + k.size(), nullptr, 10);
+}
+
+size_t countPath(const char *path, size_t from) {
+    size_t n = 0;
+    for (size_t i = from; i < pbSimServer().requests.size(); i++) {
+        n += pbSimServer().requests[i].path == path ? 1 : 0;
+    }
+    return n;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_boot_to_first_beat(void) {
+    const uint32_t prevBoots = 41;   // лічильник завантажень з минулих boot (NVS)
+    pbSim().nvs["pb_boot/n"] = std::string(reinterpret_cast<const char *>(&prevBoots), sizeof(prevBoots));
+    setup();
+    TEST_ASSERT_TRUE(runUntilDelivered(1, 30000));
+
+    const PbSimRequest &boot = pbSimServer().requests.front();
+    TEST_ASSERT_EQUAL_STRING("/api/v1/heartbeat", boot.path.c_str());
+    TEST_ASSERT_TRUE(boot.body.find("\"event\":\"boot\"") != std::string::npos);
+    TEST_ASSERT_EQUAL_UINT(1, jsonU32(boot.body, "seq"));
+    TEST_ASSERT_EQUAL_UINT(42, jsonU32(boot.body, "boot_count"));
+    uint32_t storedBoots = 0;
+    memcpy(&storedBoots, pbSim().nvs["pb_boot/n"].data(), sizeof(storedBoots));
+    TEST_ASSERT_EQUAL_UINT(42, storedBoots);
+    TEST_ASSERT_EQUAL_UINT(1, pbSimServer().dnsQueries);
+    TEST_ASSERT_TRUE(serialHas("✅ Heartbeat успішно!"));
+    TEST_ASSERT_FALSE(serialHas(API_KEY));   // і з PB_LOG_LEVEL_DEBUG тіло JSON не логується
+
+    char msg[64];
+    snprintf(msg, sizeof(msg), "boot -> first beat: %lu ms (budget %lu ms)",
+             static_cast<unsigned long>(simFirstBeatUs / kMs), static_cast<unsigned long>(kBootToFirstBeatBudgetUs / kMs));
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(simFirstBeatUs <= kBootToFirstBeatBudgetUs);
+}
+
+// Після boot — рівна сітка періоду, frame замість JSON, одне keep-alive з'єднання.
+void test_beats_follow_schedule_on_one_connection(void) {
+    const size_t from = pbSimServer().requests.size();
+    TEST_ASSERT_TRUE(runUntilRequests(from + 5, 6 * HEARTBEAT_INTERVAL_MS));
+
+    const std::vector<PbSimRequest> &req = pbSimServer().requests;
+    for (size_t i = from; i < req.size(); i++) {
+        TEST_ASSERT_EQUAL_STRING("/api/v1/heartbeat", req[i].path.c_str());
+        TEST_ASSERT_TRUE(req[i].head.find("application/octet-stream") != std::string::npos);
+        TEST_ASSERT_EQUAL_UINT(PB_FRAME_SIZE, req[i].body.size());
+        TEST_ASSERT_EQUAL_UINT(42, pbFrameGetU32(reinterpret_cast<const uint8_t *>(req[i].body.data()) + 24));
+        TEST_ASSERT_EQUAL_UINT(req[0].conn, req[i].conn);
+        if (i > from) {
+            // Дедлайн — від дедлайну, а не від кінця попереднього beat: без дрейфу.
+            TEST_ASSERT_EQUAL_UINT64(kPeriodUs, req[i].atUs - req[i - 1].atUs);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT(1, pbSimServer().connects);
+    TEST_ASSERT_EQUAL_UINT(1, pbSimServer().dnsQueries);
+}
+
+void test_server_interval_header_reschedules(void) {
+    pbSimServer().reply = pbSimReplyOk(20, "X-PB-Interval-Ms: 4000\r\n");
+    const size_t from = pbSimServer().requests.size();
+    TEST_ASSERT_TRUE(runUntilRequests(from + 4, 3 * HEARTBEAT_INTERVAL_MS));
+    const std::vector<PbSimRequest> &req = pbSimServer().requests;
+    for (size_t i = from + 2; i < req.size(); i++) {
+        const uint64_t gapUs = req[i].atUs - req[i - 1].atUs;
+        TEST_ASSERT_TRUE(gapUs > 3990 * kMs && gapUs < 4010 * kMs);
+    }
+    TEST_ASSERT_TRUE(serialHas("4000"));
+
+    // Назад на HEARTBEAT_INTERVAL_MS: без заголовка період не змінюється, тож сервер каже явно.
+    pbSimServer().reply = pbSimReplyOk(20, "X-PB-Interval-Ms: 10000\r\n");
+    TEST_ASSERT_TRUE(runUntilRequests(req.size() + 2, 3 * HEARTBEAT_INTERVAL_MS));
+    pbSimServer().reply = pbSimReplyOk(20);
+    const size_t n = req.size();
+    TEST_ASSERT_TRUE(runUntilRequests(n + 1, 2 * HEARTBEAT_INTERVAL_MS));
+    const uint64_t gapUs = req[n].atUs - req[n - 1].atUs;
+    TEST_ASSERT_TRUE(gapUs > kPeriodUs - 10 * kMs && gapUs < kPeriodUs + 10 * kMs);
+}
+
+// Сервер мовчить: beat падає рівно по таймауту, сокет закривається, наступний — нове
+// з'єднання; недоставлений seq після двох успішних beat-ів іде пакетом у /bulk.
+void test_silent_server_times_out_and_is_journaled(void) {
+    pbSim().serial.clear();
+    PbSimReply silent = pbSimReplyOk(0);
+    silent.delayMs = kPbSimNever;
+    pbSimServer().script.push_back(silent);
+
+    const size_t from = pbSimServer().requests.size();
+    const unsigned connects = pbSimServer().connects;
+    TEST_ASSERT_TRUE(runUntilRequests(from + 1, 2 * HEARTBEAT_INTERVAL_MS));
+    const uint64_t sentUs = lastRequest().atUs;
+    const size_t failedSeq = countPath("/api/v1/heartbeat", 0);
+
+    runUntilUs(sentUs + (HTTP_TIMEOUT_MS - 10) * kMs);
+    TEST_ASSERT_FALSE(serialHas("❌ Помилка heartbeat!"));
+    runUntilUs(sentUs + (HTTP_TIMEOUT_MS + 20) * kMs);
+    TEST_ASSERT_TRUE(serialHas("❌ Помилка heartbeat!"));
+
+    TEST_ASSERT_TRUE(runUntilRequests(from + 4, 4 * HEARTBEAT_INTERVAL_MS));
+    const std::vector<PbSimRequest> &req = pbSimServer().requests;
+    TEST_ASSERT_EQUAL_UINT(connects + 1, pbSimServer().connects);
+    TEST_ASSERT_EQUAL_STRING("/api/v1/heartbeat", req[from + 1].path.c_str());
+    TEST_ASSERT_EQUAL_STRING("/api/v1/heartbeat", req[from + 2].path.c_str());
+    TEST_ASSERT_EQUAL_STRING("/api/v1/heartbeat/bulk", req[from + 3].path.c_str());
+    char rec[24];
+    snprintf(rec, sizeof(rec), "\"beats\":[[%u,", static_cast<unsigned>(failedSeq));
+    TEST_ASSERT_TRUE(req[from + 3].body.find(rec) != std::string::npos);
+    runMs(100);
+    TEST_ASSERT_TRUE(serialHas("📒 Журнал доставлено: 1 записів"));
+}
+
+// Відповідь шматками по 5 байт з паузами — beat доставлено; FIN посеред заголовків — ні.
+void test_partial_responses(void) {
+    PbSimReply slow = pbSimReplyOk(10);
+    slow.chunk = 5;
+    slow.chunkGapMs = 7;
+    pbSimServer().script.push_back(slow);
+    const unsigned delivered = simDelivered;
+    const size_t from = pbSimServer().requests.size();
+    TEST_ASSERT_TRUE(runUntilRequests(from + 1, 2 * HEARTBEAT_INTERVAL_MS));
+    TEST_ASSERT_TRUE(runUntilDelivered(delivered + 1, 2000));
+
+    pbSim().serial.clear();
+    PbSimReply cut = pbSimReplyOk(10);
+    cut.bytes.resize(cut.bytes.find("Content-Length"));
+    cut.close = true;
+    pbSimServer().script.push_back(cut);
+    TEST_ASSERT_TRUE(runUntilRequests(from + 2, 2 * HEARTBEAT_INTERVAL_MS));
+    runMs(200);
+    TEST_ASSERT_EQUAL_UINT(delivered + 1, simDelivered);
+    TEST_ASSERT_TRUE(serialHas("❌ Помилка heartbeat!"));
+
+    // Наступний beat — нове з'єднання, успішно.
+    TEST_ASSERT_TRUE(runUntilDelivered(delivered + 2, 2 * HEARTBEAT_INTERVAL_MS));
+}
+
+// Лінк падає, поки beat чекає відповідь: запит обривається, слоти без мережі журналюються,
+// після DHCP — нове з'єднання, а журнал доходить пакетом.
+void test_link_flap_mid_beat(void) {
+    runMs(3 * HEARTBEAT_INTERVAL_MS);   // чистий журнал, стабільний keep-alive
+    pbSim().serial.clear();
+    PbSimReply slow = pbSimReplyOk(500);
+    pbSimServer().script.push_back(slow);
+    const size_t from = pbSimServer().requests.size();
+    const unsigned delivered = simDelivered;
+    TEST_ASSERT_TRUE(runUntilRequests(from + 1, 2 * HEARTBEAT_INTERVAL_MS));
+    const unsigned connBefore = lastRequest().conn;
+    const size_t abortedSeq = countPath("/api/v1/heartbeat", 0);
+
+    pbSimAfterMs(100, simLinkDown);
+    runMs(25000);
+    TEST_ASSERT_TRUE(serialHas("❌ Ethernet link down!"));
+    TEST_ASSERT_EQUAL_UINT(delivered, simDelivered);
+    TEST_ASSERT_EQUAL_UINT(from + 1, pbSimServer().requests.size());
+
+    simLinkUp();
+    TEST_ASSERT_TRUE(runUntilDelivered(delivered + 2, 4 * HEARTBEAT_INTERVAL_MS));
+    TEST_ASSERT_TRUE(lastRequest().conn != connBefore);
+    TEST_ASSERT_TRUE(runUntilRequests(from + 4, 2 * HEARTBEAT_INTERVAL_MS));
+    const PbSimRequest &bulk = pbSimServer().requests[from + 3];
+    TEST_ASSERT_EQUAL_STRING("/api/v1/heartbeat/bulk", bulk.path.c_str());
+    // Обірваний beat + два слоти, що пройшли без мережі.
+    char rec[24];
+    snprintf(rec, sizeof(rec), "\"beats\":[[%u,", static_cast<unsigned>(abortedSeq));
+    TEST_ASSERT_TRUE(bulk.body.find(rec) != std::string::npos);
+    TEST_ASSERT_EQUAL_UINT(3 + 1, std::count(bulk.body.begin(), bulk.body.end(), ']'));
+}
+
+// Frame не несе hb_lat: раз на PB_HB_LAT_JSON_EVERY beat-ів іде JSON з підсумком, далі знову frame.
+void test_latency_summary_rides_periodic_json(void) {
+    const size_t from = pbSimServer().requests.size();
+    const size_t beats = PB_HB_LAT_JSON_EVERY + 2;
+    TEST_ASSERT_TRUE(runUntilRequests(from + beats, 2 * beats * HEARTBEAT_INTERVAL_MS));
+    const std::vector<PbSimRequest> &req = pbSimServer().requests;
+    size_t summaryAt = 0;
+    for (size_t i = from; i + 1 < req.size() && summaryAt == 0; i++) {
+        summaryAt = req[i].body.find("\"hb_lat\":{") != std::string::npos ? i : 0;
+    }
+    TEST_ASSERT_TRUE(summaryAt != 0);
+    TEST_ASSERT_EQUAL_STRING("/api/v1/heartbeat", req[summaryAt].path.c_str());
+    TEST_ASSERT_EQUAL_UINT(PB_FRAME_SIZE, req[summaryAt + 1].body.size());
+}
+
+// millis() на ESP32 — 32 біти й переповнюється через ~49.7 доби; uptime у beat не має
+// стрибнути назад.
+void test_uptime_survives_millis_wrap(void) {
+    pbSim().nowUs += 50ull * 86400 * 1000000;
+    const size_t from = pbSimServer().requests.size();
+    TEST_ASSERT_TRUE(runUntilRequests(from + 1, 2 * HEARTBEAT_INTERVAL_MS));
+    const PbSimRequest &beat = lastRequest();
+    TEST_ASSERT_EQUAL_UINT(PB_FRAME_SIZE, beat.body.size());
+    TEST_ASSERT_TRUE(pbFrameGetU32(reinterpret_cast<const uint8_t *>(beat.body.data()) + 20) >= 50u * 86400);
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_boot_to_first_beat);
+    RUN_TEST(test_beats_follow_schedule_on_one_connection);
+    RUN_TEST(test_server_interval_header_reschedules);
+    RUN_TEST(test_silent_server_times_out_and_is_journaled);
+    RUN_TEST(test_partial_responses);
+    RUN_TEST(test_link_flap_mid_beat);
+    RUN_TEST(test_latency_summary_rides_periodic_json);
+    RUN_TEST(test_uptime_survives_millis_wrap);
+    return UNITY_END();
+}
@@ -0,0 +1,178 @@
+// Host-side tests for include/pb_sleep_plan.h (pio test -e native).
+//
+// Besides the single decisions, a small simulation runs the net task's wait loop
+// against a beat schedule with an injected light-sleep wake latency: beats must
+// never start before their deadline nor more than a tick after it, and the
+// awake share must stay close to the time a beat is actually in flight.
+
+#include <unity.h>
+
+#include "pb_beat_schedule.h"
+#include "pb_sleep_plan.h"
+
+namespace {
+
+const uint64_t kMs = 1000;
+const uint64_t kSec = 1000000;
+
+// Net-задача: beat триває inFlightMs; будь-яке пробудження зі сну запізнюється на wakeLatencyUs,
+// таймер розкладу будить на wakeAt(дедлайн).
+struct SleepSim {
+    PbSleepPlanner planner;
+    PbBeatSchedule schedule;
+    uint32_t wakeLatencyUs;
+    uint64_t inFlightMs;
+    uint64_t nowUs = 0;
+    uint64_t inFlightUntilUs = 0;
+    uint64_t alarmUs = 0;
+    uint32_t beats = 0;
+    uint32_t lateBeats = 0;   // прокинулись зі сну вже після дедлайну
+    uint64_t maxLateUs = 0;
+
+    SleepSim(uint32_t latencyUs, uint64_t beatMs)
+        : planner(100, 5000), wakeLatencyUs(latencyUs), inFlightMs(beatMs) {
+        schedule.begin(0, 10000, 0);
+    }
+
+    void run(uint64_t untilUs, bool canBeat) {
+        while (nowUs < untilUs) {
+            bool inFlight = nowUs < inFlightUntilUs;
+            if (!inFlight && canBeat && schedule.due(nowUs)) {
+                const uint64_t late = nowUs - schedule.next();
+                maxLateUs = late > maxLateUs ? late : maxLateUs;
+                schedule.started(nowUs);
+                alarmUs = planner.wakeAt(schedule.next());
+                inFlightUntilUs = nowUs + inFlightMs * kMs;
+                inFlight = true;
+                beats++;
+            }
+            const PbSleepPlan p = planner.plan(nowUs, schedule.next(), inFlight, canBeat);
+            planner.account(nowUs, p.awake);
+            uint64_t wakeUs = nowUs + p.waitMs * kMs;
+            if (!p.awake) {
+                if (alarmUs > nowUs && alarmUs <= wakeUs) {
+                    wakeUs = alarmUs;
+                    alarmUs = 0;
+                    planner.woke(wakeLatencyUs);
+                }
+                wakeUs += wakeLatencyUs;
+                if (canBeat && wakeUs > schedule.next()) {
+                    lateBeats++;
+                }
+            }
+            nowUs = wakeUs;
+        }
+        planner.account(nowUs, false);
+    }
+};
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_in_flight_stays_awake(void) {
+    PbSleepPlanner p(100, 5000);
+    const PbSleepPlan plan = p.plan(0, 10 * kSec, true, true);
+    TEST_ASSERT_TRUE(plan.awake);
+    TEST_ASSERT_EQUAL(1, plan.waitMs);
+}
+
+void test_no_beat_possible_sleeps_idle(void) {
+    PbSleepPlanner p(100, 5000);
+    // Дедлайн уже минув, але мережі немає: спимо, подія лінку розбудить.
+    const PbSleepPlan plan = p.plan(20 * kSec, 10 * kSec, false, false);
+    TEST_ASSERT_FALSE(plan.awake);
+    TEST_ASSERT_EQUAL(100, plan.waitMs);
+}
+
+void test_sleeps_until_guard_then_waits_awake(void) {
+    PbSleepPlanner p(100, 5000);
+    TEST_ASSERT_EQUAL(2000, p.guardUs());
+    // Далеко — обмежено idleMs.
+    PbSleepPlan plan = p.plan(0, 10 * kSec, false, true);
+    TEST_ASSERT_FALSE(plan.awake);
+    TEST_ASSERT_EQUAL(100, plan.waitMs);
+    // Ближче — до deadline - guard.
+    plan = p.plan(0, 50 * kMs, false, true);
+    TEST_ASSERT_FALSE(plan.awake);
+    TEST_ASSERT_EQUAL(48, plan.waitMs);
+    // Усередині guard — без сну, до дедлайну з округленням угору.
+    plan = p.plan(0, 1500, false, true);
+    TEST_ASSERT_TRUE(plan.awake);
+    TEST_ASSERT_EQUAL(2, plan.waitMs);
+    plan = p.plan(10 * kSec, 10 * kSec, false, true);
+    TEST_ASSERT_TRUE(plan.awake);
+    TEST_ASSERT_EQUAL(0, plan.waitMs);
+    TEST_ASSERT_EQUAL(10 * kSec - 2000, p.wakeAt(10 * kSec));
+    TEST_ASSERT_EQUAL(0, p.wakeAt(1000));
+}
+
+void test_guard_follows_wake_latency(void) {
+    PbSleepPlanner p(100, 5000);
+    p.woke(3000);
+    TEST_ASSERT_EQUAL(3000, p.guardUs());   // p95 не вище за max
+    p.woke(100000);
+    TEST_ASSERT_EQUAL(5000, p.guardUs());   // стеля maxGuardUs
+    PbSleepPlanner fast(100, 5000);
+    for (int i = 0; i < 20; i++) {
+        fast.woke(40);
+    }
+    TEST_ASSERT_EQUAL(PbSleepPlanner::kMinGuardUs, fast.guardUs());
+    fast.clearStats();
+    TEST_ASSERT_EQUAL(20, fast.wakeLatency().count());   // guard не скидається з вікном
+}
+
+void test_awake_share_accounting(void) {
+    PbSleepPlanner p(100, 5000);
+    TEST_ASSERT_EQUAL(0, p.awakePermille());
+    p.account(0, true);
+    p.account(250 * kMs, false);
+    p.account(1000 * kMs, true);
+    TEST_ASSERT_EQUAL(250, p.awakePermille());
+    p.clearStats();
+    p.account(1100 * kMs, false);   // 100 мс з lock-ом
+    p.account(1200 * kMs, false);
+    TEST_ASSERT_EQUAL(500, p.awakePermille());
+}
+
+void test_simulated_minute_beats_on_deadline(void) {
+    SleepSim sim(1500, 300);
+    sim.run(60 * kSec + 500 * kMs, true);
+    TEST_ASSERT_EQUAL(7, sim.beats);   // 0, 10, ..., 60 с
+    TEST_ASSERT_EQUAL(0, sim.lateBeats);
+    TEST_ASSERT_TRUE(sim.maxLateUs < kMs);
+    // 7 x 300 мс у польоті + вікна guard перед дедлайнами ≈ 3.5% часу без сну.
+    const uint16_t awake = sim.planner.awakePermille();
+    TEST_ASSERT_TRUE(awake >= 34 && awake <= 36);
+}
+
+void test_simulated_slow_wake_adapts_guard(void) {
+    SleepSim sim(3000, 300);
+    sim.run(60 * kSec + 500 * kMs, true);
+    TEST_ASSERT_EQUAL(7, sim.beats);
+    // Лише перший дедлайн після boot проспали: далі guard покриває 3 мс пробудження.
+    TEST_ASSERT_EQUAL(1, sim.lateBeats);
+    TEST_ASSERT_EQUAL(3000, sim.planner.guardUs());
+    TEST_ASSERT_TRUE(sim.maxLateUs < 2 * kMs);
+}
+
+void test_simulated_link_down_never_holds_awake(void) {
+    SleepSim sim(1500, 300);
+    sim.run(30 * kSec, false);
+    TEST_ASSERT_EQUAL(0, sim.beats);
+    TEST_ASSERT_EQUAL(0, sim.planner.awakePermille());
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_in_flight_stays_awake);
+    RUN_TEST(test_no_beat_possible_sleeps_idle);
+    RUN_TEST(test_sleeps_until_guard_then_waits_awake);
+    RUN_TEST(test_guard_follows_wake_latency);
+    RUN_TEST(test_awake_share_accounting);
+    RUN_TEST(test_simulated_minute_beats_on_deadline);
+    RUN_TEST(test_simulated_slow_wake_adapts_guard);
+    RUN_TEST(test_simulated_link_down_never_holds_awake);
+    return UNITY_END();
+}
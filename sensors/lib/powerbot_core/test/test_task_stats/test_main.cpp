@@ -0,0 +1,69 @@
+// Host-side tests for include/pb_task_stats.h (pio test -e native).
+//
+// The supervisor reports these numbers to confirm the net/led/log split leaves
+// CPU headroom, so the windowing and micros() wrap must not lie.
+
+#include <unity.h>
+
+#include "pb_task_stats.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_first_sample_only_opens_window(void) {
+    PbTaskLoad load("net");
+    load.begin(0);
+    load.end(500);
+    TEST_ASSERT_EQUAL(0, load.sample(1000));
+    TEST_ASSERT_EQUAL_STRING("net", load.name());
+}
+
+void test_busy_share_in_permille(void) {
+    PbTaskLoad load("net");
+    load.sample(0);
+    // 3 проходи по 10 мс за 1 с = 3%.
+    for (uint32_t i = 0; i < 3; i++) {
+        load.begin(i * 100000);
+        load.end(i * 100000 + 10000);
+    }
+    TEST_ASSERT_EQUAL(30, load.sample(1000000));
+    // Наступне вікно рахується окремо.
+    load.begin(1100000);
+    load.end(1600000);
+    TEST_ASSERT_EQUAL(500, load.sample(2000000));
+    TEST_ASSERT_EQUAL(0, load.sample(3000000));
+}
+
+void test_end_without_begin_is_ignored(void) {
+    PbTaskLoad load("led");
+    load.sample(0);
+    load.end(400000);
+    load.begin(500000);
+    load.end(600000);
+    load.end(900000);
+    TEST_ASSERT_EQUAL(100, load.sample(1000000));
+}
+
+void test_micros_wrap_and_clamp(void) {
+    PbTaskLoad load("log");
+    const uint32_t t0 = 0xFFFFFFFFu - 100000;
+    load.sample(t0);
+    load.begin(t0 + 50000);
+    load.end(t0 + 250000);   // через переповнення
+    TEST_ASSERT_EQUAL(500, load.sample(t0 + 400000));
+    // Порожнє вікно не ділить на нуль.
+    TEST_ASSERT_EQUAL(0, load.sample(t0 + 400000));
+    // Витіснення всередині begin..end може дати більше за вікно — обрізаємо до 100%.
+    load.begin(t0 + 300000);
+    load.end(t0 + 600000);
+    TEST_ASSERT_EQUAL(1000, load.sample(t0 + 500000));
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_sample_only_opens_window);
+    RUN_TEST(test_busy_share_in_permille);
+    RUN_TEST(test_end_without_begin_is_ignored);
+    RUN_TEST(test_micros_wrap_and_clamp);
+    return UNITY_END();
+}
@@ -0,0 +1,340 @@
+// Host-side tests for include/pb_udp_beat.h (pio test -e native).
+//
+// FakeNet is a scripted datagram socket: each recvDatagram() call pops one queued
+// entry ("" => nothing yet), so ack ordering / loss / stale acks are deterministic.
+
+#include <unity.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "pb_udp_beat.h"
+
+namespace {
+
+struct FakeNet {
+    int resolvePending = 0;
+    int resolveResult = PB_NET_OK;
+    int resolves = 0;
+
+    bool sendFail = false;
+    int sendBusy = 0;   // calls returning 0 before the datagram goes out
+    std::vector<std::string> sent;
+    uint16_t sentPort = 0;
+
+    std::deque<std::string> rx;
+    bool recvFail = false;
+    int closes = 0;
+
+    int startResolve(const char *) {
+        resolves++;
+        return pollResolve();
+    }
+    int pollResolve() {
+        if (resolvePending > 0) {
+            resolvePending--;
+            return PB_NET_PENDING;
+        }
+        return resolveResult;
+    }
+
+    long sendDatagram(const uint8_t *data, size_t len, uint16_t port) {
+        if (sendFail) {
+            return -1;
+        }
+        if (sendBusy > 0) {
+            sendBusy--;
+            return 0;
+        }
+        sent.push_back(std::string(reinterpret_cast<const char *>(data), len));
+        sentPort = port;
+        return static_cast<long>(len);
+    }
+
+    long recvDatagram(uint8_t *buf, size_t cap) {
+        if (recvFail) {
+            return -1;
+        }
+        if (rx.empty()) {
+            return 0;
+        }
+        const std::string d = rx.front();
+        rx.pop_front();
+        const size_t n = d.size() < cap ? d.size() : cap;
+        memcpy(buf, d.data(), n);
+        return static_cast<long>(n);
+    }
+
+    void closeDatagram() { closes++; }
+};
+
+const PbHbConfig kCfg = {"example.test", 18081, 1000, 0, 2000, false};
+
+typedef PbUdpBeat<FakeNet> Beat;
+
+size_t put(Beat &b, const char *payload) {
+    const size_t len = strlen(payload);
+    memcpy(b.requestBuffer(), payload, len);
+    return len;
+}
+
+PbHbState run(Beat &b, uint32_t &now, uint32_t tickMs = 10, int maxSteps = 10000) {
+    for (int i = 0; i < maxSteps && b.busy(); i++) {
+        b.step(now);
+        now += tickMs;
+    }
+    return b.state();
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_parse_ack(void) {
+    int status = 0;
+    uint32_t seq = 0;
+    bool hasSeq = false;
+    TEST_ASSERT_TRUE(pbUdpParseAck("OK 42", 5, &status, &seq, &hasSeq));
+    TEST_ASSERT_EQUAL(200, status);
+    TEST_ASSERT_TRUE(hasSeq);
+    TEST_ASSERT_EQUAL_UINT32(42, seq);
+
+    TEST_ASSERT_TRUE(pbUdpParseAck("OK", 2, &status, &seq, &hasSeq));
+    TEST_ASSERT_EQUAL(200, status);
+    TEST_ASSERT_FALSE(hasSeq);
+
+    TEST_ASSERT_TRUE(pbUdpParseAck("ERR 404 8", 9, &status, &seq, &hasSeq));
+    TEST_ASSERT_EQUAL(404, status);
+    TEST_ASSERT_EQUAL_UINT32(8, seq);
+
+    TEST_ASSERT_TRUE(pbUdpParseAck("ERR 400", 7, &status, &seq, &hasSeq));
+    TEST_ASSERT_EQUAL(400, status);
+    TEST_ASSERT_FALSE(hasSeq);
+
+    TEST_ASSERT_TRUE(pbUdpParseAck("OK 4294967295", 13, &status, &seq, &hasSeq));
+    TEST_ASSERT_EQUAL_UINT32(4294967295u, seq);
+
+    TEST_ASSERT_FALSE(pbUdpParseAck("", 0, &status, &seq, &hasSeq));
+    TEST_ASSERT_FALSE(pbUdpParseAck("OK ", 3, &status, &seq, &hasSeq));
+    TEST_ASSERT_FALSE(pbUdpParseAck("OKAY", 4, &status, &seq, &hasSeq));
+    TEST_ASSERT_FALSE(pbUdpParseAck("OK 4x", 5, &status, &seq, &hasSeq));
+    TEST_ASSERT_FALSE(pbUdpParseAck("ERR x", 5, &status, &seq, &hasSeq));
+    TEST_ASSERT_FALSE(pbUdpParseAck("HTTP/1.1 200 OK", 15, &status, &seq, &hasSeq));
+}
+
+void test_happy_path_resolves_once_and_matches_seq(void) {
+    FakeNet net;
+    net.resolvePending = 2;
+    net.rx = {"", "", "OK 1"};
+    Beat b(net, kCfg);
+    uint32_t now = 0;
+
+    b.expectSeq(1);
+    TEST_ASSERT_TRUE(b.start(put(b, "{\"seq\":1}"), now));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Resolve), static_cast<int>(b.state()));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Done), static_cast<int>(run(b, now)));
+    TEST_ASSERT_TRUE(b.ok());
+    TEST_ASSERT_EQUAL(200, b.httpStatus());
+    TEST_ASSERT_EQUAL_STRING("OK 1", b.statusLine());
+    TEST_ASSERT_EQUAL(1, static_cast<int>(net.sent.size()));
+    TEST_ASSERT_EQUAL_STRING("{\"seq\":1}", net.sent[0].c_str());
+    TEST_ASSERT_EQUAL_UINT16(18081, net.sentPort);
+    b.reset();
+
+    // Second beat: cached address, straight to Write.
+    net.rx = {"OK 2"};
+    b.expectSeq(2);
+    TEST_ASSERT_TRUE(b.start(put(b, "{\"seq\":2}"), now));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Write), static_cast<int>(b.state()));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Done), static_cast<int>(run(b, now)));
+    TEST_ASSERT_TRUE(b.ok());
+    TEST_ASSERT_EQUAL(1, net.resolves);
+}
+
+void test_stale_ack_and_garbage_are_skipped(void) {
+    FakeNet net;
+    net.rx = {"OK 6", "junk", "ERR 404 6", "OK 7"};
+    Beat b(net, kCfg);
+    uint32_t now = 0;
+
+    b.expectSeq(7);
+    TEST_ASSERT_TRUE(b.start(put(b, "beat"), now));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Done), static_cast<int>(run(b, now)));
+    TEST_ASSERT_TRUE(b.ok());
+    TEST_ASSERT_EQUAL_STRING("OK 7", b.statusLine());
+    TEST_ASSERT_TRUE(net.rx.empty());
+}
+
+void test_ack_without_seq_is_accepted(void) {
+    FakeNet net;
+    net.rx = {"OK"};
+    Beat b(net, kCfg);
+    uint32_t now = 0;
+    b.expectSeq(3);
+    TEST_ASSERT_TRUE(b.start(put(b, "power_lost"), now));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Done), static_cast<int>(run(b, now)));
+    TEST_ASSERT_TRUE(b.ok());
+}
+
+void test_server_error_ack_is_done_but_not_ok(void) {
+    FakeNet net;
+    net.rx = {"ERR 404 9"};
+    Beat b(net, kCfg);
+    uint32_t now = 0;
+    b.expectSeq(9);
+    TEST_ASSERT_TRUE(b.start(put(b, "beat"), now));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Done), static_cast<int>(run(b, now)));
+    TEST_ASSERT_FALSE(b.ok());
+    TEST_ASSERT_EQUAL(404, b.httpStatus());
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::None), static_cast<int>(b.error()));
+}
+
+void test_lost_ack_times_out_and_forces_re_resolve(void) {
+    FakeNet net;
+    Beat b(net, kCfg);
+    uint32_t now = 0;
+    b.expectSeq(1);
+    TEST_ASSERT_TRUE(b.start(put(b, "beat"), now));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Failed), static_cast<int>(run(b, now)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::StatusTimeout), static_cast<int>(b.error()));
+    TEST_ASSERT_TRUE(now >= kCfg.ioTimeoutMs);
+    TEST_ASSERT_EQUAL(1, net.closes);
+    b.reset();
+
+    // Server IP may have changed: next beat resolves again.
+    net.rx = {"OK 2"};
+    b.expectSeq(2);
+    TEST_ASSERT_TRUE(b.start(put(b, "beat"), now));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Resolve), static_cast<int>(b.state()));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Done), static_cast<int>(run(b, now)));
+    TEST_ASSERT_EQUAL(2, net.resolves);
+}
+
+void test_resolve_failure_and_timeout(void) {
+    FakeNet net;
+    net.resolveResult = PB_NET_FAIL;
+    Beat b(net, kCfg);
+    uint32_t now = 0;
+    TEST_ASSERT_TRUE(b.start(put(b, "beat"), now));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Failed), static_cast<int>(run(b, now)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::ResolveFailed), static_cast<int>(b.error()));
+    TEST_ASSERT_TRUE(net.sent.empty());
+    b.reset();
+
+    net.resolveResult = PB_NET_OK;
+    net.resolvePending = 1000000;
+    TEST_ASSERT_TRUE(b.start(put(b, "beat"), now));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Failed), static_cast<int>(run(b, now)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::ResolveTimeout), static_cast<int>(b.error()));
+}
+
+void test_send_busy_then_ok_and_send_failure(void) {
+    FakeNet net;
+    net.sendBusy = 3;
+    net.rx = {"OK 1"};
+    Beat b(net, kCfg);
+    uint32_t now = 0;
+    b.expectSeq(1);
+    TEST_ASSERT_TRUE(b.start(put(b, "beat"), now));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Done), static_cast<int>(run(b, now)));
+    TEST_ASSERT_EQUAL(1, static_cast<int>(net.sent.size()));
+    b.reset();
+
+    net.sendFail = true;
+    TEST_ASSERT_TRUE(b.start(put(b, "beat"), now));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Failed), static_cast<int>(run(b, now)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::WriteFailed), static_cast<int>(b.error()));
+}
+
+void test_recv_error_fails_as_closed(void) {
+    FakeNet net;
+    net.recvFail = true;
+    Beat b(net, kCfg);
+    uint32_t now = 0;
+    TEST_ASSERT_TRUE(b.start(put(b, "beat"), now));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Failed), static_cast<int>(run(b, now)));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbError::Closed), static_cast<int>(b.error()));
+}
+
+void test_start_rejects_busy_empty_and_oversized(void) {
+    FakeNet net;
+    Beat b(net, kCfg);
+    uint32_t now = 0;
+    TEST_ASSERT_FALSE(b.start(0, now));
+    TEST_ASSERT_FALSE(b.start(Beat::requestCapacity() + 1, now));
+    TEST_ASSERT_TRUE(b.start(put(b, "beat"), now));
+    TEST_ASSERT_FALSE(b.start(put(b, "beat"), now));
+}
+
+void test_abort_returns_to_idle_and_forgets_address(void) {
+    FakeNet net;
+    net.rx = {"OK 1"};
+    Beat b(net, kCfg);
+    uint32_t now = 0;
+    b.expectSeq(1);
+    TEST_ASSERT_TRUE(b.start(put(b, "beat"), now));
+    run(b, now);
+    b.reset();
+
+    TEST_ASSERT_TRUE(b.start(put(b, "beat"), now));
+    b.step(now);  // sent, awaiting ack
+    TEST_ASSERT_TRUE(b.busy());
+    b.abort();
+    TEST_ASSERT_FALSE(b.busy());
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Idle), static_cast<int>(b.state()));
+
+    TEST_ASSERT_TRUE(b.start(put(b, "beat"), now));
+    TEST_ASSERT_EQUAL(static_cast<int>(PbHbState::Resolve), static_cast<int>(b.state()));
+}
+
+void test_phase_timings_in_microseconds(void) {
+    FakeNet net;
+    net.resolvePending = 1;
+    net.rx = {"", "", "OK 1"};
+    Beat b(net, kCfg);
+    b.expectSeq(1);
+    uint32_t us = 0;
+    b.start(put(b, "{}"), 0, us);
+    while (b.busy()) {
+        b.step(us / 1000, us);
+        us += 300;
+    }
+    TEST_ASSERT_TRUE(b.ok());
+    const PbHbTimings &t = b.timings();
+    TEST_ASSERT_EQUAL_UINT32(300, t.get(PbHbPhase::Dns));
+    TEST_ASSERT_EQUAL_UINT32(300, t.get(PbHbPhase::Write));
+    TEST_ASSERT_FALSE(t.has(PbHbPhase::Connect));
+    // Ack is a single datagram: first byte == full response.
+    TEST_ASSERT_EQUAL_UINT32(900, t.get(PbHbPhase::Ttfb));
+    TEST_ASSERT_EQUAL_UINT32(900, t.get(PbHbPhase::Response));
+
+    // Next beat reuses the address; a lost ack is charged to TTFB.
+    b.reset();
+    b.expectSeq(2);
+    b.start(put(b, "{}"), us / 1000, us);
+    while (b.busy()) {
+        b.step(us / 1000, us);
+        us += 100000;
+    }
+    TEST_ASSERT_FALSE(b.timings().has(PbHbPhase::Dns));
+    TEST_ASSERT_TRUE(b.timings().failedAt == PbHbPhase::Ttfb);
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_ack);
+    RUN_TEST(test_happy_path_resolves_once_and_matches_seq);
+    RUN_TEST(test_stale_ack_and_garbage_are_skipped);
+    RUN_TEST(test_ack_without_seq_is_accepted);
+    RUN_TEST(test_server_error_ack_is_done_but_not_ok);
+    RUN_TEST(test_lost_ack_times_out_and_forces_re_resolve);
+    RUN_TEST(test_resolve_failure_and_timeout);
+    RUN_TEST(test_send_busy_then_ok_and_send_failure);
+    RUN_TEST(test_recv_error_fails_as_closed);
+    RUN_TEST(test_start_rejects_busy_empty_and_oversized);
+    RUN_TEST(test_abort_returns_to_idle_and_forgets_address);
+    RUN_TEST(test_phase_timings_in_microseconds);
+    return UNITY_END();
+}
@@ -2,107 +2,293 @@
  * PowerBot ESP32-S3-POE-ETH Heartbeat Sensor
  * 
  * Плата: Waveshare ESP32-S3-POE-ETH-CAM-KIT
- * Ethernet: W5500 через SPI
+ * Ethernet: W5500 через SPI — драйвер esp_eth + lwIP або arduino-libraries/Ethernet
+ * (PB_W5500_DRIVER у config.h)
+ *
+ * Тут лише Ethernet плати; решта прошивки — lib/powerbot_core (pb_sensor.h).
  */
 
 #include <Arduino.h>
-#include <SPI.h>
-#include <Ethernet.h>
-#include <ArduinoJson.h>
 #include "config.h"
 
-// MAC адреса (унікальна для кожного пристрою)
-byte mac[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, BUILDING_ID };
+#if PB_W5500_DRIVER == PB_W5500_DRIVER_ESP_ETH
+#include <atomic>
+
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+#include "esp_eth.h"
+#include "esp_event.h"
+#include "esp_mac.h"
+#include "esp_netif.h"
+#include "pb_net_lwip.h"
 
-// Ethernet клієнт
-EthernetClient ethClient;
+#if !defined(CONFIG_ETH_SPI_ETHERNET_W5500)
+#error "ESP-IDF зібрано без драйвера W5500 (CONFIG_ETH_SPI_ETHERNET_W5500): -DPB_W5500_DRIVER=PB_W5500_DRIVER_ARDUINO"
+#endif
+
+typedef PbLwipDnsNet PbBoardDnsNet;
+typedef PbLwipNet PbBoardNet;
+typedef PbLwipUdpListener PbBoardUdpListener;
+#else
+#include <SPI.h>
+#include <Ethernet.h>
+#include "pb_net_w5500.h"
 
-// Стан підключення
-bool eth_connected = false;
+typedef PbW5500DnsNet PbBoardDnsNet;
+typedef PbW5500Net PbBoardNet;
+typedef PbW5500UdpListener PbBoardUdpListener;
+#endif
 
-// Час останнього heartbeat
-unsigned long lastHeartbeatTime = 0;
+#include "pb_sensor.h"
 
-// Прототипи функцій
 void setupEthernet();
-bool sendHeartbeat();
-void blinkLED(int times, int delayMs);
 
-void setup() {
-    Serial.begin(115200);
-    delay(2000);
-    
-    Serial.println();
-    Serial.println("================================================");
+void pbBoardBanner() {
     Serial.println("  PowerBot ESP32-S3-POE-ETH Heartbeat Sensor");
     Serial.println("  Плата: Waveshare ESP32-S3-POE-ETH-CAM-KIT");
-    Serial.printf("  Building: %s (ID: %d)\n", BUILDING_NAME, BUILDING_ID);
-    Serial.printf("  Section:  %d\n", SECTION_ID);
-    Serial.printf("  Sensor:   %s\n", SENSOR_UUID);
-    Serial.printf("  Server:   %s:%d\n", SERVER_HOST, SERVER_PORT);
-    Serial.println("================================================");
-    Serial.println();
-    
-    #ifdef LED_PIN
-    pinMode(LED_PIN, OUTPUT);
-    digitalWrite(LED_PIN, LOW);
-    #endif
-    
+}
+
+#if PB_W5500_DRIVER == PB_W5500_DRIVER_ESP_ETH
+
+// ═══ W5500 через esp_eth: MAC-raw драйвер по SPI (DMA) під lwIP ═══
+// Той самий стек і модель подій, що ETH на WT32-ETH01: сокети lwIP (pb_net_lwip.h), DHCP і
+// лінк — події esp_event з задачі подій, а не опитування W5500 з net-задачі.
+
+static esp_eth_handle_t pbEthHandle = nullptr;
+static esp_netif_t *pbEthNetif = nullptr;
+static std::atomic<bool> pbEthLink(false);
+
+static void pbEthOnEvent(void *, esp_event_base_t base, int32_t id, void *) {
+    if (base == IP_EVENT && id == IP_EVENT_ETH_GOT_IP) {
+        Serial.println("✅ ETH got IP");
+        Serial.print("🌐 IP адреса:  ");
+        Serial.println(pbBoardLocalIp());
+        Serial.print("🌐 Gateway:    ");
+        Serial.println(pbBoardGatewayIp());
+        xEventGroupSetBits(pbNetEvents, kPbEvEthUp);
+        return;
+    }
+    switch (id) {
+        case ETHERNET_EVENT_START:
+            Serial.println("🔌 ETH start");
+            break;
+
+        case ETHERNET_EVENT_CONNECTED:
+            pbEthLink.store(true);
+            Serial.println("🔗 ETH link up");
+            break;
+
+        case ETHERNET_EVENT_DISCONNECTED:
+            pbEthLink.store(false);
+            Serial.println("❌ ETH disconnected");
+            xEventGroupClearBits(pbNetEvents, kPbEvEthUp);
+            break;
+
+        case ETHERNET_EVENT_STOP:
+            pbEthLink.store(false);
+            Serial.println("🛑 ETH stopped");
+            xEventGroupClearBits(pbNetEvents, kPbEvEthUp);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void pbBoardSetupEthernet() {
+    setupEthernet();
+}
+
+// IP приходить подією GOT_IP; тут — лише падіння лінку між подіями.
+bool pbBoardNetReady() {
+    if (pbEthUp() && !pbEthLink.load()) {
+        PB_LOGE(LinkDown);
+        xEventGroupClearBits(pbNetEvents, kPbEvEthUp);
+    }
+    return pbEthUp();
+}
+
+bool pbBoardLinkUp() {
+    return pbEthLink.load();
+}
+
+IPAddress pbBoardLocalIp() {
+    esp_netif_ip_info_t ip = {};
+    if (pbEthNetif == nullptr || esp_netif_get_ip_info(pbEthNetif, &ip) != ESP_OK) {
+        return IPAddress();
+    }
+    return IPAddress(ip.ip.addr);
+}
+
+IPAddress pbBoardGatewayIp() {
+    esp_netif_ip_info_t ip = {};
+    if (pbEthNetif == nullptr || esp_netif_get_ip_info(pbEthNetif, &ip) != ESP_OK) {
+        return IPAddress();
+    }
+    return IPAddress(ip.gw.addr);
+}
+
+void pbBoardBeatDelivered() {}
+
+static bool pbEthCheck(const char *what, esp_err_t err) {
+    if (err != ESP_OK) {
+        Serial.printf("❌ %s: %s\n", what, esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+// MAC і PHY W5500 на SPI-шині з DMA, драйвер esp_eth, netif lwIP. false — Ethernet не піднято.
+static bool pbEthStart() {
+    // Arduino-ядро могло вже підняти netif / цикл подій — це не помилка.
+    esp_err_t err = esp_netif_init();
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        return pbEthCheck("esp_netif_init", err);
+    }
+    err = esp_event_loop_create_default();
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        return pbEthCheck("esp_event_loop_create_default", err);
+    }
+    // INT W5500 обслуговує ISR з сервісу GPIO.
+    err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        return pbEthCheck("gpio_install_isr_service", err);
+    }
+
+    spi_bus_config_t bus = {};
+    bus.mosi_io_num = ETH_SPI_MOSI;
+    bus.miso_io_num = ETH_SPI_MISO;
+    bus.sclk_io_num = ETH_SPI_SCK;
+    bus.quadwp_io_num = -1;
+    bus.quadhd_io_num = -1;
+    if (!pbEthCheck("spi_bus_initialize", spi_bus_initialize(ETH_SPI_HOST, &bus, SPI_DMA_CH_AUTO))) {
+        return false;
+    }
+
+    spi_device_interface_config_t dev = {};
+    dev.mode = 0;
+    dev.clock_speed_hz = ETH_SPI_CLOCK_MHZ * 1000 * 1000;
+    dev.spics_io_num = ETH_PHY_CS;
+    dev.queue_size = 20;
+#if ESP_IDF_VERSION_MAJOR >= 5
+    eth_w5500_config_t w5500 = ETH_W5500_DEFAULT_CONFIG(ETH_SPI_HOST, &dev);
+#else
+    // IDF 4.x: пристрій на шині додаємо самі, з фазами команди / адреси W5500.
+    dev.command_bits = 16;
+    dev.address_bits = 8;
+    spi_device_handle_t spi = nullptr;
+    if (!pbEthCheck("spi_bus_add_device", spi_bus_add_device(ETH_SPI_HOST, &dev, &spi))) {
+        return false;
+    }
+    eth_w5500_config_t w5500 = ETH_W5500_DEFAULT_CONFIG(spi);
+#endif
+    w5500.int_gpio_num = ETH_PHY_INT;
+
+    eth_mac_config_t macConfig = ETH_MAC_DEFAULT_CONFIG();
+    eth_phy_config_t phyConfig = ETH_PHY_DEFAULT_CONFIG();
+    phyConfig.reset_gpio_num = ETH_PHY_RST;
+    esp_eth_mac_t *mac = esp_eth_mac_new_w5500(&w5500, &macConfig);
+    esp_eth_phy_t *phy = esp_eth_phy_new_w5500(&phyConfig);
+    if (mac == nullptr || phy == nullptr) {
+        Serial.println("❌ W5500 не знайдено! Перевірте SPI підключення");
+        return false;
+    }
+    esp_eth_config_t ethConfig = ETH_DEFAULT_CONFIG(mac, phy);
+    if (!pbEthCheck("esp_eth_driver_install", esp_eth_driver_install(&ethConfig, &pbEthHandle))) {
+        return false;
+    }
+
+    // W5500 не має заводської MAC: беремо Ethernet-MAC з eFuse ESP32-S3 — унікальна для плати.
+    uint8_t macAddr[6];
+    esp_read_mac(macAddr, ESP_MAC_ETH);
+    esp_eth_ioctl(pbEthHandle, ETH_CMD_S_MAC_ADDR, macAddr);
+    Serial.printf("📡 MAC:        %02X:%02X:%02X:%02X:%02X:%02X\n", macAddr[0], macAddr[1], macAddr[2],
+                  macAddr[3], macAddr[4], macAddr[5]);
+
+    esp_netif_config_t netifConfig = ESP_NETIF_DEFAULT_ETH();
+    pbEthNetif = esp_netif_new(&netifConfig);
+    esp_netif_set_hostname(pbEthNetif, SENSOR_UUID);
+    if (!pbEthCheck("esp_netif_attach", esp_netif_attach(pbEthNetif, esp_eth_new_netif_glue(pbEthHandle)))) {
+        return false;
+    }
+#if ESP_IDF_VERSION_MAJOR < 5
+    esp_eth_set_default_handlers(pbEthNetif);
+#endif
+    esp_event_handler_register(ETH_EVENT, ESP_EVENT_ANY_ID, pbEthOnEvent, nullptr);
+    esp_event_handler_register(IP_EVENT, IP_EVENT_ETH_GOT_IP, pbEthOnEvent, nullptr);
+    return pbEthCheck("esp_eth_start", esp_eth_start(pbEthHandle));
+}
+
+void setupEthernet() {
+    Serial.println("🔌 Ініціалізація W5500 (esp_eth)...");
+    Serial.printf("   SPI: SCK=%d, MISO=%d, MOSI=%d, %d МГц, DMA\n",
+                  ETH_SPI_SCK, ETH_SPI_MISO, ETH_SPI_MOSI, ETH_SPI_CLOCK_MHZ);
+    Serial.printf("   CS=%d, RST=%d, INT=%d\n", ETH_PHY_CS, ETH_PHY_RST, ETH_PHY_INT);
+
+    if (!pbEthStart()) {
+        Serial.println("❌ Помилка запуску Ethernet!");
+        return;
+    }
+
+    Serial.println("📡 Очікування DHCP...");
+    const EventBits_t up = xEventGroupWaitBits(pbNetEvents, kPbEvEthUp, pdFALSE, pdTRUE, pdMS_TO_TICKS(15000));
+    if ((up & kPbEvEthUp) == 0) {
+        Serial.println(pbEthLink.load() ? "⚠️ DHCP сервер не відповідає" : "❌ Ethernet кабель не підключено!");
+        return;
+    }
+
+    Serial.println("════════════════════════════════════");
+    Serial.println("✅ Ethernet готовий");
+    Serial.println("════════════════════════════════════");
+}
+
+#else  // PB_W5500_DRIVER_ARDUINO
+
+// MAC адреса (унікальна для кожного пристрою)
+byte mac[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, BUILDING_ID };
+
+void pbBoardSetupEthernet() {
     setupEthernet();
 }
 
-void loop() {
+// W5500 подій не шле: лінк і IP опитуємо на кожному проході net-задачі.
+bool pbBoardNetReady() {
     // Підтримуємо DHCP lease
     Ethernet.maintain();
-    
+
     // Перевіряємо стан Ethernet
-    auto link = Ethernet.linkStatus();
-    
-    if (link == LinkOFF) {
-        if (eth_connected) {
-            Serial.println("❌ Ethernet кабель відключено!");
-            eth_connected = false;
+    if (Ethernet.linkStatus() == LinkOFF) {
+        if (pbEthUp()) {
+            PB_LOGE(EthCableOff);
+            xEventGroupClearBits(pbNetEvents, kPbEvEthUp);
         }
-        blinkLED(1, 500);
-        delay(1000);
-        return;
+        return false;
     }
-    
-    if (!eth_connected && Ethernet.localIP() != IPAddress(0,0,0,0) && 
+
+    if (!pbEthUp() && Ethernet.localIP() != IPAddress(0,0,0,0) &&
         Ethernet.localIP() != IPAddress(255,255,255,255)) {
         Serial.println("🔗 Ethernet підключено!");
         Serial.print("🌐 IP: ");
         Serial.println(Ethernet.localIP());
-        eth_connected = true;
+        xEventGroupSetBits(pbNetEvents, kPbEvEthUp);
     }
-    
-    if (!eth_connected) {
-        delay(1000);
-        return;
-    }
-    
-    // Перевіряємо чи час відправляти heartbeat
-    unsigned long currentTime = millis();
-    
-    if (lastHeartbeatTime == 0 || (currentTime - lastHeartbeatTime) >= HEARTBEAT_INTERVAL_MS) {
-        Serial.println();
-        Serial.println("📤 Відправка heartbeat...");
-        
-        if (sendHeartbeat()) {
-            Serial.println("✅ Heartbeat успішно!");
-            blinkLED(1, 100);
-        } else {
-            Serial.println("❌ Помилка heartbeat!");
-            blinkLED(3, 200);
-        }
-        
-        lastHeartbeatTime = currentTime;
-        Serial.printf("⏰ Наступний через %d сек\n", HEARTBEAT_INTERVAL_MS / 1000);
-    }
-    
-    delay(100);
+    return pbEthUp();
+}
+
+bool pbBoardLinkUp() {
+    return Ethernet.linkStatus() == LinkON;
+}
+
+IPAddress pbBoardLocalIp() {
+    return Ethernet.localIP();
+}
+
+IPAddress pbBoardGatewayIp() {
+    return Ethernet.gatewayIP();
 }
 
+void pbBoardBeatDelivered() {}
+
 void setupEthernet() {
     Serial.println("🔌 Ініціалізація W5500...");
     Serial.printf("   SPI: SCK=%d, MISO=%d, MOSI=%d\n", 
@@ -153,7 +339,7 @@ void setupEthernet() {
         }
         Serial.println();
         Serial.println("════════════════════════════════════");
-        eth_connected = true;
+        xEventGroupSetBits(pbNetEvents, kPbEvEthUp);
     } else {
         Serial.println("❌ DHCP не вдалося!");
         
@@ -182,108 +368,4 @@ void setupEthernet() {
     }
 }
 
-bool sendHeartbeat() {
-    Serial.printf("🌐 Підключення до %s:%d...\n", SERVER_HOST, SERVER_PORT);
-    
-    // Перевіряємо стан мережі
-    Serial.printf("   Local IP: %s\n", Ethernet.localIP().toString().c_str());
-    Serial.printf("   Gateway:  %s\n", Ethernet.gatewayIP().toString().c_str());
-    Serial.printf("   Link:     %s\n", Ethernet.linkStatus() == LinkON ? "ON" : "OFF");
-    
-    // Перетворюємо IP рядок в IPAddress
-    // Таймаут підключення
-    ethClient.setTimeout(10000);
-    
-    Serial.println("   Спроба connect()...");
-    IPAddress serverIP;
-    int result = 0;
-    if (serverIP.fromString(SERVER_HOST)) {
-        Serial.printf("   Parsed IP: %s\n", serverIP.toString().c_str());
-        result = ethClient.connect(serverIP, SERVER_PORT);
-    } else {
-        result = ethClient.connect(SERVER_HOST, SERVER_PORT);
-    }
-    Serial.printf("   Connect result: %d\n", result);
-    
-    if (!result) {
-        Serial.println("❌ Не вдалося підключитися до сервера!");
-        Serial.println("   Можливі причини:");
-        Serial.println("   - Немає маршруту до інтернету");
-        Serial.println("   - Firewall блокує з'єднання");
-        Serial.println("   - Сервер недоступний");
-        return false;
-    }
-    
-    // Формуємо JSON
-    JsonDocument doc;
-    doc["api_key"] = API_KEY;
-    doc["building_id"] = BUILDING_ID;
-    doc["section_id"] = SECTION_ID;
-    doc["sensor_uuid"] = SENSOR_UUID;
-#if defined(SENSOR_COMMENT)
-    if (String(SENSOR_COMMENT).length() > 0) {
-        doc["comment"] = SENSOR_COMMENT;
-    }
-#endif
-    
-    String payload;
-    serializeJson(doc, payload);
-    
-    Serial.printf("📦 Payload: %s\n", payload.c_str());
-    
-    // HTTP POST запит
-    ethClient.println("POST /api/v1/heartbeat HTTP/1.1");
-    ethClient.print("Host: ");
-    ethClient.println(SERVER_HOST);
-    ethClient.println("Content-Type: application/json");
-    ethClient.println("Connection: close");
-    ethClient.print("Content-Length: ");
-    ethClient.println(payload.length());
-    ethClient.println();
-    ethClient.println(payload);
-    
-    // Чекаємо відповідь
-    unsigned long timeout = millis();
-    while (ethClient.available() == 0) {
-        if (millis() - timeout > HTTP_TIMEOUT_MS) {
-            Serial.println("❌ Таймаут відповіді!");
-            ethClient.stop();
-            return false;
-        }
-    }
-    
-    // Читаємо статус
-    String statusLine = ethClient.readStringUntil('\n');
-    Serial.printf("📨 %s\n", statusLine.c_str());
-    
-    bool success = statusLine.indexOf("200") > 0;
-    
-    // Пропускаємо заголовки
-    while (ethClient.available()) {
-        String line = ethClient.readStringUntil('\n');
-        if (line == "\r") break;
-    }
-    
-    // Читаємо body
-    String body = "";
-    while (ethClient.available()) {
-        body += (char)ethClient.read();
-    }
-    if (body.length() > 0) {
-        Serial.printf("📨 Body: %s\n", body.c_str());
-    }
-    
-    ethClient.stop();
-    return success;
-}
-
-void blinkLED(int times, int delayMs) {
-    #ifdef LED_PIN
-    for (int i = 0; i < times; i++) {
-        digitalWrite(LED_PIN, HIGH);
-        delay(delayMs);
-        digitalWrite(LED_PIN, LOW);
-        if (i < times - 1) delay(delayMs);
-    }
-    #endif
-}
+#endif  // PB_W5500_DRIVER
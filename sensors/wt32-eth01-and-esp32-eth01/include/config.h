@@ -46,9 +46,198 @@
 // Інтервал відправки heartbeat (10 секунд)
 #define HEARTBEAT_INTERVAL_MS   10000
 
+// Зсув beat-ів сенсора в межах періоду (мс) з хешу SENSOR_UUID: сенсори, що ввімкнулись разом
+// після відключення світла, розходяться по періоду. Перший beat після boot — без зсуву. 0 = вимкнено.
+#ifndef PB_HB_PHASE_SPREAD_MS
+#define PB_HB_PHASE_SPREAD_MS   HEARTBEAT_INTERVAL_MS
+#endif
+
+// Сервер може змінити період заголовком X-PB-Interval-Ms у відповіді на beat (HTTP-транспорт).
+// Значення поза цими межами обрізається до найближчої; без заголовка — HEARTBEAT_INTERVAL_MS.
+#ifndef PB_HB_INTERVAL_MIN_MS
+#define PB_HB_INTERVAL_MIN_MS   1000
+#endif
+#ifndef PB_HB_INTERVAL_MAX_MS
+#define PB_HB_INTERVAL_MAX_MS   300000
+#endif
+
+// Офлайн-журнал: скільки недоставлених слотів розкладу тримати в RAM (8 байт на запис), поки
+// немає зв'язку, щоб після відновлення відправити їх одним POST /api/v1/heartbeat/bulk —
+// сервер знімає хибне "світла немає". Повний журнал проріджується (pb_beat_journal.h).
+// 0 = вимкнено. Лише з HTTP-транспортом.
+#ifndef PB_JOURNAL_BEATS
+#define PB_JOURNAL_BEATS        32
+#endif
+
 // Таймаут HTTP запиту (10 секунд)
 #define HTTP_TIMEOUT_MS         10000
 
+// Кеш DNS для SERVER_HOST (pb_dns_cache.h): beat бере адресу з кешу, net-задача оновлює її
+// після TTL (обрізаного до цих меж). Невдале оновлення — далі остання відома адреса (вона ж
+// у NVS на наступний boot), повтор через PB_DNS_RETRY_MIN_MS, щоразу вдвічі довше до MAX.
+#ifndef PB_DNS_TTL_MIN_S
+#define PB_DNS_TTL_MIN_S        30
+#endif
+#ifndef PB_DNS_TTL_MAX_S
+#define PB_DNS_TTL_MAX_S        86400
+#endif
+#ifndef PB_DNS_TIMEOUT_MS
+#define PB_DNS_TIMEOUT_MS       2000
+#endif
+#ifndef PB_DNS_RETRY_MIN_MS
+#define PB_DNS_RETRY_MIN_MS     5000
+#endif
+#ifndef PB_DNS_RETRY_MAX_MS
+#define PB_DNS_RETRY_MAX_MS     300000
+#endif
+
+// Keep-alive: тримаємо одне HTTP/1.1 з'єднання відкритим між heartbeat і
+// перевикористовуємо його (без TCP handshake + DNS на кожен beat).
+// Якщо сервер/traefik закрив сокет — firmware прозоро перепідключається.
+// 0 = як раніше: connect/close на кожен heartbeat.
+#ifndef PB_HTTP_KEEPALIVE
+#define PB_HTTP_KEEPALIVE       1
+#endif
+
+// Транспорт heartbeat:
+//   PB_TRANSPORT_HTTP — HTTP POST /api/v1/heartbeat (за замовчуванням)
+//   PB_TRANSPORT_UDP  — одна UDP-датаграма на beat (той самий JSON) + коротке ack
+//                       від сервера; без TCP handshake і HTTP-заголовків.
+//                       На сервері має бути увімкнений SENSOR_UDP_PORT.
+// Приклад (platformio.ini): build_flags = -DPB_TRANSPORT=PB_TRANSPORT_UDP
+#define PB_TRANSPORT_HTTP       0
+#define PB_TRANSPORT_UDP        1
+#ifndef PB_TRANSPORT
+#define PB_TRANSPORT            PB_TRANSPORT_HTTP
+#endif
+
+// UDP-порт сервера (docker-compose мапить 18081/udp так само, як 18081/tcp)
+#ifndef SERVER_UDP_PORT
+#define SERVER_UDP_PORT         SERVER_PORT
+#endif
+
+// Скільки чекати ack на UDP-датаграму (мс). Без ack beat вважається невдалим
+// (сервер міг його й отримати — реальні втрати видно на сервері по seq).
+#ifndef PB_UDP_ACK_TIMEOUT_MS
+#define PB_UDP_ACK_TIMEOUT_MS   2000
+#endif
+
+// Бінарний heartbeat: 36-байтний frame з HMAC-підписом (API_KEY у мережу не йде)
+// замість JSON. Перший beat після старту (реєстрація) і fallback, якщо сервер не прийняв
+// frame, — звичайний JSON. 0 = завжди JSON.
+#ifndef PB_HB_FRAME
+#define PB_HB_FRAME             1
+#endif
+
+// Латентність фаз beat ("hb_lat": p50/p95/max і фейли по DNS/connect/write/TTFB/відповіді)
+// їде лише в JSON beat. З PB_HB_FRAME=1 — раз на стільки beat-ів шлемо JSON замість frame
+// (з ним же hb_int, hb_dns і mains_*; API_KEY тоді знову йде в мережу). 60 при періоді 10 с —
+// телеметрія раз на ~10 хв. 0 = лише з реєстрацією / fallback JSON: telemetry на сервері не оновлюється.
+#ifndef PB_HB_LAT_JSON_EVERY
+#define PB_HB_LAT_JSON_EVERY    60
+#endif
+
+// Роль у будинку:
+//   PB_ROLE_SENSOR     — звичайний сенсор (за замовчуванням)
+//   PB_ROLE_AGGREGATOR — ще й агрегатор: слухає beat-и сусідніх секцій на PB_AGG_UDP_PORT і
+//                        раз на слот розкладу шле серверу один пакет (POST /api/v1/heartbeat/batch).
+//                        Лише PB_TRANSPORT_HTTP і без light-sleep (сокет опитується постійно).
+// Сусіди — звичайні сенсори з PB_TRANSPORT_UDP, SERVER_HOST = IP агрегатора (резервація DHCP)
+// і SERVER_UDP_PORT = PB_AGG_UDP_PORT.
+#define PB_ROLE_SENSOR          0
+#define PB_ROLE_AGGREGATOR      1
+#ifndef PB_ROLE
+#define PB_ROLE                 PB_ROLE_SENSOR
+#endif
+
+#ifndef PB_AGG_UDP_PORT
+#define PB_AGG_UDP_PORT         18083
+#endif
+
+// Скільки сусідів тримає агрегатор; сусід, якого не чути PB_AGG_FORGET_MS, звільняє місце.
+#ifndef PB_AGG_PEERS
+#define PB_AGG_PEERS            8
+#endif
+#ifndef PB_AGG_FORGET_MS
+#define PB_AGG_FORGET_MS        600000
+#endif
+
+// Як часто net-задача агрегатора опитує сокет сусідів, коли більше нічого не чекає (мс).
+#ifndef PB_AGG_POLL_MS
+#define PB_AGG_POLL_MS          10
+#endif
+
+// Лог heartbeat-шляху (pb_log.h): рівень відсікається при компіляції —
+// PB_LOG_LEVEL_DEBUG додає Local IP/Gateway, payload, body і лічильники з'єднань.
+#ifndef PB_LOG_LEVEL
+#define PB_LOG_LEVEL            PB_LOG_LEVEL_INFO
+#endif
+
+// 1 = писати лог у Serial одразу з loop(), як раніше (для порівняння "⏱ beat").
+// 0 = через ring-буфер і низькопріоритетну задачу-дренер.
+#ifndef PB_LOG_DIRECT
+#define PB_LOG_DIRECT           0
+#endif
+
+// 1 = дренер пише бінарні записи замість тексту (декодує scripts/sensor_log_decode.py).
+#ifndef PB_LOG_BINARY
+#define PB_LOG_BINARY           0
+#endif
+
+// Розмір ring-буфера логу (байт, степінь двійки). Що не влізло — рахується в log_drops.
+#ifndef PB_LOG_RING_BYTES
+#define PB_LOG_RING_BYTES       2048
+#endif
+
+// Як часто дренер перевіряє ring (мс).
+#ifndef PB_LOG_DRAIN_MS
+#define PB_LOG_DRAIN_MS         10
+#endif
+
+// ─── Задачі FreeRTOS ───
+// Ядро net-задачі (лінк, heartbeat, last-gasp). 0 — де Arduino-ESP32 тримає lwIP (tcpip)
+// і драйвер Ethernet; loop() (супервізор) лишається на ядрі 1.
+#ifndef PB_NET_TASK_CORE
+#define PB_NET_TASK_CORE        0
+#endif
+
+// Стек і пріоритет net-задачі (loop() — 1, дренер логу — 0). Запас стеку видно в звіті задач.
+#ifndef PB_NET_TASK_STACK
+#define PB_NET_TASK_STACK       8192
+#endif
+#ifndef PB_NET_TASK_PRIORITY
+#define PB_NET_TASK_PRIORITY    2
+#endif
+
+// Як часто супервізор пише в Serial мінімум вільного стеку і CPU задач (мс). 0 = не писати.
+#ifndef PB_TASK_STATS_MS
+#define PB_TASK_STATS_MS        60000
+#endif
+
+// ─── Енергозбереження (esp_pm) ───
+// 0 — вимкнено; 1 — DFS: частота CPU між PB_PM_MIN_MHZ і PB_PM_MAX_MHZ за навантаженням;
+// 2 — DFS + automatic light-sleep між beat-ами. Потрібні CONFIG_PM_ENABLE (і для light-sleep
+// CONFIG_FREERTOS_USE_TICKLESS_IDLE) у sdkconfig — без них прошивка пише попередження і
+// працює на повній частоті. Поки beat у польоті, CPU тримається на максимумі (lock "pb_beat").
+// Драйвер EMAC (RMII) тримає власний lock APB_FREQ_MAX, поки Ethernet запущено: light-sleep
+// на цих платах не настане, CPU опускається до PB_PM_MIN_MHZ (не нижче 80) — фактично лише DFS.
+#ifndef PB_POWER_SAVE
+#define PB_POWER_SAVE           0
+#endif
+
+#ifndef PB_PM_MAX_MHZ
+#define PB_PM_MAX_MHZ           240
+#endif
+#ifndef PB_PM_MIN_MHZ
+#define PB_PM_MIN_MHZ           80
+#endif
+
+// Стеля guard: наскільки раніше дедлайну таймер будить чип (мкс). Фактичний guard —
+// p95 виміряної затримки пробудження, не менше 1 мс (pb_sleep_plan.h).
+#ifndef PB_PM_MAX_GUARD_US
+#define PB_PM_MAX_GUARD_US      5000
+#endif
+
 // ═══════════════════════════════════════════════════════════════
 // Ethernet PHY (LAN8720, RMII)
 //
@@ -57,7 +246,7 @@
 // Це задається через build_flags у `platformio.ini` (див. env:esp32-eth01).
 //
 // Якщо `PB_ETH_AUTOCONFIG=1` — firmware автоматично перебирає кілька типових
-// профілів (addr/clock/reset/pwr_en) на різних перезавантаженнях і зберігає
+// профілів (addr/clock/reset/pwr_en) за один boot і зберігає
 // робочий профіль в NVS. Це зроблено, бо ESP32-ETH01/WT32-ETH01 "клони" часто
 // відрізняються саме цими параметрами.
 //
@@ -77,6 +266,13 @@
 #define PB_ETH_AUTOCONFIG_PREFERRED_PHY  ETH_PHY_MAX
 #endif
 
+// Бюджет часу на кожну фазу MDIO auto-detect (A: типові піни, B: вендорські, C: wide).
+// Пари MDC/MDIO перебираються bit-bang-ом, тож повний wide-скан вкладається в кілька секунд;
+// бюджет лише не дає фазі затягнути перший heartbeat на "дивній" платі.
+#ifndef PB_ETH_DETECT_PHASE_BUDGET_MS
+#define PB_ETH_DETECT_PHASE_BUDGET_MS  2000
+#endif
+
 #ifndef PB_ETH_PHY_ADDR
 #define PB_ETH_PHY_ADDR    1
 #endif
@@ -117,6 +313,139 @@
 #define PB_ETH_POWER_UP_DELAY_MS  150
 #endif
 
+// ═══════════════════════════════════════════════════════════════
+// LAST-GASP: ДЕТЕКЦІЯ ВТРАТИ ЖИВЛЕННЯ
+// ═══════════════════════════════════════════════════════════════
+// Якщо плата має запас живлення (конденсатор / PoE hold-up) і вхід, що бачить
+// вхідну напругу — при просіданні сенсор одразу шле "power_lost", і сервер
+// позначає секцію без світла за ~секунду, а не після таймауту heartbeat.
+//   0 = вимкнено (за замовчуванням, поведінка як раніше)
+//   1 = ADC: напруга живлення через дільник на PB_POWER_SENSE_PIN
+//   2 = GPIO: brownout / power-good вхід (LOW = живлення пропало)
+#ifndef PB_POWER_SENSE_MODE
+#define PB_POWER_SENSE_MODE     0
+#endif
+
+// ETH-плати: GPIO36 (SENSOR_VP) — лише вхід, ADC1, вільний на WT32-ETH01/ESP32-ETH01.
+#ifndef PB_POWER_SENSE_PIN
+#define PB_POWER_SENSE_PIN      36
+#endif
+
+// ADC: коефіцієнт дільника ×1000 (R1=R2 → 2000) і пороги по напрузі живлення (мВ).
+// Повернення вище PB_POWER_RESTORED_MV — гістерезис проти "дрижання" біля порогу.
+#ifndef PB_POWER_DIVIDER_X1000
+#define PB_POWER_DIVIDER_X1000  2000
+#endif
+
+#ifndef PB_POWER_LOST_MV
+#define PB_POWER_LOST_MV        4300
+#endif
+
+#ifndef PB_POWER_RESTORED_MV
+#define PB_POWER_RESTORED_MV    4600
+#endif
+
+// Період семплювання і скільки семплів поспіль підтверджують подію (антидребезг).
+#ifndef PB_POWER_SAMPLE_MS
+#define PB_POWER_SAMPLE_MS      2
+#endif
+
+#ifndef PB_POWER_CONFIRM_SAMPLES
+#define PB_POWER_CONFIRM_SAMPLES 3
+#endif
+
+// Скільки часу (мс) last-gasp може блокувати loop(), поки відправляє power_lost.
+#ifndef PB_LAST_GASP_BUDGET_MS
+#define PB_LAST_GASP_BUDGET_MS  250
+#endif
+
+// ═══════════════════════════════════════════════════════════════
+// ВХОДИ: КІЛЬКА СЕКЦІЙ / ФАЗ НА ОДНІЙ ПЛАТІ
+// ═══════════════════════════════════════════════════════════════
+// PB_INPUTS > 0 — плата бачить живлення кількох секцій (фаз) через оптопари на
+// PB_INPUT_PINS і шле їх станом бітової маски "inputs": біт i -> секція PB_INPUT_SECTIONS[i].
+// Сервер веде кожен вхід як окремий сенсор своєї секції — замість SENSOR_ALIAS_* на сервері.
+// Живлення самої плати (ДБЖ / PoE) тоді світла секції не означає.
+// На будь-який фронт входу beat іде одразу, не чекаючи розкладу.
+//   0 = вимкнено (за замовчуванням, один сенсор — одна секція SECTION_ID)
+#ifndef PB_INPUTS
+#define PB_INPUTS               0
+#endif
+
+// Піни і секції входів — через кому, по PB_INPUTS штук.
+// ETH-плати: GPIO35/39 — лише вхід, без внутрішньої підтяжки (потрібен резистор 10k до 3.3V).
+#ifndef PB_INPUT_PINS
+#define PB_INPUT_PINS           39, 35, 32
+#endif
+#ifndef PB_INPUT_SECTIONS
+#define PB_INPUT_SECTIONS       1, 2, 3
+#endif
+
+// 1 = оптопара тягне вхід до GND (LOW = є напруга), 0 = HIGH = є напруга.
+#ifndef PB_INPUT_ACTIVE_LOW
+#define PB_INPUT_ACTIVE_LOW     1
+#endif
+
+// Входи семплює ISR апаратного таймера раз на PB_INPUT_SAMPLE_US.
+// Оптопара на ~220 В блимає з частотою мережі: "увімкнено" — після PB_INPUT_ON_SAMPLES
+// активних семплів, "вимкнено" — після PB_INPUT_OFF_MS без жодного (більше за 20 мс паузи
+// між імпульсами 50 Гц).
+#ifndef PB_INPUT_SAMPLE_US
+#define PB_INPUT_SAMPLE_US      1000
+#endif
+#ifndef PB_INPUT_ON_SAMPLES
+#define PB_INPUT_ON_SAMPLES     5
+#endif
+#ifndef PB_INPUT_OFF_MS
+#define PB_INPUT_OFF_MS         40
+#endif
+
+// ═══════════════════════════════════════════════════════════════
+// ЯКІСТЬ МЕРЕЖІ: НАПРУГА І ЧАСТОТА
+// ═══════════════════════════════════════════════════════════════
+// PB_MAINS=1 — датчик напруги (ZMPT101B тощо: трансформатор + зміщення в середину шкали)
+// на PB_MAINS_PIN. ADC семплює безперервно через DMA, окрема задача рахує RMS і частоту
+// кожного періоду; у heartbeat — "mains_v" / "mains_hz": min / avg / max за вікно "hb_lat".
+// Несумісно з PB_POWER_SAVE (DMA тактується від APB) і з PB_POWER_SENSE_MODE=1 (той самий ADC1).
+//   0 = вимкнено (за замовчуванням)
+#ifndef PB_MAINS
+#define PB_MAINS                0
+#endif
+
+// ETH-плати: GPIO33 — ADC1_CH5, вільний на WT32-ETH01 / ESP32-ETH01 (DMA-режим на ESP32 — лише ADC1).
+#ifndef PB_MAINS_PIN
+#define PB_MAINS_PIN            33
+#endif
+
+// Частота семплів (Гц): 400 семплів на період 50 Гц. На ESP32 — не менше 20000 (I2S0).
+#ifndef PB_MAINS_SAMPLE_HZ
+#define PB_MAINS_SAMPLE_HZ      20000
+#endif
+
+// Калібрування: мкВ мережі на одиницю ADC (обидва — RMS). Виставити по мультиметру:
+// нове = старе × (напруга мультиметра / напруга в лозі).
+#ifndef PB_MAINS_UV_PER_COUNT
+#define PB_MAINS_UV_PER_COUNT   175000
+#endif
+
+// Гістерезис перетину нуля (одиниці ADC) — вище шуму ADC, нижче амплітуди при просіданні.
+#ifndef PB_MAINS_HYST_COUNTS
+#define PB_MAINS_HYST_COUNTS    40
+#endif
+
+// Допустима частота (Гц): період довший за 1/PB_MAINS_MIN_HZ закривається без частоти.
+#ifndef PB_MAINS_MIN_HZ
+#define PB_MAINS_MIN_HZ         40
+#endif
+#ifndef PB_MAINS_MAX_HZ
+#define PB_MAINS_MAX_HZ         70
+#endif
+
+// Семплів у блоці DMA, який задача обробляє за раз (256 = 12.8 мс на 20 кГц).
+#ifndef PB_MAINS_BLOCK_SAMPLES
+#define PB_MAINS_BLOCK_SAMPLES  256
+#endif
+
 // ═══════════════════════════════════════════════════════════════
 // LED ІНДИКАЦІЯ
 // ═══════════════════════════════════════════════════════════════
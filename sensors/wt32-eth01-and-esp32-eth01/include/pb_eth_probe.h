@@ -0,0 +1,76 @@
+/*
+ * PowerBot: перебір Ethernet-профілів за один boot + часова шкала boot -> перший heartbeat.
+ *
+ * PbEthProbeOrder — порядок спроб: від start по колу, кожен профіль не більше одного разу,
+ * не більше budget спроб (решта після last-resort reboot продовжує з того ж місця).
+ *
+ * PbEthBootTimeline — мітки від boot (millis()): скільки з'їв перебір, коли link/IP/перший beat.
+ * Кожна мітка фіксується лише перший раз, щоб reconnect не переписував час старту.
+ *
+ * Header портабельний (без Arduino.h) — перевіряється на хості (test/test_eth_probe).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class PbEthProbeOrder {
+public:
+    PbEthProbeOrder(size_t count, size_t start, size_t budget)
+        : count_(count), start_(start < count ? start : 0), budget_(budget < count ? budget : count) {}
+
+    // Наступний індекс профілю; false — бюджет вичерпано.
+    bool next(size_t &idx) {
+        if (tried_ >= budget_) {
+            return false;
+        }
+        idx = (start_ + tried_) % count_;
+        tried_++;
+        return true;
+    }
+
+    size_t tried() const { return tried_; }
+    size_t budget() const { return budget_; }
+
+private:
+    size_t count_;
+    size_t start_;
+    size_t budget_;
+    size_t tried_ = 0;
+};
+
+class PbEthBootTimeline {
+public:
+    void probe(uint32_t durationMs) {
+        probes_++;
+        probeMs_ += durationMs;
+    }
+
+    void markLinkUp(uint32_t nowMs) { mark(linkUpMs_, nowMs); }
+    void markGotIp(uint32_t nowMs) { mark(gotIpMs_, nowMs); }
+    // true — це і є перший beat (лог пишемо один раз).
+    bool markFirstBeat(uint32_t nowMs) { return mark(firstBeatMs_, nowMs); }
+
+    uint32_t probes() const { return probes_; }
+    uint32_t probeMs() const { return probeMs_; }
+    // 0 — події ще не було (millis() після boot завжди > 0).
+    uint32_t linkUpMs() const { return linkUpMs_; }
+    uint32_t gotIpMs() const { return gotIpMs_; }
+    uint32_t firstBeatMs() const { return firstBeatMs_; }
+
+private:
+    static bool mark(uint32_t &slot, uint32_t nowMs) {
+        if (slot != 0) {
+            return false;
+        }
+        slot = nowMs != 0 ? nowMs : 1;
+        return true;
+    }
+
+    uint32_t probes_ = 0;
+    uint32_t probeMs_ = 0;
+    uint32_t linkUpMs_ = 0;
+    uint32_t gotIpMs_ = 0;
+    uint32_t firstBeatMs_ = 0;
+};
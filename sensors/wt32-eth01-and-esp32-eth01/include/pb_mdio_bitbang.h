@@ -0,0 +1,123 @@
+/*
+ * PowerBot: bit-banged MDIO (IEEE 802.3 clause 22) для пошуку PHY.
+ *
+ * Детект PHY на ESP32-ETH01 клонах перебирає сотні пар MDC/MDIO. Через EMAC це означало
+ * новий MAC (new/init/start/stop/deinit/del) на кожну пару; тут пара — це просто два GPIO,
+ * які Io перемикає між спробами, а кадр на порожній/плаваючій шині обривається одразу
+ * після turnaround-біта (47 тактів MDC замість 64).
+ *
+ * Io — мінімальний інтерфейс пінів:
+ *   void mdc(bool high);        // рівень MDC
+ *   void mdioDrive(bool high);  // MDIO як вихід з рівнем
+ *   void mdioRelease();         // MDIO як вхід (з pull-up)
+ *   bool mdioRead();            // рівень MDIO
+ *   void settle();              // пів періоду MDC
+ *
+ * Header портабельний (без Arduino.h) — перевіряється на хості з фейковим PHY (test/test_mdio_bitbang).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum class PbMdioRead : uint8_t {
+    Ok,
+    NoPhy,    // ніхто не потягнув turnaround у 0: адреса порожня або шина плаває
+    BusLow,   // відпущений MDIO читається як 0: пін тримає щось інше, це не шина MDIO
+};
+
+// Типові значення "нікого немає" (0x0000 — MDIO притиснутий, 0xFFFF — плаває з pull-up).
+inline bool pbMdioPhyIdValid(uint16_t id1, uint16_t id2) {
+    return id1 != 0x0000 && id1 != 0xFFFF && id2 != 0x0000 && id2 != 0xFFFF;
+}
+
+template <typename Io>
+class PbMdioBitBang {
+public:
+    static const uint8_t kPreambleBits = 32;
+
+    explicit PbMdioBitBang(Io &io) : io_(io) {}
+
+    // Шина в спокої має бути в 1 (pull-up). Якщо ні — на цій парі пінів MDIO немає.
+    bool idleHigh() {
+        io_.mdc(false);
+        io_.mdioRelease();
+        io_.settle();
+        return io_.mdioRead();
+    }
+
+    PbMdioRead read(uint8_t addr, uint8_t reg, uint16_t &out) {
+        for (uint8_t i = 0; i < kPreambleBits; i++) {
+            writeBit(true);
+        }
+        writeBits(0x1, 2);   // ST = 01
+        writeBits(0x2, 2);   // OP = 10 (read)
+        writeBits(addr, 5);
+        writeBits(reg, 5);
+
+        // TA: перший біт — Z (ми відпускаємо), другий має тягнути в 0 сам PHY.
+        io_.mdioRelease();
+        if (readBit()) {
+            // Кадр обриваємо тут: преамбула наступного read все одно ресинхронізує шину.
+            return PbMdioRead::NoPhy;
+        }
+
+        uint16_t v = 0;
+        for (uint8_t i = 0; i < 16; i++) {
+            v = static_cast<uint16_t>((v << 1) | (readBit() ? 1 : 0));
+        }
+        readBit();   // idle-такт: PHY відпускає шину
+        out = v;
+        return PbMdioRead::Ok;
+    }
+
+    // Перша адреса зі списку, де регістри 2/3 (PHY ID) читаються і схожі на справжній ID.
+    PbMdioRead scanFirstHit(const uint8_t *addrs, size_t count, uint8_t &addr, uint16_t &id1, uint16_t &id2) {
+        if (!idleHigh()) {
+            return PbMdioRead::BusLow;
+        }
+        for (size_t i = 0; i < count; i++) {
+            uint16_t a = 0;
+            uint16_t b = 0;
+            if (read(addrs[i], 2, a) != PbMdioRead::Ok || read(addrs[i], 3, b) != PbMdioRead::Ok) {
+                continue;
+            }
+            if (!pbMdioPhyIdValid(a, b)) {
+                continue;
+            }
+            addr = addrs[i];
+            id1 = a;
+            id2 = b;
+            return PbMdioRead::Ok;
+        }
+        return PbMdioRead::NoPhy;
+    }
+
+private:
+    // PHY семплює MDIO по фронту MDC.
+    void writeBit(bool bit) {
+        io_.mdioDrive(bit);
+        io_.settle();
+        io_.mdc(true);
+        io_.settle();
+        io_.mdc(false);
+    }
+
+    void writeBits(uint32_t value, uint8_t bits) {
+        for (uint8_t i = bits; i > 0; i--) {
+            writeBit(((value >> (i - 1)) & 1u) != 0);
+        }
+    }
+
+    // PHY виставляє дані після фронту MDC; читаємо після спаду, як mdio-bitbang у Linux.
+    bool readBit() {
+        io_.settle();
+        io_.mdc(true);
+        io_.settle();
+        io_.mdc(false);
+        return io_.mdioRead();
+    }
+
+    Io &io_;
+};
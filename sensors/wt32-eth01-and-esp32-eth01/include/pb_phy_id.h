@@ -0,0 +1,80 @@
+/*
+ * PowerBot: PHY ID (MDIO регістри 2/3) -> модель PHY.
+ *
+ * ID1 = OUI[3:18], ID2 = OUI[19:24] | model[9:4] | revision[3:0]. Ревізію ігноруємо: клони
+ * LAN8720A трапляються з rev 0 і 1, IP101GR/IP101A — з різними ревізіями.
+ * Таблиця constexpr, тож `pbPhyModelFromId(0x0007, 0xC0F1)` можна перевірити static_assert-ом.
+ *
+ * Header портабельний (без Arduino.h) — перевіряється на хості (test/test_phy_id).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum class PbPhyModel : uint8_t {
+    Unknown,
+    Lan8720,   // SMSC/Microchip LAN8710A/LAN8720A/LAN8742A (драйвер lan87xx)
+    Ip101,     // IC+ IP101GR/IP101A (у Arduino-ESP32 — ETH_PHY_IP101 / TLK110)
+    Rtl8201,   // Realtek RTL8201F
+    Dp83848,   // TI DP83848
+    Ksz8041,   // Microchip/Micrel KSZ8041
+    Ksz8081,   // Microchip/Micrel KSZ8081
+};
+
+struct PbPhyIdEntry {
+    uint32_t oui;
+    uint8_t model;
+    PbPhyModel kind;
+};
+
+constexpr uint32_t pbPhyOui(uint16_t id1, uint16_t id2) {
+    return (static_cast<uint32_t>(id1) << 6) | (id2 >> 10);
+}
+
+constexpr uint8_t pbPhyModelBits(uint16_t id2) {
+    return static_cast<uint8_t>((id2 >> 4) & 0x3F);
+}
+
+constexpr PbPhyIdEntry kPbPhyIds[] = {
+    {0x0001F0, 0x0F, PbPhyModel::Lan8720},   // LAN8710A / LAN8720A: 0x0007/0xC0Fx
+    {0x0001F0, 0x13, PbPhyModel::Lan8720},   // LAN8742A:            0x0007/0xC13x
+    {0x0090C3, 0x05, PbPhyModel::Ip101},     // IP101GR / IP101A:    0x0243/0x0C5x
+    {0x000732, 0x01, PbPhyModel::Rtl8201},   // RTL8201F:            0x001C/0xC81x
+    {0x080017, 0x09, PbPhyModel::Dp83848},   // DP83848:             0x2000/0x5C9x
+    {0x000885, 0x11, PbPhyModel::Ksz8041},   // KSZ8041:             0x0022/0x151x
+    {0x000885, 0x16, PbPhyModel::Ksz8081},   // KSZ8081:             0x0022/0x156x
+};
+
+constexpr size_t kPbPhyIdCount = sizeof(kPbPhyIds) / sizeof(kPbPhyIds[0]);
+
+constexpr PbPhyModel pbPhyLookup(uint32_t oui, uint8_t model, size_t i = 0) {
+    return i >= kPbPhyIdCount ? PbPhyModel::Unknown
+           : (kPbPhyIds[i].oui == oui && kPbPhyIds[i].model == model) ? kPbPhyIds[i].kind
+                                                                       : pbPhyLookup(oui, model, i + 1);
+}
+
+// 0x0000/0xFFFF (шина притиснута/плаває) ніколи не збігаються з таблицею — окрема перевірка не потрібна.
+constexpr PbPhyModel pbPhyModelFromId(uint16_t id1, uint16_t id2) {
+    return pbPhyLookup(pbPhyOui(id1, id2), pbPhyModelBits(id2));
+}
+
+inline const char *pbPhyModelName(PbPhyModel model) {
+    switch (model) {
+        case PbPhyModel::Lan8720:
+            return "LAN8720";
+        case PbPhyModel::Ip101:
+            return "IP101";
+        case PbPhyModel::Rtl8201:
+            return "RTL8201";
+        case PbPhyModel::Dp83848:
+            return "DP83848";
+        case PbPhyModel::Ksz8041:
+            return "KSZ8041";
+        case PbPhyModel::Ksz8081:
+            return "KSZ8081";
+        default:
+            return "UNKNOWN";
+    }
+}
@@ -2,34 +2,36 @@
  * PowerBot ESP32 Ethernet Heartbeat Sensor
  *
  * Плати: WT32-ETH01 / ESP32-ETH01 (LAN8720, RMII)
+ *
+ * Тут лише Ethernet плати (з автопідбором профілю PHY); решта прошивки —
+ * lib/powerbot_core (pb_sensor.h).
  */
 
 #include <Arduino.h>
 #include <WiFi.h>
 #include <ETH.h>
-#include <ArduinoJson.h>
+#include <Preferences.h>
 #include "config.h"
+#include "pb_eth_probe.h"
+#include "pb_net_lwip.h"
 
 #if PB_ETH_AUTOCONFIG
-#include <Preferences.h>
 #include "esp_err.h"
+#include "esp_eth.h"
 #include "esp_eth_mac.h"
 #include "esp_eth_com.h"
+#include "pb_mdio_bitbang.h"
+#include "pb_phy_id.h"
 #endif
 
-// Ethernet/TCP клієнт
-WiFiClient ethClient;
-
 // Для коректного логування в різних env (див. platformio.ini)
 #ifndef PB_BOARD_NAME
 #define PB_BOARD_NAME "ESP32 Ethernet"
 #endif
 
-// Стан підключення
-bool eth_connected = false;
-
-// Час останнього heartbeat
-unsigned long lastHeartbeatTime = 0;
+// Boot -> перебір профілів -> link -> IP -> перший heartbeat (лог один раз після першого beat).
+static PbEthBootTimeline pbEthBoot;
+static const char *pbEthProfileLabel = "config.h";
 
 struct PbEthProfile {
     const char *label;
@@ -82,7 +84,7 @@ static const char *pbEthPhyTypeStr(eth_phy_type_t type) {
 
 #if PB_ETH_AUTOCONFIG
 static constexpr uint32_t PB_ETH_AUTOCONFIG_MAGIC = 0x50424554; // 'PBET'
-static constexpr uint32_t PB_ETH_PROFILESET_VERSION = 7;
+static constexpr uint32_t PB_ETH_PROFILESET_VERSION = 8;
 #ifndef PB_ETH_AUTOCONFIG_DETECT_WIDE
 #define PB_ETH_AUTOCONFIG_DETECT_WIDE 0
 #endif
@@ -95,6 +97,7 @@ RTC_NOINIT_ATTR uint8_t pb_eth_detect_valid;
 RTC_NOINIT_ATTR int8_t pb_eth_detect_mdc;
 RTC_NOINIT_ATTR int8_t pb_eth_detect_mdio;
 RTC_NOINIT_ATTR uint8_t pb_eth_detect_addr;
+RTC_NOINIT_ATTR uint8_t pb_eth_detect_phy;    // eth_phy_type_t decoded from the PHY ID, ETH_PHY_MAX = unknown
 RTC_NOINIT_ATTR uint8_t pb_eth_profile_source; // 0=static list, 1=detected/dynamic list
 
 struct PbEthDetectedPhy {
@@ -106,17 +109,6 @@ struct PbEthDetectedPhy {
     uint16_t id2;
 };
 
-static bool pbEthLooksLikeValidPhyId(uint16_t id1, uint16_t id2) {
-    // Filter out common "bus floating" values.
-    if (id1 == 0x0000 || id1 == 0xFFFF) {
-        return false;
-    }
-    if (id2 == 0x0000 || id2 == 0xFFFF) {
-        return false;
-    }
-    return true;
-}
-
 static void pbEthFillMacClockConfig(eth_mac_config_t &mac_config, eth_clock_mode_t clk_mode) {
     if (clk_mode == ETH_CLOCK_GPIO0_IN) {
         mac_config.clock_config.rmii.clock_mode = EMAC_CLK_EXT_IN;
@@ -189,66 +181,173 @@ static bool pbEthMdioReadPhyIdRaw(eth_clock_mode_t clk_mode, int mdc, int mdio,
     return ok;
 }
 
-static bool pbEthMdioScanFirstHit(eth_clock_mode_t clk_mode, int mdc, int mdio, const uint8_t *addrs, size_t addr_count, PbEthDetectedPhy &out) {
+// MDIO bit-banged on two arbitrary GPIOs: an MDC/MDIO pair is just two pin numbers,
+// so moving to the next pair needs no EMAC re-creation.
+struct PbMdioGpio {
+    int mdc_pin;
+    int mdio_pin;
+    bool driving;
+
+    void mdc(bool high) { digitalWrite(mdc_pin, high ? HIGH : LOW); }
+    void mdioDrive(bool high) {
+        if (!driving) {
+            pinMode(mdio_pin, OUTPUT);
+            driving = true;
+        }
+        digitalWrite(mdio_pin, high ? HIGH : LOW);
+    }
+    void mdioRelease() {
+        if (driving) {
+            pinMode(mdio_pin, INPUT_PULLUP);
+            driving = false;
+        }
+    }
+    bool mdioRead() { return digitalRead(mdio_pin) == HIGH; }
+    void settle() { delayMicroseconds(1); }
+};
+
+// RMII reference clock for PHYs without their own oscillator: the EMAC only outputs 50MHz,
+// its SMI is left unrouted. With GPIO0_IN the PHY runs from its own oscillator and needs no EMAC.
+static esp_eth_mac_t *pbEthClockStart(eth_clock_mode_t clk_mode) {
+    if (clk_mode == ETH_CLOCK_GPIO0_IN) {
+        return nullptr;
+    }
+
     eth_mac_config_t mac_config = ETH_MAC_DEFAULT_CONFIG();
     pbEthFillMacClockConfig(mac_config, clk_mode);
-    mac_config.smi_mdc_gpio_num = mdc;
-    mac_config.smi_mdio_gpio_num = mdio;
-    mac_config.sw_reset_timeout_ms = 1000;
+    mac_config.smi_mdc_gpio_num = -1;
+    mac_config.smi_mdio_gpio_num = -1;
+    mac_config.sw_reset_timeout_ms = 100;
 
     esp_eth_mac_t *mac = esp_eth_mac_new_esp32(&mac_config);
     if (!mac) {
-        return false;
+        return nullptr;
     }
 
-    bool found = false;
-    // Important: esp32 emac implementation expects the mediator to be set before init()
-    // (otherwise internal pointers may be null and init can crash).
-    esp_eth_mediator_t mediator = {};
+    // The mediator must outlive init() .. del(), hence static.
+    static esp_eth_mediator_t mediator = {};
     mediator.phy_reg_read = pbEthMediatorPhyRegRead;
     mediator.phy_reg_write = pbEthMediatorPhyRegWrite;
     mediator.stack_input = pbEthMediatorStackInput;
     mediator.on_state_changed = pbEthMediatorOnStateChanged;
     (void)mac->set_mediator(mac, &mediator);
 
-    if (mac->init(mac) == ESP_OK) {
-        // Some implementations require MAC started for SMI access; ignore start error.
-        (void)mac->start(mac);
+    if (mac->init(mac) != ESP_OK) {
+        (void)mac->del(mac);
+        return nullptr;
+    }
+    (void)mac->start(mac);
+    return mac;
+}
 
-        for (size_t i = 0; i < addr_count; i++) {
-            const uint8_t addr = addrs[i];
-            uint32_t id1 = 0;
-            uint32_t id2 = 0;
-            if (mac->read_phy_reg(mac, addr, 2, &id1) != ESP_OK) {
-                continue;
-            }
-            if (mac->read_phy_reg(mac, addr, 3, &id2) != ESP_OK) {
-                continue;
-            }
+static void pbEthClockStop(esp_eth_mac_t *mac) {
+    if (!mac) {
+        return;
+    }
+    (void)mac->stop(mac);
+    (void)mac->deinit(mac);
+    (void)mac->del(mac);
+}
 
-            const uint16_t id1_16 = static_cast<uint16_t>(id1 & 0xFFFF);
-            const uint16_t id2_16 = static_cast<uint16_t>(id2 & 0xFFFF);
-            if (!pbEthLooksLikeValidPhyId(id1_16, id2_16)) {
-                continue;
-            }
+static bool pbEthIsClockPin(eth_clock_mode_t clk_mode, int pin) {
+    switch (clk_mode) {
+        case ETH_CLOCK_GPIO0_IN:
+        case ETH_CLOCK_GPIO0_OUT:
+            return pin == 0;
+        case ETH_CLOCK_GPIO16_OUT:
+            return pin == 16;
+        case ETH_CLOCK_GPIO17_OUT:
+            return pin == 17;
+        default:
+            return false;
+    }
+}
 
-            out = PbEthDetectedPhy{
-                .clk_mode = clk_mode,
-                .mdc_pin = mdc,
-                .mdio_pin = mdio,
-                .phy_addr = addr,
-                .id1 = id1_16,
-                .id2 = id2_16,
-            };
-            found = true;
-            break;
-        }
+static void pbEthMdioPinsAcquire(int mdc, int mdio) {
+    pinMode(mdc, OUTPUT);
+    digitalWrite(mdc, LOW);
+    pinMode(mdio, INPUT_PULLUP);
+}
 
-        (void)mac->stop(mac);
-        (void)mac->deinit(mac);
+static void pbEthMdioPinsRelease(int mdc, int mdio) {
+    pinMode(mdc, INPUT_PULLUP);
+    pinMode(mdio, INPUT_PULLUP);
+    // GPIO16 is PWR_EN on many clones: put it back HIGH and let the PHY come back up.
+    if (mdc == 16 || mdio == 16) {
+        pinMode(16, OUTPUT);
+        digitalWrite(16, HIGH);
+        delay(10);
     }
+}
 
-    (void)mac->del(mac);
+static bool pbEthMdioScanFirstHit(eth_clock_mode_t clk_mode, int mdc, int mdio, const uint8_t *addrs, size_t addr_count, PbEthDetectedPhy &out) {
+    // Bit-banging the clock pin would detach it from the EMAC clock output.
+    if (pbEthIsClockPin(clk_mode, mdc) || pbEthIsClockPin(clk_mode, mdio)) {
+        return false;
+    }
+
+    pbEthMdioPinsAcquire(mdc, mdio);
+    PbMdioGpio io = {mdc, mdio, false};
+    PbMdioBitBang<PbMdioGpio> bus(io);
+    uint8_t addr = 0;
+    uint16_t id1 = 0;
+    uint16_t id2 = 0;
+    const bool found = (bus.scanFirstHit(addrs, addr_count, addr, id1, id2) == PbMdioRead::Ok);
+    pbEthMdioPinsRelease(mdc, mdio);
+
+    if (found) {
+        out = PbEthDetectedPhy{
+            .clk_mode = clk_mode,
+            .mdc_pin = mdc,
+            .mdio_pin = mdio,
+            .phy_addr = addr,
+            .id1 = id1,
+            .id2 = id2,
+        };
+    }
+    return found;
+}
+
+// One detect phase: per clock mode a single EMAC instance (clock source only), then every pin pair
+// is tried by bit-bang. The phase stops as soon as it has used up PB_ETH_DETECT_PHASE_BUDGET_MS.
+static bool pbEthDetectPhase(const char *name,
+                             const eth_clock_mode_t *clocks,
+                             size_t clock_count,
+                             const int (*pairs)[2],
+                             size_t pair_count,
+                             const uint8_t *addrs,
+                             size_t addr_count,
+                             PbEthDetectedPhy &out) {
+    const unsigned long phase_start = millis();
+    unsigned pairs_tried = 0;
+    bool found = false;
+    bool over_budget = false;
+
+    for (size_t c = 0; c < clock_count && !found && !over_budget; c++) {
+        esp_eth_mac_t *clock = pbEthClockStart(clocks[c]);
+        if (clocks[c] != ETH_CLOCK_GPIO0_IN && !clock) {
+            Serial.printf("🔎 MDIO detect %s: clock %s не стартував, пропускаю\n", name, pbEthClockModeStr(clocks[c]));
+            continue;
+        }
+        for (size_t i = 0; i < pair_count; i++) {
+            if (millis() - phase_start >= PB_ETH_DETECT_PHASE_BUDGET_MS) {
+                over_budget = true;
+                break;
+            }
+            pairs_tried++;
+            if (pbEthMdioScanFirstHit(clocks[c], pairs[i][0], pairs[i][1], addrs, addr_count, out)) {
+                found = true;
+                break;
+            }
+        }
+        pbEthClockStop(clock);
+    }
+
+    Serial.printf("🔎 MDIO detect %s: %u пар за %lu ms%s\n",
+                  name,
+                  pairs_tried,
+                  static_cast<unsigned long>(millis() - phase_start),
+                  over_budget ? " (бюджет фази вичерпано)" : "");
     return found;
 }
 
@@ -270,7 +369,6 @@ static bool pbEthDetectPhy(PbEthDetectedPhy &out) {
     }
 
     // Phase A: most common SMI pins on ESP32 Ethernet designs.
-    static const uint8_t addr_short[] = {0, 1, 2, 3};
     static const int common_pairs[][2] = {
         {23, 18},
         {18, 23},
@@ -281,12 +379,15 @@ static bool pbEthDetectPhy(PbEthDetectedPhy &out) {
         ETH_CLOCK_GPIO17_OUT,
         ETH_CLOCK_GPIO16_OUT,
     };
-    for (eth_clock_mode_t clk : clocks_all) {
-        for (const auto &pair : common_pairs) {
-            if (pbEthMdioScanFirstHit(clk, pair[0], pair[1], addr_list, sizeof(addr_list) / sizeof(addr_list[0]), out)) {
-                return true;
-            }
-        }
+    if (pbEthDetectPhase("A",
+                         clocks_all,
+                         sizeof(clocks_all) / sizeof(clocks_all[0]),
+                         common_pairs,
+                         sizeof(common_pairs) / sizeof(common_pairs[0]),
+                         addr_list,
+                         sizeof(addr_list),
+                         out)) {
+        return true;
     }
 
     // Phase B: a few non-standard clones route MDIO/MDC to other pins.
@@ -327,62 +428,143 @@ static bool pbEthDetectPhy(PbEthDetectedPhy &out) {
         ETH_CLOCK_GPIO17_OUT,
         ETH_CLOCK_GPIO0_OUT,
     };
-    for (eth_clock_mode_t clk : clocks_some) {
-        for (const auto &pair : extended_pairs) {
-            if (pbEthMdioScanFirstHit(clk, pair[0], pair[1], addr_list, sizeof(addr_list) / sizeof(addr_list[0]), out)) {
-                return true;
-            }
-        }
+    if (pbEthDetectPhase("B",
+                         clocks_some,
+                         sizeof(clocks_some) / sizeof(clocks_some[0]),
+                         extended_pairs,
+                         sizeof(extended_pairs) / sizeof(extended_pairs[0]),
+                         addr_list,
+                         sizeof(addr_list),
+                         out)) {
+        return true;
     }
 
 #if PB_ETH_AUTOCONFIG_DETECT_WIDE
     // Phase C (wide): brute-force a wider set of safe-ish GPIOs for MDC/MDIO, but scan only addr 0..3
-    // (most modules strap the PHY in that range). This is slow-ish, so keep it behind a flag.
-    Serial.println("🔎 MDIO detect (wide): перебираю додаткові варіанти MDC/MDIO (може зайняти до ~30-60 сек)...");
+    // (most modules strap the PHY in that range).
+    Serial.println("🔎 MDIO detect (wide): перебираю додаткові варіанти MDC/MDIO...");
+    static const uint8_t addr_short[] = {0, 1, 2, 3};
     static const int candidate_pins[] = {
         23, 18, 16, 32, 2, 5, 4, 12, 13, 14, 15, 17, 33,
     };
+    static const size_t candidate_count = sizeof(candidate_pins) / sizeof(candidate_pins[0]);
+    static int wide_pairs[candidate_count * (candidate_count - 1)][2];
+    size_t wide_count = 0;
+    for (int mdc : candidate_pins) {
+        for (int mdio : candidate_pins) {
+            if (mdc == mdio) {
+                continue;
+            }
+            wide_pairs[wide_count][0] = mdc;
+            wide_pairs[wide_count][1] = mdio;
+            wide_count++;
+        }
+    }
     static const eth_clock_mode_t clocks_wide[] = {
         ETH_CLOCK_GPIO0_IN,
         ETH_CLOCK_GPIO17_OUT,
         ETH_CLOCK_GPIO0_OUT,
         ETH_CLOCK_GPIO16_OUT,
     };
-    for (eth_clock_mode_t clk : clocks_wide) {
-        for (int mdc : candidate_pins) {
-            // Avoid obvious conflicts: clock pin cannot also be used for SMI.
-            if ((clk == ETH_CLOCK_GPIO16_OUT && mdc == 16) || (clk == ETH_CLOCK_GPIO17_OUT && mdc == 17)) {
-                continue;
-            }
-            for (int mdio : candidate_pins) {
-                if (mdc == mdio) {
-                    continue;
-                }
-                if ((clk == ETH_CLOCK_GPIO16_OUT && mdio == 16) || (clk == ETH_CLOCK_GPIO17_OUT && mdio == 17)) {
-                    continue;
-                }
-                if (pbEthMdioScanFirstHit(clk,
-                                          mdc,
-                                          mdio,
-                                          addr_short,
-                                          sizeof(addr_short) / sizeof(addr_short[0]),
-                                          out)) {
-                    return true;
-                }
-            }
-        }
+    if (pbEthDetectPhase("C",
+                         clocks_wide,
+                         sizeof(clocks_wide) / sizeof(clocks_wide[0]),
+                         wide_pairs,
+                         wide_count,
+                         addr_short,
+                         sizeof(addr_short),
+                         out)) {
+        return true;
     }
 #endif
 
     return false;
 }
 
+static eth_phy_type_t pbEthPhyTypeFromId(uint16_t id1, uint16_t id2) {
+    switch (pbPhyModelFromId(id1, id2)) {
+        case PbPhyModel::Lan8720:
+            return ETH_PHY_LAN8720;
+        case PbPhyModel::Ip101:
+            return ETH_PHY_IP101;
+        case PbPhyModel::Rtl8201:
+            return ETH_PHY_RTL8201;
+        case PbPhyModel::Dp83848:
+            return ETH_PHY_DP83848;
+        case PbPhyModel::Ksz8041:
+            return ETH_PHY_KSZ8041;
+        case PbPhyModel::Ksz8081:
+            return ETH_PHY_KSZ8081;
+        default:
+            return ETH_PHY_MAX;
+    }
+}
+
+static esp_eth_phy_t *pbEthNewPhy(eth_phy_type_t type, const eth_phy_config_t &phy_config) {
+    switch (type) {
+        case ETH_PHY_LAN8720:
+            return esp_eth_phy_new_lan8720(&phy_config);
+        case ETH_PHY_TLK110:
+            return esp_eth_phy_new_ip101(&phy_config);
+        case ETH_PHY_RTL8201:
+            return esp_eth_phy_new_rtl8201(&phy_config);
+        case ETH_PHY_DP83848:
+            return esp_eth_phy_new_dp83848(&phy_config);
+        case ETH_PHY_KSZ8041:
+            return esp_eth_phy_new_ksz8041(&phy_config);
+        case ETH_PHY_KSZ8081:
+            return esp_eth_phy_new_ksz8081(&phy_config);
+        default:
+            return nullptr;
+    }
+}
+
+// The same EMAC+PHY driver install ETH.begin() does, but torn down completely afterwards
+// (uninstall + del of both objects), so the next profile starts from a clean EMAC.
+// ETH.begin() itself leaks the MAC/PHY/netif on failure, so it is called only for the winner.
+static bool pbEthProbeProfile(const PbEthProfile &p) {
+    eth_mac_config_t mac_config = ETH_MAC_DEFAULT_CONFIG();
+    pbEthFillMacClockConfig(mac_config, p.clk_mode);
+    mac_config.smi_mdc_gpio_num = p.mdc_pin;
+    mac_config.smi_mdio_gpio_num = p.mdio_pin;
+    mac_config.sw_reset_timeout_ms = 1000;
+
+    esp_eth_mac_t *mac = esp_eth_mac_new_esp32(&mac_config);
+    if (!mac) {
+        return false;
+    }
+
+    eth_phy_config_t phy_config = ETH_PHY_DEFAULT_CONFIG();
+    phy_config.phy_addr = p.phy_addr;
+    phy_config.reset_gpio_num = p.reset_pin;
+    esp_eth_phy_t *phy = pbEthNewPhy(p.phy_type, phy_config);
+    if (!phy) {
+        (void)mac->del(mac);
+        return false;
+    }
+
+    // On failure esp_eth_driver_install() deinits the MAC itself; on success the driver
+    // is never started, so uninstall is allowed right away.
+    esp_eth_config_t eth_config = ETH_DEFAULT_CONFIG(mac, phy);
+    esp_eth_handle_t handle = nullptr;
+    const esp_err_t err = esp_eth_driver_install(&eth_config, &handle);
+    const bool ok = (err == ESP_OK && handle != nullptr);
+    if (handle != nullptr) {
+        (void)esp_eth_driver_uninstall(handle);
+    }
+
+    (void)phy->del(phy);
+    (void)mac->del(mac);
+    return ok;
+}
+
 static constexpr size_t PB_ETH_DYNAMIC_MAX = 24;
 static PbEthProfile pb_eth_dynamic_profiles[PB_ETH_DYNAMIC_MAX];
 static char pb_eth_dynamic_labels[PB_ETH_DYNAMIC_MAX][96];
 static size_t pb_eth_dynamic_count;
 
-static void pbEthBuildDynamicProfiles(int mdc, int mdio, uint8_t phy_addr) {
+// phy_type comes from the PHY ID the detector read (LAN8720 when the ID is not in pb_phy_id.h).
+static void pbEthBuildDynamicProfiles(int mdc, int mdio, uint8_t phy_addr, eth_phy_type_t phy_type) {
     pb_eth_dynamic_count = 0;
 
     auto add = [&](eth_clock_mode_t clk, int reset_pin, int pwr_en_pin, int pwr_en_level, int pwr_en_delay_ms) {
@@ -393,7 +575,8 @@ static void pbEthBuildDynamicProfiles(int mdc, int mdio, uint8_t phy_addr) {
         const size_t i = pb_eth_dynamic_count;
         snprintf(pb_eth_dynamic_labels[i],
                  sizeof(pb_eth_dynamic_labels[i]),
-                 "det-mdc%d-mdio%d-addr%u-%s-rst%d-pwr%d_%d_%d",
+                 "det-%s-mdc%d-mdio%d-addr%u-%s-rst%d-pwr%d_%d_%d",
+                 pbEthPhyTypeStr(phy_type),
                  mdc,
                  mdio,
                  static_cast<unsigned>(phy_addr),
@@ -409,7 +592,7 @@ static void pbEthBuildDynamicProfiles(int mdc, int mdio, uint8_t phy_addr) {
             .reset_pin = reset_pin,
             .mdc_pin = mdc,
             .mdio_pin = mdio,
-            .phy_type = ETH_PHY_LAN8720,
+            .phy_type = phy_type,
             .clk_mode = clk,
             .pwr_en_pin = pwr_en_pin,
             .pwr_en_level = pwr_en_level,
@@ -443,9 +626,9 @@ static void pbEthBuildDynamicProfiles(int mdc, int mdio, uint8_t phy_addr) {
     add(ETH_CLOCK_GPIO17_OUT, -1, 16, 0, 250);
 }
 
-// A small set of "known good" profiles for ESP32-ETH01 clones.
-// We intentionally keep this list short: each failed ETH.begin() leaks memory in Arduino-ESP32,
-// so we try one profile per boot and reboot to move to the next.
+// A set of "known good" profiles for ESP32-ETH01 clones.
+// All of them are probed in one boot (pbEthProbeProfile tears the driver down between attempts);
+// ETH.begin() runs only for the first profile whose driver install succeeded.
 static const PbEthProfile PB_ETH_PROFILES[] = {
     // Baseline: don't touch RESET/PWR_EN, just try the most common wiring first.
     { "extclk-gpio0_in-addr0", 0, -1, 23, 18, ETH_PHY_LAN8720, ETH_CLOCK_GPIO0_IN, -1, 1, 0 },
@@ -598,129 +781,309 @@ static int pbEthFindFirstProfileByPhyType(eth_phy_type_t type) {
     }
     return -1;
 }
-#endif
-
-// Прототипи функцій
-void onEthEvent(WiFiEvent_t event);
-void setupEthernet();
-bool sendHeartbeat();
-void blinkLED(int times, int delayMs);
 
-void setup() {
-    Serial.begin(115200);
-    delay(2000);
+// The whole winning configuration, not an index: it also covers profiles built from MDIO detection
+// and survives profile-set changes. Bump PB_ETH_WINNER_VERSION when the layout changes.
+static constexpr uint8_t PB_ETH_WINNER_VERSION = 1;
 
-    Serial.println();
-    Serial.println("================================================");
-    Serial.println("  PowerBot ESP32 Ethernet Heartbeat Sensor");
-    Serial.print("  Board:    ");
-    Serial.println(PB_BOARD_NAME);
-    Serial.printf("  Building: %s (ID: %d)\n", BUILDING_NAME, BUILDING_ID);
-    Serial.printf("  Section:  %d\n", SECTION_ID);
-    Serial.printf("  Sensor:   %s\n", SENSOR_UUID);
-    Serial.printf("  Server:   %s:%d\n", SERVER_HOST, SERVER_PORT);
-    Serial.println("================================================");
-    Serial.println();
-
-#if defined(LED_PIN) && (LED_PIN >= 0)
-    pinMode(LED_PIN, OUTPUT);
-    digitalWrite(LED_PIN, LOW);
-#endif
+struct PbEthWinnerRecord {
+    uint8_t version;
+    uint8_t phy_type;
+    uint8_t clk_mode;
+    uint8_t phy_addr;
+    int8_t mdc_pin;
+    int8_t mdio_pin;
+    int8_t reset_pin;
+    int8_t pwr_en_pin;
+    uint8_t pwr_en_level;
+    uint8_t reserved;
+    uint16_t pwr_en_delay_ms;
+    uint16_t id1;
+    uint16_t id2;
+};
 
-    WiFi.onEvent(onEthEvent);
-    setupEthernet();
+static bool pbEthLoadWinner(PbEthWinnerRecord &rec) {
+    Preferences prefs;
+    if (!prefs.begin("pb_eth", false)) {
+        return false;
+    }
+    bool ok = false;
+    if (prefs.getBytesLength("winner") == sizeof(rec)) {
+        ok = (prefs.getBytes("winner", &rec, sizeof(rec)) == sizeof(rec));
+    }
+    prefs.end();
+    return ok &&
+           rec.version == PB_ETH_WINNER_VERSION &&
+           rec.phy_type < ETH_PHY_MAX &&
+           rec.clk_mode <= ETH_CLOCK_GPIO17_OUT &&
+           rec.phy_addr < 32 &&
+           rec.mdc_pin >= 0 &&
+           rec.mdio_pin >= 0 &&
+           pbMdioPhyIdValid(rec.id1, rec.id2);
 }
 
-void loop() {
-    if (!eth_connected || !ETH.linkUp()) {
-        if (eth_connected && !ETH.linkUp()) {
-            Serial.println("❌ Ethernet link down!");
-            eth_connected = false;
-        }
-        blinkLED(1, 500);
-        delay(1000);
+static void pbEthStoreWinner(const PbEthProfile &p, uint16_t id1, uint16_t id2) {
+    // Without a PHY ID there is nothing to validate the record against on the next boot.
+    if (!pbMdioPhyIdValid(id1, id2)) {
         return;
     }
 
-    // Перевіряємо чи час відправляти heartbeat
-    const unsigned long currentTime = millis();
-    if (lastHeartbeatTime == 0 || (currentTime - lastHeartbeatTime) >= HEARTBEAT_INTERVAL_MS) {
-        Serial.println();
-        Serial.println("📤 Відправка heartbeat...");
+    PbEthWinnerRecord rec = {};
+    rec.version = PB_ETH_WINNER_VERSION;
+    rec.phy_type = static_cast<uint8_t>(p.phy_type);
+    rec.clk_mode = static_cast<uint8_t>(p.clk_mode);
+    rec.phy_addr = p.phy_addr;
+    rec.mdc_pin = static_cast<int8_t>(p.mdc_pin);
+    rec.mdio_pin = static_cast<int8_t>(p.mdio_pin);
+    rec.reset_pin = static_cast<int8_t>(p.reset_pin);
+    rec.pwr_en_pin = static_cast<int8_t>(p.pwr_en_pin);
+    rec.pwr_en_level = static_cast<uint8_t>(p.pwr_en_level);
+    rec.pwr_en_delay_ms = static_cast<uint16_t>(p.pwr_en_delay_ms);
+    rec.id1 = id1;
+    rec.id2 = id2;
+
+    // Skip the flash write when nothing changed (the common case after every blackout).
+    PbEthWinnerRecord old = {};
+    if (pbEthLoadWinner(old) && memcmp(&old, &rec, sizeof(rec)) == 0) {
+        return;
+    }
 
-        if (sendHeartbeat()) {
-            Serial.println("✅ Heartbeat успішно!");
-            blinkLED(1, 100);
-        } else {
-            Serial.println("❌ Помилка heartbeat!");
-            blinkLED(3, 200);
-        }
+    Preferences prefs;
+    if (!prefs.begin("pb_eth", false)) {
+        return;
+    }
+    prefs.putBytes("winner", &rec, sizeof(rec));
+    prefs.end();
+}
 
-        lastHeartbeatTime = currentTime;
-        Serial.printf("⏰ Наступний через %d сек\n", HEARTBEAT_INTERVAL_MS / 1000);
+static void pbEthEraseWinner() {
+    Preferences prefs;
+    if (!prefs.begin("pb_eth", false)) {
+        return;
     }
+    prefs.remove("winner");
+    prefs.end();
+}
 
-    delay(100);
+// Where to start in the static list: NVS-remembered profile, then the first profile of the detected
+// (or PB_ETH_AUTOCONFIG_PREFERRED_PHY) type, then 0.
+static size_t pbEthStaticStartIndex(int &preferred, eth_phy_type_t detected_type) {
+    const size_t profile_count = sizeof(PB_ETH_PROFILES) / sizeof(PB_ETH_PROFILES[0]);
+    preferred = pbEthLoadPreferredProfileIndex();
+    if (preferred < 0 || preferred >= static_cast<int>(profile_count)) {
+        preferred = -1;
+    }
+    if (preferred >= 0 && (detected_type == ETH_PHY_MAX || PB_ETH_PROFILES[preferred].phy_type == detected_type)) {
+        return static_cast<size_t>(preferred);
+    }
+    const eth_phy_type_t want = (detected_type != ETH_PHY_MAX) ? detected_type
+                                                               : static_cast<eth_phy_type_t>(PB_ETH_AUTOCONFIG_PREFERRED_PHY);
+    if (want != ETH_PHY_MAX) {
+        const int by_type = pbEthFindFirstProfileByPhyType(want);
+        if (by_type >= 0) {
+            return static_cast<size_t>(by_type);
+        }
+    }
+    return 0;
 }
 
-void onEthEvent(WiFiEvent_t event) {
-    switch (event) {
-        case ARDUINO_EVENT_ETH_START:
-            ETH.setHostname(SENSOR_UUID);
-            Serial.println("🔌 ETH start");
-            break;
+// PWR_EN level (+ power-up delay) and RESET de-asserted, as the profile expects before any MDIO access.
+static void pbEthApplyProfilePins(const PbEthProfile &p) {
+    if (p.pwr_en_pin >= 0) {
+        pinMode(p.pwr_en_pin, OUTPUT);
+        digitalWrite(p.pwr_en_pin, p.pwr_en_level ? HIGH : LOW);
+        if (p.pwr_en_delay_ms > 0) {
+            delay(p.pwr_en_delay_ms);
+        }
+    }
 
-        case ARDUINO_EVENT_ETH_CONNECTED:
-            Serial.println("🔗 ETH link up");
-            break;
+    // If we have a dedicated RESET pin in this profile, make sure it's not stuck low
+    // (most PHY reset pins are active-low).
+    if (p.reset_pin >= 0 && p.reset_pin != p.pwr_en_pin) {
+        pinMode(p.reset_pin, OUTPUT);
+        digitalWrite(p.reset_pin, HIGH);
+        delay(10);
+    }
+}
 
-        case ARDUINO_EVENT_ETH_GOT_IP:
-            Serial.println("✅ ETH got IP");
-            Serial.print("🌐 IP адреса:  ");
-            Serial.println(ETH.localIP());
-            Serial.print("🌐 Gateway:    ");
-            Serial.println(ETH.gatewayIP());
-            Serial.print("🌐 DNS:        ");
-            Serial.println(ETH.dnsIP());
-            Serial.print("🌐 Subnet:     ");
-            Serial.println(ETH.subnetMask());
-            Serial.print("📡 MAC:        ");
-            Serial.println(ETH.macAddress());
-            eth_connected = true;
-            break;
+// Tries up to `budget` profiles starting at `start`, all in this boot. Returns the index of the
+// first profile whose driver install succeeded (its PWR_EN/RESET levels are left applied), or -1.
+// id1/id2 — PHY ID read for that profile before the install (0 if the read failed).
+// Profiles of another PHY type than `only_type` (ETH_PHY_MAX = any), or than the type their own
+// PHY ID decodes to, are pruned without a driver install.
+static int pbEthProbeProfiles(const PbEthProfile *profiles,
+                              size_t profile_count,
+                              size_t start,
+                              size_t budget,
+                              eth_phy_type_t only_type,
+                              size_t &tried,
+                              uint16_t &id1,
+                              uint16_t &id2) {
+    PbEthProbeOrder order(profile_count, start, budget);
+    const size_t already_tried = profile_count - order.budget();
+    unsigned pruned = 0;
+    size_t idx = 0;
+    while (order.next(idx)) {
+        const PbEthProfile &p = profiles[idx];
+        if (only_type != ETH_PHY_MAX && p.phy_type != only_type) {
+            pruned++;
+            continue;
+        }
+        Serial.printf("🔧 ETH autoconfig: attempt %u/%u, profile %u: %s\n",
+                      static_cast<unsigned>(already_tried + order.tried()),
+                      static_cast<unsigned>(profile_count),
+                      static_cast<unsigned>(idx + 1),
+                      p.label);
+        Serial.printf("   PHY_TYPE=%s, PHY_ADDR=%u, RESET=%d\n", pbEthPhyTypeStr(p.phy_type), p.phy_addr, p.reset_pin);
+        Serial.printf("   MDC=%d, MDIO=%d\n", p.mdc_pin, p.mdio_pin);
+        Serial.printf("   CLK_MODE=%s (%d)\n", pbEthClockModeStr(p.clk_mode), static_cast<int>(p.clk_mode));
+        Serial.printf("   PWR_EN=%d (level=%d, delay=%dms)\n", p.pwr_en_pin, p.pwr_en_level, p.pwr_en_delay_ms);
+
+        const unsigned long probe_start = millis();
+        pbEthApplyProfilePins(p);
+
+        // Diagnostics: read raw PHY ID registers (2/3) before the driver install. This helps distinguish:
+        // - wrong PHY address (often 0xFFFF/0xFFFF)
+        // - wrong MDC/MDIO pins (read fails)
+        // - real PHY present (valid OUI/model)
+        id1 = 0;
+        id2 = 0;
+        const bool id_ok = pbEthMdioReadPhyIdRaw(p.clk_mode, p.mdc_pin, p.mdio_pin, p.phy_addr, id1, id2);
+        if (id_ok) {
+            Serial.printf("   PHY_ID=0x%04X/0x%04X\n", static_cast<unsigned>(id1), static_cast<unsigned>(id2));
+        } else {
+            Serial.println("   PHY_ID=<read failed>");
+            id1 = 0;
+            id2 = 0;
+        }
 
-        case ARDUINO_EVENT_ETH_DISCONNECTED:
-            Serial.println("❌ ETH disconnected");
-            eth_connected = false;
-            break;
+        const eth_phy_type_t id_type = id_ok ? pbEthPhyTypeFromId(id1, id2) : ETH_PHY_MAX;
+        if (id_type != ETH_PHY_MAX && id_type != p.phy_type) {
+            Serial.printf("   ⏭ PHY_ID означає %s, а профіль для %s — пропускаю\n",
+                          pbEthPhyTypeStr(id_type),
+                          pbEthPhyTypeStr(p.phy_type));
+            pruned++;
+            continue;
+        }
 
-        case ARDUINO_EVENT_ETH_STOP:
-            Serial.println("🛑 ETH stopped");
-            eth_connected = false;
-            break;
+        const bool ok = pbEthProbeProfile(p);
+        const unsigned long probe_ms = millis() - probe_start;
+        pbEthBoot.probe(static_cast<uint32_t>(probe_ms));
+        Serial.printf("   ⏱ probe: %s за %lu ms (від boot: %lu ms)\n",
+                      ok ? "PHY відповів" : "PHY не відповідає",
+                      probe_ms,
+                      static_cast<unsigned long>(millis()));
+        if (ok) {
+            tried = order.tried();
+            if (pruned > 0) {
+                Serial.printf("   (відсіяно за типом PHY: %u)\n", pruned);
+            }
+            return static_cast<int>(idx);
+        }
+    }
+    tried = order.tried();
+    if (pruned > 0) {
+        Serial.printf("   (відсіяно за типом PHY: %u)\n", pruned);
+    }
+    return -1;
+}
 
-        default:
-            break;
+// PHY ID over bit-banged MDIO on the profile's own pins: microseconds with GPIO0_IN, one short
+// EMAC clock bring-up otherwise. No driver install.
+static bool pbEthReadPhyIdFast(const PbEthProfile &p, uint16_t &id1, uint16_t &id2) {
+    if (pbEthIsClockPin(p.clk_mode, p.mdc_pin) || pbEthIsClockPin(p.clk_mode, p.mdio_pin)) {
+        return false;
+    }
+    esp_eth_mac_t *clock = pbEthClockStart(p.clk_mode);
+    if (p.clk_mode != ETH_CLOCK_GPIO0_IN && !clock) {
+        return false;
     }
+
+    pbEthMdioPinsAcquire(p.mdc_pin, p.mdio_pin);
+    PbMdioGpio io = {p.mdc_pin, p.mdio_pin, false};
+    PbMdioBitBang<PbMdioGpio> bus(io);
+    const bool ok = bus.idleHigh() &&
+                    bus.read(p.phy_addr, 2, id1) == PbMdioRead::Ok &&
+                    bus.read(p.phy_addr, 3, id2) == PbMdioRead::Ok;
+    pbEthMdioPinsRelease(p.mdc_pin, p.mdio_pin);
+
+    pbEthClockStop(clock);
+    return ok;
 }
 
-void setupEthernet() {
-    Serial.println("🔌 Ініціалізація Ethernet PHY (RMII)...");
+// Boot straight into the configuration remembered in NVS, if the PHY on its pins still reports
+// the stored ID. false — no record or it no longer fits (the full search runs next).
+static bool pbEthBeginFromWinner() {
+    PbEthWinnerRecord rec = {};
+    if (!pbEthLoadWinner(rec)) {
+        return false;
+    }
 
-    eth_connected = false;
+    static char label[96];
+    snprintf(label,
+             sizeof(label),
+             "nvs-mdc%d-mdio%d-addr%u-%s-rst%d-pwr%d_%d_%d",
+             rec.mdc_pin,
+             rec.mdio_pin,
+             static_cast<unsigned>(rec.phy_addr),
+             pbEthClockModeStr(static_cast<eth_clock_mode_t>(rec.clk_mode)),
+             rec.reset_pin,
+             rec.pwr_en_pin,
+             rec.pwr_en_level,
+             rec.pwr_en_delay_ms);
+    const PbEthProfile p = {
+        .label = label,
+        .phy_addr = rec.phy_addr,
+        .reset_pin = rec.reset_pin,
+        .mdc_pin = rec.mdc_pin,
+        .mdio_pin = rec.mdio_pin,
+        .phy_type = static_cast<eth_phy_type_t>(rec.phy_type),
+        .clk_mode = static_cast<eth_clock_mode_t>(rec.clk_mode),
+        .pwr_en_pin = rec.pwr_en_pin,
+        .pwr_en_level = rec.pwr_en_level,
+        .pwr_en_delay_ms = rec.pwr_en_delay_ms,
+    };
 
-#if PB_ETH_AUTOCONFIG
-    // Many ESP32-ETH01 clones require GPIO16 to be driven HIGH to power up (or de-assert reset for) the PHY.
-    // Factory firmwares often do this very early. Keep it stable across autoconfig reboots.
-    pinMode(16, OUTPUT);
-    digitalWrite(16, HIGH);
-    delay(10);
+    const unsigned long check_start = millis();
+    pbEthApplyProfilePins(p);
+    uint16_t id1 = 0;
+    uint16_t id2 = 0;
+    const bool id_ok = pbEthReadPhyIdFast(p, id1, id2);
+    const unsigned long check_ms = millis() - check_start;
+    if (!id_ok || id1 != rec.id1 || id2 != rec.id2) {
+        Serial.printf("🔎 ETH: профіль з NVS (%s) не підтверджено: PHY_ID=0x%04X/0x%04X, очікував 0x%04X/0x%04X (%lu ms)\n",
+                      label,
+                      static_cast<unsigned>(id1),
+                      static_cast<unsigned>(id2),
+                      static_cast<unsigned>(rec.id1),
+                      static_cast<unsigned>(rec.id2),
+                      check_ms);
+        return false;
+    }
 
-    // Some vendor firmwares configure these as pulled-up inputs ("CFG" straps / options).
-    // This is harmless for typical boards and avoids floating pins on some revisions.
-    pinMode(2, INPUT_PULLUP);
-    pinMode(32, INPUT_PULLUP);
+    Serial.printf("⚡ ETH: профіль з NVS (%s, %s), PHY_ID=0x%04X/0x%04X збігся за %lu ms\n",
+                  label,
+                  pbEthPhyTypeStr(p.phy_type),
+                  static_cast<unsigned>(id1),
+                  static_cast<unsigned>(id2),
+                  check_ms);
+    if (!ETH.begin(p.phy_addr, p.reset_pin, p.mdc_pin, p.mdio_pin, p.phy_type, p.clk_mode)) {
+        // ETH.begin() leaks the driver on failure: forget the record and search from a clean boot.
+        Serial.println("❌ ETH.begin() не вдалося для профілю з NVS, стираю запис і перезавантажуюсь...");
+        pbEthEraseWinner();
+        pb_eth_magic = 0;
+        delay(1500);
+        Serial.flush();
+        ESP.restart();
+        return false;
+    }
+    pbEthProfileLabel = label;
+    return true;
+}
 
+// Full autoconfig search: MDIO detect (once per RTC session), then every candidate profile in this boot.
+// false — no working profile (or ETH.begin() failed and a reboot is not worth it).
+static bool pbEthAutoconfigSearch() {
     const PbEthProfile *profiles = PB_ETH_PROFILES;
     size_t profile_count = sizeof(PB_ETH_PROFILES) / sizeof(PB_ETH_PROFILES[0]);
 
@@ -728,6 +1091,7 @@ void setupEthernet() {
                                    pb_eth_profileset_ver != PB_ETH_PROFILESET_VERSION ||
                                    pb_eth_detect_done > 1 ||
                                    pb_eth_detect_valid > 1 ||
+                                   pb_eth_detect_phy > ETH_PHY_MAX ||
                                    pb_eth_profile_source > 1);
     if (session_mismatch) {
         pb_eth_magic = PB_ETH_AUTOCONFIG_MAGIC;
@@ -739,6 +1103,7 @@ void setupEthernet() {
         pb_eth_detect_mdc = -1;
         pb_eth_detect_mdio = -1;
         pb_eth_detect_addr = 0xFF;
+        pb_eth_detect_phy = ETH_PHY_MAX;
         pb_eth_profile_source = 0;
     }
 
@@ -753,10 +1118,12 @@ void setupEthernet() {
             pb_eth_detect_mdc = static_cast<int8_t>(det.mdc_pin);
             pb_eth_detect_mdio = static_cast<int8_t>(det.mdio_pin);
             pb_eth_detect_addr = det.phy_addr;
+            pb_eth_detect_phy = static_cast<uint8_t>(pbEthPhyTypeFromId(det.id1, det.id2));
             pb_eth_profile_source = 1;
-            Serial.printf("🔎 MDIO detect: PHY found (id=0x%04X/0x%04X) @addr=%u using mdc=%d mdio=%d clock=%s\n",
+            Serial.printf("🔎 MDIO detect: PHY found (id=0x%04X/0x%04X -> %s) @addr=%u using mdc=%d mdio=%d clock=%s\n",
                           static_cast<unsigned>(det.id1),
                           static_cast<unsigned>(det.id2),
+                          pbPhyModelName(pbPhyModelFromId(det.id1, det.id2)),
                           static_cast<unsigned>(det.phy_addr),
                           det.mdc_pin,
                           det.mdio_pin,
@@ -769,7 +1136,9 @@ void setupEthernet() {
     }
 
     if (pb_eth_profile_source == 1 && pb_eth_detect_valid && pb_eth_detect_mdc >= 0 && pb_eth_detect_mdio >= 0 && pb_eth_detect_addr != 0xFF) {
-        pbEthBuildDynamicProfiles(pb_eth_detect_mdc, pb_eth_detect_mdio, pb_eth_detect_addr);
+        const eth_phy_type_t det_type = (pb_eth_detect_phy != ETH_PHY_MAX) ? static_cast<eth_phy_type_t>(pb_eth_detect_phy)
+                                                                           : ETH_PHY_LAN8720;
+        pbEthBuildDynamicProfiles(pb_eth_detect_mdc, pb_eth_detect_mdio, pb_eth_detect_addr, det_type);
         if (pb_eth_dynamic_count > 0) {
             profiles = pb_eth_dynamic_profiles;
             profile_count = pb_eth_dynamic_count;
@@ -779,126 +1148,208 @@ void setupEthernet() {
         }
     }
 
+    // A decoded PHY ID prunes every profile of another PHY type (static list included).
+    const eth_phy_type_t detected_type = static_cast<eth_phy_type_t>(pb_eth_detect_phy);
     int preferred = -1;
-    int preferred_by_type = -1;
-    if (pb_eth_profile_source == 0) {
-        preferred = pbEthLoadPreferredProfileIndex();
-        if (preferred < 0 || preferred >= static_cast<int>(profile_count)) {
-            preferred = -1;
-        }
-
-        if (PB_ETH_AUTOCONFIG_PREFERRED_PHY != ETH_PHY_MAX) {
-            preferred_by_type = pbEthFindFirstProfileByPhyType(static_cast<eth_phy_type_t>(PB_ETH_AUTOCONFIG_PREFERRED_PHY));
-        }
-    }
+    const size_t static_start = pbEthStaticStartIndex(preferred, detected_type);
 
     const bool state_invalid = (pb_eth_next_profile >= profile_count || pb_eth_tried_count >= profile_count);
     if (session_mismatch || state_invalid) {
         pb_eth_tried_count = 0;
-        if (pb_eth_profile_source == 0) {
-            if (preferred >= 0) {
-                pb_eth_next_profile = static_cast<uint8_t>(preferred);
-            } else if (preferred_by_type >= 0) {
-                pb_eth_next_profile = static_cast<uint8_t>(preferred_by_type);
-            } else {
-                pb_eth_next_profile = 0;
-            }
-        } else {
-            pb_eth_next_profile = 0;
-        }
+        pb_eth_next_profile = (pb_eth_profile_source == 0) ? static_cast<uint8_t>(static_start) : 0;
     }
 
-    const uint8_t idx = pb_eth_next_profile;
-    const PbEthProfile &p = profiles[idx];
+    // Усі кандидати пробуємо в цьому boot; RTC-стан потрібен лише для last-resort reboot нижче.
+    size_t tried = 0;
+    uint16_t id1 = 0;
+    uint16_t id2 = 0;
+    int found = pbEthProbeProfiles(profiles, profile_count, pb_eth_next_profile, profile_count - pb_eth_tried_count, detected_type, tried, id1, id2);
+    size_t tried_total = pb_eth_tried_count + tried;
 
-    const unsigned attempt_no = static_cast<unsigned>(pb_eth_tried_count) + 1;
-    Serial.printf("🔧 ETH autoconfig: attempt %u/%u, profile %u: %s\n",
-                  attempt_no,
-                  static_cast<unsigned>(profile_count),
-                  static_cast<unsigned>(idx + 1),
-                  p.label);
-    Serial.printf("   PHY_TYPE=%s, PHY_ADDR=%u, RESET=%d\n", pbEthPhyTypeStr(p.phy_type), p.phy_addr, p.reset_pin);
-    Serial.printf("   MDC=%d, MDIO=%d\n", p.mdc_pin, p.mdio_pin);
-    Serial.printf("   CLK_MODE=%s (%d)\n", pbEthClockModeStr(p.clk_mode), static_cast<int>(p.clk_mode));
-    Serial.printf("   PWR_EN=%d (level=%d, delay=%dms)\n", p.pwr_en_pin, p.pwr_en_level, p.pwr_en_delay_ms);
-
-    if (p.pwr_en_pin >= 0) {
-        pinMode(p.pwr_en_pin, OUTPUT);
-        digitalWrite(p.pwr_en_pin, p.pwr_en_level ? HIGH : LOW);
-        if (p.pwr_en_delay_ms > 0) {
-            delay(p.pwr_en_delay_ms);
-        }
+    // If we were using detected/dynamic profiles and still failed, fall back to the generic list.
+    if (found < 0 && pb_eth_profile_source == 1) {
+        Serial.println("↻ Fallback: переключаюсь на загальний список профілів (без перезавантаження)...");
+        pb_eth_profile_source = 0;
+        pb_eth_detect_valid = 0;
+        profiles = PB_ETH_PROFILES;
+        profile_count = sizeof(PB_ETH_PROFILES) / sizeof(PB_ETH_PROFILES[0]);
+        found = pbEthProbeProfiles(profiles, profile_count, static_start, profile_count, detected_type, tried, id1, id2);
+        tried_total = tried;
     }
 
-    // Diagnostics: read raw PHY ID registers (2/3) before ETH.begin(). This helps distinguish:
-    // - wrong PHY address (often 0xFFFF/0xFFFF)
-    // - wrong MDC/MDIO pins (read fails)
-    // - real PHY present (valid OUI/model)
-    {
-        // If we have a dedicated RESET pin in this profile, make sure it's not stuck low
-        // before reading PHY IDs (most PHY reset pins are active-low).
-        if (p.reset_pin >= 0 && p.reset_pin != p.pwr_en_pin) {
-            pinMode(p.reset_pin, OUTPUT);
-            digitalWrite(p.reset_pin, HIGH);
-            delay(10);
-        }
-
-        uint16_t id1 = 0;
-        uint16_t id2 = 0;
-        const bool id_ok = pbEthMdioReadPhyIdRaw(p.clk_mode, p.mdc_pin, p.mdio_pin, p.phy_addr, id1, id2);
-        if (id_ok) {
-            Serial.printf("   PHY_ID=0x%04X/0x%04X\n", static_cast<unsigned>(id1), static_cast<unsigned>(id2));
-        } else {
-            Serial.println("   PHY_ID=<read failed>");
-        }
+    if (found < 0) {
+        Serial.printf("❌ ETH autoconfig: жоден профіль не підійшов (%u проб за %lu ms).\n",
+                      static_cast<unsigned>(pbEthBoot.probes()),
+                      static_cast<unsigned long>(pbEthBoot.probeMs()));
+        Serial.println("   Найчастіші причини:");
+        Serial.println("   - неправильний RMII clock mode (IN/OUT) або pin");
+        Serial.println("   - інший PHY type (LAN8720 vs IP101/RTL8201)");
+        Serial.println("   - PHY не має живлення/завис у reset");
+        Serial.println("   Діагностика (для ESP32-ETH01 клонів):");
+        Serial.println("   - встав кабель у свіч: має світитись LINK/ACT на RJ45");
+        Serial.println("   - мультиметром поміряй IO16->GND під час старту (має бути ~3.3V, якщо це PWR_EN)");
+        Serial.println("   - перевір, чи є на платі 50MHz oscillator і чи він не припаяний 'навпаки' (є такі заводські дефекти)");
+        pb_eth_next_profile = 0;
+        pb_eth_tried_count = 0;
+        return false;
     }
 
-    if (!ETH.begin(p.phy_addr, p.reset_pin, p.mdc_pin, p.mdio_pin, p.phy_type, p.clk_mode)) {
-        Serial.println("❌ ETH.begin() не вдалося (PHY не відповідає).");
+    const uint8_t idx = static_cast<uint8_t>(found);
+    const PbEthProfile &p = profiles[idx];
+    pbEthProfileLabel = p.label;
+    Serial.printf("✅ ETH autoconfig: профіль %u/%u (%s), перебір: %u проб за %lu ms\n",
+                  static_cast<unsigned>(idx + 1),
+                  static_cast<unsigned>(profile_count),
+                  p.label,
+                  static_cast<unsigned>(pbEthBoot.probes()),
+                  static_cast<unsigned long>(pbEthBoot.probeMs()));
 
-        pb_eth_tried_count++;
-        pb_eth_next_profile = static_cast<uint8_t>((idx + 1) % profile_count);
+    if (!ETH.begin(p.phy_addr, p.reset_pin, p.mdc_pin, p.mdio_pin, p.phy_type, p.clk_mode)) {
+        Serial.println("❌ ETH.begin() не вдалося після успішного probe.");
 
-        if (pb_eth_tried_count >= profile_count) {
-            Serial.println("❌ ETH autoconfig: жоден профіль не підійшов.");
-            Serial.println("   Найчастіші причини:");
-            Serial.println("   - неправильний RMII clock mode (IN/OUT) або pin");
-            Serial.println("   - інший PHY type (LAN8720 vs IP101/RTL8201)");
-            Serial.println("   - PHY не має живлення/завис у reset");
-            Serial.println("   Діагностика (для ESP32-ETH01 клонів):");
-            Serial.println("   - встав кабель у свіч: має світитись LINK/ACT на RJ45");
-            Serial.println("   - мультиметром поміряй IO16->GND під час старту (має бути ~3.3V, якщо це PWR_EN)");
-            Serial.println("   - перевір, чи є на платі 50MHz oscillator і чи він не припаяний 'навпаки' (є такі заводські дефекти)");
-
-            // If we were using detected/dynamic profiles and still failed, fall back once to the generic list.
-            if (pb_eth_profile_source == 1) {
-                Serial.println("↻ Fallback: переключаюсь на загальний список профілів і перезавантажуюсь...");
-                pb_eth_profile_source = 0;
-                pb_eth_detect_valid = 0;
-                pb_eth_next_profile = 0;
-                pb_eth_tried_count = 0;
-                delay(1500);
-                Serial.flush();
-                ESP.restart();
-            }
-            return;
+        // Last resort: ETH.begin() leaks the driver on failure, so the rest of the list
+        // is continued after a reboot (RTC_NOINIT keeps the position).
+        if (tried_total >= profile_count) {
+            pb_eth_next_profile = 0;
+            pb_eth_tried_count = 0;
+            return false;
         }
-
+        pb_eth_next_profile = static_cast<uint8_t>((idx + 1) % profile_count);
+        pb_eth_tried_count = static_cast<uint8_t>(tried_total);
         Serial.printf("↻ ETH autoconfig: reboot для наступного профілю (%u/%u)...\n",
                       static_cast<unsigned>(pb_eth_next_profile + 1),
                       static_cast<unsigned>(profile_count));
         delay(1500);
         Serial.flush();
         ESP.restart();
-        return;
+        return false;
     }
 
     // We got a working low-level init; remember this profile for next boots.
     if (pb_eth_profile_source == 0 && preferred != static_cast<int>(idx)) {
         pbEthStorePreferredProfileIndex(idx);
     }
+    pbEthStoreWinner(p, id1, id2);
     pb_eth_tried_count = 0;
     pb_eth_next_profile = idx;
+    return true;
+}
+#endif
+
+typedef PbLwipDnsNet PbBoardDnsNet;
+typedef PbLwipNet PbBoardNet;
+typedef PbLwipUdpListener PbBoardUdpListener;
+
+#include "pb_sensor.h"
+
+void onEthEvent(WiFiEvent_t event);
+void setupEthernet();
+
+void pbBoardBanner() {
+    Serial.println("  PowerBot ESP32 Ethernet Heartbeat Sensor");
+    Serial.print("  Board:    ");
+    Serial.println(PB_BOARD_NAME);
+}
+
+void pbBoardSetupEthernet() {
+    WiFi.onEvent(onEthEvent);
+    setupEthernet();
+}
+
+// IP приходить подією GOT_IP; тут — лише падіння лінку між подіями.
+bool pbBoardNetReady() {
+    if (pbEthUp() && !ETH.linkUp()) {
+        PB_LOGE(LinkDown);
+        xEventGroupClearBits(pbNetEvents, kPbEvEthUp);
+    }
+    return pbEthUp();
+}
+
+bool pbBoardLinkUp() {
+    return ETH.linkUp();
+}
+
+IPAddress pbBoardLocalIp() {
+    return ETH.localIP();
+}
+
+IPAddress pbBoardGatewayIp() {
+    return ETH.gatewayIP();
+}
+
+// Boot -> перший доставлений heartbeat: лог один раз.
+void pbBoardBeatDelivered() {
+    if (pbEthBoot.markFirstBeat(millis())) {
+        PB_LOGI(HbBootToFirst, pbEthBoot.firstBeatMs(), pbEthProfileLabel, pbEthBoot.probes(),
+                pbEthBoot.probeMs(), pbEthBoot.linkUpMs(), pbEthBoot.gotIpMs());
+    }
+}
+
+void onEthEvent(WiFiEvent_t event) {
+    switch (event) {
+        case ARDUINO_EVENT_ETH_START:
+            ETH.setHostname(SENSOR_UUID);
+            Serial.println("🔌 ETH start");
+            break;
+
+        case ARDUINO_EVENT_ETH_CONNECTED:
+            pbEthBoot.markLinkUp(millis());
+            Serial.println("🔗 ETH link up");
+            break;
+
+        case ARDUINO_EVENT_ETH_GOT_IP:
+            pbEthBoot.markGotIp(millis());
+            Serial.println("✅ ETH got IP");
+            Serial.print("🌐 IP адреса:  ");
+            Serial.println(ETH.localIP());
+            Serial.print("🌐 Gateway:    ");
+            Serial.println(ETH.gatewayIP());
+            Serial.print("🌐 DNS:        ");
+            Serial.println(ETH.dnsIP());
+            Serial.print("🌐 Subnet:     ");
+            Serial.println(ETH.subnetMask());
+            Serial.print("📡 MAC:        ");
+            Serial.println(ETH.macAddress());
+            xEventGroupSetBits(pbNetEvents, kPbEvEthUp);
+            break;
+
+        case ARDUINO_EVENT_ETH_DISCONNECTED:
+            Serial.println("❌ ETH disconnected");
+            xEventGroupClearBits(pbNetEvents, kPbEvEthUp);
+            break;
+
+        case ARDUINO_EVENT_ETH_STOP:
+            Serial.println("🛑 ETH stopped");
+            xEventGroupClearBits(pbNetEvents, kPbEvEthUp);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void setupEthernet() {
+    Serial.println("🔌 Ініціалізація Ethernet PHY (RMII)...");
+
+    xEventGroupClearBits(pbNetEvents, kPbEvEthUp);
+
+#if PB_ETH_AUTOCONFIG
+    // Many ESP32-ETH01 clones require GPIO16 to be driven HIGH to power up (or de-assert reset for) the PHY.
+    // Factory firmwares often do this very early. Keep it stable across autoconfig reboots.
+    pinMode(16, OUTPUT);
+    digitalWrite(16, HIGH);
+    delay(10);
+
+    // Some vendor firmwares configure these as pulled-up inputs ("CFG" straps / options).
+    // This is harmless for typical boards and avoids floating pins on some revisions.
+    pinMode(2, INPUT_PULLUP);
+    pinMode(32, INPUT_PULLUP);
+
+    // The winner stored in NVS goes first: a power cycle wipes RTC state, and the first
+    // heartbeat after power returns is the restoration signal, so no detect/search if it still fits.
+    if (!pbEthBeginFromWinner() && !pbEthAutoconfigSearch()) {
+        return;
+    }
 #else
     Serial.printf("   PHY_ADDR=%d, RESET=%d\n", PB_ETH_PHY_ADDR, PB_ETH_PHY_POWER);
     Serial.printf("   MDC=%d, MDIO=%d\n", PB_ETH_PHY_MDC, PB_ETH_PHY_MDIO);
@@ -926,12 +1377,8 @@ void setupEthernet() {
 #endif
 
     Serial.println("📡 Очікування DHCP...");
-    const unsigned long waitStart = millis();
-    while (!eth_connected && (millis() - waitStart) < 15000) {
-        delay(100);
-    }
-
-    if (!eth_connected) {
+    const EventBits_t up = xEventGroupWaitBits(pbNetEvents, kPbEvEthUp, pdFALSE, pdTRUE, pdMS_TO_TICKS(15000));
+    if ((up & kPbEvEthUp) == 0) {
         Serial.println("❌ DHCP не вдалося отримати за 15 секунд");
         return;
     }
@@ -940,103 +1387,3 @@ void setupEthernet() {
     Serial.println("✅ Ethernet готовий");
     Serial.println("════════════════════════════════════");
 }
-
-bool sendHeartbeat() {
-    Serial.printf("🌐 Підключення до %s:%d...\n", SERVER_HOST, SERVER_PORT);
-    Serial.printf("   Local IP: %s\n", ETH.localIP().toString().c_str());
-    Serial.printf("   Gateway:  %s\n", ETH.gatewayIP().toString().c_str());
-    Serial.printf("   Link:     %s\n", ETH.linkUp() ? "ON" : "OFF");
-
-    ethClient.setTimeout(HTTP_TIMEOUT_MS);
-
-    Serial.println("   Спроба connect()...");
-    const bool connected = ethClient.connect(SERVER_HOST, SERVER_PORT);
-    Serial.printf("   Connect result: %d\n", connected ? 1 : 0);
-
-    if (!connected) {
-        Serial.println("❌ Не вдалося підключитися до сервера!");
-        Serial.println("   Можливі причини:");
-        Serial.println("   - Немає маршруту до інтернету");
-        Serial.println("   - Firewall блокує з'єднання");
-        Serial.println("   - Сервер недоступний");
-        return false;
-    }
-
-    // Формуємо JSON
-    JsonDocument doc;
-    doc["api_key"] = API_KEY;
-    doc["building_id"] = BUILDING_ID;
-    doc["section_id"] = SECTION_ID;
-    doc["sensor_uuid"] = SENSOR_UUID;
-#if defined(SENSOR_COMMENT)
-    if (String(SENSOR_COMMENT).length() > 0) {
-        doc["comment"] = SENSOR_COMMENT;
-    }
-#endif
-
-    String payload;
-    serializeJson(doc, payload);
-
-    Serial.printf("📦 Payload: %s\n", payload.c_str());
-
-    // HTTP POST запит
-    ethClient.println("POST /api/v1/heartbeat HTTP/1.1");
-    ethClient.print("Host: ");
-    ethClient.println(SERVER_HOST);
-    ethClient.println("Content-Type: application/json");
-    ethClient.println("Connection: close");
-    ethClient.print("Content-Length: ");
-    ethClient.println(payload.length());
-    ethClient.println();
-    ethClient.println(payload);
-
-    // Чекаємо відповідь
-    const unsigned long timeout = millis();
-    while (!ethClient.available()) {
-        if (millis() - timeout > HTTP_TIMEOUT_MS) {
-            Serial.println("❌ Таймаут відповіді!");
-            ethClient.stop();
-            return false;
-        }
-        delay(10);
-    }
-
-    // Читаємо статус
-    const String statusLine = ethClient.readStringUntil('\n');
-    Serial.printf("📨 %s\n", statusLine.c_str());
-
-    const bool success = statusLine.indexOf(" 200 ") > 0;
-
-    // Пропускаємо заголовки
-    while (ethClient.available()) {
-        const String line = ethClient.readStringUntil('\n');
-        if (line == "\r") {
-            break;
-        }
-    }
-
-    // Читаємо body
-    String body = "";
-    while (ethClient.available()) {
-        body += static_cast<char>(ethClient.read());
-    }
-    if (body.length() > 0) {
-        Serial.printf("📨 Body: %s\n", body.c_str());
-    }
-
-    ethClient.stop();
-    return success;
-}
-
-void blinkLED(int times, int delayMs) {
-#if defined(LED_PIN) && (LED_PIN >= 0)
-    for (int i = 0; i < times; i++) {
-        digitalWrite(LED_PIN, HIGH);
-        delay(delayMs);
-        digitalWrite(LED_PIN, LOW);
-        if (i < times - 1) {
-            delay(delayMs);
-        }
-    }
-#endif
-}
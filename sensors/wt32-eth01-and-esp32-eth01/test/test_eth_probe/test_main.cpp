@@ -0,0 +1,82 @@
+// Host-side tests for include/pb_eth_probe.h (pio test -e native).
+//
+// Covers the in-boot profile iteration (wrap-around, resume budget after a reboot)
+// and the boot timeline that feeds the "boot -> first heartbeat" log line.
+
+#include <unity.h>
+
+#include "pb_eth_probe.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_order_wraps_from_start_and_covers_all_once(void) {
+    PbEthProbeOrder order(5, 3, 5);
+    const size_t expected[] = {3, 4, 0, 1, 2};
+    size_t idx = 99;
+    for (size_t i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(order.next(idx));
+        TEST_ASSERT_EQUAL(expected[i], idx);
+    }
+    TEST_ASSERT_FALSE(order.next(idx));
+    TEST_ASSERT_EQUAL(5, order.tried());
+}
+
+void test_order_resumes_with_remaining_budget(void) {
+    // Після reboot: 2 профілі вже спробувано, продовжуємо з третього.
+    PbEthProbeOrder order(4, 2, 4 - 2);
+    size_t idx = 99;
+    TEST_ASSERT_TRUE(order.next(idx));
+    TEST_ASSERT_EQUAL(2, idx);
+    TEST_ASSERT_TRUE(order.next(idx));
+    TEST_ASSERT_EQUAL(3, idx);
+    TEST_ASSERT_FALSE(order.next(idx));
+}
+
+void test_order_clamps_bad_start_and_budget(void) {
+    PbEthProbeOrder order(3, 7, 10);
+    TEST_ASSERT_EQUAL(3, order.budget());
+    size_t idx = 99;
+    TEST_ASSERT_TRUE(order.next(idx));
+    TEST_ASSERT_EQUAL(0, idx);
+
+    PbEthProbeOrder empty(0, 0, 5);
+    TEST_ASSERT_FALSE(empty.next(idx));
+}
+
+void test_timeline_marks_only_first_event(void) {
+    PbEthBootTimeline t;
+    t.probe(120);
+    t.probe(80);
+    TEST_ASSERT_EQUAL(2, t.probes());
+    TEST_ASSERT_EQUAL(200, t.probeMs());
+
+    TEST_ASSERT_EQUAL(0, t.linkUpMs());
+    t.markLinkUp(2500);
+    t.markLinkUp(9000);  // reconnect не переписує час старту
+    TEST_ASSERT_EQUAL(2500, t.linkUpMs());
+
+    t.markGotIp(3100);
+    TEST_ASSERT_EQUAL(3100, t.gotIpMs());
+
+    TEST_ASSERT_TRUE(t.markFirstBeat(3400));
+    TEST_ASSERT_FALSE(t.markFirstBeat(63400));
+    TEST_ASSERT_EQUAL(3400, t.firstBeatMs());
+}
+
+void test_timeline_zero_ms_still_counts_as_marked(void) {
+    PbEthBootTimeline t;
+    TEST_ASSERT_TRUE(t.markFirstBeat(0));
+    TEST_ASSERT_FALSE(t.markFirstBeat(0));
+    TEST_ASSERT_EQUAL(1, t.firstBeatMs());
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_order_wraps_from_start_and_covers_all_once);
+    RUN_TEST(test_order_resumes_with_remaining_budget);
+    RUN_TEST(test_order_clamps_bad_start_and_budget);
+    RUN_TEST(test_timeline_marks_only_first_event);
+    RUN_TEST(test_timeline_zero_ms_still_counts_as_marked);
+    return UNITY_END();
+}
@@ -0,0 +1,215 @@
+// Host-side tests for include/pb_mdio_bitbang.h (pio test -e native).
+//
+// FakeBus models the wire (pull-up, optional stuck-low) and a clause-22 PHY that
+// samples MDIO on the rising MDC edge and drives TA/data after it, so the tests
+// check the real bit timing and how many MDC clocks a miss costs.
+
+#include <unity.h>
+
+#include "pb_mdio_bitbang.h"
+
+namespace {
+
+class FakeBus {
+public:
+    bool phyPresent = false;
+    uint8_t phyAddr = 0;
+    uint16_t regs[32] = {};
+    bool stuckLow = false;
+    unsigned clocks = 0;
+
+    void mdc(bool high) {
+        if (high && !mdc_) {
+            clocks++;
+            onRisingEdge(line());
+        }
+        mdc_ = high;
+    }
+    void mdioDrive(bool high) {
+        masterDrives_ = true;
+        masterLevel_ = high;
+    }
+    void mdioRelease() { masterDrives_ = false; }
+    bool mdioRead() { return line(); }
+    void settle() {}
+
+private:
+    enum class State { Idle, Header, Turnaround, Data, Release };
+
+    bool line() const {
+        if (stuckLow) {
+            return false;
+        }
+        if (masterDrives_) {
+            return masterLevel_;
+        }
+        if (phyDrives_) {
+            return phyLevel_;
+        }
+        return true;  // pull-up
+    }
+
+    void onRisingEdge(bool bit) {
+        switch (state_) {
+            case State::Idle:
+                if (bit) {
+                    ones_++;
+                } else {
+                    if (ones_ >= 32) {
+                        state_ = State::Header;
+                        header_ = 0;
+                        headerBits_ = 1;
+                    }
+                    ones_ = 0;
+                }
+                break;
+            case State::Header: {
+                header_ = static_cast<uint16_t>((header_ << 1) | (bit ? 1 : 0));
+                if (++headerBits_ < 14) {
+                    break;
+                }
+                const unsigned st = header_ >> 12;
+                const unsigned op = (header_ >> 10) & 0x3;
+                const unsigned pa = (header_ >> 5) & 0x1F;
+                const unsigned ra = header_ & 0x1F;
+                if (phyPresent && st == 1 && op == 2 && pa == phyAddr) {
+                    value_ = regs[ra];
+                    state_ = State::Turnaround;
+                } else {
+                    state_ = State::Idle;
+                }
+                break;
+            }
+            case State::Turnaround:
+                phyDrives_ = true;
+                phyLevel_ = false;
+                dataBit_ = 15;
+                state_ = State::Data;
+                break;
+            case State::Data:
+                phyLevel_ = ((value_ >> dataBit_) & 1) != 0;
+                if (dataBit_-- == 0) {
+                    state_ = State::Release;
+                }
+                break;
+            case State::Release:
+                phyDrives_ = false;
+                state_ = State::Idle;
+                ones_ = 0;
+                break;
+        }
+    }
+
+    bool mdc_ = false;
+    bool masterDrives_ = false;
+    bool masterLevel_ = true;
+    bool phyDrives_ = false;
+    bool phyLevel_ = true;
+    State state_ = State::Idle;
+    unsigned ones_ = 0;
+    uint16_t header_ = 0;
+    unsigned headerBits_ = 0;
+    uint16_t value_ = 0;
+    int dataBit_ = 0;
+};
+
+const uint8_t kAddrs[] = {0, 1, 2, 3};
+
+FakeBus lan8720At(uint8_t addr) {
+    FakeBus bus;
+    bus.phyPresent = true;
+    bus.phyAddr = addr;
+    bus.regs[2] = 0x0007;
+    bus.regs[3] = 0xC0F1;
+    return bus;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_read_hit_returns_register(void) {
+    FakeBus bus = lan8720At(1);
+    PbMdioBitBang<FakeBus> mdio(bus);
+    uint16_t v = 0;
+    TEST_ASSERT_TRUE(mdio.read(1, 3, v) == PbMdioRead::Ok);
+    TEST_ASSERT_EQUAL_HEX16(0xC0F1, v);
+    // 32 преамбула + 14 заголовок + TA + 16 даних + idle.
+    TEST_ASSERT_EQUAL(64, bus.clocks);
+}
+
+void test_read_miss_aborts_after_turnaround(void) {
+    FakeBus bus = lan8720At(1);
+    PbMdioBitBang<FakeBus> mdio(bus);
+    uint16_t v = 0x1234;
+    TEST_ASSERT_TRUE(mdio.read(0, 2, v) == PbMdioRead::NoPhy);
+    TEST_ASSERT_EQUAL_HEX16(0x1234, v);
+    TEST_ASSERT_EQUAL(47, bus.clocks);
+
+    // Обірваний кадр не ламає наступний: преамбула ресинхронізує PHY.
+    TEST_ASSERT_TRUE(mdio.read(1, 2, v) == PbMdioRead::Ok);
+    TEST_ASSERT_EQUAL_HEX16(0x0007, v);
+}
+
+void test_scan_finds_phy_address_and_id(void) {
+    FakeBus bus = lan8720At(2);
+    PbMdioBitBang<FakeBus> mdio(bus);
+    uint8_t addr = 0xFF;
+    uint16_t id1 = 0;
+    uint16_t id2 = 0;
+    TEST_ASSERT_TRUE(mdio.scanFirstHit(kAddrs, sizeof(kAddrs), addr, id1, id2) == PbMdioRead::Ok);
+    TEST_ASSERT_EQUAL(2, addr);
+    TEST_ASSERT_EQUAL_HEX16(0x0007, id1);
+    TEST_ASSERT_EQUAL_HEX16(0xC0F1, id2);
+}
+
+void test_floating_bus_costs_one_short_frame_per_address(void) {
+    FakeBus bus;
+    PbMdioBitBang<FakeBus> mdio(bus);
+    uint8_t all[32];
+    for (uint8_t i = 0; i < 32; i++) {
+        all[i] = i;
+    }
+    uint8_t addr = 0xFF;
+    uint16_t id1 = 0;
+    uint16_t id2 = 0;
+    TEST_ASSERT_TRUE(mdio.scanFirstHit(all, sizeof(all), addr, id1, id2) == PbMdioRead::NoPhy);
+    TEST_ASSERT_EQUAL(0xFF, addr);
+    // Реєстр 3 не читаємо, якщо вже реєстр 2 без відповіді.
+    TEST_ASSERT_EQUAL(32 * 47, bus.clocks);
+}
+
+void test_bus_held_low_is_rejected_without_clocking(void) {
+    FakeBus bus = lan8720At(0);
+    bus.stuckLow = true;
+    PbMdioBitBang<FakeBus> mdio(bus);
+    uint8_t addr = 0xFF;
+    uint16_t id1 = 0;
+    uint16_t id2 = 0;
+    TEST_ASSERT_TRUE(mdio.scanFirstHit(kAddrs, sizeof(kAddrs), addr, id1, id2) == PbMdioRead::BusLow);
+    TEST_ASSERT_EQUAL(0, bus.clocks);
+}
+
+void test_scan_skips_implausible_ids(void) {
+    FakeBus bus = lan8720At(0);
+    bus.regs[3] = 0xFFFF;
+    PbMdioBitBang<FakeBus> mdio(bus);
+    uint8_t addr = 0xFF;
+    uint16_t id1 = 0;
+    uint16_t id2 = 0;
+    TEST_ASSERT_TRUE(mdio.scanFirstHit(kAddrs, sizeof(kAddrs), addr, id1, id2) == PbMdioRead::NoPhy);
+    TEST_ASSERT_FALSE(pbMdioPhyIdValid(0x0000, 0xC0F1));
+    TEST_ASSERT_TRUE(pbMdioPhyIdValid(0x0243, 0x0C54));
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_read_hit_returns_register);
+    RUN_TEST(test_read_miss_aborts_after_turnaround);
+    RUN_TEST(test_scan_finds_phy_address_and_id);
+    RUN_TEST(test_floating_bus_costs_one_short_frame_per_address);
+    RUN_TEST(test_bus_held_low_is_rejected_without_clocking);
+    RUN_TEST(test_scan_skips_implausible_ids);
+    return UNITY_END();
+}
@@ -0,0 +1,64 @@
+// Host-side tests for include/pb_phy_id.h (pio test -e native).
+//
+// IDs below are register 2/3 values as read from real boards and datasheets;
+// the autoconfig prunes its candidate profiles by the model decoded here.
+
+#include <unity.h>
+
+#include "pb_phy_id.h"
+
+static_assert(pbPhyModelFromId(0x0007, 0xC0F1) == PbPhyModel::Lan8720, "LAN8720A must decode at compile time");
+static_assert(pbPhyModelFromId(0xFFFF, 0xFFFF) == PbPhyModel::Unknown, "floating bus must not match");
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_oui_and_model_split(void) {
+    TEST_ASSERT_EQUAL_HEX32(0x0001F0, pbPhyOui(0x0007, 0xC0F1));
+    TEST_ASSERT_EQUAL(0x0F, pbPhyModelBits(0xC0F1));
+    TEST_ASSERT_EQUAL_HEX32(0x0090C3, pbPhyOui(0x0243, 0x0C54));
+    TEST_ASSERT_EQUAL(0x05, pbPhyModelBits(0x0C54));
+}
+
+void test_known_phys(void) {
+    TEST_ASSERT_TRUE(pbPhyModelFromId(0x0007, 0xC0F0) == PbPhyModel::Lan8720);
+    TEST_ASSERT_TRUE(pbPhyModelFromId(0x0007, 0xC130) == PbPhyModel::Lan8720);
+    TEST_ASSERT_TRUE(pbPhyModelFromId(0x0243, 0x0C54) == PbPhyModel::Ip101);
+    TEST_ASSERT_TRUE(pbPhyModelFromId(0x001C, 0xC816) == PbPhyModel::Rtl8201);
+    TEST_ASSERT_TRUE(pbPhyModelFromId(0x2000, 0x5C90) == PbPhyModel::Dp83848);
+    TEST_ASSERT_TRUE(pbPhyModelFromId(0x0022, 0x1512) == PbPhyModel::Ksz8041);
+    TEST_ASSERT_TRUE(pbPhyModelFromId(0x0022, 0x1560) == PbPhyModel::Ksz8081);
+}
+
+void test_revision_bits_are_ignored(void) {
+    for (uint16_t rev = 0; rev < 16; rev++) {
+        TEST_ASSERT_TRUE(pbPhyModelFromId(0x0007, static_cast<uint16_t>(0xC0F0 | rev)) == PbPhyModel::Lan8720);
+        TEST_ASSERT_TRUE(pbPhyModelFromId(0x0243, static_cast<uint16_t>(0x0C50 | rev)) == PbPhyModel::Ip101);
+    }
+}
+
+void test_same_oui_different_model(void) {
+    // KSZ8041 і KSZ8081 мають один OUI — розрізняє лише поле model.
+    TEST_ASSERT_TRUE(pbPhyOui(0x0022, 0x1512) == pbPhyOui(0x0022, 0x1560));
+    TEST_ASSERT_TRUE(pbPhyModelFromId(0x0022, 0x1512) != pbPhyModelFromId(0x0022, 0x1560));
+    // Відомий OUI, невідома модель.
+    TEST_ASSERT_TRUE(pbPhyModelFromId(0x0007, 0xC0A0) == PbPhyModel::Unknown);
+}
+
+void test_bus_noise_and_unknown_vendors(void) {
+    TEST_ASSERT_TRUE(pbPhyModelFromId(0x0000, 0x0000) == PbPhyModel::Unknown);
+    TEST_ASSERT_TRUE(pbPhyModelFromId(0xFFFF, 0xFFFF) == PbPhyModel::Unknown);
+    TEST_ASSERT_TRUE(pbPhyModelFromId(0x0181, 0xB8A0) == PbPhyModel::Unknown);
+    TEST_ASSERT_EQUAL_STRING("UNKNOWN", pbPhyModelName(PbPhyModel::Unknown));
+    TEST_ASSERT_EQUAL_STRING("IP101", pbPhyModelName(PbPhyModel::Ip101));
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_oui_and_model_split);
+    RUN_TEST(test_known_phys);
+    RUN_TEST(test_revision_bits_are_ignored);
+    RUN_TEST(test_same_oui_different_model);
+    RUN_TEST(test_bus_noise_and_unknown_vendors);
+    return UNITY_END();
+}
@@ -3,85 +3,58 @@
  *
  * Плата: Wireless-Tag WT32-ETH01
  * Ethernet: LAN8720 через RMII
+ *
+ * Тут лише Ethernet плати; решта прошивки — lib/powerbot_core (pb_sensor.h).
  */
 
 #include <Arduino.h>
 #include <WiFi.h>
 #include <ETH.h>
-#include <ArduinoJson.h>
 #include "config.h"
+#include "pb_net_lwip.h"
 
-// Ethernet/TCP клієнт
-WiFiClient ethClient;
-
-// Стан підключення
-bool eth_connected = false;
+typedef PbLwipDnsNet PbBoardDnsNet;
+typedef PbLwipNet PbBoardNet;
+typedef PbLwipUdpListener PbBoardUdpListener;
 
-// Час останнього heartbeat
-unsigned long lastHeartbeatTime = 0;
+#include "pb_sensor.h"
 
-// Прототипи функцій
 void onEthEvent(WiFiEvent_t event);
 void setupEthernet();
-bool sendHeartbeat();
-void blinkLED(int times, int delayMs);
 
-void setup() {
-    Serial.begin(115200);
-    delay(2000);
-
-    Serial.println();
-    Serial.println("================================================");
+void pbBoardBanner() {
     Serial.println("  PowerBot WT32-ETH01 Heartbeat Sensor");
     Serial.println("  Плата: Wireless-Tag WT32-ETH01");
-    Serial.printf("  Building: %s (ID: %d)\n", BUILDING_NAME, BUILDING_ID);
-    Serial.printf("  Section:  %d\n", SECTION_ID);
-    Serial.printf("  Sensor:   %s\n", SENSOR_UUID);
-    Serial.printf("  Server:   %s:%d\n", SERVER_HOST, SERVER_PORT);
-    Serial.println("================================================");
-    Serial.println();
-
-#if defined(LED_PIN) && (LED_PIN >= 0)
-    pinMode(LED_PIN, OUTPUT);
-    digitalWrite(LED_PIN, LOW);
-#endif
+}
 
+void pbBoardSetupEthernet() {
     WiFi.onEvent(onEthEvent);
     setupEthernet();
 }
 
-void loop() {
-    if (!eth_connected || !ETH.linkUp()) {
-        if (eth_connected && !ETH.linkUp()) {
-            Serial.println("❌ Ethernet link down!");
-            eth_connected = false;
-        }
-        blinkLED(1, 500);
-        delay(1000);
-        return;
+// IP приходить подією GOT_IP; тут — лише падіння лінку між подіями.
+bool pbBoardNetReady() {
+    if (pbEthUp() && !ETH.linkUp()) {
+        PB_LOGE(LinkDown);
+        xEventGroupClearBits(pbNetEvents, kPbEvEthUp);
     }
+    return pbEthUp();
+}
 
-    // Перевіряємо чи час відправляти heartbeat
-    const unsigned long currentTime = millis();
-    if (lastHeartbeatTime == 0 || (currentTime - lastHeartbeatTime) >= HEARTBEAT_INTERVAL_MS) {
-        Serial.println();
-        Serial.println("📤 Відправка heartbeat...");
-
-        if (sendHeartbeat()) {
-            Serial.println("✅ Heartbeat успішно!");
-            blinkLED(1, 100);
-        } else {
-            Serial.println("❌ Помилка heartbeat!");
-            blinkLED(3, 200);
-        }
-
-        lastHeartbeatTime = currentTime;
-        Serial.printf("⏰ Наступний через %d сек\n", HEARTBEAT_INTERVAL_MS / 1000);
-    }
+bool pbBoardLinkUp() {
+    return ETH.linkUp();
+}
 
-    delay(100);
+IPAddress pbBoardLocalIp() {
+    return ETH.localIP();
 }
 
+IPAddress pbBoardGatewayIp() {
+    return ETH.gatewayIP();
+}
+
+void pbBoardBeatDelivered() {}
+
 void onEthEvent(WiFiEvent_t event) {
     switch (event) {
         case ARDUINO_EVENT_ETH_START:
@@ -105,17 +78,17 @@ void onEthEvent(WiFiEvent_t event) {
             Serial.println(ETH.subnetMask());
             Serial.print("📡 MAC:        ");
             Serial.println(ETH.macAddress());
-            eth_connected = true;
+            xEventGroupSetBits(pbNetEvents, kPbEvEthUp);
             break;
 
         case ARDUINO_EVENT_ETH_DISCONNECTED:
             Serial.println("❌ ETH disconnected");
-            eth_connected = false;
+            xEventGroupClearBits(pbNetEvents, kPbEvEthUp);
             break;
 
         case ARDUINO_EVENT_ETH_STOP:
             Serial.println("🛑 ETH stopped");
-            eth_connected = false;
+            xEventGroupClearBits(pbNetEvents, kPbEvEthUp);
             break;
 
         default:
@@ -139,12 +112,8 @@ void setupEthernet() {
     }
 
     Serial.println("📡 Очікування DHCP...");
-    const unsigned long waitStart = millis();
-    while (!eth_connected && (millis() - waitStart) < 15000) {
-        delay(100);
-    }
-
-    if (!eth_connected) {
+    const EventBits_t up = xEventGroupWaitBits(pbNetEvents, kPbEvEthUp, pdFALSE, pdTRUE, pdMS_TO_TICKS(15000));
+    if ((up & kPbEvEthUp) == 0) {
         Serial.println("❌ DHCP не вдалося отримати за 15 секунд");
         return;
     }
@@ -153,103 +122,3 @@ void setupEthernet() {
     Serial.println("✅ Ethernet готовий");
     Serial.println("════════════════════════════════════");
 }
-
-bool sendHeartbeat() {
-    Serial.printf("🌐 Підключення до %s:%d...\n", SERVER_HOST, SERVER_PORT);
-    Serial.printf("   Local IP: %s\n", ETH.localIP().toString().c_str());
-    Serial.printf("   Gateway:  %s\n", ETH.gatewayIP().toString().c_str());
-    Serial.printf("   Link:     %s\n", ETH.linkUp() ? "ON" : "OFF");
-
-    ethClient.setTimeout(HTTP_TIMEOUT_MS);
-
-    Serial.println("   Спроба connect()...");
-    const bool connected = ethClient.connect(SERVER_HOST, SERVER_PORT);
-    Serial.printf("   Connect result: %d\n", connected ? 1 : 0);
-
-    if (!connected) {
-        Serial.println("❌ Не вдалося підключитися до сервера!");
-        Serial.println("   Можливі причини:");
-        Serial.println("   - Немає маршруту до інтернету");
-        Serial.println("   - Firewall блокує з'єднання");
-        Serial.println("   - Сервер недоступний");
-        return false;
-    }
-
-    // Формуємо JSON
-    JsonDocument doc;
-    doc["api_key"] = API_KEY;
-    doc["building_id"] = BUILDING_ID;
-    doc["section_id"] = SECTION_ID;
-    doc["sensor_uuid"] = SENSOR_UUID;
-#if defined(SENSOR_COMMENT)
-    if (String(SENSOR_COMMENT).length() > 0) {
-        doc["comment"] = SENSOR_COMMENT;
-    }
-#endif
-
-    String payload;
-    serializeJson(doc, payload);
-
-    Serial.printf("📦 Payload: %s\n", payload.c_str());
-
-    // HTTP POST запит
-    ethClient.println("POST /api/v1/heartbeat HTTP/1.1");
-    ethClient.print("Host: ");
-    ethClient.println(SERVER_HOST);
-    ethClient.println("Content-Type: application/json");
-    ethClient.println("Connection: close");
-    ethClient.print("Content-Length: ");
-    ethClient.println(payload.length());
-    ethClient.println();
-    ethClient.println(payload);
-
-    // Чекаємо відповідь
-    const unsigned long timeout = millis();
-    while (!ethClient.available()) {
-        if (millis() - timeout > HTTP_TIMEOUT_MS) {
-            Serial.println("❌ Таймаут відповіді!");
-            ethClient.stop();
-            return false;
-        }
-        delay(10);
-    }
-
-    // Читаємо статус
-    const String statusLine = ethClient.readStringUntil('\n');
-    Serial.printf("📨 %s\n", statusLine.c_str());
-
-    const bool success = statusLine.indexOf(" 200 ") > 0;
-
-    // Пропускаємо заголовки
-    while (ethClient.available()) {
-        const String line = ethClient.readStringUntil('\n');
-        if (line == "\r") {
-            break;
-        }
-    }
-
-    // Читаємо body
-    String body = "";
-    while (ethClient.available()) {
-        body += static_cast<char>(ethClient.read());
-    }
-    if (body.length() > 0) {
-        Serial.printf("📨 Body: %s\n", body.c_str());
-    }
-
-    ethClient.stop();
-    return success;
-}
-
-void blinkLED(int times, int delayMs) {
-#if defined(LED_PIN) && (LED_PIN >= 0)
-    for (int i = 0; i < times; i++) {
-        digitalWrite(LED_PIN, HIGH);
-        delay(delayMs);
-        digitalWrite(LED_PIN, LOW);
-        if (i < times - 1) {
-            delay(delayMs);
-        }
-    }
-#endif
-}
@@ -23,6 +23,7 @@ from database import (
     get_sensor_by_uuid,
     freeze_sensor,
     unfreeze_sensor,
+    sensor_heartbeat_is_fresh,
     get_building_section_power_state,
     count_subscribers,
     get_subscribers_stats_by_building_section,
@@ -582,7 +583,7 @@ async def cb_sensor_freeze(callback: CallbackQuery) -> None:
     if section_state is not None:
         frozen_is_up = bool(section_state["is_up"])
     else:
-        frozen_is_up = bool(sensor.get("last_heartbeat") and (now - sensor["last_heartbeat"]) < timeout)
+        frozen_is_up = sensor_heartbeat_is_fresh(sensor, now, timeout)
 
     ok = await freeze_sensor(
         uuid,
@@ -682,8 +683,7 @@ async def _render_sensors_page(
         frozen_active = bool(frozen_until and frozen_until > now)
 
         if s.get("last_heartbeat"):
-            age = now - s["last_heartbeat"]
-            online = age < timeout
+            online = sensor_heartbeat_is_fresh(s, now, timeout)
             status_icon = "🟢" if online else "🔴"
         else:
             status_icon = "⚪"
@@ -827,8 +827,10 @@ async def _render_sensor_detail(bot: Bot, chat_id: int, *, uuid: str, prefer_mes
     # Real online status based on heartbeat.
     if sensor.get("last_heartbeat"):
         age = now - sensor["last_heartbeat"]
-        online = age < timeout
+        online = sensor_heartbeat_is_fresh(sensor, now, timeout)
         status = "🟢 online" if online else "🔴 offline"
+        if sensor.get("power_lost_at") and not online and age < timeout:
+            status = "🪫 power lost (last-gasp)"
         when = (
             f"{int(age.total_seconds())} сек тому"
             if age.total_seconds() < 60
@@ -23,6 +23,7 @@ from database import (
     default_section_for_building,
     freeze_sensor,
     unfreeze_sensor,
+    sensor_heartbeat_is_fresh,
 )
 from services import broadcast_messages
 
@@ -192,7 +193,7 @@ async def _handle_sensors_freeze_all(job: dict) -> tuple[int, int]:
         if section_state is not None:
             frozen_is_up = bool(section_state["is_up"])
         else:
-            frozen_is_up = bool(sensor.get("last_heartbeat") and (now - sensor["last_heartbeat"]) < timeout)
+            frozen_is_up = sensor_heartbeat_is_fresh(sensor, now, timeout)
 
         ok = await freeze_sensor(
             str(sensor["uuid"]),
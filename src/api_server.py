@@ -10,15 +10,79 @@ Body: {
     "sensor_uuid": "esp32-newcastle-01"
 }
 
+Опційне поле "event" (тип повідомлення, за замовчуванням "heartbeat"):
+    "heartbeat"   # звичайний periodic beat
+    "boot"        # перший beat після старту прошивки (живлення відновилось)
+    "power_lost"  # last-gasp: прошивка побачила просідання живлення і встигла повідомити;
+                  # сенсор одразу вважається offline (без очікування SENSOR_TIMEOUT_SEC)
+
+Опційне поле "seq": порядковий номер beat з моменту boot (прошивка +1 на кожен beat);
+сервер рахує по ньому втрачені heartbeat (sensors.hb_received / hb_lost).
+
+Опційні службові поля (телеметрія прошивки, зберігаються в sensors.telemetry_json):
+    "conn_new": 3,        # скільки разів сенсор відкривав нове TCP-з'єднання з моменту boot
+    "conn_reused": 118,   # скільки heartbeat пішло через keep-alive з'єднання
+    "uptime_s": 86400,    # аптайм прошивки
+    "boot_count": 17,     # лічильник завантажень прошивки (NVS); база курсора проти повтору frame
+    "heap_free": 201000,  # вільний heap на момент beat
+    "heap_min": 198000,   # мінімум вільного heap з моменту boot
+    "heap_drops": 0,      # скільки beat-ів закінчились новим мінімумом heap (росте = щось тече)
+    "log_drops": 0,       # скільки рядків логу прошивка відкинула (ring-буфер повний)
+    "hb_lat": {           # латентність фаз beat-ів з останнього доставленого підсумку, мкс:
+        "dns": [p50, p95, max, fails],   # фази: dns, connect, write, ttfb, response;
+        ...                              # fails — скільки beat-ів упали саме на цій фазі
+    },
+    "hb_int": [p50, p95, max, skipped],  # |інтервал між beat-ами - період|, мкс, за те саме вікно;
+                                         # skipped — пропущені слоти розкладу (мережі не було)
+    "hb_dns": [p50, p95, max, fails],    # фонові DNS-запити прошивки за те саме вікно, мкс;
+                                         # fails — невдалі (beat-и йшли на останню відому адресу)
+    "mains_v": [min, avg, max, cycles],  # якість мережі (PB_MAINS): RMS напруги по періодах за
+                                         # те саме вікно, дВ (0.1 В); cycles — виміряні періоди
+    "mains_hz": [min, avg, max, cycles]  # частота по періодах, мГц; cycles — періоди з частотою
+                                         # (без перетину нуля, напр. світла немає, — не рахуються)
+
 Response: {"status": "ok", "timestamp": "2026-01-22T12:00:00Z"}
+Якщо задано SENSOR_HEARTBEAT_INTERVAL_SEC, прийнятий HTTP beat (JSON чи frame) отримує заголовок
+X-PB-Interval-Ms — прошивка переходить на цей період (у своїх межах PB_HB_INTERVAL_*_MS).
+
+UDP (SENSOR_UDP_PORT, прошивка з PB_TRANSPORT=PB_TRANSPORT_UDP): одна датаграма = той самий
+JSON, що й body вище. Ack: "OK <seq>" або "ERR <status> <seq>" (лише для датаграм з валідним api_key).
+
+Бінарний heartbeat (прошивка з PB_HB_FRAME=1): замість JSON — 36-байтний frame, підписаний
+HMAC від SENSOR_API_KEY (layout — у sensor_frame.py). HTTP: Content-Type: application/octet-stream;
+UDP: датаграма, що починається з b"PB". Сенсор має бути вже зареєстрований JSON heartbeat-ом.
+Повтор перехопленого frame відхиляється (409): приймається лише frame, новіший за (boot_count, seq)
+останнього прийнятого beat; boot_count — лічильник завантажень з NVS прошивки, назад не йде.
+
+Офлайн-журнал: POST /api/v1/heartbeat/bulk — beat-и, які сенсор не зміг доставити (зв'язку
+не було, а живлення було), одним запитом після відновлення:
+    {"api_key": ..., "sensor_uuid": ..., "building_id": ..., "section_id": ...,
+     "period_ms": 10000,           # період beat прошивки
+     "stride": 1,                  # журнал проріджено: записано кожен stride-й слот
+     "beats": [[seq, age_s], ...]} # age_s — вік запису на момент відправки; seq 0 — маркер
+                                   # втрати живлення (last-gasp)
+Сервер зберігає beat-и в sensor_journal_beats і однією транзакцією позначає пари down/up,
+які журнал спростовує (events.refuted_at/refuted_by; з історії вони зникають, з БД — ні).
+Response: {"status": "ok", "stored": N, "events_refuted": M}.
+
+Агрегатор будинку: POST /api/v1/heartbeat/batch — один сенсор у будинку (PB_ROLE=AGGREGATOR)
+збирає beat-и секцій по LAN і раз на інтервал шле їх одним запитом:
+    {"api_key": ..., "building_id": ..., "sensor_uuid": <агрегатор>,
+     "beats": [{"sensor_uuid": ... | "uuid_hash": <hex з frame>, "section_id": ...,
+                "event": ..., "seq": ..., "uptime_s": ...,
+                "age_ms": 830}, ...]}  # age_ms — скільки beat чекав в агрегаторі
+Усі beat-и — однією транзакцією БД. Response: {"status": "ok", "stored": N, "results": [200, 404, ...]}
+(статус кожного beat у порядку запиту) + X-PB-Interval-Ms, як на звичайний beat.
 """
 
+import asyncio
 import hashlib
 import hmac
 import json
 import logging
 import time
-from datetime import datetime
+from dataclasses import dataclass
+from datetime import datetime, timedelta
 from pathlib import Path
 from urllib.parse import parse_qsl, quote_plus
 from io import BytesIO
@@ -28,12 +92,29 @@ import img2pdf
 
 from business import get_business_service, is_business_feature_enabled
 from config import CFG
+from sensor_events import request_sensors_recheck
+from sensor_frame import (
+    SENSOR_FRAME_SIZE,
+    SENSOR_FRAME_UUID_HASH_SIZE,
+    SensorFrameKey,
+    decode_sensor_frame,
+    is_sensor_frame,
+    sensor_uuid_hash,
+)
 from yasno import get_planned_outages, get_building_schedule_text
 from database import (
     get_sensor_by_uuid,
+    get_all_sensor_uuids,
     get_active_sensor_by_public_id,
     get_all_active_sensors_with_public_ids,
     upsert_sensor_heartbeat,
+    upsert_sensor_heartbeats,
+    upsert_sensor_inputs,
+    mark_sensor_power_lost,
+    accept_sensor_frame,
+    backfill_sensor_journal,
+    sensor_heartbeat_is_fresh,
+    sensor_is_input_hub,
     get_building_by_id,
     add_subscriber,
     get_subscriber_building_and_section,
@@ -107,8 +188,10 @@ def _sensor_is_online_by_heartbeat_only(sensor: dict) -> tuple[bool, int | None]
     last_heartbeat = sensor.get("last_heartbeat")
     if not last_heartbeat:
         return False, None
-    age_seconds = max(0, int((datetime.now() - last_heartbeat).total_seconds()))
-    return age_seconds < int(CFG.sensor_timeout), age_seconds
+    now = datetime.now()
+    age_seconds = max(0, int((now - last_heartbeat).total_seconds()))
+    # sensor_heartbeat_is_fresh також враховує last-gasp power_lost після останнього beat.
+    return sensor_heartbeat_is_fresh(sensor, now, timedelta(seconds=int(CFG.sensor_timeout))), age_seconds
 
 
 async def _is_business_offers_ui_visible() -> bool:
@@ -182,53 +265,135 @@ def _filter_places_by_query(
     return trimmed
 
 
-async def heartbeat_handler(request: web.Request) -> web.Response:
+# Типи повідомлень на /api/v1/heartbeat (поле "event").
+SENSOR_HEARTBEAT_EVENTS = ("heartbeat", "boot", "power_lost")
+
+# Цілочисельні лічильники, які прошивка може додавати до heartbeat.
+SENSOR_TELEMETRY_INT_FIELDS = (
+    "conn_new",
+    "conn_reused",
+    "uptime_s",
+    "boot_count",
+    "heap_free",
+    "heap_min",
+    "heap_drops",
+    "log_drops",
+)
+
+# Входів на одній платі (PB_INPUTS у прошивці): "inputs" — бітова маска, біт i -> input_sections[i].
+SENSOR_INPUTS_MAX = 16
+
+# Фази heartbeat у "hb_lat" (кожна — [p50_us, p95_us, max_us, fails]).
+SENSOR_HB_LATENCY_PHASES = ("dns", "connect", "write", "ttfb", "response")
+
+
+def _is_stats4(value) -> bool:
+    """[p50, p95, max, лічильник] — чотири невід'ємні цілі."""
+    return (
+        isinstance(value, list)
+        and len(value) == 4
+        and all(not isinstance(v, bool) and isinstance(v, int) and v >= 0 for v in value)
+    )
+
+
+def _extract_hb_latency(value) -> dict | None:
+    """Підсумок латентності фаз з heartbeat; биті/невідомі фази відкидаються поодинці."""
+    if not isinstance(value, dict):
+        return None
+    latency: dict = {}
+    for phase in SENSOR_HB_LATENCY_PHASES:
+        stats = value.get(phase)
+        if not _is_stats4(stats):
+            continue
+        latency[phase] = stats
+    return latency or None
+
+
+def _extract_sensor_telemetry(data: dict) -> dict | None:
+    """Вибрати з heartbeat відомі службові метрики (невідомі/некоректні поля ігноруються)."""
+    telemetry: dict = {}
+    for key in SENSOR_TELEMETRY_INT_FIELDS:
+        value = data.get(key)
+        if isinstance(value, bool) or not isinstance(value, int) or value < 0:
+            continue
+        telemetry[key] = value
+    latency = _extract_hb_latency(data.get("hb_lat"))
+    if latency is not None:
+        telemetry["hb_lat"] = latency
+    intervals = data.get("hb_int")
+    if _is_stats4(intervals):
+        telemetry["hb_int"] = intervals
+    dns = data.get("hb_dns")
+    if _is_stats4(dns):
+        telemetry["hb_dns"] = dns
+    for key in ("mains_v", "mains_hz"):
+        mains = data.get(key)
+        if _is_stats4(mains):
+            telemetry[key] = mains
+    return telemetry or None
+
+
+@dataclass(frozen=True)
+class _SensorBeat:
+    """Провалідований beat: поля, які пишуться в БД, і будинок після canonical mapping."""
+
+    sensor_uuid: str
+    event: str
+    seq: int | None
+    building_id: int
+    section_id: int | None = None
+    building: dict | None = None
+    name: str | None = None
+    comment: str | None = None
+    telemetry: dict | None = None
+    inputs: int | None = None
+    input_sections: tuple[int, ...] = ()
+
+
+def _parse_sensor_heartbeat(
+    data: dict, *, authenticated: bool = False
+) -> tuple[tuple[int, dict] | None, _SensorBeat | None]:
     """
-    Обробник heartbeat запитів від ESP32 сенсорів.
-    
-    Очікує JSON:
-    {
-        "api_key": "secret-key",
-        "building_id": 1,
-        "section_id": 2,
-        "sensor_uuid": "unique-sensor-id"
-    }
+    Валідація beat (спільна для одиночного і пакетного heartbeat, без БД).
+    Повертає ((HTTP-статус, тіло), None) при помилці або (None, beat).
+    Для "power_lost" будинок/секція не перевіряються (beat лише позначає сенсор offline).
     """
-    try:
-        data = await request.json()
-    except Exception:
-        return web.json_response(
-            {"status": "error", "message": "Invalid JSON"},
-            status=400
-        )
-    
+    if not isinstance(data, dict):
+        return (400, {"status": "error", "message": "Invalid JSON"}), None
+
     # Валідація API ключа
     api_key = data.get("api_key")
-    if not api_key or api_key != CFG.sensor_api_key:
+    if not authenticated and (not api_key or api_key != CFG.sensor_api_key):
         logger.warning(f"Invalid API key attempt: {api_key[:10] if api_key else 'None'}...")
-        return web.json_response(
-            {"status": "error", "message": "Invalid API key"},
-            status=401
-        )
-    
+        return (401, {"status": "error", "message": "Invalid API key"}), None
+
     # Валідація building_id з payload (може бути нормалізований пізніше по uuid).
     building_id = data.get("building_id")
     if not isinstance(building_id, int):
-        return web.json_response(
-            {"status": "error", "message": "building_id must be an integer"},
-            status=400
-        )
+        return (400, {"status": "error", "message": "building_id must be an integer"}), None
 
     # Валідація sensor_uuid
     sensor_uuid = data.get("sensor_uuid")
     if not sensor_uuid or not isinstance(sensor_uuid, str):
-        return web.json_response(
-            {"status": "error", "message": "sensor_uuid is required and must be a string"},
-            status=400
-        )
+        return (400, {"status": "error", "message": "sensor_uuid is required and must be a string"}), None
     sensor_uuid = sensor_uuid.strip()
     sensor_uuid_key = sensor_uuid.lower()
 
+    event = data.get("event")
+    if event is None:
+        event = "heartbeat"
+    if not isinstance(event, str) or event not in SENSOR_HEARTBEAT_EVENTS:
+        return (400, {"status": "error", "message": f"event must be one of: {', '.join(SENSOR_HEARTBEAT_EVENTS)}"}), None
+
+    seq = data.get("seq")
+    if seq is not None and (isinstance(seq, bool) or not isinstance(seq, int) or seq < 0):
+        return (400, {"status": "error", "message": "seq must be a non-negative integer"}), None
+
+    if event == "power_lost":
+        # Last-gasp: відповідаємо якнайшвидше, без upsert/перевірок секції —
+        # сенсор уже зареєстрований попередніми heartbeat.
+        return None, _SensorBeat(sensor_uuid=sensor_uuid, event=event, seq=seq, building_id=building_id)
+
     # Канонічне зіставлення uuid -> building_id.
     # Це захищає від розбіжності "прошивочного ID" vs канонічного ID будинку в БД.
     canonical_building_id = CFG.sensor_uuid_building_map.get(sensor_uuid_key)
@@ -244,10 +409,7 @@ async def heartbeat_handler(request: web.Request) -> web.Response:
     # Перевіряємо що будинок існує (вже після canonical mapping).
     building = get_building_by_id(building_id)
     if not building:
-        return web.json_response(
-            {"status": "error", "message": f"Building {building_id} not found"},
-            status=404
-        )
+        return (404, {"status": "error", "message": f"Building {building_id} not found"}), None
 
     # Валідація section_id (1..N). Для backward-compat дозволяємо відсутність (ставимо дефолт).
     section_id = data.get("section_id")
@@ -275,72 +437,547 @@ async def heartbeat_handler(request: web.Request) -> web.Response:
             section_id = fallback_section_id
             max_sections = get_building_section_count(building_id)
             if not isinstance(section_id, int) or not is_valid_section_for_building(building_id, section_id):
-                return web.json_response(
-                    {"status": "error", "message": f"section_id must be integer 1..{max_sections}"},
-                    status=400,
-                )
+                return (400, {"status": "error", "message": f"section_id must be integer 1..{max_sections}"}), None
         else:
-            return web.json_response(
-                {"status": "error", "message": f"section_id must be integer 1..{max_sections}"},
-                status=400,
-            )
+            return (400, {"status": "error", "message": f"section_id must be integer 1..{max_sections}"}), None
 
     sensor_name = data.get("name")
     if sensor_name is not None and not isinstance(sensor_name, str):
-        return web.json_response(
-            {"status": "error", "message": "name must be string"},
-            status=400,
-        )
+        return (400, {"status": "error", "message": "name must be string"}), None
     if isinstance(sensor_name, str):
         sensor_name = sensor_name.strip() or None
 
     comment = data.get("comment")
     if comment is not None and not isinstance(comment, str):
-        return web.json_response(
-            {"status": "error", "message": "comment must be string"},
-            status=400,
-        )
+        return (400, {"status": "error", "message": "comment must be string"}), None
     if isinstance(comment, str):
         comment = comment.strip()
         if not comment:
             comment = None
         elif len(comment) > 160:
             comment = comment[:160]
-    
-    # Upsert сенсора + heartbeat (1 операція БД)
-    sensor_before = await get_sensor_by_uuid(sensor_uuid)
-    is_new = await upsert_sensor_heartbeat(sensor_uuid, building_id, section_id, sensor_name, comment)
+
+    telemetry = _extract_sensor_telemetry(data)
+    inputs = data.get("inputs")
+    input_sections = data.get("input_sections")
+    if inputs is not None or input_sections is not None:
+        # Плата з кількома входами: кожен вхід — своя секція (замість SENSOR_ALIAS_*).
+        if (
+            not isinstance(input_sections, list)
+            or not 0 < len(input_sections) <= SENSOR_INPUTS_MAX
+            or not all(
+                isinstance(sid, int) and not isinstance(sid, bool) and is_valid_section_for_building(building_id, sid)
+                for sid in input_sections
+            )
+        ):
+            return (
+                400,
+                {
+                    "status": "error",
+                    "message": f"input_sections must be a list of 1..{SENSOR_INPUTS_MAX} sections 1..{max_sections}",
+                },
+            ), None
+        if isinstance(inputs, bool) or not isinstance(inputs, int) or not 0 <= inputs < (1 << len(input_sections)):
+            return (400, {"status": "error", "message": "inputs must be a bitmask of input_sections"}), None
+        telemetry = dict(telemetry or {}, inputs=inputs)
+
+    return None, _SensorBeat(
+        sensor_uuid=sensor_uuid,
+        event=event,
+        seq=seq,
+        building_id=building_id,
+        section_id=section_id,
+        building=building,
+        name=sensor_name,
+        comment=comment,
+        telemetry=telemetry,
+        inputs=inputs,
+        input_sections=tuple(input_sections or ()),
+    )
+
+
+async def _process_sensor_power_lost(beat: _SensorBeat) -> tuple[int, dict]:
+    """Last-gasp "power_lost": сенсор offline до наступного beat, монітор — одразу."""
+    known = await mark_sensor_power_lost(beat.sensor_uuid)
+    if known:
+        logger.warning("Sensor %s reported power loss (last-gasp)", beat.sensor_uuid)
+        request_sensors_recheck()
+    else:
+        logger.warning("Ignoring power_lost from unknown/inactive sensor %s", beat.sensor_uuid)
+    return 200, {
+        "status": "ok",
+        "timestamp": datetime.now().isoformat(),
+        "event": beat.event,
+        "sensor_uuid": beat.sensor_uuid,
+    }
+
+
+def _sensor_heartbeat_stored(beat: _SensorBeat, sensor_before: dict | None, is_new: bool) -> None:
+    """Логи і recheck монітора після upsert beat (одиночного чи з пакета)."""
+    if beat.event == "boot":
+        logger.info("Sensor %s booted: building=%s section=%s", beat.sensor_uuid, beat.building_id, beat.section_id)
+
+    # Сенсор щойно "ожив" (boot, перший beat після таймауту чи power_lost) —
+    # не чекаємо планового циклу моніторингу, щоб UP-сповіщення пішло одразу.
+    was_online = bool(sensor_before) and sensor_heartbeat_is_fresh(
+        sensor_before, datetime.now(), timedelta(seconds=int(CFG.sensor_timeout))
+    )
+    if beat.event == "boot" or not was_online:
+        request_sensors_recheck()
+
     if is_new:
         logger.info(
             "New sensor registered: %s building=%s section=%s (%s)",
-            sensor_uuid,
-            building_id,
-            section_id,
-            building["name"],
+            beat.sensor_uuid,
+            beat.building_id,
+            beat.section_id,
+            beat.building["name"],
         )
     else:
         if sensor_before and (
-            sensor_before.get("building_id") != building_id
-            or sensor_before.get("section_id") != section_id
+            sensor_before.get("building_id") != beat.building_id
+            or sensor_before.get("section_id") != beat.section_id
         ):
             logger.warning(
                 "Sensor %s moved: (%s,%s) -> (%s,%s)",
-                sensor_uuid,
+                beat.sensor_uuid,
                 sensor_before.get("building_id"),
                 sensor_before.get("section_id"),
-                building_id,
-                section_id,
+                beat.building_id,
+                beat.section_id,
             )
-    
+
+
+async def _store_sensor_inputs(beat: _SensorBeat, heard_at: datetime) -> None:
+    """
+    Входи плати (beat з "inputs") -> сенсори "<uuid>#in<N>" у секціях input_sections.
+    Плата шле beat одразу на фронті входу, тож вхід, що змінив стан, будить монітор.
+    """
+    if beat.inputs is None:
+        return
+    channels = [
+        {
+            "uuid": f"{beat.sensor_uuid}#in{i + 1}",
+            "section_id": section_id,
+            "name": f"{beat.name} · вхід {i + 1}" if beat.name else None,
+            "on": bool(beat.inputs >> i & 1),
+        }
+        for i, section_id in enumerate(beat.input_sections)
+    ]
+    before = await upsert_sensor_inputs(beat.building_id, channels, heard_at)
+    now = datetime.now()
+    timeout = timedelta(seconds=int(CFG.sensor_timeout))
+    changed = [
+        channel["uuid"]
+        for channel, sensor_before in zip(channels, before)
+        if sensor_before is None or sensor_heartbeat_is_fresh(sensor_before, now, timeout) != channel["on"]
+    ]
+    if changed:
+        logger.info("Sensor %s inputs=%s: changed %s", beat.sensor_uuid, bin(beat.inputs), ", ".join(changed))
+        request_sensors_recheck()
+
+
+async def process_sensor_heartbeat(data: dict, *, authenticated: bool = False) -> tuple[int, dict]:
+    """
+    Обробити heartbeat від ESP32 сенсора (спільне ядро для HTTP і UDP транспорту).
+
+    Очікує dict:
+    {
+        "api_key": "secret-key",
+        "building_id": 1,
+        "section_id": 2,
+        "sensor_uuid": "unique-sensor-id",
+        "event": "heartbeat" | "boot" | "power_lost",   (опц.)
+        "seq": 42,                                      (опц.)
+        "inputs": 5, "input_sections": [1, 2, 3]        (опц., плата з кількома входами)
+    }
+
+    authenticated=True — джерело вже перевірене (HMAC бінарного frame), api_key не потрібен.
+
+    Повертає (HTTP-статус, тіло відповіді).
+    """
+    error, beat = _parse_sensor_heartbeat(data, authenticated=authenticated)
+    if error is not None:
+        return error
+    if beat.event == "power_lost":
+        return await _process_sensor_power_lost(beat)
+
+    sensor_uuid, building_id, section_id = beat.sensor_uuid, beat.building_id, beat.section_id
+    sensor_name, comment, telemetry = beat.name, beat.comment, beat.telemetry
+
+    # Upsert сенсора + heartbeat (1 операція БД)
+    sensor_before = await get_sensor_by_uuid(sensor_uuid)
+    is_new = await upsert_sensor_heartbeat(sensor_uuid, building_id, section_id, sensor_name, comment, telemetry=telemetry,
+                                          seq=beat.seq, seq_restart=(beat.event == "boot"),
+                                          boot_count=(telemetry or {}).get("boot_count"))
+    _sensor_heartbeat_stored(beat, sensor_before, is_new)
+    await _store_sensor_inputs(beat, datetime.now())
+
     now = datetime.now().isoformat()
-    
-    return web.json_response({
+
+    return 200, {
         "status": "ok",
         "timestamp": now,
-        "building": building["name"],
+        "building": beat.building["name"],
         "section_id": section_id,
         "sensor_uuid": sensor_uuid,
-    })
+    }
+
+
+# ─── Бінарний heartbeat (HMAC frame) ───
+
+_sensor_frame_key: tuple[str, SensorFrameKey] | None = None
+_sensor_uuid_by_hash: dict[bytes, str] = {}
+
+
+def _get_sensor_frame_key() -> SensorFrameKey:
+    """HMAC-ключ з midstate, перераховується лише при зміні SENSOR_API_KEY."""
+    global _sensor_frame_key
+    key = CFG.sensor_api_key or ""
+    if _sensor_frame_key is None or _sensor_frame_key[0] != key:
+        _sensor_frame_key = (key, SensorFrameKey(key))
+    return _sensor_frame_key[1]
+
+
+async def _resolve_sensor_uuid_hash(uuid_hash: bytes) -> str | None:
+    """uuid_hash -> sensor_uuid серед зареєстрованих сенсорів (кеш оновлюється при промаху)."""
+    sensor_uuid = _sensor_uuid_by_hash.get(uuid_hash)
+    if sensor_uuid is not None:
+        return sensor_uuid
+    _sensor_uuid_by_hash.clear()
+    for known_uuid in await get_all_sensor_uuids():
+        _sensor_uuid_by_hash[sensor_uuid_hash(known_uuid)] = known_uuid
+    return _sensor_uuid_by_hash.get(uuid_hash)
+
+
+async def process_sensor_frame(data: bytes) -> tuple[int, dict, int | None]:
+    """
+    Обробити бінарний heartbeat frame. Повертає (HTTP-статус, тіло відповіді, seq з frame).
+    Невалідний підпис -> 401; невідомий сенсор -> 404; повтор / застарілий frame -> 409
+    (last_heartbeat і power_lost_at не змінюються). На 4xx прошивка відповідає JSON heartbeat-ом.
+    """
+    frame = decode_sensor_frame(data, _get_sensor_frame_key())
+    if frame is None:
+        logger.warning("Invalid sensor heartbeat frame (%d bytes)", len(data))
+        return 401, {"status": "error", "message": "Invalid frame signature"}, None
+
+    sensor_uuid = await _resolve_sensor_uuid_hash(frame.uuid_hash)
+    if sensor_uuid is None:
+        return 404, {"status": "error", "message": "Unknown sensor: send JSON heartbeat first"}, frame.seq
+    if not await accept_sensor_frame(sensor_uuid, frame.event, frame.seq, frame.boot_count):
+        logger.warning(
+            "Replayed sensor frame %s: event=%s seq=%d boot_count=%d",
+            sensor_uuid, frame.event, frame.seq, frame.boot_count,
+        )
+        return 409, {"status": "error", "message": "Replayed frame"}, frame.seq
+
+    status, payload = await process_sensor_heartbeat(
+        {
+            "building_id": frame.building_id,
+            "section_id": frame.section_id,
+            "sensor_uuid": sensor_uuid,
+            "event": frame.event,
+            "seq": frame.seq,
+            "uptime_s": frame.uptime_s,
+            "boot_count": frame.boot_count,
+        },
+        authenticated=True,
+    )
+    return status, payload, frame.seq
+
+
+def _heartbeat_response(payload: dict, status: int) -> web.Response:
+    """Відповідь на HTTP beat; прийнятий beat несе інструкцію періоду (SENSOR_HEARTBEAT_INTERVAL_SEC)."""
+    headers = None
+    interval = int(CFG.sensor_heartbeat_interval)
+    if status == 200 and interval > 0:
+        headers = {"X-PB-Interval-Ms": str(interval * 1000)}
+    return web.json_response(payload, status=status, headers=headers)
+
+
+async def heartbeat_handler(request: web.Request) -> web.Response:
+    """Обробник heartbeat запитів від ESP32 сенсорів (POST /api/v1/heartbeat)."""
+    if request.content_type == "application/octet-stream":
+        body = await request.content.read(SENSOR_FRAME_SIZE + 1)
+        status, payload, _ = await process_sensor_frame(body)
+        return _heartbeat_response(payload, status)
+    try:
+        data = await request.json()
+    except Exception:
+        return web.json_response(
+            {"status": "error", "message": "Invalid JSON"},
+            status=400
+        )
+    status, payload = await process_sensor_heartbeat(data)
+    return _heartbeat_response(payload, status)
+
+
+# ─── Офлайн-журнал сенсора (пакет недоставлених beat-ів) ───
+
+# Журнал прошивки — десятки записів; з запасом на ручне/тестове догрузження.
+SENSOR_JOURNAL_MAX_BEATS = 1024
+
+
+def _is_journal_beat(value) -> bool:
+    """[seq, age_s] — два невід'ємні цілі."""
+    return (
+        isinstance(value, list)
+        and len(value) == 2
+        and all(not isinstance(v, bool) and isinstance(v, int) and v >= 0 for v in value)
+    )
+
+
+async def process_sensor_journal(data: dict) -> tuple[int, dict]:
+    """
+    Обробити офлайн-журнал сенсора (POST /api/v1/heartbeat/bulk). Повертає (HTTP-статус, тіло).
+    Сенсор має бути зареєстрований (журнал шле лише після доставленого beat).
+    """
+    if not isinstance(data, dict):
+        return 400, {"status": "error", "message": "Invalid JSON"}
+
+    api_key = data.get("api_key")
+    if not api_key or api_key != CFG.sensor_api_key:
+        logger.warning(f"Invalid API key attempt (journal): {api_key[:10] if api_key else 'None'}...")
+        return 401, {"status": "error", "message": "Invalid API key"}
+
+    sensor_uuid = data.get("sensor_uuid")
+    if not sensor_uuid or not isinstance(sensor_uuid, str):
+        return 400, {"status": "error", "message": "sensor_uuid is required and must be a string"}
+    sensor_uuid = sensor_uuid.strip()
+
+    beats = data.get("beats")
+    if not isinstance(beats, list) or not all(_is_journal_beat(b) for b in beats):
+        return 400, {"status": "error", "message": "beats must be a list of [seq, age_s]"}
+    if len(beats) > SENSOR_JOURNAL_MAX_BEATS:
+        return 413, {"status": "error", "message": f"at most {SENSOR_JOURNAL_MAX_BEATS} beats per request"}
+
+    period_ms = data.get("period_ms", 0)
+    stride = data.get("stride", 1)
+    for name, value, minimum in (("period_ms", period_ms, 0), ("stride", stride, 1)):
+        if isinstance(value, bool) or not isinstance(value, int) or value < minimum:
+            return 400, {"status": "error", "message": f"{name} must be an integer >= {minimum}"}
+
+    # Вік -> годинник сервера; порядок журналу (від найстарішого) зберігаємо.
+    now = datetime.now()
+    journal = [(seq, now - timedelta(seconds=age_s)) for seq, age_s in beats]
+    # Між записами проріджуваного журналу — stride періодів; плюс таймаут, за який монітор
+    # встигає записати "down".
+    max_gap = timedelta(seconds=int(CFG.sensor_timeout)) + timedelta(milliseconds=2 * stride * period_ms)
+
+    result = await backfill_sensor_journal(sensor_uuid, journal, max_gap)
+    if result is None:
+        return 404, {"status": "error", "message": "Unknown sensor: send JSON heartbeat first"}
+    stored, events_refuted = result
+    if events_refuted:
+        logger.warning(
+            "Sensor %s journal: %s beats back-filled, %s false outage events refuted",
+            sensor_uuid,
+            stored,
+            events_refuted,
+        )
+    else:
+        logger.info("Sensor %s journal: %s beats back-filled", sensor_uuid, stored)
+    return 200, {"status": "ok", "stored": stored, "events_refuted": events_refuted}
+
+
+async def heartbeat_bulk_handler(request: web.Request) -> web.Response:
+    """Офлайн-журнал від ESP32 сенсора (POST /api/v1/heartbeat/bulk)."""
+    try:
+        data = await request.json()
+    except Exception:
+        return web.json_response({"status": "error", "message": "Invalid JSON"}, status=400)
+    status, payload = await process_sensor_journal(data)
+    return web.json_response(payload, status=status)
+
+
+# ─── Пакет beat-ів від агрегатора будинку ───
+# Сенсори секцій шлють beat по LAN сенсору-агрегатору (PB_ROLE=AGGREGATOR у прошивці),
+# а той раз на інтервал — один запит на весь будинок.
+
+# Секцій у будинку — одиниці; з запасом на кілька агрегаторів за одним.
+SENSOR_BATCH_MAX_BEATS = 64
+
+
+async def _parse_sensor_batch_beat(entry, building_id) -> tuple[int, _SensorBeat | None, int]:
+    """
+    Елемент пакета -> (статус елемента, beat, age_ms). Елемент — поля beat без api_key
+    (building_id — з пакета, якщо свого немає); sensor_uuid або uuid_hash (hex, як у frame) —
+    сенсор, який агрегатор знає лише з frame. age_ms — скільки beat чекав в агрегаторі.
+    """
+    if not isinstance(entry, dict):
+        return 400, None, 0
+    item = dict(entry)
+    item.pop("api_key", None)
+    item.setdefault("building_id", building_id)
+
+    uuid_hash = item.pop("uuid_hash", None)
+    if item.get("sensor_uuid") is None and uuid_hash is not None:
+        try:
+            raw_hash = bytes.fromhex(uuid_hash) if isinstance(uuid_hash, str) else b""
+        except ValueError:
+            raw_hash = b""
+        if len(raw_hash) != SENSOR_FRAME_UUID_HASH_SIZE:
+            return 400, None, 0
+        item["sensor_uuid"] = await _resolve_sensor_uuid_hash(raw_hash)
+        if item["sensor_uuid"] is None:
+            return 404, None, 0   # агрегатор попросить сенсор надіслати JSON beat
+
+    age_ms = item.get("age_ms", 0)
+    if isinstance(age_ms, bool) or not isinstance(age_ms, int) or age_ms < 0:
+        return 400, None, 0
+
+    error, beat = _parse_sensor_heartbeat(item, authenticated=True)
+    if error is not None:
+        return error[0], None, 0
+    return 200, beat, age_ms
+
+
+async def process_sensor_batch(data: dict) -> tuple[int, dict]:
+    """
+    Обробити пакет beat-ів агрегатора (POST /api/v1/heartbeat/batch). Повертає (HTTP-статус, тіло).
+
+    {
+        "api_key": "secret-key",
+        "building_id": 1,
+        "sensor_uuid": "aggregator-uuid",               (опц., для логів)
+        "beats": [
+            {"sensor_uuid": "...", "section_id": 1, "event": "heartbeat", "seq": 42, "age_ms": 0, ...},
+            {"uuid_hash": "0011223344556677", "section_id": 2, "seq": 17, "age_ms": 830},
+        ]
+    }
+
+    Усі beat-и пишуться однією транзакцією. Статус кожного — у "results" (в порядку beats):
+    пакет не відкидається через один невалідний або невідомий сенсор.
+    """
+    if not isinstance(data, dict):
+        return 400, {"status": "error", "message": "Invalid JSON"}
+
+    api_key = data.get("api_key")
+    if not api_key or api_key != CFG.sensor_api_key:
+        logger.warning(f"Invalid API key attempt (batch): {api_key[:10] if api_key else 'None'}...")
+        return 401, {"status": "error", "message": "Invalid API key"}
+
+    beats = data.get("beats")
+    if not isinstance(beats, list) or not beats:
+        return 400, {"status": "error", "message": "beats must be a non-empty list"}
+    if len(beats) > SENSOR_BATCH_MAX_BEATS:
+        return 413, {"status": "error", "message": f"at most {SENSOR_BATCH_MAX_BEATS} beats per request"}
+
+    now = datetime.now()
+    timeout = timedelta(seconds=int(CFG.sensor_timeout))
+    results: list[int] = []
+    stored: list[_SensorBeat] = []
+    rows: list[dict] = []
+    for entry in beats:
+        status, beat, age_ms = await _parse_sensor_batch_beat(entry, data.get("building_id"))
+        if beat is not None and beat.event == "power_lost":
+            status, _ = await _process_sensor_power_lost(beat)
+        elif beat is not None:
+            stored.append(beat)
+            rows.append(
+                {
+                    "uuid": beat.sensor_uuid,
+                    "building_id": beat.building_id,
+                    "section_id": beat.section_id,
+                    "name": beat.name,
+                    "comment": beat.comment,
+                    "telemetry": beat.telemetry,
+                    "seq": beat.seq,
+                    "seq_restart": beat.event == "boot",
+                    # Beat, що пролежав в агрегаторі довше за таймаут, не має "оживити" сенсор заднім числом.
+                    "heard_at": now - min(timedelta(milliseconds=age_ms), timeout),
+                }
+            )
+        results.append(status)
+
+    if rows:
+        before = await upsert_sensor_heartbeats(rows)
+        for beat, sensor_before in zip(stored, before):
+            _sensor_heartbeat_stored(beat, sensor_before, sensor_before is None)
+        for beat, row in zip(stored, rows):
+            await _store_sensor_inputs(beat, row["heard_at"])
+
+    rejected = sum(1 for status in results if status != 200)
+    if rejected:
+        logger.warning(
+            "Sensor batch from %s: %s beats stored, %s rejected (%s)",
+            data.get("sensor_uuid"),
+            len(rows),
+            rejected,
+            results,
+        )
+    # "results" — першим: прошивка агрегатора читає лише початок тіла відповіді.
+    return 200, {"results": results, "status": "ok", "stored": len(rows), "timestamp": now.isoformat()}
+
+
+async def heartbeat_batch_handler(request: web.Request) -> web.Response:
+    """Пакет beat-ів від агрегатора будинку (POST /api/v1/heartbeat/batch)."""
+    try:
+        data = await request.json()
+    except Exception:
+        return web.json_response({"status": "error", "message": "Invalid JSON"}, status=400)
+    status, payload = await process_sensor_batch(data)
+    return _heartbeat_response(payload, status)
+
+
+# ─── UDP-транспорт heartbeat ───
+# Без TCP handshake і HTTP-заголовків: один beat = одна датаграма в кожен бік.
+
+SENSOR_UDP_MAX_DATAGRAM = 1024
+
+
+def _sensor_udp_ack(status: int, seq: object) -> bytes:
+    """Коротке ack для прошивки: "OK <seq>" / "ERR <status> <seq>" (seq — якщо був у датаграмі)."""
+    ack = "OK" if status == 200 else f"ERR {status}"
+    if isinstance(seq, int) and not isinstance(seq, bool):
+        ack = f"{ack} {seq}"
+    return ack.encode("ascii")
+
+
+class SensorHeartbeatUdpProtocol(asyncio.DatagramProtocol):
+    """UDP listener для heartbeat: кожна датаграма обробляється тим же process_sensor_heartbeat()."""
+
+    def __init__(self) -> None:
+        self.transport: asyncio.DatagramTransport | None = None
+        self._tasks: set[asyncio.Task] = set()
+
+    def connection_made(self, transport: asyncio.BaseTransport) -> None:
+        self.transport = transport  # type: ignore[assignment]
+
+    def datagram_received(self, data: bytes, addr: tuple) -> None:
+        if len(data) > SENSOR_UDP_MAX_DATAGRAM:
+            logger.warning("UDP heartbeat from %s dropped: %d bytes", addr[0], len(data))
+            return
+        task = asyncio.create_task(self._handle(data, addr))
+        self._tasks.add(task)
+        task.add_done_callback(self._tasks.discard)
+
+    async def _handle(self, data: bytes, addr: tuple) -> None:
+        if is_sensor_frame(data):
+            try:
+                status, _, seq = await process_sensor_frame(data)
+            except Exception:
+                logger.exception("UDP heartbeat frame from %s failed", addr[0])
+                status, seq = 500, None
+        else:
+            try:
+                payload = json.loads(data)
+            except ValueError:
+                logger.warning("UDP heartbeat from %s: invalid JSON", addr[0])
+                return
+            if not isinstance(payload, dict):
+                return
+            seq = payload.get("seq")
+            try:
+                status, _ = await process_sensor_heartbeat(payload)
+            except Exception:
+                logger.exception("UDP heartbeat from %s failed", addr[0])
+                status = 500
+        # На датаграми без валідного ключа не відповідаємо: listener не має бути відбивачем.
+        if status == 401:
+            return
+        if self.transport is not None and not self.transport.is_closing():
+            self.transport.sendto(_sensor_udp_ack(status, seq), addr)
 
 
 async def health_handler(request: web.Request) -> web.Response:
@@ -378,6 +1015,9 @@ async def sensors_info_handler(request: web.Request) -> web.Response:
                 "name": s["name"],
                 "comment": s.get("comment"),
                 "last_heartbeat": s["last_heartbeat"].isoformat() if s["last_heartbeat"] else None,
+                "power_lost_at": s["power_lost_at"].isoformat() if s.get("power_lost_at") else None,
+                "telemetry": s.get("telemetry"),
+                "heartbeat_seq": s.get("heartbeat_seq"),
             }
             for s in sensors
         ],
@@ -673,6 +1313,8 @@ async def _get_power_payload(building_id: int | None, section_id: int | None) ->
     sensors = await get_sensors_by_building(building_id)
     section_sensors = []
     for s in sensors:
+        if sensor_is_input_hub(s):
+            continue
         sid = s.get("section_id")
         if sid is None:
             sid = default_section_for_building(building_id)
@@ -684,10 +1326,8 @@ async def _get_power_payload(building_id: int | None, section_id: int | None) ->
     now = datetime.now()
     timeout = CFG.sensor_timeout
     for s in section_sensors:
-        if s["last_heartbeat"]:
-            delta = (now - s["last_heartbeat"]).total_seconds()
-            if delta < timeout:
-                sensors_online += 1
+        if sensor_heartbeat_is_fresh(s, now, timedelta(seconds=timeout)):
+            sensors_online += 1
 
     is_up = None
     if sensors_total > 0:
@@ -1158,6 +1798,8 @@ def create_api_app() -> web.Application:
     
     # Додаємо маршрути
     app.router.add_post("/api/v1/heartbeat", heartbeat_handler)
+    app.router.add_post("/api/v1/heartbeat/bulk", heartbeat_bulk_handler)
+    app.router.add_post("/api/v1/heartbeat/batch", heartbeat_batch_handler)
     app.router.add_get("/api/v1/health", health_handler)
     app.router.add_get("/api/v1/sensors", sensors_info_handler)
     app.router.add_get("/api/v1/public/sensors/status", public_sensors_status_handler)
@@ -1209,3 +1851,29 @@ async def stop_api_server(runner: web.AppRunner):
     """Зупинити API сервер."""
     await runner.cleanup()
     logger.info("API server stopped")
+
+
+async def start_sensor_udp_listener(
+    host: str = "0.0.0.0",
+    port: int | None = None,
+) -> asyncio.DatagramTransport | None:
+    """Запустити UDP listener для heartbeat (SENSOR_UDP_PORT=0 — вимкнено; явний port=0 — будь-який вільний)."""
+    if port is None:
+        if CFG.sensor_udp_port <= 0:
+            return None
+        port = CFG.sensor_udp_port
+    loop = asyncio.get_running_loop()
+    transport, _ = await loop.create_datagram_endpoint(
+        SensorHeartbeatUdpProtocol,
+        local_addr=(host, port),
+    )
+    logger.info("Sensor UDP heartbeat listener started on %s:%s", host, transport.get_extra_info("sockname")[1])
+    return transport
+
+
+async def stop_sensor_udp_listener(transport: asyncio.DatagramTransport | None):
+    """Зупинити UDP listener для heartbeat."""
+    if transport is None:
+        return
+    transport.close()
+    logger.info("Sensor UDP heartbeat listener stopped")
@@ -56,6 +56,8 @@ class Config:
     sensor_api_key: str  # API ключ для сенсорів
     sensor_public_api_key: str  # API ключ для read-only публічних ендпоінтів статусу сенсорів
     sensor_timeout: int  # Таймаут в секундах для визначення відключення
+    sensor_udp_port: int  # UDP порт для heartbeat (0 = UDP-транспорт вимкнено)
+    sensor_heartbeat_interval: int  # Період heartbeat для прошивки в секундах (0 = не задавати)
     # Canonical sensor mapping by UUID:
     # sensor_uuid -> canonical building_id used by backend (source of truth).
     sensor_uuid_building_map: dict[str, int]
@@ -128,6 +130,8 @@ def parse_sensor_aliases_from_env() -> dict[tuple[int, int], list[tuple[int, int
     - Invalid entries are ignored.
     - Self-mapping is ignored.
     - Duplicates are removed preserving order.
+    - A board that physically sees several sections should report them itself
+      (firmware PB_INPUTS, heartbeat "inputs" bitmask) instead of an alias.
     """
     mapping: dict[tuple[int, int], list[tuple[int, int]]] = {}
     valid_sections = {1, 2, 3}
@@ -283,6 +287,8 @@ CFG = Config(
     sensor_api_key=os.getenv("SENSOR_API_KEY", "").strip().strip('"').strip("'"),
     sensor_public_api_key=os.getenv("SENSOR_PUBLIC_API_KEY", "").strip().strip('"').strip("'"),
     sensor_timeout=int(os.getenv("SENSOR_TIMEOUT_SEC", "150")),
+    sensor_udp_port=int(os.getenv("SENSOR_UDP_PORT", "0")),
+    sensor_heartbeat_interval=int(os.getenv("SENSOR_HEARTBEAT_INTERVAL_SEC", "0")),
     sensor_uuid_building_map=parse_sensor_uuid_building_map_from_env(DEFAULT_SENSOR_UUID_BUILDING_MAP),
     sensor_aliases=parse_sensor_aliases_from_env(),
     web_app_enabled=parse_bool(os.getenv("WEB_APP", "0")),
@@ -197,7 +197,9 @@ async def init_db():
                 event_type TEXT NOT NULL,
                 timestamp TEXT NOT NULL,
                 building_id INTEGER DEFAULT NULL,
-                section_id INTEGER DEFAULT NULL
+                section_id INTEGER DEFAULT NULL,
+                refuted_at TEXT DEFAULT NULL,
+                refuted_by TEXT DEFAULT NULL
             )"""
         )
         # Міграція: додати колонки quiet_start/quiet_end якщо їх немає
@@ -609,6 +611,15 @@ async def init_db():
             await db.execute("ALTER TABLE events ADD COLUMN section_id INTEGER DEFAULT NULL")
         except Exception:
             pass
+        # Міграція: події, які спростував офлайн-журнал сенсора, позначаються, а не видаляються
+        try:
+            await db.execute("ALTER TABLE events ADD COLUMN refuted_at TEXT DEFAULT NULL")
+        except Exception:
+            pass
+        try:
+            await db.execute("ALTER TABLE events ADD COLUMN refuted_by TEXT DEFAULT NULL")
+        except Exception:
+            pass
         try:
             await db.execute(
                 """
@@ -636,6 +647,13 @@ async def init_db():
                 last_heartbeat TEXT,
                 created_at TEXT NOT NULL,
                 is_active INTEGER DEFAULT 1,
+                telemetry_json TEXT DEFAULT NULL,
+                power_lost_at TEXT DEFAULT NULL,
+                hb_seq INTEGER DEFAULT NULL,
+                hb_received INTEGER DEFAULT 0,
+                hb_lost INTEGER DEFAULT 0,
+                frame_cursor INTEGER DEFAULT NULL,
+                frame_boot INTEGER DEFAULT NULL,
                 FOREIGN KEY (building_id) REFERENCES buildings(id)
             )"""
         )
@@ -661,6 +679,34 @@ async def init_db():
             await db.execute("ALTER TABLE sensors ADD COLUMN frozen_at TEXT DEFAULT NULL")
         except Exception:
             pass
+        try:
+            await db.execute("ALTER TABLE sensors ADD COLUMN telemetry_json TEXT DEFAULT NULL")
+        except Exception:
+            pass
+        try:
+            await db.execute("ALTER TABLE sensors ADD COLUMN power_lost_at TEXT DEFAULT NULL")
+        except Exception:
+            pass
+        try:
+            await db.execute("ALTER TABLE sensors ADD COLUMN hb_seq INTEGER DEFAULT NULL")
+        except Exception:
+            pass
+        try:
+            await db.execute("ALTER TABLE sensors ADD COLUMN hb_received INTEGER DEFAULT 0")
+        except Exception:
+            pass
+        try:
+            await db.execute("ALTER TABLE sensors ADD COLUMN hb_lost INTEGER DEFAULT 0")
+        except Exception:
+            pass
+        try:
+            await db.execute("ALTER TABLE sensors ADD COLUMN frame_cursor INTEGER DEFAULT NULL")
+        except Exception:
+            pass
+        try:
+            await db.execute("ALTER TABLE sensors ADD COLUMN frame_boot INTEGER DEFAULT NULL")
+        except Exception:
+            pass
         try:
             await db.execute(
                 """
@@ -689,6 +735,20 @@ async def init_db():
         await db.execute(
             "CREATE INDEX IF NOT EXISTS idx_sensor_public_ids_sensor_uuid ON sensor_public_ids (sensor_uuid)"
         )
+
+        # Офлайн-журнал сенсорів (POST /api/v1/heartbeat/bulk): beat-и, що не дійшли вчасно.
+        await db.execute(
+            """CREATE TABLE IF NOT EXISTS sensor_journal_beats (
+                sensor_uuid TEXT NOT NULL,
+                ts TEXT NOT NULL,
+                seq INTEGER NOT NULL,
+                received_at TEXT NOT NULL,
+                FOREIGN KEY (sensor_uuid) REFERENCES sensors(uuid) ON DELETE CASCADE
+            )"""
+        )
+        await db.execute(
+            "CREATE INDEX IF NOT EXISTS idx_sensor_journal_beats_sensor_ts ON sensor_journal_beats (sensor_uuid, ts)"
+        )
         try:
             now_iso = datetime.now().isoformat()
             await db.execute(
@@ -1861,7 +1921,7 @@ async def get_last_event(
     Повертає (event_type, timestamp) або None.
     """
     async with open_db() as db:
-        clauses: list[str] = []
+        clauses: list[str] = ["refuted_at IS NULL"]
         params: list[object] = []
         if event_type:
             clauses.append("event_type=?")
@@ -1873,8 +1933,7 @@ async def get_last_event(
             clauses.append("building_id=?")
             params.append(building_id)
 
-        where = f"WHERE {' AND '.join(clauses)}" if clauses else ""
-        query = f"SELECT event_type, timestamp FROM events {where} ORDER BY id DESC LIMIT 1"
+        query = f"SELECT event_type, timestamp FROM events WHERE {' AND '.join(clauses)} ORDER BY id DESC LIMIT 1"
 
         async with db.execute(query, tuple(params)) as cur:
             row = await cur.fetchone()
@@ -1890,7 +1949,7 @@ async def get_last_event_before(
 ) -> tuple[str, datetime] | None:
     """Отримати останню подію до вказаного часу."""
     async with open_db() as db:
-        clauses = ["timestamp < ?"]
+        clauses = ["timestamp < ?", "refuted_at IS NULL"]
         params: list[object] = [before.isoformat()]
         if building_id is not None and section_id is not None:
             clauses.append("building_id=? AND section_id=?")
@@ -1914,7 +1973,7 @@ async def get_events_since(
 ) -> list[tuple[str, datetime]]:
     """Отримати всі події після вказаного часу."""
     async with open_db() as db:
-        clauses = ["timestamp >= ?"]
+        clauses = ["timestamp >= ?", "refuted_at IS NULL"]
         params: list[object] = [since.isoformat()]
         if building_id is not None and section_id is not None:
             clauses.append("building_id=? AND section_id=?")
@@ -1932,10 +1991,11 @@ async def get_events_since(
 async def get_all_events(
     building_id: int | None = None,
     section_id: int | None = None,
+    include_refuted: bool = False,
 ) -> list[tuple[str, datetime]]:
-    """Отримати всі події."""
+    """Отримати всі події (include_refuted=True — разом зі спростованими офлайн-журналом, для аудиту)."""
     async with open_db() as db:
-        clauses: list[str] = []
+        clauses: list[str] = [] if include_refuted else ["refuted_at IS NULL"]
         params: list[object] = []
         if building_id is not None and section_id is not None:
             clauses.append("building_id=? AND section_id=?")
@@ -1958,7 +2018,7 @@ async def get_last_events(
 ) -> list[tuple[str, datetime]]:
     """Отримати останні N подій (за замовчуванням 2)."""
     async with open_db() as db:
-        clauses: list[str] = []
+        clauses: list[str] = ["refuted_at IS NULL"]
         params: list[object] = []
         if building_id is not None and section_id is not None:
             clauses.append("building_id=? AND section_id=?")
@@ -1967,8 +2027,7 @@ async def get_last_events(
             clauses.append("building_id=?")
             params.append(building_id)
 
-        where = f"WHERE {' AND '.join(clauses)}" if clauses else ""
-        query = f"SELECT event_type, timestamp FROM events {where} ORDER BY id DESC LIMIT ?"
+        query = f"SELECT event_type, timestamp FROM events WHERE {' AND '.join(clauses)} ORDER BY id DESC LIMIT ?"
         params.append(limit)
 
         async with db.execute(query, tuple(params)) as cur:
@@ -3515,57 +3574,461 @@ async def sync_building_sensor_stats(building_id: int | None = None) -> None:
 
     await _with_sqlite_retry(_op)
 
+def _parse_sensor_telemetry(raw: str | None) -> dict | None:
+    """Розпарсити sensors.telemetry_json (битий JSON не має ламати список сенсорів)."""
+    if not raw:
+        return None
+    try:
+        value = json.loads(raw)
+    except (TypeError, ValueError):
+        return None
+    return value if isinstance(value, dict) else None
+
+
+def sensor_heartbeat_is_fresh(sensor: dict, now: datetime, timeout: timedelta) -> bool:
+    """
+    Онлайн-статус сенсора лише за heartbeat (без урахування freeze):
+    останній beat молодший за timeout і після нього сенсор не надсилав last-gasp "power_lost".
+    """
+    last_heartbeat = sensor.get("last_heartbeat")
+    if not last_heartbeat or (now - last_heartbeat) >= timeout:
+        return False
+    power_lost_at = sensor.get("power_lost_at")
+    return not (power_lost_at and power_lost_at >= last_heartbeat)
+
+
+def sensor_is_input_hub(sensor: dict) -> bool:
+    """
+    Плата з входами (прошивка PB_INPUTS, у telemetry є "inputs"): секції за неї звітують
+    сенсори-входи "<uuid>#in<N>", а живлення самої плати (часто від ДБЖ) — не світло секції.
+    """
+    telemetry = sensor.get("telemetry")
+    return isinstance(telemetry, dict) and "inputs" in telemetry
+
+
+# Наскільки "назад" може прийти seq, щоб вважатись дублем / запізнілим UDP-пакетом,
+# а не перезапуском лічильника на прошивці.
+HEARTBEAT_SEQ_REORDER_WINDOW = 64
+
+
+def advance_heartbeat_seq(
+    last_seq: int | None,
+    received: int,
+    lost: int,
+    seq: int,
+    *,
+    restart: bool = False,
+) -> tuple[int, int, int]:
+    """
+    Облік втрат heartbeat за seq (лічильник прошивки, +1 на кожен beat з моменту boot).
+    Повертає нові (last_seq, received, lost).
+
+    - пропуск у seq -> пропущені beat рахуються як загублені;
+    - дубль / запізнілий пакет у межах вікна -> ігнорується (вже врахований як втрата);
+    - boot або seq далеко "назад" -> лічильник на прошивці перезапустився, нова база.
+    """
+    if last_seq is None or restart:
+        return seq, received + 1, lost
+    if seq > last_seq:
+        return seq, received + 1, lost + (seq - last_seq - 1)
+    if last_seq - seq < HEARTBEAT_SEQ_REORDER_WINDOW:
+        return last_seq, received, lost
+    return seq, received + 1, lost
+
+
+def sensor_frame_cursor(event: str, seq: int) -> int:
+    """Позиція beat у межах boot: power_lost несе seq останнього beat, тож іде одразу після нього."""
+    return seq * 2 + (1 if event == "power_lost" else 0)
+
+
+def sensor_frame_is_new(
+    cursor: int | None,
+    cursor_boot: int | None,
+    event: str,
+    seq: int,
+    boot_count: int,
+) -> bool:
+    """
+    Захист від повтору підписаного frame (HMAC не містить часу — перехоплений frame валідний завжди).
+    cursor/cursor_boot — останній прийнятий beat сенсора (frame або JSON з seq).
+
+    Frame новий, якщо (boot_count, позиція) строго більші: boot_count — лічильник завантажень
+    з NVS прошивки і назад не йде, тож frame-и (і boot) з минулих епох не проходять.
+    """
+    if cursor is None:
+        return True
+    last_boot = cursor_boot or 0
+    if boot_count != last_boot:
+        return boot_count > last_boot
+    return sensor_frame_cursor(event, seq) > cursor
+
+
+async def accept_sensor_frame(uuid: str, event: str, seq: int, boot_count: int) -> bool:
+    """
+    Атомарно перевірити frame на повтор (sensor_frame_is_new) і зсунути курсор сенсора.
+    False — повтор або застарілий frame: стан сенсора не змінено.
+    """
+    async def _op() -> bool:
+        async with open_db() as db:
+            await db.execute("BEGIN IMMEDIATE")
+            async with db.execute("SELECT frame_cursor, frame_boot FROM sensors WHERE uuid=?", (uuid,)) as cur:
+                row = await cur.fetchone()
+            if row is not None and not sensor_frame_is_new(row[0], row[1], event, seq, boot_count):
+                await db.execute("ROLLBACK")
+                return False
+            await db.execute(
+                "UPDATE sensors SET frame_cursor=?, frame_boot=? WHERE uuid=?",
+                (sensor_frame_cursor(event, seq), boot_count, uuid),
+            )
+            await db.execute("COMMIT")
+            return True
+
+    return await _with_sqlite_retry(_op)
+
+
+async def _upsert_sensor_heartbeat_in_tx(
+    db: aiosqlite.Connection,
+    uuid: str,
+    building_id: int,
+    section_id: int | None,
+    name: str | None,
+    comment: str | None,
+    telemetry: dict | None,
+    seq: int | None,
+    seq_restart: bool,
+    heard_at: str,
+    sync_building_ids: set[int],
+) -> dict | None:
+    """
+    Upsert одного beat у відкритій транзакції. Будинки, лічильники сенсорів яких треба
+    перерахувати, додаються в sync_building_ids (рахує caller — один раз на транзакцію).
+    Повертає стан сенсора до beat або None, якщо сенсор новий.
+    """
+    telemetry_json = json.dumps(telemetry, separators=(",", ":"), sort_keys=True) if telemetry else None
+    async with db.execute(
+        """
+        SELECT building_id, is_active, hb_seq, hb_received, hb_lost, section_id, last_heartbeat, power_lost_at
+          FROM sensors WHERE uuid=?
+        """,
+        (uuid,),
+    ) as cur:
+        prev_row = await cur.fetchone()
+    existed = prev_row is not None
+    prev_building_id = int(prev_row[0]) if prev_row and prev_row[0] is not None else None
+    prev_is_active = bool(prev_row[1]) if prev_row and prev_row[1] is not None else False
+
+    hb_seq = hb_received = hb_lost = None
+    if seq is not None:
+        hb_seq, hb_received, hb_lost = advance_heartbeat_seq(
+            prev_row[2] if prev_row else None,
+            int(prev_row[3] or 0) if prev_row else 0,
+            int(prev_row[4] or 0) if prev_row else 0,
+            seq,
+            restart=seq_restart,
+        )
+
+    await db.execute(
+        """
+        INSERT INTO sensors(
+            uuid, building_id, section_id, name, comment, last_heartbeat, created_at, is_active, telemetry_json,
+            hb_seq, hb_received, hb_lost
+        )
+        VALUES(?, ?, ?, ?, ?, ?, ?, 1, ?, ?, COALESCE(?, 0), COALESCE(?, 0))
+        ON CONFLICT(uuid) DO UPDATE SET
+            building_id=excluded.building_id,
+            section_id=excluded.section_id,
+            name=COALESCE(excluded.name, sensors.name),
+            comment=COALESCE(excluded.comment, sensors.comment),
+            -- beat з агрегатора приходить "постарілим" (heard_at = now - age_ms): не відкочуємо
+            -- last_heartbeat назад і не знімаємо power_lost_at, новіший за сам beat.
+            last_heartbeat=MAX(COALESCE(sensors.last_heartbeat, excluded.last_heartbeat), excluded.last_heartbeat),
+            is_active=1,
+            telemetry_json=COALESCE(excluded.telemetry_json, sensors.telemetry_json),
+            power_lost_at=CASE
+                WHEN sensors.power_lost_at IS NULL OR excluded.last_heartbeat > sensors.power_lost_at THEN NULL
+                ELSE sensors.power_lost_at
+            END,
+            hb_seq=COALESCE(?, sensors.hb_seq),
+            hb_received=COALESCE(?, sensors.hb_received),
+            hb_lost=COALESCE(?, sensors.hb_lost)
+        """,
+        (
+            uuid, building_id, section_id, name, comment, heard_at, heard_at, telemetry_json,
+            hb_seq, hb_received, hb_lost,
+            hb_seq, hb_received, hb_lost,
+        ),
+    )
+
+    if not existed:
+        sync_building_ids.add(int(building_id))
+        return None
+    if prev_building_id is not None and prev_building_id != int(building_id):
+        sync_building_ids.add(prev_building_id)
+        sync_building_ids.add(int(building_id))
+    elif not prev_is_active:
+        sync_building_ids.add(int(building_id))
+    return {
+        "uuid": uuid,
+        "building_id": prev_building_id,
+        "section_id": prev_row[5],
+        "is_active": prev_is_active,
+        "last_heartbeat": datetime.fromisoformat(prev_row[6]) if prev_row[6] else None,
+        "power_lost_at": datetime.fromisoformat(prev_row[7]) if prev_row[7] else None,
+    }
+
+
 async def upsert_sensor_heartbeat(
     uuid: str,
     building_id: int,
     section_id: int | None,
     name: str | None = None,
     comment: str | None = None,
+    telemetry: dict | None = None,
+    seq: int | None = None,
+    seq_restart: bool = False,
+    boot_count: int | None = None,
 ) -> bool:
     """
-    Upsert сенсора + оновити last_heartbeat.
+    Upsert сенсора + оновити last_heartbeat (і зняти power_lost_at: сенсор знову живий).
+    last_heartbeat не йде назад, power_lost_at новіший за beat лишається.
+    telemetry — службові метрики з heartbeat (зберігаються як останній знімок).
+    seq — порядковий номер beat з прошивки для обліку втрат (seq_restart=True на boot).
+    boot_count — лічильник завантажень прошивки; разом із seq ставить курсор захисту frame
+    від повтору (JSON несе api_key, тож йому довіряємо: JSON boot — нова база для frame-ів).
     Повертає True якщо сенсор був створений, False якщо оновлений.
     """
     async def _op() -> bool:
         async with open_db() as db:
-            now = datetime.now().isoformat()
+            sync_building_ids: set[int] = set()
+            prev = await _upsert_sensor_heartbeat_in_tx(
+                db, uuid, building_id, section_id, name, comment, telemetry, seq, seq_restart,
+                datetime.now().isoformat(), sync_building_ids,
+            )
+            if seq is not None:
+                await db.execute(
+                    "UPDATE sensors SET frame_cursor=?, frame_boot=? WHERE uuid=?",
+                    (sensor_frame_cursor("heartbeat", seq), boot_count or 0, uuid),
+                )
+            if sync_building_ids:
+                await _sync_building_sensor_stats_in_tx(db, sync_building_ids)
+            await db.commit()
+            return prev is None
+
+    return await _with_sqlite_retry(_op)
+
+
+async def upsert_sensor_heartbeats(beats: list[dict]) -> list[dict | None]:
+    """
+    Пакет beat-ів (агрегатор будинку) однією транзакцією: для кожного — те саме, що
+    upsert_sensor_heartbeat(), лічильники будинків перераховуються один раз.
+
+    Елемент beats: uuid, building_id, section_id, name, comment, telemetry, seq, seq_restart
+    (як аргументи upsert_sensor_heartbeat) і heard_at — коли beat почув агрегатор.
+    Повертає для кожного стан сенсора до beat (uuid, building_id, section_id, is_active,
+    last_heartbeat, power_lost_at) або None, якщо сенсор новий.
+    """
+    async def _op() -> list[dict | None]:
+        async with open_db() as db:
+            await db.execute("BEGIN IMMEDIATE")
+            sync_building_ids: set[int] = set()
+            before: list[dict | None] = []
+            for beat in beats:
+                before.append(
+                    await _upsert_sensor_heartbeat_in_tx(
+                        db,
+                        beat["uuid"],
+                        beat["building_id"],
+                        beat.get("section_id"),
+                        beat.get("name"),
+                        beat.get("comment"),
+                        beat.get("telemetry"),
+                        beat.get("seq"),
+                        bool(beat.get("seq_restart")),
+                        beat["heard_at"].isoformat(),
+                        sync_building_ids,
+                    )
+                )
+            if sync_building_ids:
+                await _sync_building_sensor_stats_in_tx(db, sync_building_ids)
+            await db.execute("COMMIT")
+            return before
+
+    return await _with_sqlite_retry(_op)
+
+
+async def upsert_sensor_inputs(building_id: int, channels: list[dict], heard_at: datetime) -> list[dict | None]:
+    """
+    Входи плати з кількома секціями (прошивка PB_INPUTS) однією транзакцією: кожен вхід —
+    окремий сенсор "<uuid плати>#in<N>" у своїй секції, тож стан секції рахується як для
+    звичайних сенсорів. Вхід без живлення лишається зареєстрованим, але offline
+    (power_lost_at = heard_at, як після last-gasp).
+
+    Елемент channels: uuid, section_id, name, on. Повертає для кожного стан сенсора до beat
+    або None, якщо сенсор новий (як upsert_sensor_heartbeats()).
+    """
+    async def _op() -> list[dict | None]:
+        async with open_db() as db:
+            await db.execute("BEGIN IMMEDIATE")
+            sync_building_ids: set[int] = set()
+            before: list[dict | None] = []
+            heard_at_iso = heard_at.isoformat()
+            for channel in channels:
+                before.append(
+                    await _upsert_sensor_heartbeat_in_tx(
+                        db,
+                        channel["uuid"],
+                        building_id,
+                        channel["section_id"],
+                        channel.get("name"),
+                        None,
+                        None,
+                        None,
+                        False,
+                        heard_at_iso,
+                        sync_building_ids,
+                    )
+                )
+                if not channel["on"]:
+                    await db.execute("UPDATE sensors SET power_lost_at=? WHERE uuid=?", (heard_at_iso, channel["uuid"]))
+            if sync_building_ids:
+                await _sync_building_sensor_stats_in_tx(db, sync_building_ids)
+            await db.execute("COMMIT")
+            return before
+
+    return await _with_sqlite_retry(_op)
+
+
+# Повторна доставка того самого журналу (відповідь загубилась) дає ті самі seq з часом,
+# зсунутим на похибку uptime -> годинник сервера; такі записи не дублюємо.
+SENSOR_JOURNAL_DEDUP_WINDOW = timedelta(seconds=60)
+
+
+def journal_alive_spans(
+    beats: list[tuple[int, datetime]],
+    max_gap: timedelta,
+) -> list[tuple[datetime, datetime]]:
+    """
+    Відрізки, коли сенсор гарантовано мав живлення, з офлайн-журналу.
+    beats — (seq, ts) у порядку журналу; seq 0 — маркер втрати живлення (last-gasp), він
+    розриває відрізок. Розрив більший за max_gap теж розриває відрізок.
+    """
+    spans: list[tuple[datetime, datetime]] = []
+    start: datetime | None = None
+    end: datetime | None = None
+    for seq, ts in beats:
+        if seq == 0 or (end is not None and ts - end > max_gap):
+            if start is not None and end is not None:
+                spans.append((start, end))
+            start = end = None
+            if seq == 0:
+                continue
+        if start is None:
+            start = ts
+        end = ts
+    if start is not None and end is not None:
+        spans.append((start, end))
+    return spans
+
+
+async def backfill_sensor_journal(
+    uuid: str,
+    beats: list[tuple[int, datetime]],
+    max_gap: timedelta,
+) -> tuple[int, int] | None:
+    """
+    Догрузити офлайн-журнал сенсора однією транзакцією: beat-и -> sensor_journal_beats,
+    а пари подій down/up секції, що повністю лежать у відрізку "живлення було"
+    (journal_alive_spans), позначаються refuted_at/refuted_by — це був збій зв'язку, а не
+    відключення світла. Події лишаються в таблиці для аудиту, читачі історії їх пропускають.
+    Повертає (збережено beat-ів, спростовано подій) або None, якщо активного сенсора немає.
+    """
+    received_at = datetime.now().isoformat()
+    rows = [
+        (
+            uuid, ts.isoformat(), seq, received_at,
+            uuid, seq, (ts - SENSOR_JOURNAL_DEDUP_WINDOW).isoformat(), (ts + SENSOR_JOURNAL_DEDUP_WINDOW).isoformat(),
+        )
+        for seq, ts in beats
+        if seq > 0
+    ]
+    spans = journal_alive_spans(beats, max_gap)
+
+    async def _op() -> tuple[int, int] | None:
+        async with open_db() as db:
+            await db.execute("BEGIN IMMEDIATE")
             async with db.execute(
-                "SELECT building_id, is_active FROM sensors WHERE uuid=?",
+                "SELECT building_id, section_id FROM sensors WHERE uuid=? AND is_active=1",
                 (uuid,),
             ) as cur:
-                prev_row = await cur.fetchone()
-            existed = prev_row is not None
-            prev_building_id = int(prev_row[0]) if prev_row and prev_row[0] is not None else None
-            prev_is_active = bool(prev_row[1]) if prev_row and prev_row[1] is not None else False
+                sensor = await cur.fetchone()
+            if sensor is None:
+                await db.execute("ROLLBACK")
+                return None
+            building_id = int(sensor[0])
+            section_id = sensor[1] if sensor[1] is not None else default_section_for_building(building_id)
 
-            await db.execute(
+            async with db.execute("SELECT total_changes()") as cur:
+                before = int((await cur.fetchone())[0])
+            await db.executemany(
                 """
-                INSERT INTO sensors(uuid, building_id, section_id, name, comment, last_heartbeat, created_at, is_active)
-                VALUES(?, ?, ?, ?, ?, ?, ?, 1)
-                ON CONFLICT(uuid) DO UPDATE SET
-                    building_id=excluded.building_id,
-                    section_id=excluded.section_id,
-                    name=COALESCE(excluded.name, sensors.name),
-                    comment=COALESCE(excluded.comment, sensors.comment),
-                    last_heartbeat=excluded.last_heartbeat,
-                    is_active=1
+                INSERT INTO sensor_journal_beats(sensor_uuid, ts, seq, received_at)
+                SELECT ?, ?, ?, ?
+                 WHERE NOT EXISTS (
+                       SELECT 1 FROM sensor_journal_beats
+                        WHERE sensor_uuid=? AND seq=? AND ts BETWEEN ? AND ?
+                 )
                 """,
-                (uuid, building_id, section_id, name, comment, now, now),
+                rows,
             )
+            async with db.execute("SELECT total_changes()") as cur:
+                stored = int((await cur.fetchone())[0]) - before
+
+            refuted_ids: list[int] = []
+            if section_id is not None:
+                for start, end in spans:
+                    async with db.execute(
+                        """
+                        SELECT id, event_type, timestamp FROM events
+                         WHERE building_id=? AND section_id=? AND timestamp >= ? AND timestamp <= ?
+                           AND refuted_at IS NULL
+                         ORDER BY timestamp, id
+                        """,
+                        (building_id, int(section_id), start.isoformat(), (end + max_gap).isoformat()),
+                    ) as cur:
+                        events = await cur.fetchall()
+                    for prev, nxt in zip(events, events[1:]):
+                        if (
+                            prev[1] == "down"
+                            and nxt[1] == "up"
+                            and datetime.fromisoformat(prev[2]) <= end
+                            and int(prev[0]) not in refuted_ids
+                        ):
+                            refuted_ids.extend((int(prev[0]), int(nxt[0])))
+            if refuted_ids:
+                await db.executemany(
+                    "UPDATE events SET refuted_at=?, refuted_by=? WHERE id=?",
+                    [(received_at, uuid, i) for i in refuted_ids],
+                )
+            await db.execute("COMMIT")
+            return stored, len(refuted_ids)
 
-            sync_building_ids: set[int] = set()
-            if not existed:
-                sync_building_ids.add(int(building_id))
-            else:
-                if prev_building_id is not None and prev_building_id != int(building_id):
-                    sync_building_ids.add(prev_building_id)
-                    sync_building_ids.add(int(building_id))
-                elif not prev_is_active:
-                    sync_building_ids.add(int(building_id))
-            if sync_building_ids:
-                await _sync_building_sensor_stats_in_tx(db, sync_building_ids)
+    return await _with_sqlite_retry(_op)
+
+
+async def mark_sensor_power_lost(uuid: str) -> bool:
+    """
+    Зафіксувати last-gasp "power_lost" від сенсора: до наступного heartbeat він вважається offline.
+    Повертає True якщо активний сенсор знайдено.
+    """
+    async def _op() -> bool:
+        async with open_db() as db:
+            now = datetime.now().isoformat()
+            cursor = await db.execute(
+                "UPDATE sensors SET power_lost_at=? WHERE uuid=? AND is_active=1",
+                (now, uuid),
+            )
             await db.commit()
-            return not existed
+            return cursor.rowcount > 0
 
     return await _with_sqlite_retry(_op)
 
@@ -3635,6 +4098,14 @@ async def update_sensor_heartbeat(uuid: str) -> bool:
     return await _with_sqlite_retry(_op)
 
 
+async def get_all_sensor_uuids() -> list[str]:
+    """UUID усіх сенсорів (включно з неактивними) — для пошуку за uuid_hash з бінарного heartbeat."""
+    async with open_db() as db:
+        async with db.execute("SELECT uuid FROM sensors") as cur:
+            rows = await cur.fetchall()
+    return [str(row[0]) for row in rows]
+
+
 async def get_sensor_by_uuid(uuid: str) -> dict | None:
     """Отримати сенсор за UUID."""
     async with open_db() as db:
@@ -3643,7 +4114,7 @@ async def get_sensor_by_uuid(uuid: str) -> dict | None:
             """
             SELECT uuid, building_id, section_id, name, comment,
                    frozen_until, frozen_is_up, frozen_at,
-                   last_heartbeat, created_at, is_active
+                   last_heartbeat, power_lost_at, created_at, is_active
               FROM sensors
              WHERE uuid=?
             """,
@@ -3661,6 +4132,7 @@ async def get_sensor_by_uuid(uuid: str) -> dict | None:
                     "frozen_is_up": (bool(row["frozen_is_up"]) if row["frozen_is_up"] is not None else None),
                     "frozen_at": datetime.fromisoformat(row["frozen_at"]) if row["frozen_at"] else None,
                     "last_heartbeat": datetime.fromisoformat(row["last_heartbeat"]) if row["last_heartbeat"] else None,
+                    "power_lost_at": datetime.fromisoformat(row["power_lost_at"]) if row["power_lost_at"] else None,
                     "created_at": datetime.fromisoformat(row["created_at"]),
                     "is_active": bool(row["is_active"]),
                 }
@@ -3699,7 +4171,7 @@ async def get_active_sensor_by_public_id(public_id: int) -> dict | None:
             SELECT spi.id AS public_id,
                    s.uuid, s.building_id, s.section_id, s.name, s.comment,
                    s.frozen_until, s.frozen_is_up, s.frozen_at,
-                   s.last_heartbeat, s.created_at, s.is_active
+                   s.last_heartbeat, s.power_lost_at, s.created_at, s.is_active
               FROM sensor_public_ids spi
               JOIN sensors s ON s.uuid = spi.sensor_uuid
              WHERE spi.id=?
@@ -3720,6 +4192,7 @@ async def get_active_sensor_by_public_id(public_id: int) -> dict | None:
                     "frozen_is_up": (bool(row["frozen_is_up"]) if row["frozen_is_up"] is not None else None),
                     "frozen_at": datetime.fromisoformat(row["frozen_at"]) if row["frozen_at"] else None,
                     "last_heartbeat": datetime.fromisoformat(row["last_heartbeat"]) if row["last_heartbeat"] else None,
+                    "power_lost_at": datetime.fromisoformat(row["power_lost_at"]) if row["power_lost_at"] else None,
                     "created_at": datetime.fromisoformat(row["created_at"]),
                     "is_active": bool(row["is_active"]),
                 }
@@ -3736,7 +4209,7 @@ async def get_all_active_sensors_with_public_ids() -> list[dict]:
             SELECT spi.id AS public_id,
                    s.uuid, s.building_id, s.section_id, s.name, s.comment,
                    s.frozen_until, s.frozen_is_up, s.frozen_at,
-                   s.last_heartbeat, s.created_at
+                   s.last_heartbeat, s.power_lost_at, s.created_at
               FROM sensor_public_ids spi
               JOIN sensors s ON s.uuid = spi.sensor_uuid
              WHERE s.is_active=1
@@ -3756,6 +4229,7 @@ async def get_all_active_sensors_with_public_ids() -> list[dict]:
                     "frozen_is_up": (bool(row["frozen_is_up"]) if row["frozen_is_up"] is not None else None),
                     "frozen_at": datetime.fromisoformat(row["frozen_at"]) if row["frozen_at"] else None,
                     "last_heartbeat": datetime.fromisoformat(row["last_heartbeat"]) if row["last_heartbeat"] else None,
+                    "power_lost_at": datetime.fromisoformat(row["power_lost_at"]) if row["power_lost_at"] else None,
                     "created_at": datetime.fromisoformat(row["created_at"]),
                 }
                 for row in rows
@@ -3770,7 +4244,7 @@ async def get_sensors_by_building(building_id: int) -> list[dict]:
             """
             SELECT uuid, building_id, section_id, name, comment,
                    frozen_until, frozen_is_up, frozen_at,
-                   last_heartbeat, created_at
+                   last_heartbeat, power_lost_at, created_at, telemetry_json
               FROM sensors
              WHERE building_id=? AND is_active=1
             """,
@@ -3788,7 +4262,9 @@ async def get_sensors_by_building(building_id: int) -> list[dict]:
                     "frozen_is_up": (bool(row["frozen_is_up"]) if row["frozen_is_up"] is not None else None),
                     "frozen_at": datetime.fromisoformat(row["frozen_at"]) if row["frozen_at"] else None,
                     "last_heartbeat": datetime.fromisoformat(row["last_heartbeat"]) if row["last_heartbeat"] else None,
+                    "power_lost_at": datetime.fromisoformat(row["power_lost_at"]) if row["power_lost_at"] else None,
                     "created_at": datetime.fromisoformat(row["created_at"]),
+                    "telemetry": _parse_sensor_telemetry(row["telemetry_json"]),
                 }
                 for row in rows
             ]
@@ -3802,7 +4278,7 @@ async def get_sensors_by_building_section(building_id: int, section_id: int) ->
             """
             SELECT uuid, building_id, section_id, name, comment,
                    frozen_until, frozen_is_up, frozen_at,
-                   last_heartbeat, created_at
+                   last_heartbeat, power_lost_at, created_at
               FROM sensors
              WHERE building_id=?
                AND section_id=?
@@ -3822,6 +4298,7 @@ async def get_sensors_by_building_section(building_id: int, section_id: int) ->
                     "frozen_is_up": (bool(row["frozen_is_up"]) if row["frozen_is_up"] is not None else None),
                     "frozen_at": datetime.fromisoformat(row["frozen_at"]) if row["frozen_at"] else None,
                     "last_heartbeat": datetime.fromisoformat(row["last_heartbeat"]) if row["last_heartbeat"] else None,
+                    "power_lost_at": datetime.fromisoformat(row["power_lost_at"]) if row["power_lost_at"] else None,
                     "created_at": datetime.fromisoformat(row["created_at"]),
                 }
                 for row in rows
@@ -3836,7 +4313,8 @@ async def get_all_active_sensors() -> list[dict]:
             """
             SELECT uuid, building_id, section_id, name, comment,
                    frozen_until, frozen_is_up, frozen_at,
-                   last_heartbeat, created_at
+                   last_heartbeat, power_lost_at, created_at, telemetry_json,
+                   hb_seq, hb_received, hb_lost
               FROM sensors
              WHERE is_active=1
             """
@@ -3853,7 +4331,18 @@ async def get_all_active_sensors() -> list[dict]:
                     "frozen_is_up": (bool(row["frozen_is_up"]) if row["frozen_is_up"] is not None else None),
                     "frozen_at": datetime.fromisoformat(row["frozen_at"]) if row["frozen_at"] else None,
                     "last_heartbeat": datetime.fromisoformat(row["last_heartbeat"]) if row["last_heartbeat"] else None,
+                    "power_lost_at": datetime.fromisoformat(row["power_lost_at"]) if row["power_lost_at"] else None,
                     "created_at": datetime.fromisoformat(row["created_at"]),
+                    "telemetry": _parse_sensor_telemetry(row["telemetry_json"]),
+                    "heartbeat_seq": (
+                        {
+                            "last": row["hb_seq"],
+                            "received": int(row["hb_received"] or 0),
+                            "lost": int(row["hb_lost"] or 0),
+                        }
+                        if row["hb_seq"] is not None
+                        else None
+                    ),
                 }
                 for row in rows
             ]
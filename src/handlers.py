@@ -25,7 +25,9 @@ from database import (
     set_sponsored_offers_enabled, sponsored_offers_enabled_key,
     get_offers_digest_enabled, set_offers_digest_enabled,
     has_any_published_verified_business_place,
-    get_last_event, get_subscriber_building, get_building_by_id, save_last_bot_message
+    get_last_event, get_subscriber_building, get_building_by_id, save_last_bot_message,
+    sensor_heartbeat_is_fresh,
+    sensor_is_input_hub,
 )
 from services import state_text, calculate_stats, format_duration, format_light_status
 
@@ -309,13 +311,15 @@ async def get_light_status_text(user_id: int) -> str:
     now = datetime.now()
     timeout = timedelta(seconds=CFG.sensor_timeout)
     for s in sensors:
+        if sensor_is_input_hub(s):
+            continue
         sid = s.get("section_id")
         if sid is None:
             sid = default_section_for_building(user_building_id)
         if sid != user_section_id:
             continue
         sensors_total += 1
-        if s["last_heartbeat"] and (now - s["last_heartbeat"]) < timeout:
+        if sensor_heartbeat_is_fresh(s, now, timeout):
             sensors_online += 1
 
     if sensors_total == 0:
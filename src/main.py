@@ -14,7 +14,13 @@ from database import init_db
 from handlers import router
 from services import alert_monitor_loop, sensors_monitor_loop
 from yasno import yasno_schedule_monitor_loop
-from api_server import create_api_app, start_api_server, stop_api_server
+from api_server import (
+    create_api_app,
+    start_api_server,
+    stop_api_server,
+    start_sensor_udp_listener,
+    stop_sensor_udp_listener,
+)
 from single_message_bot import SingleMessageBot
 from admin_jobs_worker import admin_jobs_worker_loop
 from business import is_business_subscription_lifecycle_enabled
@@ -36,6 +42,8 @@ async def main():
     # Запускаємо API сервер для ESP32 сенсорів
     api_app = create_api_app()
     api_runner = await start_api_server(api_app)
+    # UDP-транспорт heartbeat (якщо SENSOR_UDP_PORT задано)
+    udp_transport = await start_sensor_udp_listener()
     
     # Запускаємо фонові таски
     # Моніторинг ESP32 сенсорів (основна система визначення стану світла)
@@ -58,6 +66,7 @@ async def main():
     try:
         await dp.start_polling(bot)
     finally:
+        await stop_sensor_udp_listener(udp_transport)
         await stop_api_server(api_runner)
 
 
@@ -0,0 +1,41 @@
+"""
+Позачергова перевірка стану сенсорів.
+
+API-сервер і sensors_monitor_loop працюють в одному event loop. Коли heartbeat
+змінює стан сенсора "миттєво" (last-gasp power_lost, boot після відновлення
+живлення, перший beat після таймауту), монітор будимо одразу, а не чекаємо
+наступного CHECK_INTERVAL.
+"""
+
+import asyncio
+
+_recheck_event: asyncio.Event | None = None
+_recheck_loop: asyncio.AbstractEventLoop | None = None
+
+
+def _get_recheck_event() -> asyncio.Event:
+    # Event прив'язується до loop при першому використанні; smoke-тести запускають
+    # кілька asyncio.run() в одному процесі, тож тримаємо окремий Event на loop.
+    global _recheck_event, _recheck_loop
+    loop = asyncio.get_running_loop()
+    if _recheck_event is None or _recheck_loop is not loop:
+        _recheck_event = asyncio.Event()
+        _recheck_loop = loop
+    return _recheck_event
+
+
+def request_sensors_recheck() -> None:
+    """Попросити sensors_monitor_loop перерахувати стани секцій якнайшвидше."""
+    _get_recheck_event().set()
+
+
+async def wait_sensors_recheck(timeout: float) -> bool:
+    """Чекати timeout секунд або до request_sensors_recheck(). True — якщо розбудили раніше."""
+    event = _get_recheck_event()
+    try:
+        await asyncio.wait_for(event.wait(), timeout)
+        woke = True
+    except asyncio.TimeoutError:
+        woke = False
+    event.clear()
+    return woke
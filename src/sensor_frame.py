@@ -0,0 +1,133 @@
+"""
+Компактний бінарний heartbeat сенсора (HMAC-підписаний frame замість JSON з api_key).
+
+Layout (little-endian, 36 байт):
+    0   2s  magic            b"PB"
+    2   B   version          SENSOR_FRAME_VERSION
+    3   B   event            індекс у SENSOR_FRAME_EVENTS
+    4   H   building_id
+    6   H   section_id
+    8   8s  uuid_hash        SHA-256(sensor_uuid)[:8]
+    16  I   seq              порядковий номер beat з моменту boot
+    20  I   uptime_s         аптайм прошивки, секунди
+    24  I   boot_count       лічильник завантажень прошивки (NVS, не зменшується)
+    28  8s  tag              HMAC-SHA256(SENSOR_API_KEY, bytes[0:28])[:8]
+
+Ключ у мережу не йде. Сам sensor_uuid теж: сервер знаходить сенсор за uuid_hash серед
+уже зареєстрованих (реєстрація / зміна назви чи коментаря — звичайним JSON heartbeat).
+Підпис не містить часу: від повтору захищає курсор (boot_count, seq) на сервері.
+
+Модуль без залежностей від config/БД: його ж використовують smoke-тести з
+тест-векторами, спільними з прошивкою (sensors/lib/powerbot_core/test/heartbeat_frame_vectors.txt).
+"""
+
+from __future__ import annotations
+
+import hashlib
+import hmac
+import struct
+from dataclasses import dataclass
+
+
+SENSOR_FRAME_MAGIC = b"PB"
+SENSOR_FRAME_VERSION = 2
+SENSOR_FRAME_STRUCT = struct.Struct("<2sBBHH8sIII8s")
+SENSOR_FRAME_SIZE = SENSOR_FRAME_STRUCT.size
+SENSOR_FRAME_SIGNED_SIZE = SENSOR_FRAME_SIZE - 8
+SENSOR_FRAME_TAG_SIZE = 8
+SENSOR_FRAME_UUID_HASH_SIZE = 8
+
+# Порядок = код event у frame (збігається з PbFrameEvent у прошивці).
+SENSOR_FRAME_EVENTS = ("heartbeat", "boot", "power_lost")
+
+
+@dataclass(frozen=True)
+class SensorFrame:
+    event: str
+    building_id: int
+    section_id: int
+    uuid_hash: bytes
+    seq: int
+    uptime_s: int
+    boot_count: int
+
+
+def sensor_uuid_hash(sensor_uuid: str) -> bytes:
+    """Короткий ідентифікатор сенсора у frame."""
+    return hashlib.sha256(sensor_uuid.encode("utf-8")).digest()[:SENSOR_FRAME_UUID_HASH_SIZE]
+
+
+class SensorFrameKey:
+    """
+    HMAC-ключ з попередньо обчисленим midstate (ipad/opad блоки вже прогнані через SHA-256):
+    на кожен frame лише copy() + один блок даних, як і в прошивці.
+    """
+
+    def __init__(self, key: str | bytes) -> None:
+        if isinstance(key, str):
+            key = key.encode("utf-8")
+        self._mac = hmac.new(key, digestmod=hashlib.sha256)
+
+    def tag(self, signed: bytes) -> bytes:
+        mac = self._mac.copy()
+        mac.update(signed)
+        return mac.digest()[:SENSOR_FRAME_TAG_SIZE]
+
+
+def encode_sensor_frame(
+    key: SensorFrameKey,
+    *,
+    event: str,
+    building_id: int,
+    section_id: int,
+    sensor_uuid: str,
+    seq: int,
+    uptime_s: int,
+    boot_count: int = 0,
+) -> bytes:
+    """Зібрати підписаний frame (для тестів / симуляторів; прошивка робить те саме в pb_hb_frame.h)."""
+    signed = SENSOR_FRAME_STRUCT.pack(
+        SENSOR_FRAME_MAGIC,
+        SENSOR_FRAME_VERSION,
+        SENSOR_FRAME_EVENTS.index(event),
+        building_id,
+        section_id,
+        sensor_uuid_hash(sensor_uuid),
+        seq,
+        uptime_s,
+        boot_count,
+        b"",
+    )[:SENSOR_FRAME_SIGNED_SIZE]
+    return signed + key.tag(signed)
+
+
+def is_sensor_frame(data: bytes) -> bool:
+    """Чи схоже на бінарний frame (а не на JSON)."""
+    return data[:2] == SENSOR_FRAME_MAGIC
+
+
+def decode_sensor_frame(data: bytes, key: SensorFrameKey) -> SensorFrame | None:
+    """
+    Розібрати і перевірити frame. None — не frame, невідома версія/event або невалідний підпис
+    (причину навмисно не розрізняємо: для відправника це все "невалідний ключ").
+    """
+    if len(data) != SENSOR_FRAME_SIZE:
+        return None
+    magic, version, event_code, building_id, section_id, uuid_hash, seq, uptime_s, boot_count, tag = (
+        SENSOR_FRAME_STRUCT.unpack(data)
+    )
+    if magic != SENSOR_FRAME_MAGIC or version != SENSOR_FRAME_VERSION:
+        return None
+    if not hmac.compare_digest(tag, key.tag(data[:SENSOR_FRAME_SIGNED_SIZE])):
+        return None
+    if event_code >= len(SENSOR_FRAME_EVENTS):
+        return None
+    return SensorFrame(
+        event=SENSOR_FRAME_EVENTS[event_code],
+        building_id=building_id,
+        section_id=section_id,
+        uuid_hash=uuid_hash,
+        seq=seq,
+        uptime_s=uptime_s,
+        boot_count=boot_count,
+    )
@@ -15,6 +15,8 @@ from database import (
     get_subscribers_for_light_notification, get_subscribers_for_alert_notification,
     NEWCASTLE_BUILDING_ID, get_all_active_sensors,
     get_sensors_by_building, get_building_by_id,
+    sensor_heartbeat_is_fresh,
+    sensor_is_input_hub,
     get_last_events, remove_subscriber,
     get_last_event_before,
     get_subscriber_building_and_section,
@@ -24,6 +26,7 @@ from database import (
     get_building_section_power_state,
     set_building_section_power_state,
 )
+from sensor_events import wait_sensors_recheck
 
 # Налаштування масових розсилок (можна перевизначити через env)
 BROADCAST_RATE_PER_SEC = float(os.getenv("BROADCAST_RATE_PER_SEC", "20"))
@@ -88,6 +91,8 @@ async def format_light_status(
     now = datetime.now()
     timeout = timedelta(seconds=CFG.sensor_timeout)
     for s in sensors:
+        if sensor_is_input_hub(s):
+            continue
         sensor_section = s.get("section_id")
         if sensor_section is None:
             sensor_section = default_section_for_building(user_building_id)
@@ -99,7 +104,7 @@ async def format_light_status(
                 bool(s.get("frozen_is_up")) if s.get("frozen_is_up") is not None else False
             )
         else:
-            effective_online = bool(s["last_heartbeat"] and (now - s["last_heartbeat"]) < timeout)
+            effective_online = sensor_heartbeat_is_fresh(s, now, timeout)
 
         physical_section_any_online[int(sensor_section)] = (
             physical_section_any_online.get(int(sensor_section), False) or effective_online
@@ -135,6 +140,8 @@ async def format_light_status(
             src_sensors = await get_sensors_by_building(src_bid)
             any_online: dict[int, bool] = {}
             for sensor in src_sensors:
+                if sensor_is_input_hub(sensor):
+                    continue
                 sid = sensor.get("section_id")
                 if sid is None:
                     sid = default_section_for_building(src_bid)
@@ -149,7 +156,7 @@ async def format_light_status(
                         bool(sensor.get("frozen_is_up")) if sensor.get("frozen_is_up") is not None else False
                     )
                 else:
-                    effective_online = bool(sensor["last_heartbeat"] and (now - sensor["last_heartbeat"]) < timeout)
+                    effective_online = sensor_heartbeat_is_fresh(sensor, now, timeout)
 
                 any_online[sid_int] = any_online.get(sid_int, False) or effective_online
 
@@ -484,6 +491,9 @@ async def check_sensors_timeout() -> dict[tuple[int, int], bool]:
     # Групуємо сенсори по (будинок, секція)
     sections_sensors: dict[tuple[int, int], list[dict]] = {}
     for sensor in sensors:
+        # Плата з входами: секції — за її сенсорами-входами, не за живленням самої плати.
+        if sensor_is_input_hub(sensor):
+            continue
         bid = sensor["building_id"]
         sid = sensor.get("section_id")
         if sid is None:
@@ -506,7 +516,7 @@ async def check_sensors_timeout() -> dict[tuple[int, int], bool]:
                     bool(sensor.get("frozen_is_up")) if sensor.get("frozen_is_up") is not None else False
                 )
             else:
-                effective_online = bool(sensor["last_heartbeat"] and (now - sensor["last_heartbeat"]) < timeout)
+                effective_online = sensor_heartbeat_is_fresh(sensor, now, timeout)
 
             if effective_online:
                 is_up = True
@@ -556,10 +566,7 @@ async def get_building_sensors_status(building_id: int) -> dict:
     online_count = 0
     
     for sensor in sensors:
-        is_online = False
-        if sensor["last_heartbeat"]:
-            time_since = now - sensor["last_heartbeat"]
-            is_online = time_since < timeout
+        is_online = sensor_heartbeat_is_fresh(sensor, now, timeout)
         
         if is_online:
             online_count += 1
@@ -927,6 +934,8 @@ async def sensors_monitor_loop(bot: Bot):
     """
     Цикл моніторингу ESP32 сенсорів.
     Перевіряє таймаути heartbeat і надсилає сповіщення при зміні стану будинку.
+    Крім планової перевірки кожні CHECK_INTERVAL секунд, прокидається позачергово
+    на події сенсорів (last-gasp power_lost, boot) — див. sensor_events.
     """
     from aiogram.types import InlineKeyboardMarkup, InlineKeyboardButton
     
@@ -1056,4 +1065,5 @@ async def sensors_monitor_loop(bot: Bot):
         except Exception:
             logging.exception("sensors_monitor_loop error")
         
-        await asyncio.sleep(CHECK_INTERVAL)
+        # Heartbeat API будить цикл одразу після power_lost / boot / повернення сенсора.
+        await wait_sensors_recheck(CHECK_INTERVAL)